@@ -2,6 +2,7 @@
 #include <Automaton.h>
 #include <CircularBuffer.h>
 #include <limits.h>
+#include "TargetGame.h"
 
 /**
  * Buttons.
@@ -61,10 +62,7 @@ const int FINAL_PHASE = 3;
 Atm_timer timerState;
 
 const int STATE_TIMER_MS = 50;
-const int BUTTONS_BUF_SIZE = 10;
 
-CircularBuffer<int, BUTTONS_BUF_SIZE> bufButtonPresses;
-CircularBuffer<int, BUTTONS_NUM> bufButtonTargets;
 CircularBuffer<uint32_t, BUTTONS_NUM> bufButtonColors;
 
 typedef struct programState {
@@ -77,6 +75,8 @@ typedef struct programState {
 
 ProgramState progState;
 
+TargetGame buttonTargets(BUTTONS_NUM);
+
 /**
  * Utility to check for existence in a circular buffer.
  */
@@ -117,47 +117,28 @@ void initRelay()
  * Functions to get the dynamic config that depends on the current phase.
  */
 
+constexpr int PHASE_HIT_STREAK[] = {6, 4, 3};
+constexpr unsigned long PHASE_MAX_SPAN_MILLIS[] = {10000, 6000, 5000};
+
+// Targets are drawn from [min, max)
+constexpr int PHASE_NUM_TARGETS_MIN[] = {5};
+constexpr int PHASE_NUM_TARGETS_MAX[] = {7};
+
 int getPhaseHitStreak(int phase)
 {
-    const int streakLong = 6;
-    const int streakMedium = 4;
-    const int streakShort = 3;
-
-    if (phase == 0) {
-        return streakLong;
-    } else if (phase == 1) {
-        return streakMedium;
-    } else {
-        return streakShort;
-    }
+    return phaseValue(PHASE_HIT_STREAK, phase);
 }
 
 unsigned long getPhaseMaxSpanMillis(int phase)
 {
-    const unsigned long millisLong = 10000;
-    const unsigned long millisMedium = 6000;
-    const unsigned long millisShort = 5000;
-
-    if (phase == 0) {
-        return millisLong;
-    } else if (phase == 1) {
-        return millisMedium;
-    } else {
-        return millisShort;
-    }
+    return phaseValue(PHASE_MAX_SPAN_MILLIS, phase);
 }
 
 int getPhaseNumTargets(int phase)
 {
-    const int minNum = 5;
-    const int maxNum = 7;
-
-    if (maxNum > BUTTONS_NUM) {
-        Serial.println(F("WARN :: Unexpected number of buttons"));
-        return random(1, BUTTONS_NUM);
-    } else {
-        return random(minNum, maxNum);
-    }
+    return random(
+        phaseValue(PHASE_NUM_TARGETS_MIN, phase),
+        phaseValue(PHASE_NUM_TARGETS_MAX, phase));
 }
 
 void refreshErrorPaletteBuffer(int phase)
@@ -212,67 +193,23 @@ uint32_t getPhaseRandomColorError(int phase)
 
 void clearTargets()
 {
-    bufButtonTargets.clear();
+    buttonTargets.clear();
     bufButtonColors.clear();
 }
 
 bool inTargetsBuffer(int idx)
 {
-    return inBuffer(bufButtonTargets, idx);
-}
-
-bool pushTarget(int idx)
-{
-    if (idx < 0 || idx >= BUTTONS_NUM) {
-        Serial.println(F("Target should be in [0, numLeds)"));
-        return false;
-    }
-
-    if (inTargetsBuffer(idx)) {
-        return false;
-    }
-
-    if (!bufButtonTargets.isFull()) {
-        Serial.print(F("Adding target: "));
-        Serial.println(idx);
-        bufButtonTargets.push(idx);
-        return true;
-    }
-
-    return false;
-}
-
-int pickRandomTarget()
-{
-    int randPivot = random(0, BUTTONS_NUM * 10) % BUTTONS_NUM;
-    int counter = 0;
-
-    while (inTargetsBuffer(randPivot) && counter <= BUTTONS_NUM) {
-        randPivot = (randPivot + 1) % BUTTONS_NUM;
-        counter++;
-    }
-
-    return inTargetsBuffer(randPivot) ? -1 : randPivot;
+    return buttonTargets.isTarget(idx);
 }
 
 void randomizeTargets(int num)
 {
-    num = (num > (BUTTONS_NUM)) ? BUTTONS_NUM : num;
-
-    clearTargets();
-
-    int randTarget;
-
-    for (int i = 0; i < num; i++) {
-        randTarget = pickRandomTarget();
-
-        if (randTarget == -1) {
-            Serial.println(F("Warn: no more random targets to pick"));
-            break;
-        }
-
-        pushTarget(randTarget);
+    if (buttonTargets.randomize(num) < num) {
+        Serial.println(F("Warn: no more random targets to pick"));
     }
+
+    Serial.print(F("Targets: "));
+    Serial.println(buttonTargets.getTargets(), BIN);
 }
 
 void updateButtonColorsBuffer()
@@ -296,8 +233,6 @@ void updateButtonColorsBuffer()
 
 void initState()
 {
-    bufButtonPresses.clear();
-
     clearTargets();
 
     progState.startMillis = 0;
@@ -311,8 +246,6 @@ void initState()
 
 void resetStateToPhaseStart()
 {
-    bufButtonPresses.clear();
-
     clearTargets();
 
     progState.startMillis = 0;
@@ -328,33 +261,7 @@ void resetStateToPhaseStart()
 
 bool inPressesBuffer(int val)
 {
-    return inBuffer(bufButtonPresses, val);
-}
-
-bool isPressesBufferError()
-{
-    for (int i = 0; i < bufButtonPresses.size(); i++) {
-        if (!inTargetsBuffer(bufButtonPresses[i])) {
-            return true;
-        }
-    }
-
-    return false;
-}
-
-bool isPressesBufferMatch()
-{
-    if (bufButtonTargets.size() != bufButtonPresses.size()) {
-        return false;
-    }
-
-    for (int i = 0; i < bufButtonTargets.size(); i++) {
-        if (!inPressesBuffer(bufButtonTargets[i])) {
-            return false;
-        }
-    }
-
-    return true;
+    return buttonTargets.isHit(val);
 }
 
 /**
@@ -457,7 +364,6 @@ void updateTargets()
     updateButtonColorsBuffer();
     showTargetLeds();
     progState.startMillis = millis();
-    bufButtonPresses.clear();
 }
 
 void advanceProgress()
@@ -517,13 +423,13 @@ void updateState()
     if (progState.startMillis == 0) {
         Serial.println(F("First target update"));
         updateTargets();
-    } else if (isPressesBufferError()) {
+    } else if (buttonTargets.isError()) {
         Serial.println(F("Error: restart"));
         errorAndRestart();
     } else if (isExpired()) {
         Serial.println(F("Time expired: restart"));
         errorAndRestart();
-    } else if (isPressesBufferMatch()) {
+    } else if (buttonTargets.isMatch()) {
         Serial.println(F("OK: advancing progress"));
         advanceProgress();
     } else {
@@ -544,13 +450,9 @@ void onPress(int idx, int v, int up)
     Serial.print(F("Press:"));
     Serial.println(idx);
 
-    bool isDup = inBuffer(bufButtonPresses, idx);
-
-    if (!isDup) {
+    if (buttonTargets.hit(idx)) {
         Serial.print(F("Pushing:"));
         Serial.println(idx);
-
-        bufButtonPresses.push(idx);
     }
 }
 
@@ -0,0 +1,183 @@
+#include <chrono>
+#include <string>
+#include <unity.h>
+#include <ArduinoSim.h>
+#include "TargetGame.h"
+
+/**
+ * Runs the compostin sketch against the virtual clock of the native
+ * simulation: `pio test -e native`.
+ */
+
+extern TargetGame buttonTargets;
+
+unsigned long getPhaseMaxSpanMillis(int phase);
+int getPhaseHitStreak(int phase);
+
+const uint8_t BUTTON_PINS_FIRST = 4;
+const uint8_t BUTTON_PHASE = 12;
+const uint8_t LED_PHASE = A0;
+const uint8_t RELAY = 3;
+
+const unsigned long STATE_TICK_MS = 50;
+
+bool serialContains(const char *text)
+{
+    return sim::serialOutput().find(text) != std::string::npos;
+}
+
+void pressTargets()
+{
+    TargetMask targets = buttonTargets.getTargets();
+
+    for (uint8_t i = 0; i < TARGET_GAME_MAX_SIZE; i++) {
+        if (targets & TargetGame::maskOf(i)) {
+            sim::press(BUTTON_PINS_FIRST + i, 20, 20);
+        }
+    }
+
+    // Let the state timer see the match
+    sim::runFor(2 * STATE_TICK_MS);
+}
+
+void setUp()
+{
+    sim::reset();
+    setup();
+    sim::runFor(STATE_TICK_MS);
+    sim::clearSerial();
+}
+
+void tearDown()
+{
+}
+
+void test_phase_spans()
+{
+    TEST_ASSERT_EQUAL_UINT32(10000, getPhaseMaxSpanMillis(0));
+    TEST_ASSERT_EQUAL_UINT32(6000, getPhaseMaxSpanMillis(1));
+    TEST_ASSERT_EQUAL_UINT32(5000, getPhaseMaxSpanMillis(2));
+    TEST_ASSERT_EQUAL_UINT32(5000, getPhaseMaxSpanMillis(3));
+}
+
+void test_locked_until_phase_press()
+{
+    TEST_ASSERT_EQUAL(HIGH, sim::getPin(LED_PHASE));
+    TEST_ASSERT_EQUAL_UINT16(0, buttonTargets.getTargets());
+
+    sim::press(BUTTON_PHASE);
+
+    TEST_ASSERT_EQUAL(LOW, sim::getPin(LED_PHASE));
+    TEST_ASSERT_NOT_EQUAL(0, buttonTargets.getTargets());
+}
+
+void test_targets_expire_after_phase_span()
+{
+    for (int phase = 0; phase < 3; phase++) {
+        unsigned long span = getPhaseMaxSpanMillis(phase);
+
+        sim::press(BUTTON_PHASE, 20, 0);
+        sim::clearSerial();
+
+        // Expiry is checked on the state timer ticks
+        sim::runFor(span - STATE_TICK_MS);
+        TEST_ASSERT_FALSE(serialContains("Time expired"));
+
+        sim::runFor(3 * STATE_TICK_MS);
+        TEST_ASSERT_TRUE(serialContains("Time expired"));
+        TEST_ASSERT_EQUAL(HIGH, sim::getPin(LED_PHASE));
+
+        // Complete the phase to move on to the next span
+        sim::press(BUTTON_PHASE);
+
+        for (int i = 0; i < getPhaseHitStreak(phase); i++) {
+            pressTargets();
+        }
+
+        sim::runFor(STATE_TICK_MS);
+    }
+}
+
+void test_wrong_button_restarts_phase()
+{
+    sim::press(BUTTON_PHASE);
+
+    TargetMask targets = buttonTargets.getTargets();
+    uint8_t wrong = 0;
+
+    while (targets & TargetGame::maskOf(wrong)) {
+        wrong++;
+    }
+
+    sim::press(BUTTON_PINS_FIRST + wrong);
+    sim::runFor(STATE_TICK_MS);
+
+    TEST_ASSERT_TRUE(serialContains("Error: restart"));
+    TEST_ASSERT_EQUAL(HIGH, sim::getPin(LED_PHASE));
+    TEST_ASSERT_EQUAL_UINT16(0, buttonTargets.getTargets());
+}
+
+void test_game_completes_and_opens_relay()
+{
+    for (int phase = 0; phase < 3; phase++) {
+        sim::press(BUTTON_PHASE);
+
+        for (int i = 0; i < getPhaseHitStreak(phase); i++) {
+            TEST_ASSERT_EQUAL(LOW, sim::getPin(RELAY));
+            pressTargets();
+        }
+    }
+
+    // The final effect never returns: the simulation cuts it short
+    sim::setMaxBlockMillis(10000);
+    sim::runFor(STATE_TICK_MS * 2);
+
+    TEST_ASSERT_TRUE(serialContains("Game completed"));
+    TEST_ASSERT_TRUE(sim::timedOut());
+    TEST_ASSERT_EQUAL(HIGH, sim::getPin(RELAY));
+    TEST_ASSERT_FALSE(serialContains("Error"));
+}
+
+void test_loop_throughput()
+{
+    const unsigned long simulatedMs = 60000;
+
+    sim::press(BUTTON_PHASE);
+
+    unsigned long blockedStart = sim::blockedMillis();
+    auto wallStart = std::chrono::steady_clock::now();
+    unsigned long iterations = sim::runFor(simulatedMs, 100);
+    auto wallEnd = std::chrono::steady_clock::now();
+
+    double wallMs = std::chrono::duration<double, std::milli>(wallEnd - wallStart).count();
+    char message[128];
+
+    snprintf(
+        message,
+        sizeof(message),
+        "%lu loop() calls in %.1f ms (%.0f calls/s, %.0fx real time)",
+        iterations,
+        wallMs,
+        iterations / (wallMs / 1000.0),
+        simulatedMs / wallMs);
+
+    TEST_MESSAGE(message);
+
+    // Every 100 us step is a loop() call, except while an effect blocks
+    unsigned long blockedMs = sim::blockedMillis() - blockedStart;
+
+    TEST_ASSERT_EQUAL_UINT32(simulatedMs - blockedMs, iterations / 10);
+    TEST_ASSERT_TRUE(wallMs < simulatedMs);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_phase_spans);
+    RUN_TEST(test_locked_until_phase_press);
+    RUN_TEST(test_targets_expire_after_phase_span);
+    RUN_TEST(test_wrong_button_restarts_phase);
+    RUN_TEST(test_game_completes_and_opens_relay);
+    RUN_TEST(test_loop_throughput);
+    return UNITY_END();
+}
@@ -0,0 +1,133 @@
+#ifndef CODE_MATCHER_H
+#define CODE_MATCHER_H
+
+#include <Arduino.h>
+
+/**
+ * Matches a stream of keys against a set of equal length codes.
+ *
+ * The last codeSize keys are kept in a window together with their
+ * polynomial rolling hash, which is updated in O(1) per key. After each
+ * key the hash is compared against the precomputed hash of every code and
+ * only a code whose hash is equal is compared key by key, so a check
+ * costs one integer compare per code instead of codeSize char compares.
+ *
+ * A code matches as soon as its last key is entered, whatever was typed
+ * before it.
+ */
+
+const int8_t CODE_MATCHER_NONE = -1;
+const uint8_t CODE_MATCHER_MAX_CODES = 8;
+const uint8_t CODE_MATCHER_MAX_SIZE = 16;
+const uint32_t CODE_MATCHER_BASE = 257;
+
+class CodeMatcher
+{
+public:
+    /**
+     * codes is numCodes x codeSize chars, one code after the other.
+     */
+    CodeMatcher(const char *codes, uint8_t numCodes, uint8_t codeSize)
+        : codes(codes),
+          numCodes(numCodes > CODE_MATCHER_MAX_CODES ? CODE_MATCHER_MAX_CODES : numCodes),
+          codeSize(codeSize > CODE_MATCHER_MAX_SIZE ? CODE_MATCHER_MAX_SIZE : codeSize),
+          outWeight(1)
+    {
+        for (uint8_t i = 0; i < this->codeSize; i++) {
+            outWeight *= CODE_MATCHER_BASE;
+        }
+
+        for (uint8_t k = 0; k < this->numCodes; k++) {
+            uint32_t hash = 0;
+
+            for (uint8_t i = 0; i < this->codeSize; i++) {
+                hash = hash * CODE_MATCHER_BASE + (uint8_t)code(k)[i];
+            }
+
+            codeHashes[k] = hash;
+        }
+
+        clear();
+    }
+
+    void clear()
+    {
+        hash = 0;
+        count = 0;
+        first = 0;
+    }
+
+    /**
+     * Adds a key and returns the index of the code that the window now
+     * matches, or CODE_MATCHER_NONE.
+     */
+    int8_t push(char key)
+    {
+        hash = hash * CODE_MATCHER_BASE + (uint8_t)key;
+
+        if (count < codeSize) {
+            window[(first + count) % codeSize] = key;
+            count++;
+        } else {
+            // The oldest key now has weight BASE^codeSize: drop it
+            hash -= outWeight * (uint8_t)window[first];
+            window[first] = key;
+            first = (first + 1) % codeSize;
+        }
+
+        if (count < codeSize) {
+            return CODE_MATCHER_NONE;
+        }
+
+        for (uint8_t k = 0; k < numCodes; k++) {
+            if (codeHashes[k] == hash && isWindowEqual(code(k))) {
+                return k;
+            }
+        }
+
+        return CODE_MATCHER_NONE;
+    }
+
+    uint8_t size() const
+    {
+        return count;
+    }
+
+    /**
+     * Key i of the window, oldest first.
+     */
+    char operator[](uint8_t i) const
+    {
+        return window[(first + i) % codeSize];
+    }
+
+private:
+    const char *codes;
+    uint8_t numCodes;
+    uint8_t codeSize;
+    uint32_t outWeight;
+    uint32_t codeHashes[CODE_MATCHER_MAX_CODES];
+
+    char window[CODE_MATCHER_MAX_SIZE];
+    uint8_t first;
+    uint8_t count;
+    uint32_t hash;
+
+    const char *code(uint8_t k) const
+    {
+        return codes + k * codeSize;
+    }
+
+    bool isWindowEqual(const char *other) const
+    {
+        for (uint8_t i = 0; i < codeSize; i++) {
+            if ((*this)[i] != other[i]) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+#endif
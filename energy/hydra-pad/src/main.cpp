@@ -1,7 +1,7 @@
 #include <Adafruit_NeoPixel.h>
-#include <CircularBuffer.h>
-#include <Keypad.h>
 #include <limits.h>
+#include "CodeMatcher.h"
+#include "KeypadScanner.h"
 
 /**
  * LED strips.
@@ -38,32 +38,38 @@ const uint32_t COLOR_ERR = Adafruit_NeoPixel::Color(255, 0, 0);
 const byte ROWS = 4;
 const byte COLS = 4;
 
-char keys[ROWS][COLS] = {
+const char keys[ROWS][COLS] = {
     { '1', '2', '3', 'A' },
     { '4', '5', '6', 'B' },
     { '7', '8', '9', 'C' },
     { '*', '0', '#', 'D' }
 };
 
-byte rowPins[ROWS] = { 2, 3, 4, 5 };
-byte colPins[COLS] = { 6, 7, 8, 9 };
+const byte rowPins[ROWS] = { 2, 3, 4, 5 };
+const byte colPins[COLS] = { 6, 7, 8, 9 };
 
-Keypad kpd = Keypad(makeKeymap(keys), rowPins, colPins, ROWS, COLS);
+KeypadScanner keypad(&keys[0][0], rowPins, colPins, ROWS, COLS);
+
+// Timer2 CTC: 16 MHz / 1024 / (77 + 1) = 200 Hz, one scan every 5 ms
+const uint8_t KEYPAD_TIMER_OCR = 77;
 
 const int SOLUTION_SIZE = 4;
 
-char solutionKeys[SOLUTION_SIZE] = {
+const char solutionKeys[SOLUTION_SIZE] = {
     '1',
     '9',
     '1',
-    '7  ',
+    '7',
 };
 
 /**
  * Inputs buffer.
  */
 
-CircularBuffer<char, SOLUTION_SIZE> keyBuffer;
+CodeMatcher codeMatcher(solutionKeys, 1, SOLUTION_SIZE);
+
+// Keys since the last error effect: a wrong attempt is SOLUTION_SIZE keys
+uint8_t attemptKeys = 0;
 
 /**
  * LED functions.
@@ -168,53 +174,58 @@ void showFinishEffect(int numLoops)
  * Keypad and buffer functions.
  */
 
-void updateKeyBuffer()
+ISR(TIMER2_COMPA_vect)
 {
-    char key = kpd.getKey();
-
-    if (key != NO_KEY) {
-        Serial.print(F("Key: "));
-        Serial.println(key);
-        keyBuffer.push(key);
-        showPadPressEffect();
-    }
+    keypad.scan();
 }
 
-bool isCodeInBuffer(char* code)
+void initKeypad()
 {
-    if (keyBuffer.size() < SOLUTION_SIZE) {
-        return false;
-    }
-
-    for (int i = 0; i < keyBuffer.size(); i++) {
-        if (keyBuffer[i] != code[i]) {
-            return false;
-        }
-    }
-
-    return true;
+    keypad.begin();
+
+    noInterrupts();
+    TCCR2A = bit(WGM21);
+    TCCR2B = bit(CS22) | bit(CS21) | bit(CS20);
+    OCR2A = KEYPAD_TIMER_OCR;
+    TCNT2 = 0;
+    TIMSK2 = bit(OCIE2A);
+    interrupts();
 }
 
+/**
+ * Keys pressed while an effect blocks are queued by the scanner and
+ * handled here afterwards, in order. The code is matched on the stream
+ * of keys, so a stray key does not force the player to retype a whole
+ * attempt after the error effect.
+ */
 void keypadLoop()
 {
-    updateKeyBuffer();
+    KeypadEvent event;
 
-    if (keyBuffer.available() > 0) {
-        return;
-    }
+    while (keypad.pop(event)) {
+        if (!event.isPressed) {
+            continue;
+        }
 
-    Serial.println(F("Buffer is full"));
+        Serial.print(F("Key: "));
+        Serial.println(event.key);
+        showPadPressEffect();
 
-    if (isCodeInBuffer(solutionKeys)) {
-        pixelPad.fill(COLOR_OK);
-        pixelPad.show();
-        showFinishEffect(0);
-    } else {
-        showPadErrorEffect();
-    }
+        if (codeMatcher.push(event.key) != CODE_MATCHER_NONE) {
+            pixelPad.fill(COLOR_OK);
+            pixelPad.show();
+            showFinishEffect(0);
+        }
 
-    keyBuffer.clear();
-};
+        attemptKeys++;
+
+        if (attemptKeys >= SOLUTION_SIZE) {
+            Serial.println(F("Buffer is full"));
+            showPadErrorEffect();
+            attemptKeys = 0;
+        }
+    }
+}
 
 /**
  * Entrypoint.
@@ -225,6 +236,7 @@ void setup()
     Serial.begin(9600);
 
     initLeds();
+    initKeypad();
 
     Serial.println(F(">> Starting Hydra-Pad program"));
 
@@ -0,0 +1,233 @@
+#include <string>
+#include <ArduinoSim.h>
+#include "../../include/KeypadScanner.h"
+#include "../../include/CodeMatcher.h"
+
+/**
+ * Host test of KeypadScanner and CodeMatcher: a bouncing key on
+ * simulated pins scanned as the 5 ms timer interrupt would, a FIFO left
+ * undrained, and CodeMatcher against a naive compare of the last keys.
+ *
+ * The simulated pins are not wired to each other, so a pressed key is a
+ * LOW column pin whatever row is driven. The matrix here is a single row.
+ *
+ * Build and run from this directory with the native simulation core:
+ *
+ *   g++ -O2 -I ../../../../native-sim/ArduinoSim/src keypad_scanner_test.cpp \
+ *       ../../../../native-sim/ArduinoSim/src/ArduinoSim.cpp -o keypad_scanner_test
+ *   ./keypad_scanner_test
+ *
+ * Exits with 1 if a check fails.
+ */
+
+const uint8_t ROWS = 1;
+const uint8_t COLS = 4;
+const uint8_t ROW_PINS[ROWS] = {2};
+const uint8_t COL_PINS[COLS] = {3, 4, 5, 6};
+const char KEYMAP[ROWS * COLS] = {'1', '2', '3', 'A'};
+
+const uint8_t CODE_SIZE = 8;
+const char CODES[] = "31459600"
+                     "38730857"
+                     "75448377";
+const uint8_t NUM_CODES = 3;
+const long NUM_RANDOM_KEYS = 200000;
+
+int numFailures = 0;
+
+#define CHECK(cond)                                           \
+    do                                                        \
+    {                                                         \
+        if (!(cond))                                          \
+        {                                                     \
+            printf("FAIL line %d: %s\n", __LINE__, #cond);    \
+            numFailures++;                                    \
+        }                                                     \
+    } while (0)
+
+void setup()
+{
+}
+
+void loop()
+{
+}
+
+void releaseAll()
+{
+    for (uint8_t c = 0; c < COLS; c++)
+    {
+        sim::setPin(COL_PINS[c], HIGH);
+    }
+}
+
+/**
+ * Scans once per sample, the key at col pressed while the sample is 1.
+ */
+void scanSamples(KeypadScanner &scanner, uint8_t col, const uint8_t *samples, uint8_t numSamples)
+{
+    for (uint8_t i = 0; i < numSamples; i++)
+    {
+        sim::setPin(COL_PINS[col], samples[i] ? LOW : HIGH);
+        scanner.scan();
+        sim::advance(5);
+    }
+}
+
+void testBounce()
+{
+    sim::reset();
+    releaseAll();
+
+    KeypadScanner scanner(KEYMAP, ROW_PINS, COL_PINS, ROWS, COLS);
+    scanner.begin();
+
+    CHECK(sim::getPinMode(ROW_PINS[0]) == INPUT);
+    CHECK(sim::getPinMode(COL_PINS[0]) == INPUT_PULLUP);
+
+    // 3 bounce samples on the press and on the release
+    const uint8_t samples[] = {1, 0, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 0, 0, 0, 0, 0, 0};
+    scanSamples(scanner, 2, samples, sizeof(samples));
+
+    KeypadEvent event = {0, false};
+
+    CHECK(scanner.pop(event));
+    CHECK(event.key == '3' && event.isPressed);
+    CHECK(scanner.pop(event));
+    CHECK(event.key == '3' && !event.isPressed);
+    CHECK(!scanner.pop(event));
+    CHECK(scanner.getOverruns() == 0);
+
+    // The row idles as an input between scans
+    CHECK(sim::getPinMode(ROW_PINS[0]) == INPUT);
+}
+
+void testShortGlitch()
+{
+    sim::reset();
+    releaseAll();
+
+    KeypadScanner scanner(KEYMAP, ROW_PINS, COL_PINS, ROWS, COLS);
+    scanner.begin();
+
+    // Never 4 agreeing scans in a row
+    const uint8_t samples[] = {1, 1, 1, 0, 1, 1, 1, 0, 0, 0, 0, 0};
+    scanSamples(scanner, 0, samples, sizeof(samples));
+
+    KeypadEvent event = {0, false};
+
+    CHECK(!scanner.pop(event));
+}
+
+void testOverrun()
+{
+    sim::reset();
+    releaseAll();
+
+    KeypadScanner scanner(KEYMAP, ROW_PINS, COL_PINS, ROWS, COLS);
+    scanner.begin();
+
+    const uint8_t samples[] = {1, 1, 1, 1, 0, 0, 0, 0};
+
+    // 10 presses and releases while loop() is blocked: the FIFO keeps 15
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        scanSamples(scanner, i % COLS, samples, sizeof(samples));
+    }
+
+    CHECK(scanner.getOverruns() == 5);
+
+    KeypadEvent event = {0, false};
+    uint8_t numEvents = 0;
+
+    while (scanner.pop(event))
+    {
+        CHECK(event.key == KEYMAP[(numEvents / 2) % COLS]);
+        CHECK(event.isPressed == (numEvents % 2 == 0));
+        numEvents++;
+    }
+
+    CHECK(numEvents == KEYPAD_SCANNER_FIFO_SIZE - 1);
+}
+
+int naiveMatch(const std::string &keys)
+{
+    if (keys.size() < CODE_SIZE)
+    {
+        return CODE_MATCHER_NONE;
+    }
+
+    std::string last = keys.substr(keys.size() - CODE_SIZE);
+
+    for (uint8_t k = 0; k < NUM_CODES; k++)
+    {
+        if (last.compare(0, CODE_SIZE, CODES + k * CODE_SIZE, CODE_SIZE) == 0)
+        {
+            return k;
+        }
+    }
+
+    return CODE_MATCHER_NONE;
+}
+
+void testMatcher()
+{
+    CodeMatcher matcher(CODES, NUM_CODES, CODE_SIZE);
+    std::string keys;
+    long numMismatches = 0;
+    long numMatches = 0;
+
+    srand(3);
+
+    for (long i = 0; i < NUM_RANDOM_KEYS; i++)
+    {
+        std::string input;
+
+        // Now and then type a whole code, otherwise a random digit
+        if (rand() % 50 == 0)
+        {
+            input.assign(CODES + (rand() % NUM_CODES) * CODE_SIZE, CODE_SIZE);
+        }
+        else
+        {
+            input = (char)('0' + rand() % 10);
+        }
+
+        for (size_t j = 0; j < input.size(); j++)
+        {
+            keys += input[j];
+
+            int8_t expected = naiveMatch(keys);
+            int8_t actual = matcher.push(input[j]);
+
+            if (actual != expected)
+            {
+                numMismatches++;
+            }
+
+            if (expected != CODE_MATCHER_NONE)
+            {
+                numMatches++;
+                matcher.clear();
+                keys.clear();
+            }
+        }
+    }
+
+    printf("matcher: %ld matches, %ld mismatches\n", numMatches, numMismatches);
+
+    CHECK(numMismatches == 0);
+    CHECK(numMatches > 0);
+}
+
+int main()
+{
+    testBounce();
+    testShortGlitch();
+    testOverrun();
+    testMatcher();
+
+    printf(numFailures == 0 ? "OK\n" : "FAILED\n");
+
+    return numFailures == 0 ? 0 : 1;
+}
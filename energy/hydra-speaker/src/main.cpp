@@ -1,3 +1,4 @@
+#include "AudioFxScheduler.h"
 #include <Adafruit_NeoPixel.h>
 #include <SerialRFID.h>
 #include <SoftwareSerial.h>
@@ -46,6 +47,9 @@ const byte AUDIO_TRACK_PINS[NUM_TRACKS] = {
 
 const unsigned long AUDIO_TRACK_MAX_MS = 50000;
 const int AUDIO_EFFECT_DELAY_MS = 500;
+const unsigned long AUDIO_TRIGGER_MS = 200;
+
+AudioFxScheduler audio(PIN_AUDIO_ACT, AUDIO_TRIGGER_MS);
 
 /**
  * LED strip.
@@ -85,35 +89,15 @@ const uint32_t AUDIO_TRACK_COLORS[NUM_TRACKS] = {
  * Audio FX functions.
  */
 
-bool isTrackPlaying()
-{
-    return digitalRead(PIN_AUDIO_ACT) == LOW;
-}
-
-void playTrack(byte trackPin)
-{
-    if (isTrackPlaying()) {
-        Serial.println(F("Skipping: Audio still playing"));
-        return;
-    }
-
-    Serial.print(F("Playing track on pin: "));
-    Serial.println(trackPin);
-
-    digitalWrite(trackPin, LOW);
-    pinMode(trackPin, OUTPUT);
-    delay(200);
-    pinMode(trackPin, INPUT);
-}
-
 void initAudioPins()
 {
     for (int i = 0; i < NUM_TRACKS; i++) {
         pinMode(AUDIO_TRACK_PINS[i], INPUT);
     }
 
-    pinMode(PIN_AUDIO_ACT, INPUT);
     pinMode(PIN_AUDIO_RST, INPUT);
+
+    audio.begin();
 }
 
 void resetAudio()
@@ -153,9 +137,9 @@ void displayAudioLedEffect(int tagIdx)
 
     int currTarget;
 
-    delay(AUDIO_EFFECT_DELAY_MS);
+    audio.wait(AUDIO_EFFECT_DELAY_MS);
 
-    while (isTrackPlaying() && !timeout) {
+    while (audio.isBusy() && !timeout) {
         currTarget = random(limitLo, limitHi);
 
         clearLeds();
@@ -163,13 +147,13 @@ void displayAudioLedEffect(int tagIdx)
         for (int i = 0; i < currTarget; i++) {
             pixelStrip.setPixelColor(i, trackColor);
             pixelStrip.show();
-            delay(LED_EFFECT_STEP_MS);
+            audio.wait(LED_EFFECT_STEP_MS);
         }
 
         for (int i = (currTarget - 1); i >= 0; i--) {
             pixelStrip.setPixelColor(i, 0);
             pixelStrip.show();
-            delay(LED_EFFECT_STEP_MS);
+            audio.wait(LED_EFFECT_STEP_MS);
         }
 
         now = millis();
@@ -231,7 +215,10 @@ void readTagAndPlayAudio()
         return;
     }
 
-    playTrack(AUDIO_TRACK_PINS[tagIdx]);
+    if (!audio.play(AUDIO_TRACK_PINS[tagIdx], AUDIO_FX_SKIP_IF_BUSY)) {
+        return;
+    }
+
     displayAudioLedEffect(tagIdx);
 }
 
@@ -254,6 +241,7 @@ void setup()
 
 void loop()
 {
+    audio.update();
     readTagAndPlayAudio();
-    delay(100);
+    audio.wait(100);
 }
@@ -0,0 +1,245 @@
+#ifndef BLOB_RENDERER_H
+#define BLOB_RENDERER_H
+
+#include <Arduino.h>
+
+/**
+ * Time-based renderer for blobs of light moving along a LED strip.
+ *
+ * A blob's position is a function of the time since it started. It is
+ * interpolated in 24.8 fixed point between the keyframes of its curve, so
+ * the motion does not depend on how often render() is called and the
+ * per-segment speed can vary (a speed curve).
+ *
+ * Pixels are anti-aliased by coverage: a pixel that the blob covers by a
+ * fraction f is drawn at f x its color. Coverage from concurrent blobs is
+ * added up and saturates at 1.
+ *
+ * render() only rewrites pixels whose coverage can have changed since the
+ * previous frame: the ranges between the old and new head and tail of
+ * every blob. The fully covered interior and the rest of the strip are
+ * not touched, so the strip must not be cleared between frames.
+ */
+
+const uint16_t BLOB_ONE = 256;
+
+typedef struct blobKeyframe
+{
+    uint16_t ms;
+    int16_t px;
+} BlobKeyframe;
+
+typedef struct blob
+{
+    const BlobKeyframe *curve;
+    uint8_t curveSize;
+    uint8_t size;
+    unsigned long startMillis;
+    bool isActive;
+    bool hasFrame;
+    int16_t frameFirst;
+    int16_t frameLast;
+} Blob;
+
+template <typename Strip>
+class BlobRenderer
+{
+public:
+    BlobRenderer(
+        Strip &strip,
+        Blob *blobs,
+        uint8_t numBlobs,
+        uint32_t (*colorAt)(uint16_t))
+        : strip(strip),
+          blobs(blobs),
+          numBlobs(numBlobs),
+          colorAt(colorAt)
+    {
+    }
+
+    void start(uint8_t idx, unsigned long now)
+    {
+        blobs[idx].startMillis = now;
+        blobs[idx].isActive = true;
+    }
+
+    void stop(uint8_t idx)
+    {
+        blobs[idx].isActive = false;
+    }
+
+    bool isActive(uint8_t idx) const
+    {
+        return blobs[idx].isActive;
+    }
+
+    /**
+     * True once the blob has reached the last keyframe of its curve.
+     */
+    bool isFinished(uint8_t idx, unsigned long now) const
+    {
+        const Blob &blob = blobs[idx];
+        uint16_t lastMs = blob.curve[blob.curveSize - 1].ms;
+
+        return !blob.isActive || now - blob.startMillis >= lastMs;
+    }
+
+    /**
+     * Position of the blob tail in 1/256 pixels.
+     */
+    int32_t positionQ8(uint8_t idx, unsigned long now) const
+    {
+        const Blob &blob = blobs[idx];
+        unsigned long elapsed = now - blob.startMillis;
+
+        const BlobKeyframe *curve = blob.curve;
+        uint8_t last = blob.curveSize - 1;
+
+        if (elapsed >= curve[last].ms)
+        {
+            return (int32_t)curve[last].px * BLOB_ONE;
+        }
+
+        uint8_t k = 0;
+
+        while (k < last - 1 && elapsed >= curve[k + 1].ms)
+        {
+            k++;
+        }
+
+        int32_t span = curve[k + 1].ms - curve[k].ms;
+        int32_t dt = elapsed - curve[k].ms;
+        int32_t dpx = curve[k + 1].px - curve[k].px;
+
+        return (int32_t)curve[k].px * BLOB_ONE + (dpx * BLOB_ONE * dt) / span;
+    }
+
+    /**
+     * Writes the pixels that changed since the previous frame.
+     * The caller is responsible for calling show().
+     */
+    void render(unsigned long now)
+    {
+        int16_t numPix = strip.numPixels();
+
+        for (uint8_t b = 0; b < numBlobs; b++)
+        {
+            Blob &blob = blobs[b];
+
+            bool hadFrame = blob.hasFrame;
+            int16_t oldFirst = blob.frameFirst;
+            int16_t oldLast = blob.frameLast;
+
+            int16_t first = 0;
+            int16_t last = -1;
+
+            if (blob.isActive)
+            {
+                int32_t tail = positionQ8(b, now);
+                int32_t head = tail + (int32_t)blob.size * BLOB_ONE - 1;
+
+                first = max(floorPixel(tail), (int16_t)0);
+                last = min(floorPixel(head), (int16_t)(numPix - 1));
+            }
+
+            blob.hasFrame = first <= last;
+            blob.frameFirst = first;
+            blob.frameLast = last;
+
+            if (!hadFrame && !blob.hasFrame)
+            {
+                continue;
+            }
+
+            if (!hadFrame || !blob.hasFrame)
+            {
+                // Appeared or vanished: redraw the whole old or new span
+                drawRange(
+                    hadFrame ? oldFirst : first,
+                    hadFrame ? oldLast : last,
+                    now);
+
+                continue;
+            }
+
+            drawRange(min(oldFirst, first), max(oldFirst, first), now);
+            drawRange(min(oldLast, last), max(oldLast, last), now);
+        }
+    }
+
+private:
+    Strip &strip;
+    Blob *blobs;
+    uint8_t numBlobs;
+    uint32_t (*colorAt)(uint16_t);
+
+    static int16_t floorPixel(int32_t q8)
+    {
+        return q8 >= 0 ? q8 / BLOB_ONE : -((-q8 + BLOB_ONE - 1) / BLOB_ONE);
+    }
+
+    uint16_t coverage(int16_t pixel, unsigned long now) const
+    {
+        int32_t pixelIni = (int32_t)pixel * BLOB_ONE;
+        int32_t pixelEnd = pixelIni + BLOB_ONE;
+        uint16_t total = 0;
+
+        for (uint8_t b = 0; b < numBlobs; b++)
+        {
+            if (!blobs[b].isActive)
+            {
+                continue;
+            }
+
+            int32_t tail = positionQ8(b, now);
+            int32_t head = tail + (int32_t)blobs[b].size * BLOB_ONE;
+            int32_t overlap = min(head, pixelEnd) - max(tail, pixelIni);
+
+            if (overlap > 0)
+            {
+                total += overlap;
+            }
+
+            if (total >= BLOB_ONE)
+            {
+                return BLOB_ONE;
+            }
+        }
+
+        return total;
+    }
+
+    void drawRange(int16_t first, int16_t last, unsigned long now)
+    {
+        for (int16_t i = first; i <= last; i++)
+        {
+            drawPixel(i, now);
+        }
+    }
+
+    void drawPixel(int16_t i, unsigned long now)
+    {
+        uint16_t cov = coverage(i, now);
+
+        if (cov == 0)
+        {
+            strip.setPixelColor(i, 0);
+            return;
+        }
+
+        uint32_t color = colorAt(i);
+
+        if (cov < BLOB_ONE)
+        {
+            uint8_t r = (uint8_t)(color >> 16) * cov >> 8;
+            uint8_t g = (uint8_t)(color >> 8) * cov >> 8;
+            uint8_t b = (uint8_t)color * cov >> 8;
+
+            color = ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+        }
+
+        strip.setPixelColor(i, color);
+    }
+};
+
+#endif
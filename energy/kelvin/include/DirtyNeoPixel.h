@@ -0,0 +1,283 @@
+#ifndef DIRTY_NEOPIXEL_H
+#define DIRTY_NEOPIXEL_H
+
+#include <Adafruit_NeoPixel.h>
+
+/**
+ * NeoPixel strip that only transfers its buffer when pixels have changed.
+ *
+ * Writes are compared against the buffer and widen a dirty range, so
+ * redrawing identical content is free. clear() is deferred until show():
+ * pixels that are redrawn afterwards are compared against what is on the
+ * strip and only the ones left untouched are blanked. This makes the usual
+ * clear() + setPixelColor() + show() refresh cost nothing when the frame
+ * did not change.
+ *
+ * show() skips the transfer when the strip is clean. With a frame interval
+ * set it transfers at most once per interval; tick() (called from loop())
+ * flushes a frame that was held back.
+ */
+
+class DirtyNeoPixel : public Adafruit_NeoPixel
+{
+public:
+    DirtyNeoPixel(
+        uint16_t n,
+        uint16_t pin,
+        neoPixelType type,
+        unsigned long frameMs = 0)
+        : Adafruit_NeoPixel(n, pin, type),
+          touched((uint8_t *)calloc((n + 7) / 8, 1)),
+          isClearPending(false),
+          dirtyFirst(0),
+          dirtyLast(n > 0 ? n - 1 : 0),
+          isDirty(n > 0),
+          frameMs(frameMs),
+          lastShow(0),
+          generation(0)
+    {
+    }
+
+    DirtyNeoPixel(const DirtyNeoPixel &) = delete;
+    DirtyNeoPixel &operator=(const DirtyNeoPixel &) = delete;
+
+    ~DirtyNeoPixel()
+    {
+        free(touched);
+    }
+
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b)
+    {
+        uint8_t prev[4];
+
+        if (!beginWrite(n, prev))
+        {
+            return;
+        }
+
+        Adafruit_NeoPixel::setPixelColor(n, r, g, b);
+        endWrite(n, prev);
+    }
+
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+    {
+        uint8_t prev[4];
+
+        if (!beginWrite(n, prev))
+        {
+            return;
+        }
+
+        Adafruit_NeoPixel::setPixelColor(n, r, g, b, w);
+        endWrite(n, prev);
+    }
+
+    void setPixelColor(uint16_t n, uint32_t c)
+    {
+        uint8_t prev[4];
+
+        if (!beginWrite(n, prev))
+        {
+            return;
+        }
+
+        Adafruit_NeoPixel::setPixelColor(n, c);
+        endWrite(n, prev);
+    }
+
+    void fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0)
+    {
+        if (first >= numLEDs)
+        {
+            return;
+        }
+
+        uint16_t end = count == 0 ? numLEDs : first + count;
+        end = end > numLEDs ? numLEDs : end;
+
+        for (uint16_t i = first; i < end; i++)
+        {
+            setPixelColor(i, c);
+        }
+    }
+
+    void clear()
+    {
+        if (touched == NULL)
+        {
+            Adafruit_NeoPixel::clear();
+            markDirty(0, numLEDs - 1);
+            return;
+        }
+
+        memset(touched, 0, (numLEDs + 7) / 8);
+        isClearPending = true;
+    }
+
+    uint32_t getPixelColor(uint16_t n) const
+    {
+        if (isClearPending && !isTouched(n))
+        {
+            return 0;
+        }
+
+        return Adafruit_NeoPixel::getPixelColor(n);
+    }
+
+    void setBrightness(uint8_t b)
+    {
+        if (b != getBrightness())
+        {
+            markDirty(0, numLEDs - 1);
+        }
+
+        Adafruit_NeoPixel::setBrightness(b);
+    }
+
+    /**
+     * Transfers the buffer if it changed since the last transfer.
+     * Returns true when the strip was actually written.
+     */
+    bool show()
+    {
+        resolveClear();
+
+        if (!isDirty)
+        {
+            return false;
+        }
+
+        unsigned long now = millis();
+
+        if (frameMs > 0 && generation > 0 && now - lastShow < frameMs)
+        {
+            return false;
+        }
+
+        Adafruit_NeoPixel::show();
+
+        lastShow = now;
+        isDirty = false;
+        generation++;
+
+        return true;
+    }
+
+    bool tick()
+    {
+        return show();
+    }
+
+    bool needsShow() const
+    {
+        return isDirty || isClearPending;
+    }
+
+    uint16_t getDirtyFirst() const
+    {
+        return dirtyFirst;
+    }
+
+    uint16_t getDirtyLast() const
+    {
+        return dirtyLast;
+    }
+
+    uint32_t getGeneration() const
+    {
+        return generation;
+    }
+
+private:
+    uint8_t *touched;
+    bool isClearPending;
+    uint16_t dirtyFirst;
+    uint16_t dirtyLast;
+    bool isDirty;
+    unsigned long frameMs;
+    unsigned long lastShow;
+    uint32_t generation;
+
+    uint8_t bytesPerPixel() const
+    {
+        return wOffset == rOffset ? 3 : 4;
+    }
+
+    bool isTouched(uint16_t n) const
+    {
+        return touched[n >> 3] & (1 << (n & 7));
+    }
+
+    void markDirty(uint16_t first, uint16_t last)
+    {
+        if (!isDirty)
+        {
+            dirtyFirst = first;
+            dirtyLast = last;
+            isDirty = true;
+            return;
+        }
+
+        dirtyFirst = first < dirtyFirst ? first : dirtyFirst;
+        dirtyLast = last > dirtyLast ? last : dirtyLast;
+    }
+
+    bool beginWrite(uint16_t n, uint8_t *prev)
+    {
+        if (n >= numLEDs || pixels == NULL)
+        {
+            return false;
+        }
+
+        if (isClearPending)
+        {
+            touched[n >> 3] |= 1 << (n & 7);
+        }
+
+        memcpy(prev, &pixels[n * bytesPerPixel()], bytesPerPixel());
+
+        return true;
+    }
+
+    void endWrite(uint16_t n, const uint8_t *prev)
+    {
+        if (memcmp(prev, &pixels[n * bytesPerPixel()], bytesPerPixel()) != 0)
+        {
+            markDirty(n, n);
+        }
+    }
+
+    void resolveClear()
+    {
+        if (!isClearPending)
+        {
+            return;
+        }
+
+        isClearPending = false;
+
+        uint8_t bpp = bytesPerPixel();
+
+        for (uint16_t i = 0; i < numLEDs; i++)
+        {
+            if (isTouched(i))
+            {
+                continue;
+            }
+
+            uint8_t *p = &pixels[i * bpp];
+
+            for (uint8_t j = 0; j < bpp; j++)
+            {
+                if (p[j] != 0)
+                {
+                    memset(p, 0, bpp);
+                    markDirty(i, i);
+                    break;
+                }
+            }
+        }
+    }
+};
+
+#endif
@@ -1,6 +1,11 @@
 #include <Adafruit_NeoPixel.h>
 #include <Automaton.h>
 #include <limits.h>
+#include "DirtyNeoPixel.h"
+#include "BlobRenderer.h"
+
+// #define LOOP_PROFILER
+#include "LoopProfiler.h"
 
 /**
  * Energy LED strip.
@@ -11,7 +16,7 @@ const uint16_t LED_ENERGY_NUM = 89;
 const uint16_t LED_ENERGY_PIN = 2;
 const uint16_t LED_ENERGY_BLOB_SIZE = 10;
 
-Adafruit_NeoPixel ledEnergy = Adafruit_NeoPixel(
+DirtyNeoPixel ledEnergy(
     LED_ENERGY_NUM,
     LED_ENERGY_PIN,
     NEO_GRB + NEO_KHZ800);
@@ -25,15 +30,27 @@ const uint32_t COLOR_COLD = Adafruit_NeoPixel::gamma32(
 const uint32_t COLOR_HOT = Adafruit_NeoPixel::gamma32(
     Adafruit_NeoPixel::Color(255, 0, 0));
 
-const uint16_t LED_ENERGY_MODULO_SLOW = 1;
-const uint16_t LED_ENERGY_MODULO_MEDIUM = 1;
-const uint16_t LED_ENERGY_MODULO_FAST = 1;
+// Blob tail position (pixels) over time (ms): 50 pixels/s, as the old
+// one pixel per 20 ms tick. The blob slides off the end of the strip.
+const BlobKeyframe LED_ENERGY_CURVE[] = {
+    { 0, 0 },
+    { 1780, LED_ENERGY_NUM }
+};
+
+const uint8_t LED_ENERGY_CURVE_SIZE = sizeof(LED_ENERGY_CURVE) / sizeof(BlobKeyframe);
+
+const uint8_t LED_ENERGY_NUM_BLOBS = 1;
 
-const uint16_t LED_ENERGY_HIDDEN_PATCH_SIZE = 7;
+Blob ledEnergyBlobs[LED_ENERGY_NUM_BLOBS] = {
+    { LED_ENERGY_CURVE, LED_ENERGY_CURVE_SIZE, LED_ENERGY_BLOB_SIZE }
+};
+
+const unsigned long LED_ENERGY_HIDDEN_PATCH_MS = 140;
 
 Atm_timer timerLedEnergy;
 
-const int LED_ENERGY_TIMER_MS = 20;
+// Only the frame rate: positions depend on millis()
+const int LED_ENERGY_TIMER_MS = 10;
 
 /**
  * Progress LED strip.
@@ -43,7 +60,7 @@ const uint8_t LED_PROGRESS_BRIGHTNESS = 150;
 const uint16_t LED_PROGRESS_NUM = 30;
 const uint16_t LED_PROGRESS_PIN = A1;
 
-Adafruit_NeoPixel ledProgress = Adafruit_NeoPixel(
+DirtyNeoPixel ledProgress(
     LED_PROGRESS_NUM,
     LED_PROGRESS_PIN,
     NEO_GRB + NEO_KHZ800);
@@ -67,23 +84,19 @@ const uint16_t LED_INDICATOR_PIN[SIZE_LED_INDICATOR] = {
     3, 4, 5, 6
 };
 
-Adafruit_NeoPixel ledIndicators[SIZE_LED_INDICATOR] = {
-    Adafruit_NeoPixel(
-        LED_INDICATOR_NUM[0],
+DirtyNeoPixel ledIndicators[SIZE_LED_INDICATOR] = {
+    { LED_INDICATOR_NUM[0],
         LED_INDICATOR_PIN[0],
-        NEO_GRB + NEO_KHZ800),
-    Adafruit_NeoPixel(
-        LED_INDICATOR_NUM[1],
+        NEO_GRB + NEO_KHZ800 },
+    { LED_INDICATOR_NUM[1],
         LED_INDICATOR_PIN[1],
-        NEO_GRB + NEO_KHZ800),
-    Adafruit_NeoPixel(
-        LED_INDICATOR_NUM[2],
+        NEO_GRB + NEO_KHZ800 },
+    { LED_INDICATOR_NUM[2],
         LED_INDICATOR_PIN[2],
-        NEO_GRB + NEO_KHZ800),
-    Adafruit_NeoPixel(
-        LED_INDICATOR_NUM[3],
+        NEO_GRB + NEO_KHZ800 },
+    { LED_INDICATOR_NUM[3],
         LED_INDICATOR_PIN[3],
-        NEO_GRB + NEO_KHZ800)
+        NEO_GRB + NEO_KHZ800 }
 };
 
 const uint8_t SIZE_COLORS_INDICATOR = 4;
@@ -140,10 +153,9 @@ Atm_led btnsEnergyLeds[BTN_ENERGY_NUM];
 uint8_t ledIndicatorColorIdx[SIZE_LED_INDICATOR];
 
 typedef struct programState {
-    uint16_t ledEnergyPivot;
     uint16_t ledEnergyLoop;
-    uint16_t ledEnergyTickCounter;
-    uint16_t ledEnergyHiddenCountdown;
+    bool isLedEnergyHidden;
+    unsigned long ledEnergyHiddenMillis;
     uint8_t* ledIndicatorColorIdx;
     int16_t progressLevel;
     bool indicatorOk;
@@ -153,10 +165,9 @@ ProgramState progState;
 
 void initState()
 {
-    progState.ledEnergyPivot = 0;
     progState.ledEnergyLoop = 0;
-    progState.ledEnergyTickCounter = 0;
-    progState.ledEnergyHiddenCountdown = 0;
+    progState.isLedEnergyHidden = false;
+    progState.ledEnergyHiddenMillis = 0;
     progState.ledIndicatorColorIdx = ledIndicatorColorIdx;
     progState.progressLevel = 0;
     progState.indicatorOk = false;
@@ -206,6 +217,8 @@ void showStartEffect()
 
 void showFinishEffect(int numLoops = 2)
 {
+    PROFILE_SECTION(PROFILE_SECTION_LED);
+
     const uint16_t delayMs = 100;
 
     numLoops = numLoops <= 0 ? INT_MAX : numLoops;
@@ -252,6 +265,8 @@ void initLedProgress()
 
 void refreshLedProgress()
 {
+    PROFILE_SECTION(PROFILE_SECTION_LED);
+
     uint16_t pixelsPerLevel = ceil(ledProgress.numPixels() / PROGRESS_LEVEL_MAX);
     uint16_t totalPixels = progState.progressLevel * pixelsPerLevel;
 
@@ -317,9 +332,19 @@ uint32_t getEnergyPixelColor(uint16_t idx)
     return isOverSurface ? COLOR_COLD : COLOR_HOT;
 }
 
-uint16_t getCurrentEnergyTickModulo()
+BlobRenderer<DirtyNeoPixel> ledEnergyRenderer(
+    ledEnergy,
+    ledEnergyBlobs,
+    LED_ENERGY_NUM_BLOBS,
+    getEnergyPixelColor);
+
+void startLedEnergyLoop(unsigned long now)
 {
-    return LED_ENERGY_MODULO_SLOW;
+    progState.isLedEnergyHidden = false;
+
+    for (uint8_t i = 0; i < LED_ENERGY_NUM_BLOBS; i++) {
+        ledEnergyRenderer.start(i, now);
+    }
 }
 
 void onEnergyPress(int idx, int v, int up)
@@ -327,9 +352,9 @@ void onEnergyPress(int idx, int v, int up)
     Serial.print(F("Energy button: "));
     Serial.println(idx);
 
-    if (progState.ledEnergyHiddenCountdown > 0) {
+    if (progState.isLedEnergyHidden) {
         addProgress();
-        progState.ledEnergyHiddenCountdown = 0;
+        startLedEnergyLoop(millis());
     } else {
         removeProgress();
     }
@@ -363,51 +388,42 @@ void setEnergyButtonLeds(bool on)
     }
 }
 
-void ledEnergyRefreshTick()
-{
-    uint16_t mod = getCurrentEnergyTickModulo();
-    progState.ledEnergyTickCounter++;
-    progState.ledEnergyTickCounter = progState.ledEnergyTickCounter % mod;
-}
-
-bool shouldRefreshLedEnergy()
-{
-    return progState.ledEnergyTickCounter == 0;
-}
-
+/**
+ * The blob loop ends when the first blob has left the strip.
+ * Then the strip stays dark for the hidden patch window.
+ */
 void refreshLedEnergy()
 {
-    ledEnergy.clear();
-
-    if (progState.ledEnergyHiddenCountdown > 0) {
-        setEnergyButtonLeds(true);
-        progState.ledEnergyHiddenCountdown--;
-        ledEnergy.show();
-        return;
-    }
-
-    setEnergyButtonLeds(false);
+    PROFILE_SECTION(PROFILE_SECTION_LED);
 
-    uint16_t numPix = ledEnergy.numPixels();
+    unsigned long now = millis();
 
-    uint16_t ledIni = progState.ledEnergyPivot;
-    uint16_t ledEnd = ledIni + LED_ENERGY_BLOB_SIZE - 1;
-    ledEnd = ledEnd >= numPix ? numPix - 1 : ledEnd;
+    if (progState.isLedEnergyHidden) {
+        if (now - progState.ledEnergyHiddenMillis < LED_ENERGY_HIDDEN_PATCH_MS) {
+            setEnergyButtonLeds(true);
+            return;
+        }
 
-    for (uint16_t i = ledIni; i <= ledEnd; i++) {
-        ledEnergy.setPixelColor(i, getEnergyPixelColor(i));
+        startLedEnergyLoop(now);
+    } else if (!ledEnergyRenderer.isActive(0)) {
+        startLedEnergyLoop(now);
     }
 
-    progState.ledEnergyPivot++;
+    if (ledEnergyRenderer.isFinished(0, now)) {
+        for (uint8_t i = 0; i < LED_ENERGY_NUM_BLOBS; i++) {
+            ledEnergyRenderer.stop(i);
+        }
 
-    if (progState.ledEnergyPivot >= numPix) {
-        progState.ledEnergyPivot = 0;
         progState.ledEnergyLoop++;
-        progState.ledEnergyHiddenCountdown = LED_ENERGY_HIDDEN_PATCH_SIZE;
+        progState.isLedEnergyHidden = true;
+        progState.ledEnergyHiddenMillis = now;
         setEnergyButtonLeds(true);
         Serial.println(F("Hidden patch: enter"));
+    } else {
+        setEnergyButtonLeds(false);
     }
 
+    ledEnergyRenderer.render(now);
     ledEnergy.show();
 }
 
@@ -419,11 +435,7 @@ void onLedEnergyTimer(int idx, int v, int up)
         return;
     }
 
-    if (shouldRefreshLedEnergy()) {
-        refreshLedEnergy();
-    }
-
-    ledEnergyRefreshTick();
+    refreshLedEnergy();
 }
 
 void initLedEnergyTimer()
@@ -450,6 +462,8 @@ void initLedIndicators()
 
 void refreshLedIndicators()
 {
+    PROFILE_SECTION(PROFILE_SECTION_LED);
+
     uint32_t color;
 
     for (int i = 0; i < SIZE_LED_INDICATOR; i++) {
@@ -539,5 +553,6 @@ void setup()
 
 void loop()
 {
+    PROFILE_LOOP();
     automaton.run();
 }
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include <random>
+#include <unity.h>
+#include <ArduinoSim.h>
+#include "BlobRenderer.h"
+
+/**
+ * BlobRenderer against a reference that redraws every pixel from its
+ * coverage on every frame: `pio test -e native`.
+ */
+
+const uint16_t NUM_PIXELS = 60;
+
+/**
+ * Plain pixel buffer: no brightness, so colors read back as written.
+ */
+class FakeStrip
+{
+public:
+    FakeStrip() : writes(0)
+    {
+        clear();
+    }
+
+    uint16_t numPixels() const
+    {
+        return NUM_PIXELS;
+    }
+
+    void setPixelColor(uint16_t n, uint32_t c)
+    {
+        if (n < NUM_PIXELS) {
+            pixels[n] = c;
+            writes++;
+        }
+    }
+
+    uint32_t getPixelColor(uint16_t n) const
+    {
+        return pixels[n];
+    }
+
+    void clear()
+    {
+        for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+            pixels[i] = 0;
+        }
+    }
+
+    unsigned long writes;
+
+private:
+    uint32_t pixels[NUM_PIXELS];
+};
+
+const uint32_t COLOR_A = 0xFF8000;
+const uint32_t COLOR_B = 0x20C0FF;
+
+uint32_t colorAt(uint16_t idx)
+{
+    return idx < NUM_PIXELS / 2 ? COLOR_A : COLOR_B;
+}
+
+// A fast start then a slow end, and a blob that goes back and forth
+const BlobKeyframe CURVE_A[] = {
+    { 0, -8 },
+    { 400, 30 },
+    { 1600, 62 }
+};
+
+const BlobKeyframe CURVE_B[] = {
+    { 0, 50 },
+    { 700, 5 },
+    { 1300, 40 }
+};
+
+Blob blobs[2];
+
+void initBlobs()
+{
+    blobs[0] = { CURVE_A, 3, 8 };
+    blobs[1] = { CURVE_B, 3, 5 };
+}
+
+/**
+ * Color of a pixel drawn from scratch.
+ */
+uint32_t referenceColor(const BlobRenderer<FakeStrip> &renderer, uint16_t pixel, unsigned long now)
+{
+    int32_t pixelIni = (int32_t)pixel * BLOB_ONE;
+    int32_t pixelEnd = pixelIni + BLOB_ONE;
+    int32_t total = 0;
+
+    for (uint8_t b = 0; b < 2; b++) {
+        if (!renderer.isActive(b)) {
+            continue;
+        }
+
+        int32_t tail = renderer.positionQ8(b, now);
+        int32_t head = tail + (int32_t)blobs[b].size * BLOB_ONE;
+        int32_t overlap = (head < pixelEnd ? head : pixelEnd) - (tail > pixelIni ? tail : pixelIni);
+
+        total += overlap > 0 ? overlap : 0;
+    }
+
+    if (total == 0) {
+        return 0;
+    }
+
+    if (total >= BLOB_ONE) {
+        return colorAt(pixel);
+    }
+
+    uint32_t color = colorAt(pixel);
+    uint8_t r = (uint8_t)(color >> 16) * total >> 8;
+    uint8_t g = (uint8_t)(color >> 8) * total >> 8;
+    uint8_t b = (uint8_t)color * total >> 8;
+
+    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
+
+int countMismatches(const BlobRenderer<FakeStrip> &renderer, const FakeStrip &strip, unsigned long now)
+{
+    int mismatches = 0;
+
+    for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+        mismatches += strip.getPixelColor(i) != referenceColor(renderer, i, now);
+    }
+
+    return mismatches;
+}
+
+void setUp()
+{
+    initBlobs();
+}
+
+void tearDown()
+{
+}
+
+void test_position_follows_keyframes()
+{
+    FakeStrip strip;
+    BlobRenderer<FakeStrip> renderer(strip, blobs, 2, colorAt);
+
+    renderer.start(0, 1000);
+
+    TEST_ASSERT_EQUAL_INT32(-8 * BLOB_ONE, renderer.positionQ8(0, 1000));
+    TEST_ASSERT_EQUAL_INT32(30 * BLOB_ONE, renderer.positionQ8(0, 1400));
+    TEST_ASSERT_EQUAL_INT32(46 * BLOB_ONE, renderer.positionQ8(0, 2000));
+    TEST_ASSERT_EQUAL_INT32(62 * BLOB_ONE, renderer.positionQ8(0, 2600));
+    TEST_ASSERT_EQUAL_INT32(62 * BLOB_ONE, renderer.positionQ8(0, 9000));
+
+    // Half way through the first segment: -8 + 38 / 2
+    TEST_ASSERT_EQUAL_INT32(11 * BLOB_ONE, renderer.positionQ8(0, 1200));
+
+    TEST_ASSERT_FALSE(renderer.isFinished(0, 2599));
+    TEST_ASSERT_TRUE(renderer.isFinished(0, 2600));
+}
+
+void test_matches_reference_at_random_frame_intervals()
+{
+    FakeStrip strip;
+    BlobRenderer<FakeStrip> renderer(strip, blobs, 2, colorAt);
+    std::mt19937 rng(7);
+
+    unsigned long now = 5000;
+    int frames = 0;
+    int mismatches = 0;
+
+    renderer.start(0, now);
+    renderer.start(1, now + 250);
+
+    while (!renderer.isFinished(0, now) || !renderer.isFinished(1, now)) {
+        renderer.render(now);
+        mismatches += countMismatches(renderer, strip, now);
+        frames++;
+
+        now += 3 + rng() % 15;
+    }
+
+    renderer.stop(0);
+    renderer.stop(1);
+    renderer.render(now);
+
+    char message[64];
+    snprintf(message, sizeof(message), "%d frames", frames);
+    TEST_MESSAGE(message);
+
+    TEST_ASSERT_GREATER_THAN(100, frames);
+    TEST_ASSERT_EQUAL_INT(0, mismatches);
+
+    for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+        TEST_ASSERT_EQUAL_HEX32(0, strip.getPixelColor(i));
+    }
+}
+
+void test_only_changed_pixels_are_written()
+{
+    FakeStrip strip;
+    BlobRenderer<FakeStrip> renderer(strip, blobs, 1, colorAt);
+
+    renderer.start(0, 0);
+    renderer.render(400);
+
+    unsigned long writes = strip.writes;
+
+    // Nothing moved: only the pixel at each end is redrawn
+    renderer.render(400);
+    TEST_ASSERT_EQUAL_UINT32(writes + 2, strip.writes);
+
+    // A step of less than a pixel touches the ends, not the interior
+    writes = strip.writes;
+    renderer.render(410);
+    TEST_ASSERT_LESS_OR_EQUAL(writes + 4, strip.writes);
+    TEST_ASSERT_EQUAL_INT(0, countMismatches(renderer, strip, 410));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_position_follows_keyframes);
+    RUN_TEST(test_matches_reference_at_random_frame_intervals);
+    RUN_TEST(test_only_changed_pixels_are_written);
+    return UNITY_END();
+}
@@ -0,0 +1,190 @@
+#include <chrono>
+#include <string>
+#include <unity.h>
+#include <ArduinoSim.h>
+#include "DirtyNeoPixel.h"
+#include "BlobRenderer.h"
+
+/**
+ * Runs the kelvin sketch against the virtual clock of the native
+ * simulation: `pio test -e native`.
+ */
+
+extern DirtyNeoPixel ledEnergy;
+extern DirtyNeoPixel ledIndicators[];
+extern Blob ledEnergyBlobs[];
+
+const uint8_t BTN_INDICATOR_PINS[] = {7, 8, 9, 10};
+const uint8_t BTN_ENERGY_PIN = 11;
+const uint8_t BTN_ENERGY_LED_PIN = A2;
+
+// Presses that take each indicator from its first color to the key
+const uint8_t INDICATOR_PRESSES[] = {2, 0, 3, 1};
+
+const unsigned long BLOB_LOOP_MS = 1780;
+const unsigned long HIDDEN_PATCH_MS = 140;
+const unsigned long INDICATOR_TICK_MS = 200;
+
+bool serialContains(const char *text)
+{
+    return sim::serialOutput().find(text) != std::string::npos;
+}
+
+/**
+ * Runs the sketch 1 ms at a time until text is printed.
+ * Returns the time it took, or maxMs + 1 if it was not printed.
+ */
+unsigned long runUntil(const char *text, unsigned long maxMs)
+{
+    for (unsigned long ms = 0; ms <= maxMs; ms++) {
+        if (serialContains(text)) {
+            return ms;
+        }
+
+        sim::runFor(1);
+    }
+
+    return maxMs + 1;
+}
+
+void solveIndicators()
+{
+    for (uint8_t i = 0; i < 4; i++) {
+        for (uint8_t k = 0; k < INDICATOR_PRESSES[i]; k++) {
+            sim::press(BTN_INDICATOR_PINS[i], 20, 20);
+        }
+    }
+
+    sim::runFor(INDICATOR_TICK_MS);
+}
+
+void setUp()
+{
+    // Zeroed at power-up on the board, but not by setup()
+    ledEnergyBlobs[0].isActive = false;
+    ledEnergyBlobs[0].hasFrame = false;
+
+    sim::reset();
+    setup();
+    sim::clearSerial();
+}
+
+void tearDown()
+{
+}
+
+void test_energy_strip_dark_until_indicators_solved()
+{
+    sim::runFor(3000);
+
+    TEST_ASSERT_FALSE(serialContains("Indicator OK"));
+    TEST_ASSERT_EQUAL_UINT32(0, ledEnergy.getPixelColor(0));
+
+    solveIndicators();
+
+    TEST_ASSERT_TRUE(serialContains("Indicator OK"));
+}
+
+void test_hidden_patch_window()
+{
+    solveIndicators();
+
+    TEST_ASSERT_TRUE(runUntil("Hidden patch: enter", BLOB_LOOP_MS + 20) <= BLOB_LOOP_MS + 20);
+    TEST_ASSERT_EQUAL(HIGH, sim::getPin(BTN_ENERGY_LED_PIN));
+
+    // The patch stays open for its window, then the next loop starts
+    sim::runFor(HIDDEN_PATCH_MS - 20);
+    TEST_ASSERT_EQUAL(HIGH, sim::getPin(BTN_ENERGY_LED_PIN));
+
+    sim::runFor(40);
+    TEST_ASSERT_EQUAL(LOW, sim::getPin(BTN_ENERGY_LED_PIN));
+
+    // One blob loop per BLOB_LOOP_MS + HIDDEN_PATCH_MS
+    sim::clearSerial();
+    unsigned long next = runUntil("Hidden patch: enter", BLOB_LOOP_MS + 40);
+
+    TEST_ASSERT_UINT32_WITHIN(30, BLOB_LOOP_MS - 20, next);
+}
+
+void test_energy_press_timing()
+{
+    solveIndicators();
+
+    sim::press(BTN_ENERGY_PIN, 20, 20);
+    TEST_ASSERT_TRUE(serialContains("Progress - :: 0"));
+
+    runUntil("Hidden patch: enter", BLOB_LOOP_MS + 20);
+    sim::press(BTN_ENERGY_PIN, 20, 20);
+    TEST_ASSERT_TRUE(serialContains("Progress + :: 2"));
+}
+
+void test_max_progress_finishes()
+{
+    solveIndicators();
+
+    for (int i = 0; i < 5; i++) {
+        sim::clearSerial();
+        runUntil("Hidden patch: enter", BLOB_LOOP_MS + HIDDEN_PATCH_MS + 20);
+        sim::setMaxBlockMillis(10000);
+        sim::press(BTN_ENERGY_PIN, 20, 20);
+    }
+
+    // The finish effect never returns: the simulation cuts it short
+    TEST_ASSERT_TRUE(serialContains("Progress + :: 10"));
+    TEST_ASSERT_TRUE(serialContains("Max progress"));
+    TEST_ASSERT_TRUE(sim::timedOut());
+}
+
+void test_idle_indicators_not_transferred()
+{
+    solveIndicators();
+    sim::runFor(INDICATOR_TICK_MS);
+
+    unsigned long shows = ledIndicators[0].getShowCount();
+
+    sim::runFor(10000);
+
+    // Refreshed every tick with the same colors: nothing is sent
+    TEST_ASSERT_EQUAL_UINT32(shows, ledIndicators[0].getShowCount());
+}
+
+void test_loop_throughput()
+{
+    const unsigned long simulatedMs = 60000;
+
+    solveIndicators();
+
+    auto wallStart = std::chrono::steady_clock::now();
+    unsigned long iterations = sim::runFor(simulatedMs, 100);
+    auto wallEnd = std::chrono::steady_clock::now();
+
+    double wallMs = std::chrono::duration<double, std::milli>(wallEnd - wallStart).count();
+    char message[160];
+
+    snprintf(
+        message,
+        sizeof(message),
+        "%lu loop() calls in %.1f ms (%.0f calls/s, %.0fx real time), %lu energy strip transfers",
+        iterations,
+        wallMs,
+        iterations / (wallMs / 1000.0),
+        simulatedMs / wallMs,
+        ledEnergy.getShowCount());
+
+    TEST_MESSAGE(message);
+
+    TEST_ASSERT_EQUAL_UINT32(simulatedMs * 10, iterations);
+    TEST_ASSERT_TRUE(wallMs < simulatedMs);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_energy_strip_dark_until_indicators_solved);
+    RUN_TEST(test_hidden_patch_window);
+    RUN_TEST(test_energy_press_timing);
+    RUN_TEST(test_max_progress_finishes);
+    RUN_TEST(test_idle_indicators_not_transferred);
+    RUN_TEST(test_loop_throughput);
+    return UNITY_END();
+}
@@ -1,3 +1,4 @@
+#include "RfidReaderScheduler.h"
 #include <Adafruit_NeoPixel.h>
 #include <Automaton.h>
 #include <SerialRFID.h>
@@ -29,6 +30,24 @@ SerialRFID rfids[RFID_NUM] = {
     SerialRFID(rfidSoftSerials[2])
 };
 
+SoftwareSerial* const rfidSerialPtrs[RFID_NUM] = {
+    &rfidSoftSerials[0],
+    &rfidSoftSerials[1],
+    &rfidSoftSerials[2]
+};
+
+const unsigned long RFID_DWELL_MS = 120;
+
+// How long a reader whose tag just entered range keeps listen() waiting
+// for its frame, and the delay before the relay falls back to the TIR line
+const unsigned long RFID_HOLD_MS = 400;
+
+RfidReaderScheduler rfidScheduler(
+    rfidSerialPtrs,
+    RFID_NUM,
+    RFID_DWELL_MS,
+    RFID_HOLD_MS);
+
 /**
  * Machines representing the Tag in Range signals.
  */
@@ -74,11 +93,13 @@ char tagBuffer[SIZE_TAG_ID];
 
 bool rfidsUnlocked[RFID_NUM];
 bool tagsInRange[RFID_NUM];
+bool tagsRead[RFID_NUM];
 unsigned long unlockMillis[RFID_NUM];
 
 typedef struct programState {
     bool* rfidsUnlocked;
     bool* tagsInRange;
+    bool* tagsRead;
     unsigned long* unlockMillis;
 } ProgramState;
 
@@ -88,11 +109,13 @@ void initState()
 {
     progState.rfidsUnlocked = rfidsUnlocked;
     progState.tagsInRange = tagsInRange;
+    progState.tagsRead = tagsRead;
     progState.unlockMillis = unlockMillis;
 
     for (int i = 0; i < RFID_NUM; i++) {
         progState.rfidsUnlocked[i] = false;
         progState.tagsInRange[i] = false;
+        progState.tagsRead[i] = false;
         progState.unlockMillis[i] = 0;
     }
 }
@@ -250,7 +273,7 @@ void relayLoop()
     unsigned long now = millis();
 
     for (int i = 0; i < RFID_NUM; i++) {
-        if (progState.tagsInRange[i]) {
+        if (progState.tagsRead[i] && progState.tagsInRange[i]) {
             progState.unlockMillis[i] = now;
             openRelay(i);
         } else {
@@ -275,8 +298,19 @@ void onTirChange(int idx, int v, int up)
     Serial.println(isInRange);
 
     progState.tagsInRange[idx] = isInRange;
+    rfidScheduler.setTagInRange(idx, isInRange);
+
+    if (!isInRange) {
+        progState.tagsRead[idx] = false;
+        rfidScheduler.printStats(Serial);
+    }
+}
+
+void acceptTag(uint8_t idx)
+{
+    progState.tagsRead[idx] = true;
 
-    if (isInRange && progState.rfidsUnlocked[idx] == false) {
+    if (progState.rfidsUnlocked[idx] == false) {
         Serial.print(F("Unlocked #"));
         Serial.println(idx);
         uint16_t numUnlocked = getNumUnlocked();
@@ -285,6 +319,43 @@ void onTirChange(int idx, int v, int up)
     }
 }
 
+void onTagRead(uint8_t idx)
+{
+    // Tags still in the field keep sending frames:
+    // only the first read while in range counts
+    if (progState.tagsRead[idx]) {
+        return;
+    }
+
+    rfidScheduler.onRead(idx);
+
+    Serial.print(F("Tag on #"));
+    Serial.print(idx);
+    Serial.print(F(": "));
+    Serial.println(tagBuffer);
+
+    acceptTag(idx);
+}
+
+/**
+ * The ID-12 sends a single frame per presentation, which is lost if the
+ * reader was not listening. Once the hold time has passed with no frame
+ * the tag-in-range line alone accepts the tag (it still counts as a miss).
+ */
+void checkOverdueReads()
+{
+    for (int i = 0; i < RFID_NUM; i++) {
+        if (progState.tagsInRange[i]
+            && !progState.tagsRead[i]
+            && rfidScheduler.isReadOverdue(i)) {
+            Serial.print(F("No frame on #"));
+            Serial.print(i);
+            Serial.println(F(", accepting TIR"));
+            acceptTag(i);
+        }
+    }
+}
+
 void initRfidsTagInRange()
 {
     const uint16_t debounceMs = 50;
@@ -304,32 +375,23 @@ void initRfids()
         rfidSoftSerials[i].begin(9600);
     }
 
+    rfidScheduler.begin();
     initRfidsTagInRange();
 }
 
 void rfidLoop()
 {
-    const uint8_t activeIdx = 0;
-
-    bool isReplaced = rfidSoftSerials[activeIdx].listen();
-
-    if (isReplaced) {
-        Serial.print(F("Listening on #"));
-        Serial.println(activeIdx);
-    }
+    uint8_t activeIdx = rfidScheduler.update();
 
     bool someTag = rfids[activeIdx].readTag(
         tagBuffer,
         sizeof(tagBuffer));
 
-    if (!someTag) {
-        return;
+    if (someTag) {
+        onTagRead(activeIdx);
     }
 
-    Serial.print(F("Tag on #"));
-    Serial.print(activeIdx);
-    Serial.print(F(": "));
-    Serial.println(tagBuffer);
+    checkOverdueReads();
 }
 
 /**
@@ -1,5 +1,6 @@
 #include <Automaton.h>
 #include <Adafruit_NeoPixel.h>
+#include "QuadratureDecoder.h"
 
 typedef struct potInfo {
   int potPin;
@@ -33,8 +34,9 @@ const int STRIP_BLOCK_LEN = 209;
 const int ENCODER_BOUNCE_MS = 1000;
 const int MAX_ENCODER_LEVEL = NEOPIXEL_NUM - STRIP_BLOCK_LEN;
 
-const int ENC_RANGE_LO = 0;
-const int ENC_RANGE_HI = 10;
+// Steps only count while the encoder spins at least this fast (steps/s)
+const long ENCODER_MIN_VELOCITY = 20;
+const unsigned long ENCODER_SLOT_MS = 50;
 
 const int POT_RANGE_LO = 1;
 const int POT_RANGE_HI = 9;
@@ -72,13 +74,19 @@ int potSolutionKey[SOLUTIONS_SIZE][TOTAL_POTS] = {
 Atm_analog pots[TOTAL_POTS];
 Atm_controller potsController;
 Atm_controller encoderController;
-Atm_encoder rotEncoder;
 Atm_timer encoderLevelTimer;
 Atm_button btnManualActivation;
 
-unsigned long rotCounter = 1;
+QuadratureDecoder rotEncoder(ENC_PIN_A, ENC_PIN_B, ENCODER_SLOT_MS);
+
+unsigned long rotCounter = 0;
 const unsigned long ROT_COUNTER_DIVISOR = 8;
 
+// D8 and D9 are PORTB (PCINT0)
+ISR(PCINT0_vect) {
+  rotEncoder.update();
+}
+
 Adafruit_NeoPixel pixelStrip = Adafruit_NeoPixel(NEOPIXEL_NUM, NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
 
 const unsigned long POTS_STRIP_DELAY_STEP_MS = 100;
@@ -189,8 +197,21 @@ void onMaxEncoderLevel(int idx, int v, int up) {
   openRelay();
 }
 
-void onRotEncoderChange(int idx, int v, int up) {
-  if (!programState.isEncoderActive) {
+/**
+ * Raises the encoder level every ROT_COUNTER_DIVISOR steps taken while
+ * spinning fast enough. Steps taken before the pots are solved are
+ * dropped.
+ */
+void processEncoder() {
+  rotEncoder.sample(millis());
+
+  unsigned long steps = abs(rotEncoder.take());
+
+  if (!programState.isEncoderActive || steps == 0) {
+    return;
+  }
+
+  if (abs(rotEncoder.getVelocity()) < ENCODER_MIN_VELOCITY) {
     return;
   }
 
@@ -198,17 +219,10 @@ void onRotEncoderChange(int idx, int v, int up) {
     playHoldTrack(PIN_AUDIO_TRACK_ENCODER);
   }
 
-  Serial.print(F("onRotEncoderChange:: idx="));
-  Serial.print(idx);
-  Serial.print(" v=");
-  Serial.print(v);
-  Serial.println();
-  Serial.flush();
-
-  rotCounter++;
+  rotCounter += steps;
 
-  if (rotCounter % ROT_COUNTER_DIVISOR == 0) {
-    Serial.println("Encoder event");
+  while (rotCounter >= ROT_COUNTER_DIVISOR) {
+    rotCounter -= ROT_COUNTER_DIVISOR;
     increaseEncoderLevel();
   }
 }
@@ -318,10 +332,7 @@ void initMachines() {
   .IF(isPotsSolutionValid)
   .onChange(true, onPotsSolutionValid);
 
-  rotEncoder
-  .begin(ENC_PIN_A, ENC_PIN_B)
-  .range(ENC_RANGE_LO, ENC_RANGE_HI, true)
-  .onChange(onRotEncoderChange);
+  rotEncoder.begin();
 
   encoderLevelTimer
   .begin(ENCODER_BOUNCE_MS)
@@ -395,4 +406,5 @@ void setup() {
 
 void loop() {
   automaton.run();
+  processEncoder();
 }
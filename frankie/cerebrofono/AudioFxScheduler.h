@@ -0,0 +1,269 @@
+#ifndef AUDIO_FX_SCHEDULER_H
+#define AUDIO_FX_SCHEDULER_H
+
+#include <Arduino.h>
+
+/**
+ * Non-blocking trigger scheduler for the Adafruit Audio FX sound board.
+ *
+ * play() never blocks. The trigger pin is pulled LOW and released from
+ * update() once the hold time has passed. Call update() from loop().
+ * While the board is busy (a trigger is held or PIN_AUDIO_ACT is LOW),
+ * requests wait in a small priority queue:
+ *
+ *  - A request for a pin that is already queued is coalesced into the
+ *    existing entry, which keeps the higher of the two priorities.
+ *  - When the queue is full, a new request replaces the lowest-priority
+ *    entry if it has a higher priority and is dropped otherwise.
+ *  - AUDIO_FX_INTERRUPT cuts the current track and triggers right away.
+ *  - AUDIO_FX_SKIP_IF_BUSY drops the request instead of queueing it.
+ *    This is the old "Skipping: Audio playing" behaviour.
+ *  - gapMs holds a queued track until the board has been idle that long.
+ *
+ * Pass AUDIO_FX_NO_PIN as pinAct on boards without the ACT line wired;
+ * the board is then only considered busy while a trigger is held.
+ *
+ * Effects that still block use wait() instead of delay(), so a held
+ * trigger is released on time and queued tracks start meanwhile.
+ */
+
+const uint8_t AUDIO_FX_QUEUE_SIZE = 6;
+const uint8_t AUDIO_FX_NO_PIN = 0xFF;
+
+const uint8_t AUDIO_FX_QUEUE = 0;
+const uint8_t AUDIO_FX_INTERRUPT = 1;
+const uint8_t AUDIO_FX_SKIP_IF_BUSY = 2;
+
+typedef struct audioFxRequest
+{
+    uint8_t pin;
+    uint8_t priority;
+    uint16_t gapMs;
+} AudioFxRequest;
+
+class AudioFxScheduler
+{
+public:
+    AudioFxScheduler(uint8_t pinAct, unsigned long holdMs = 300)
+        : pinAct(pinAct),
+          holdMs(holdMs),
+          heldPin(AUDIO_FX_NO_PIN),
+          heldSince(0),
+          idleSince(0),
+          queueSize(0)
+    {
+    }
+
+    void begin()
+    {
+        if (pinAct != AUDIO_FX_NO_PIN)
+        {
+            pinMode(pinAct, INPUT);
+        }
+
+        idleSince = millis();
+    }
+
+    bool isBoardPlaying()
+    {
+        return pinAct != AUDIO_FX_NO_PIN && digitalRead(pinAct) == LOW;
+    }
+
+    bool isBusy()
+    {
+        return heldPin != AUDIO_FX_NO_PIN || isBoardPlaying();
+    }
+
+    uint8_t pending() const
+    {
+        return queueSize;
+    }
+
+    /**
+     * Requests a track. Returns false if the request was dropped.
+     */
+    bool play(
+        uint8_t trackPin,
+        uint8_t mode = AUDIO_FX_QUEUE,
+        uint8_t priority = 0,
+        uint16_t gapMs = 0)
+    {
+        if (mode == AUDIO_FX_INTERRUPT)
+        {
+            removeQueued(trackPin);
+            trigger(trackPin);
+            return true;
+        }
+
+        if (trackPin == heldPin)
+        {
+            return true;
+        }
+
+        bool canPlayNow = queueSize == 0 && gapMs == 0 && !isBusy();
+
+        if (canPlayNow)
+        {
+            trigger(trackPin);
+            return true;
+        }
+
+        if (mode == AUDIO_FX_SKIP_IF_BUSY)
+        {
+            Serial.println(F("Skipping: Audio playing"));
+            return false;
+        }
+
+        return enqueue(trackPin, priority, gapMs);
+    }
+
+    void clear()
+    {
+        queueSize = 0;
+    }
+
+    void update()
+    {
+        unsigned long now = millis();
+
+        if (heldPin != AUDIO_FX_NO_PIN && now - heldSince >= holdMs)
+        {
+            release();
+        }
+
+        if (isBusy())
+        {
+            idleSince = now;
+            return;
+        }
+
+        if (queueSize == 0 || now - idleSince < queue[0].gapMs)
+        {
+            return;
+        }
+
+        uint8_t trackPin = queue[0].pin;
+        removeAt(0);
+        trigger(trackPin);
+    }
+
+    /**
+     * Waits the given time calling update().
+     */
+    void wait(unsigned long ms)
+    {
+        unsigned long ini = millis();
+
+        while (millis() - ini < ms)
+        {
+            update();
+        }
+    }
+
+private:
+    uint8_t pinAct;
+    unsigned long holdMs;
+    uint8_t heldPin;
+    unsigned long heldSince;
+    unsigned long idleSince;
+    AudioFxRequest queue[AUDIO_FX_QUEUE_SIZE];
+    uint8_t queueSize;
+
+    void trigger(uint8_t trackPin)
+    {
+        if (heldPin != AUDIO_FX_NO_PIN)
+        {
+            release();
+        }
+
+        Serial.print(F("Playing track on pin: "));
+        Serial.println(trackPin);
+
+        digitalWrite(trackPin, LOW);
+        pinMode(trackPin, OUTPUT);
+
+        heldPin = trackPin;
+        heldSince = millis();
+    }
+
+    void release()
+    {
+        pinMode(heldPin, INPUT);
+        heldPin = AUDIO_FX_NO_PIN;
+    }
+
+    void removeAt(uint8_t idx)
+    {
+        for (uint8_t i = idx + 1; i < queueSize; i++)
+        {
+            queue[i - 1] = queue[i];
+        }
+
+        queueSize--;
+    }
+
+    void removeQueued(uint8_t trackPin)
+    {
+        for (uint8_t i = 0; i < queueSize; i++)
+        {
+            if (queue[i].pin == trackPin)
+            {
+                removeAt(i);
+                return;
+            }
+        }
+    }
+
+    /**
+     * Keeps the queue sorted by descending priority (FIFO among equals).
+     */
+    void insertSorted(AudioFxRequest req)
+    {
+        uint8_t idx = queueSize;
+
+        while (idx > 0 && queue[idx - 1].priority < req.priority)
+        {
+            queue[idx] = queue[idx - 1];
+            idx--;
+        }
+
+        queue[idx] = req;
+        queueSize++;
+    }
+
+    bool enqueue(uint8_t trackPin, uint8_t priority, uint16_t gapMs)
+    {
+        for (uint8_t i = 0; i < queueSize; i++)
+        {
+            if (queue[i].pin != trackPin)
+            {
+                continue;
+            }
+
+            AudioFxRequest req = queue[i];
+            req.priority = priority > req.priority ? priority : req.priority;
+            removeAt(i);
+            insertSorted(req);
+
+            return true;
+        }
+
+        if (queueSize == AUDIO_FX_QUEUE_SIZE)
+        {
+            if (queue[queueSize - 1].priority >= priority)
+            {
+                Serial.println(F("Audio queue full: dropping track"));
+                return false;
+            }
+
+            queueSize--;
+        }
+
+        AudioFxRequest req = {trackPin, priority, gapMs};
+        insertSorted(req);
+
+        return true;
+    }
+};
+
+#endif
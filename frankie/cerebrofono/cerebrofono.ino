@@ -1,4 +1,5 @@
 #include <Adafruit_NeoPixel.h>
+#include "AudioFxScheduler.h"
 
 // Constants that enumerate the possible results when polling the RFID reader
 // Track 0: "Cinco de la tarde"
@@ -33,6 +34,9 @@ const byte PIN_AUDIO_TRACK_2 = 10;
 const byte PIN_AUDIO_TRACK_3 = 11;
 const byte PIN_AUDIO_TRACK_4 = 12;
 
+// The ACT pin is not wired: new tracks always interrupt the current one
+AudioFxScheduler audio(AUDIO_FX_NO_PIN, 200);
+
 // Non-printable tag buffer characters
 const int TAG_CHAR_STX = 2;
 const int TAG_CHAR_CR = 13;
@@ -238,19 +242,10 @@ byte readMainTag() {
 
 /**
    Plays the audio track connected to the given pin.
+   The trigger pin is released later from audio.update().
 */
 void playTrack(byte trackPin) {
-  Serial.print("Setting pin to LOW / OUTPUT: ");
-  Serial.println(trackPin);
-
-  digitalWrite(trackPin, LOW);
-  pinMode(trackPin, OUTPUT);
-  delay(200);
-
-  Serial.println("Going back to INPUT");
-
-  pinMode(trackPin, INPUT);
-  delay(200);
+  audio.play(trackPin, AUDIO_FX_INTERRUPT);
 }
 
 /**
@@ -313,13 +308,13 @@ void displayAudioLedEffect(byte theTag) {
     for (int i = 0; i < currTarget; i++) {
       pixelStrip.setPixelColor(i, trackColor);
       pixelStrip.show();
-      delay(LED_EFFECT_STEP_MS);
+      audio.wait(LED_EFFECT_STEP_MS);
     }
 
     for (int i = (currTarget - 1); i >= 0; i--) {
       pixelStrip.setPixelColor(i, 0, 0, 0);
       pixelStrip.show();
-      delay(LED_EFFECT_STEP_MS);
+      audio.wait(LED_EFFECT_STEP_MS);
     }
 
     now = millis();
@@ -351,6 +346,7 @@ void setup() {
   pinMode(PIN_AUDIO_TRACK_2, INPUT);
   pinMode(PIN_AUDIO_TRACK_3, INPUT);
   pinMode(PIN_AUDIO_TRACK_4, INPUT);
+  audio.begin();
 
   pixelStrip.begin();
   pixelStrip.setBrightness(200);
@@ -371,6 +367,7 @@ void setup() {
 }
 
 void loop() {
+  audio.update();
   byte mainTag = readMainTag();
   handleTag(mainTag);
 }
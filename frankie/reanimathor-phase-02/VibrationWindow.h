@@ -0,0 +1,177 @@
+#ifndef VIBRATION_WINDOW_H
+#define VIBRATION_WINDOW_H
+
+#include <Arduino.h>
+
+/**
+ * Running maximum of the sensor level over a sliding window of samples.
+ *
+ * sample() is called at a fixed rate from a timer interrupt. The samples
+ * that can still become the maximum are kept in a monotonic deque: a new
+ * sample drops every older entry that is not greater than it, and the
+ * front (the maximum) is dropped once it is older than the window. Each
+ * sample is pushed and popped at most once, so the cost per sample is
+ * O(1) amortized and the maximum is always at the front.
+ *
+ * Entries hold the level and the 16-bit tick of the sample. Entries never
+ * outlive the window, so ages are exact for any window up to 65535 ticks.
+ *
+ * The deque only fills up on a long, strictly decreasing run. Then the
+ * back entry is moved to the new tick and keeps its higher level, which
+ * costs O(1). The maximum can be overestimated until that entry expires
+ * but a peak is never missed.
+ *
+ * The window (ticks) and threshold (level) can be changed at runtime.
+ * A longer window is only reported ready once it has been filled.
+ */
+
+const uint8_t VIBRATION_WINDOW_CAPACITY = 64;
+const uint16_t VIBRATION_WINDOW_LEVEL_MAX = 0x3FF;
+
+typedef struct vibrationEntry
+{
+    uint16_t level;
+    uint16_t tick;
+} VibrationEntry;
+
+class VibrationWindow
+{
+public:
+    VibrationWindow(uint16_t windowTicks, uint16_t threshold)
+        : windowTicks(clampWindow(windowTicks)),
+          threshold(threshold),
+          first(0),
+          count(0),
+          tick(0),
+          numSamples(0)
+    {
+    }
+
+    /**
+     * Call from the sampling interrupt only.
+     */
+    void sample(uint16_t level)
+    {
+        level = level > VIBRATION_WINDOW_LEVEL_MAX ? VIBRATION_WINDOW_LEVEL_MAX : level;
+
+        if (numSamples < 0xFFFF)
+        {
+            numSamples++;
+        }
+
+        tick++;
+
+        while (count > 0 && buf[at(count - 1)].level <= level)
+        {
+            count--;
+        }
+
+        if (count == VIBRATION_WINDOW_CAPACITY)
+        {
+            // The back moves to this tick and keeps its higher level
+            buf[at(count - 1)].tick = tick;
+        }
+        else
+        {
+            VibrationEntry &entry = buf[at(count)];
+
+            entry.level = level;
+            entry.tick = tick;
+            count++;
+        }
+
+        while ((uint16_t)(tick - buf[first].tick) >= windowTicks)
+        {
+            first = next(first);
+            count--;
+        }
+    }
+
+    /**
+     * Maximum level over the window. Call from loop().
+     */
+    uint16_t getMax() const
+    {
+        noInterrupts();
+        uint16_t max = count > 0 ? buf[first].level : 0;
+        interrupts();
+
+        return max;
+    }
+
+    /**
+     * True once a full window of samples has been seen.
+     */
+    bool isReady() const
+    {
+        noInterrupts();
+        bool ready = numSamples >= windowTicks;
+        interrupts();
+
+        return ready;
+    }
+
+    bool isAboveThreshold() const
+    {
+        return getMax() > threshold;
+    }
+
+    void setWindow(uint16_t ticks)
+    {
+        ticks = clampWindow(ticks);
+
+        noInterrupts();
+
+        if (ticks > windowTicks && numSamples > windowTicks)
+        {
+            // Older samples are gone: wait until the new window fills up
+            numSamples = windowTicks;
+        }
+
+        windowTicks = ticks;
+        interrupts();
+    }
+
+    uint16_t getWindow() const
+    {
+        return windowTicks;
+    }
+
+    void setThreshold(uint16_t level)
+    {
+        threshold = level;
+    }
+
+    uint16_t getThreshold() const
+    {
+        return threshold;
+    }
+
+private:
+    volatile uint16_t windowTicks;
+    uint16_t threshold;
+
+    VibrationEntry buf[VIBRATION_WINDOW_CAPACITY];
+    volatile uint8_t first;
+    volatile uint8_t count;
+    uint16_t tick;
+    volatile uint16_t numSamples;
+
+    static uint16_t clampWindow(uint16_t ticks)
+    {
+        return ticks > 0 ? ticks : 1;
+    }
+
+    static uint8_t next(uint8_t idx)
+    {
+        return idx + 1 < VIBRATION_WINDOW_CAPACITY ? idx + 1 : 0;
+    }
+
+    uint8_t at(uint8_t pos) const
+    {
+        uint16_t idx = first + pos;
+        return idx < VIBRATION_WINDOW_CAPACITY ? idx : idx - VIBRATION_WINDOW_CAPACITY;
+    }
+};
+
+#endif
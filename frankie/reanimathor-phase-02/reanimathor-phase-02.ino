@@ -1,21 +1,16 @@
 #include <CircularBuffer.h>
 #include <Adafruit_NeoPixel.h>
+#include "VibrationWindow.h"
 
 #define STATE_STABLE 1
 #define STATE_VIBRATING 2
 #define STATE_UNKNOWN 3
 
-struct sensorSample {
-  unsigned long tstamp;
-  int level;
-};
-
 struct stateSample {
   unsigned long tstamp;
   byte state;
 };
 
-typedef struct sensorSample SensorSample;
 typedef struct stateSample StateSample;
 
 // Pin connected to the vibration sensor
@@ -31,11 +26,12 @@ const byte ACTIVATION_LED_PIN = 9;
 const int PIN_AUDIO_TRACK_ACTIVATION = 4;
 const int PIN_AUDIO_TRACK_COMPLETION = 5;
 
-// Size of the sensor samples buffer
-const int SENSOR_BUFFER_SIZE = 100;
+// Sensor sampling: Timer2 CTC at 16 MHz / 64 / (249 + 1) = 1 kHz
+const uint8_t SENSOR_SAMPLE_TIMER_OCR = 249;
 
-// Buffer that will contain the vibration sensor readings
-CircularBuffer<SensorSample, SENSOR_BUFFER_SIZE> sensorBuffer;
+// Default length (ms, one sample per ms) of the sensor samples window,
+// can be changed over Serial with "W <ms>"
+const uint16_t SENSOR_WINDOW_MS = 120;
 
 // Size of the vibration states buffer
 const int STATE_BUFFER_SIZE = 1;
@@ -47,9 +43,18 @@ CircularBuffer<StateSample, STATE_BUFFER_SIZE> stateBuffer;
 // from the sensor samples buffer
 const unsigned long STATE_SAMPLING_PERIOD_MS = 5;
 
-// Sensor analog level threshold
+// Sensor analog level threshold,
+// can be changed over Serial with "T <level>"
 const int SENSOR_ANALOG_LEVEL_THRESHOLD = 500;
 
+// Running max of the vibration sensor readings
+VibrationWindow sensorWindow(SENSOR_WINDOW_MS, SENSOR_ANALOG_LEVEL_THRESHOLD);
+
+// Serial configuration command line
+const byte CONFIG_LINE_SIZE = 16;
+char configLine[CONFIG_LINE_SIZE];
+byte configLineLen = 0;
+
 // Iteration delay (ms)
 const int LOOP_WAIT_MS = 1;
 
@@ -116,33 +121,91 @@ void printState(byte theState) {
 }
 
 /**
-   Read the sensor and push the value to the buffer.
+   Takes the conversion started on the previous tick and starts the next
+   one, so the sensor is sampled at a fixed rate whatever loop() is doing.
 */
-void updateSensorBuffer() {
-  int sensorVal = analogRead(SENSOR_PIN);
-
-  SensorSample sample;
-  sample.tstamp = millis();
-  sample.level = sensorVal;
+ISR(TIMER2_COMPA_vect) {
+  uint16_t level = ADC;
+  ADCSRA |= bit(ADSC);
+  sensorWindow.sample(level);
+}
 
-  sensorBuffer.push(sample);
+/**
+   Start sampling the sensor from the Timer2 interrupt.
+*/
+void startSensorSampling() {
+  // Selects the sensor channel and reference
+  analogRead(SENSOR_PIN);
+
+  noInterrupts();
+  ADCSRA |= bit(ADSC);
+  TCCR2A = bit(WGM21);
+  TCCR2B = bit(CS22);
+  OCR2A = SENSOR_SAMPLE_TIMER_OCR;
+  TCNT2 = 0;
+  TIMSK2 = bit(OCIE2A);
+  interrupts();
 }
 
 /**
    Returns the current vibration sensor status.
 */
 byte getSensorBufferState() {
-  if (sensorBuffer.isFull() == false) {
+  if (!sensorWindow.isReady()) {
     return STATE_UNKNOWN;
   }
 
-  for (int i = 0; i < sensorBuffer.size(); i++) {
-    if (sensorBuffer[i].level > SENSOR_ANALOG_LEVEL_THRESHOLD) {
-      return STATE_VIBRATING;
-    }
+  return sensorWindow.isAboveThreshold() ? STATE_VIBRATING : STATE_STABLE;
+}
+
+/**
+   Applies a "W <ms>" (window) or "T <level>" (threshold) command.
+*/
+void applyConfigLine() {
+  long val = atol(configLine + 1);
+
+  if (configLine[0] == 'W' && val > 0 && val <= 0xFFFF) {
+    sensorWindow.setWindow(val);
+  } else if (configLine[0] == 'T' && val >= 0 && val <= 1023) {
+    sensorWindow.setThreshold(val);
+  } else {
+    Serial.println("Unknown command");
+    return;
   }
 
-  return STATE_STABLE;
+  Serial.print("Window (ms): ");
+  Serial.print(sensorWindow.getWindow());
+  Serial.print(" Threshold: ");
+  Serial.println(sensorWindow.getThreshold());
+}
+
+/**
+   Reads configuration commands from the serial console without blocking.
+*/
+void updateConfigFromSerial() {
+  while (Serial.available() > 0) {
+    char c = Serial.read();
+
+    if (c == '\r') {
+      continue;
+    }
+
+    if (c != '\n') {
+      if (configLineLen < CONFIG_LINE_SIZE - 1) {
+        configLine[configLineLen++] = c;
+      }
+
+      continue;
+    }
+
+    configLine[configLineLen] = '\0';
+
+    if (configLineLen > 0) {
+      applyConfigLine();
+    }
+
+    configLineLen = 0;
+  }
 }
 
 /**
@@ -404,11 +467,13 @@ void loop() {
     digitalWrite(ACTIVATION_LED_PIN, HIGH);
     playTrack(PIN_AUDIO_TRACK_ACTIVATION);
     activateInitialLeds();
+    startSensorSampling();
     isActivated = true;
   }
 
+  updateConfigFromSerial();
+
   if (isActivated) {
-    updateSensorBuffer();
     updateStateBufferIfTimePassed();
     checkCurrentStateAndUpdateLeds();
     bouncePixelsIfTimePassed();
@@ -1,5 +1,7 @@
 #include <Automaton.h>
 #include <Adafruit_NeoPixel.h>
+#include "DirtyNeoPixel.h"
+#include "InputEventQueue.h"
 
 /**
   Structs
@@ -19,6 +21,12 @@ typedef struct joystickInfo {
   byte pinRight;
 } JoystickInfo;
 
+typedef struct inputBinding {
+  byte pin;
+  void (*onPress)(int idx);
+  int id;
+} InputBinding;
+
 typedef struct playerDot {
   int idxStart;
   uint32_t color;
@@ -83,21 +91,8 @@ JoystickInfo joyInfo02 = {
   Automator machines
 */
 
-Atm_button joy01BtnUp;
-Atm_button joy01BtnDown;
-Atm_button joy01BtnLeft;
-Atm_button joy01BtnRight;
-
-Atm_button joy02BtnUp;
-Atm_button joy02BtnDown;
-Atm_button joy02BtnLeft;
-Atm_button joy02BtnRight;
-
 Atm_timer randomizeTimer;
 
-Atm_button buttonP01;
-Atm_button buttonP02;
-
 /**
    Relay pin
 */
@@ -122,6 +117,21 @@ const byte PIN_AUDIO_TRACK_ERROR = A3;
 const byte BUTTON_P01_PIN = 2;
 const byte BUTTON_P02_PIN = 3;
 
+/**
+   Input capture: joystick and button edges are queued from pin change
+   interrupts, so they are not lost while a blocking effect is running
+*/
+
+const unsigned long INPUT_DEBOUNCE_US = 20000UL;
+
+InputEventQueue<64> inputQueue;
+InputDebouncer inputDebouncer(INPUT_DEBOUNCE_US);
+
+volatile uint8_t inputLastPinB;
+volatile uint8_t inputLastPinD;
+
+uint8_t inputReportedOverruns = 0;
+
 /**
    LED strips initialization
 */
@@ -134,8 +144,8 @@ const uint8_t NEOPIX_PIN_02 = 12;
 
 const int PROGRESS_PATCH_SIZE = 40;
 
-Adafruit_NeoPixel stripPlayers = Adafruit_NeoPixel(NEOPIX_NUM_01, NEOPIX_PIN_01, NEO_GRB + NEO_KHZ800);
-Adafruit_NeoPixel stripProgress = Adafruit_NeoPixel(NEOPIX_NUM_02, NEOPIX_PIN_02, NEO_GRB + NEO_KHZ800);
+DirtyNeoPixel stripPlayers(NEOPIX_NUM_01, NEOPIX_PIN_01, NEO_GRB + NEO_KHZ800);
+DirtyNeoPixel stripProgress(NEOPIX_NUM_02, NEOPIX_PIN_02, NEO_GRB + NEO_KHZ800);
 
 /**
    Initialization of dot structs and program state
@@ -272,17 +282,17 @@ void drawDots() {
    Joystick functions
 */
 
-void onJoyUp(int idx, int v, int up) {
+void onJoyUp(int idx) {
   Serial.print("U:");
   Serial.println(idx);
 }
 
-void onJoyDown(int idx, int v, int up) {
+void onJoyDown(int idx) {
   Serial.print("D:");
   Serial.println(idx);
 }
 
-void onJoyLeft(int idx, int v, int up) {
+void onJoyLeft(int idx) {
   Serial.print("L:");
   Serial.println(idx);
 
@@ -296,7 +306,7 @@ void onJoyLeft(int idx, int v, int up) {
   }
 }
 
-void onJoyRight(int idx, int v, int up) {
+void onJoyRight(int idx) {
   Serial.print("R:");
   Serial.println(idx);
 
@@ -310,39 +320,6 @@ void onJoyRight(int idx, int v, int up) {
   }
 }
 
-void initJoysticks() {
-  joy01BtnUp
-  .begin(joyInfo01.pinUp)
-  .onPress(onJoyUp, JOYSTICK_ID_01);
-
-  joy01BtnDown
-  .begin(joyInfo01.pinDown)
-  .onPress(onJoyDown, JOYSTICK_ID_01);
-
-  joy01BtnLeft
-  .begin(joyInfo01.pinLeft)
-  .onPress(onJoyLeft, JOYSTICK_ID_01);
-
-  joy01BtnRight
-  .begin(joyInfo01.pinRight)
-  .onPress(onJoyRight, JOYSTICK_ID_01);
-
-  joy02BtnUp
-  .begin(joyInfo02.pinUp)
-  .onPress(onJoyUp, JOYSTICK_ID_02);
-
-  joy02BtnDown
-  .begin(joyInfo02.pinDown)
-  .onPress(onJoyDown, JOYSTICK_ID_02);
-
-  joy02BtnLeft
-  .begin(joyInfo02.pinLeft)
-  .onPress(onJoyLeft, JOYSTICK_ID_02);
-
-  joy02BtnRight
-  .begin(joyInfo02.pinRight)
-  .onPress(onJoyRight, JOYSTICK_ID_02);
-}
 
 /**
   Button and timer marchines functions
@@ -392,7 +369,7 @@ bool enoughTargetsCaptured() {
   return progState.matchCounter >= NUM_TARGETS;
 }
 
-void onButtonChange(int idx, int v, int up) {
+void onButtonChange(int idx) {
   Serial.print("B:");
   Serial.println(idx);
 
@@ -416,14 +393,117 @@ void initMachines() {
   .repeat(-1)
   .onTimer(onRandomizeTimer)
   .start();
+}
+
+/**
+   Input capture functions
+*/
+
+const InputBinding INPUT_BINDINGS[] = {
+  { joyInfo01.pinUp, onJoyUp, JOYSTICK_ID_01 },
+  { joyInfo01.pinDown, onJoyDown, JOYSTICK_ID_01 },
+  { joyInfo01.pinLeft, onJoyLeft, JOYSTICK_ID_01 },
+  { joyInfo01.pinRight, onJoyRight, JOYSTICK_ID_01 },
+  { joyInfo02.pinUp, onJoyUp, JOYSTICK_ID_02 },
+  { joyInfo02.pinDown, onJoyDown, JOYSTICK_ID_02 },
+  { joyInfo02.pinLeft, onJoyLeft, JOYSTICK_ID_02 },
+  { joyInfo02.pinRight, onJoyRight, JOYSTICK_ID_02 },
+  { BUTTON_P01_PIN, onButtonChange, BUTTON_ID_01 },
+  { BUTTON_P02_PIN, onButtonChange, BUTTON_ID_02 }
+};
 
-  buttonP01
-  .begin(BUTTON_P01_PIN)
-  .onPress(onButtonChange, BUTTON_ID_01);
+const int NUM_INPUT_BINDINGS = sizeof(INPUT_BINDINGS) / sizeof(InputBinding);
+
+void captureInputPort(uint8_t state, uint8_t prev, uint8_t mask, uint8_t firstPin) {
+  uint8_t changed = (state ^ prev) & mask;
+  unsigned long now = micros();
+
+  for (uint8_t b = 0; changed != 0; b++, changed >>= 1) {
+    if (changed & 1) {
+      inputQueue.push(firstPin + b, (state >> b) & 1, now);
+    }
+  }
+}
+
+// UNO: D8-D13 are PORTB (PCINT0), D0-D7 are PORTD (PCINT2)
+
+ISR(PCINT0_vect) {
+  uint8_t state = PINB;
+  captureInputPort(state, inputLastPinB, PCMSK0, 8);
+  inputLastPinB = state;
+}
 
-  buttonP02
-  .begin(BUTTON_P02_PIN)
-  .onPress(onButtonChange, BUTTON_ID_02);
+ISR(PCINT2_vect) {
+  uint8_t state = PIND;
+  captureInputPort(state, inputLastPinD, PCMSK2, 0);
+  inputLastPinD = state;
+}
+
+void initInputs() {
+  for (int i = 0; i < NUM_INPUT_BINDINGS; i++) {
+    byte pin = INPUT_BINDINGS[i].pin;
+
+    pinMode(pin, INPUT_PULLUP);
+    inputDebouncer.begin(pin, digitalRead(pin));
+  }
+
+  noInterrupts();
+
+  inputLastPinB = PINB;
+  inputLastPinD = PIND;
+
+  for (int i = 0; i < NUM_INPUT_BINDINGS; i++) {
+    byte pin = INPUT_BINDINGS[i].pin;
+
+    *digitalPinToPCMSK(pin) |= bit(digitalPinToPCMSKbit(pin));
+    PCICR |= bit(digitalPinToPCICRbit(pin));
+  }
+
+  interrupts();
+}
+
+void dispatchInputEvent(const InputEvent &event) {
+  // Buttons are active LOW: only presses drive the game
+  if (event.level != LOW) {
+    return;
+  }
+
+  for (int i = 0; i < NUM_INPUT_BINDINGS; i++) {
+    if (INPUT_BINDINGS[i].pin == event.pin) {
+      INPUT_BINDINGS[i].onPress(INPUT_BINDINGS[i].id);
+      return;
+    }
+  }
+}
+
+/**
+   Replays the queued edges in capture order. Handlers may block (effects,
+   audio triggers): edges arriving meanwhile are queued and replayed after.
+*/
+
+void processInputEvents() {
+  InputEvent event;
+  InputEvent settled;
+
+  while (inputQueue.pop(event)) {
+    while (inputDebouncer.settle(event.micros, settled)) {
+      dispatchInputEvent(settled);
+    }
+
+    if (inputDebouncer.accept(event)) {
+      dispatchInputEvent(event);
+    }
+  }
+
+  while (inputDebouncer.settle(micros(), settled)) {
+    dispatchInputEvent(settled);
+  }
+
+  if (inputQueue.getOverruns() != inputReportedOverruns) {
+    inputReportedOverruns = inputQueue.getOverruns();
+    Serial.print("Input overruns:");
+    Serial.println(inputReportedOverruns);
+  }
 }
 
 /**
@@ -432,7 +512,6 @@ void initMachines() {
 
 void clearPlayerStrips() {
   stripPlayers.clear();
-  stripPlayers.show();
 }
 
 void showPlayerStrips() {
@@ -597,7 +676,7 @@ void setup() {
   Serial.begin(9600);
 
   initRelay();
-  initJoysticks();
+  initInputs();
   initStrips();
   initMachines();
   randomizeTargetDot();
@@ -607,6 +686,7 @@ void setup() {
 
 void loop() {
   automaton.run();
+  processInputEvents();
   clearPlayerStrips();
   drawDots();
   showPlayerStrips();
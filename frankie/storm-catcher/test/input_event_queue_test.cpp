@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <vector>
+#include <ArduinoSim.h>
+#include "../InputEventQueue.h"
+
+/**
+ * Host test of InputEventQueue and InputDebouncer: bouncing presses on
+ * two pins pushed as the pin change ISR would, while loop() is blocked in
+ * effects and only drains the queue every 300 ms.
+ *
+ * Build and run from this directory with the native simulation core:
+ *
+ *   g++ -O2 -I ../../../native-sim/ArduinoSim/src input_event_queue_test.cpp \
+ *       ../../../native-sim/ArduinoSim/src/ArduinoSim.cpp -o input_event_queue_test
+ *   ./input_event_queue_test
+ *
+ * Exits with 1 if a check fails.
+ */
+
+const uint8_t QUEUE_SIZE = 64;
+const unsigned long DEBOUNCE_US = 20000;
+const unsigned long DRAIN_US = 300000;
+const uint8_t PINS[] = {2, 8};
+const int NUM_PRESSES = 200;
+
+int numFailures = 0;
+
+#define CHECK(cond)                                           \
+    do                                                        \
+    {                                                         \
+        if (!(cond))                                          \
+        {                                                     \
+            printf("FAIL line %d: %s\n", __LINE__, #cond);    \
+            numFailures++;                                    \
+        }                                                     \
+    } while (0)
+
+void setup()
+{
+}
+
+void loop()
+{
+}
+
+typedef struct press
+{
+    uint8_t pin;
+    unsigned long downUs;
+    unsigned long upUs;
+} Press;
+
+std::vector<InputEvent> edges;
+std::vector<InputEvent> dispatched;
+
+/**
+ * Pushes an edge to level at atUs, preceded by bounce pairs 300 us apart.
+ * The last edge is the one that stays.
+ */
+unsigned long scheduleEdge(uint8_t pin, uint8_t level, unsigned long atUs, int bounces)
+{
+    for (int i = 0; i < bounces; i++)
+    {
+        edges.push_back({pin, level, atUs + i * 600});
+        edges.push_back({pin, (uint8_t)!level, atUs + i * 600 + 300});
+    }
+
+    edges.push_back({pin, level, atUs + bounces * 600});
+
+    return atUs + bounces * 600;
+}
+
+/**
+ * Same as processInputEvents() in the sketch.
+ */
+void drain(InputEventQueue<QUEUE_SIZE> &queue, InputDebouncer &debouncer, unsigned long nowUs)
+{
+    InputEvent event;
+    InputEvent settled;
+
+    while (queue.pop(event))
+    {
+        while (debouncer.settle(event.micros, settled))
+        {
+            dispatched.push_back(settled);
+        }
+
+        if (debouncer.accept(event))
+        {
+            dispatched.push_back(event);
+        }
+    }
+
+    while (debouncer.settle(nowUs, settled))
+    {
+        dispatched.push_back(settled);
+    }
+}
+
+/**
+ * Feeds the edges to the queue in time order and drains it every drainUs.
+ */
+void run(InputEventQueue<QUEUE_SIZE> &queue, InputDebouncer &debouncer, unsigned long drainUs)
+{
+    std::stable_sort(edges.begin(), edges.end(), [](const InputEvent &a, const InputEvent &b) {
+        return a.micros < b.micros;
+    });
+
+    unsigned long nextDrainUs = drainUs;
+
+    for (size_t k = 0; k < edges.size(); k++)
+    {
+        for (; nextDrainUs <= edges[k].micros; nextDrainUs += drainUs)
+        {
+            drain(queue, debouncer, nextDrainUs);
+        }
+
+        queue.push(edges[k].pin, edges[k].level, edges[k].micros);
+    }
+
+    drain(queue, debouncer, nextDrainUs + DEBOUNCE_US);
+}
+
+void testBlockedConsumer()
+{
+    InputEventQueue<QUEUE_SIZE> queue;
+    InputDebouncer debouncer(DEBOUNCE_US);
+    std::vector<Press> presses;
+
+    edges.clear();
+    dispatched.clear();
+    srand(7);
+
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        debouncer.begin(PINS[i], HIGH);
+    }
+
+    // Holds of 8-120 ms, some shorter than the debounce window, and gaps
+    // of 30-200 ms between presses
+    unsigned long t = 10000;
+
+    for (int i = 0; i < NUM_PRESSES; i++)
+    {
+        Press press;
+
+        press.pin = PINS[rand() % 2];
+        press.downUs = scheduleEdge(press.pin, LOW, t, rand() % 4);
+        press.upUs = scheduleEdge(press.pin, HIGH, press.downUs + 8000 + rand() % 112000, rand() % 4);
+        presses.push_back(press);
+
+        t = press.upUs + 30000 + rand() % 170000;
+    }
+
+    size_t numEdges = edges.size();
+
+    run(queue, debouncer, DRAIN_US);
+
+    printf("blocked consumer: %zu edges, %u overruns, %zu dispatched\n",
+           numEdges, queue.getOverruns(), dispatched.size());
+
+    CHECK(queue.getOverruns() == 0);
+    CHECK(dispatched.size() == 2 * presses.size());
+
+    // Every press and release, in capture order and timed no later than
+    // its last edge. A press is taken on its first edge.
+    bool isInOrder = true;
+
+    for (size_t i = 0; i < presses.size() && 2 * i + 1 < dispatched.size(); i++)
+    {
+        const InputEvent &down = dispatched[2 * i];
+        const InputEvent &up = dispatched[2 * i + 1];
+
+        isInOrder = isInOrder &&
+                    down.pin == presses[i].pin && down.level == LOW &&
+                    up.pin == presses[i].pin && up.level == HIGH &&
+                    down.micros <= presses[i].downUs && up.micros <= presses[i].upUs &&
+                    presses[i].downUs - down.micros < DEBOUNCE_US;
+    }
+
+    CHECK(isInOrder);
+}
+
+void testOverrun()
+{
+    InputEventQueue<QUEUE_SIZE> queue;
+    InputEvent event;
+
+    for (uint8_t i = 0; i < 100; i++)
+    {
+        queue.push(PINS[0], i & 1, i);
+    }
+
+    // One slot stays free to tell a full ring from an empty one
+    CHECK(queue.getOverruns() == 100 - (QUEUE_SIZE - 1));
+
+    uint8_t numEvents = 0;
+
+    while (queue.pop(event))
+    {
+        CHECK(event.micros == numEvents);
+        numEvents++;
+    }
+
+    CHECK(numEvents == QUEUE_SIZE - 1);
+    CHECK(queue.push(PINS[0], LOW, 0));
+}
+
+int main()
+{
+    testBlockedConsumer();
+    testOverrun();
+
+    printf(numFailures == 0 ? "OK\n" : "FAILED\n");
+
+    return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#ifndef QUADRATURE_DECODER_H
+#define QUADRATURE_DECODER_H
+
+#include <Arduino.h>
+
+/**
+ * Quadrature encoder decoded from a pin change interrupt.
+ *
+ * update() is called from the ISR of the port the A and B pins are on.
+ * It reads both pins and looks up the transition from the previous state
+ * in a 16-entry table: +1 or -1 for a valid step, 0 for no change or for
+ * a transition where both lines changed. Steps are quarter cycles, the
+ * same unit Atm_encoder counted.
+ *
+ * Both lines change at once when an edge is missed, e.g. while a long
+ * NeoPixel show() keeps interrupts off. The encoder cannot reverse
+ * within one missed step, so such a transition counts as 2 steps in the
+ * direction of the last valid step. Only one seen before any valid step
+ * is counted in errors.
+ *
+ * The position is a 32-bit counter written only by the ISR and read with
+ * interrupts off, so no step is lost however long loop() is busy.
+ *
+ * Velocity is estimated over a sliding window: sample() (from loop())
+ * stores the position every slot and the velocity is the distance
+ * between the newest and the oldest sample, in steps per second. Its
+ * sign is the direction.
+ */
+
+const uint8_t QUADRATURE_WINDOW_SLOTS = 8;
+
+const int8_t QUADRATURE_TABLE[16] = {
+    0, -1, 1, 0,
+    1, 0, 0, -1,
+    -1, 0, 0, 1,
+    0, 1, -1, 0};
+
+class QuadratureDecoder
+{
+public:
+    QuadratureDecoder(uint8_t pinA, uint8_t pinB, unsigned long slotMs)
+        : pinA(pinA),
+          pinB(pinB),
+          slotMs(slotMs),
+          state(0),
+          lastDelta(0),
+          position(0),
+          errors(0),
+          takenPosition(0),
+          lastSlotMillis(0),
+          slotIdx(0),
+          velocity(0)
+    {
+    }
+
+    /**
+     * Enables the pin change interrupt of both pins. The sketch defines
+     * the ISR of their port and calls update() from it.
+     */
+    void begin()
+    {
+        pinMode(pinA, INPUT_PULLUP);
+        pinMode(pinB, INPUT_PULLUP);
+
+        regA = portInputRegister(digitalPinToPort(pinA));
+        regB = portInputRegister(digitalPinToPort(pinB));
+        maskA = digitalPinToBitMask(pinA);
+        maskB = digitalPinToBitMask(pinB);
+
+        for (uint8_t i = 0; i < QUADRATURE_WINDOW_SLOTS; i++)
+        {
+            window[i] = 0;
+        }
+
+        noInterrupts();
+
+        state = readPins();
+
+        *digitalPinToPCMSK(pinA) |= bit(digitalPinToPCMSKbit(pinA));
+        *digitalPinToPCMSK(pinB) |= bit(digitalPinToPCMSKbit(pinB));
+        PCICR |= bit(digitalPinToPCICRbit(pinA));
+        PCICR |= bit(digitalPinToPCICRbit(pinB));
+
+        interrupts();
+    }
+
+    /**
+     * Call from the pin change ISR only.
+     */
+    void update()
+    {
+        uint8_t next = readPins();
+
+        if (next == state)
+        {
+            return;
+        }
+
+        int8_t delta = QUADRATURE_TABLE[(state << 2) | next];
+
+        if (delta != 0)
+        {
+            position += delta;
+            lastDelta = delta;
+        }
+        else if (lastDelta != 0)
+        {
+            position += 2 * lastDelta;
+        }
+        else if (errors < 0xFF)
+        {
+            errors++;
+        }
+
+        state = next;
+    }
+
+    int32_t getPosition() const
+    {
+        noInterrupts();
+        int32_t value = position;
+        interrupts();
+
+        return value;
+    }
+
+    /**
+     * Steps (signed) since the previous call.
+     */
+    int32_t take()
+    {
+        int32_t current = getPosition();
+        int32_t steps = current - takenPosition;
+        takenPosition = current;
+
+        return steps;
+    }
+
+    /**
+     * Call from loop(): stores a window sample every slot.
+     */
+    void sample(unsigned long now)
+    {
+        if (now - lastSlotMillis < slotMs)
+        {
+            return;
+        }
+
+        lastSlotMillis = now;
+
+        int32_t current = getPosition();
+        uint8_t oldest = (slotIdx + 1) % QUADRATURE_WINDOW_SLOTS;
+
+        window[slotIdx] = current;
+
+        // The oldest sample is (SLOTS - 1) slots old
+        velocity = (current - window[oldest]) * 1000L /
+                   (long)((QUADRATURE_WINDOW_SLOTS - 1) * slotMs);
+
+        slotIdx = oldest;
+    }
+
+    /**
+     * Steps per second over the window; positive when position grows.
+     */
+    long getVelocity() const
+    {
+        return velocity;
+    }
+
+    unsigned long getWindowMs() const
+    {
+        return (QUADRATURE_WINDOW_SLOTS - 1) * slotMs;
+    }
+
+    uint8_t getErrors() const
+    {
+        return errors;
+    }
+
+private:
+    uint8_t pinA;
+    uint8_t pinB;
+    unsigned long slotMs;
+
+    volatile uint8_t *regA;
+    volatile uint8_t *regB;
+    uint8_t maskA;
+    uint8_t maskB;
+
+    uint8_t state;
+    int8_t lastDelta;
+    volatile int32_t position;
+    volatile uint8_t errors;
+
+    int32_t takenPosition;
+    int32_t window[QUADRATURE_WINDOW_SLOTS];
+    unsigned long lastSlotMillis;
+    uint8_t slotIdx;
+    long velocity;
+
+    uint8_t readPins() const
+    {
+        return ((*regA & maskA) ? 2 : 0) | ((*regB & maskB) ? 1 : 0);
+    }
+};
+
+#endif
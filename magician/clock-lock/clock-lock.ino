@@ -1,6 +1,7 @@
 #include <Automaton.h>
 #include <Adafruit_NeoPixel.h>
 #include "limits.h"
+#include "QuadratureDecoder.h"
 
 typedef struct programState {
   unsigned long encoderCounter;
@@ -29,16 +30,27 @@ const byte RELAY_PIN = 7;
 const int ENCODER_TIMER_MS = 1000;
 const int ENCODER_COUNTER_THRESHOLD = 150;
 
-const unsigned long OPEN_INTERVAL_MS = 60000;
+// Every step counts towards opening, as with the original Atm_encoder.
+// Set to true to only count steps while the encoder spins at least
+// ENCODER_MIN_VELOCITY (steps/s) over the velocity window, and to reset
+// the counter when it slows down below that speed.
+const bool ENCODER_RESET_WHEN_SLOW = false;
+const long ENCODER_MIN_VELOCITY = 40;
+const unsigned long ENCODER_SLOT_MS = 50;
+const unsigned long ENCODER_REPORT_MS = 500;
 
-const int ENC_RANGE_LO = 0;
-const int ENC_RANGE_HI = 100;
+const unsigned long OPEN_INTERVAL_MS = 60000;
 
-Atm_controller encoderController;
-Atm_encoder rotEncoder;
 Atm_timer encoderLevelTimer;
 
-unsigned long rotCounter = 1;
+QuadratureDecoder rotEncoder(ENC_PIN_A, ENC_PIN_B, ENCODER_SLOT_MS);
+
+unsigned long lastEncoderReportMillis = 0;
+
+// A4 and A5 are PORTC (PCINT1)
+ISR(PCINT1_vect) {
+  rotEncoder.update();
+}
 
 void onMaxEncoderLevel(int idx, int v, int up) {
   if (programState.isOpen) {
@@ -50,27 +62,56 @@ void onMaxEncoderLevel(int idx, int v, int up) {
   openRelay();
 }
 
-void onRotEncoderChange(int idx, int v, int up) {
-  if (programState.isOpen) {
+bool isEncoderLevelOverThreshold() {
+  return programState.encoderCounter >= ENCODER_COUNTER_THRESHOLD;
+}
+
+void reportEncoder(unsigned long now, long velocity) {
+  if (now - lastEncoderReportMillis < ENCODER_REPORT_MS) {
     return;
   }
 
-  Serial.print("onRotEncoderChange :: idx=");
-  Serial.print(idx);
-  Serial.print(" v=");
-  Serial.print(v);
-  Serial.println();
-  Serial.flush();
+  lastEncoderReportMillis = now;
 
-  programState.encoderCounter++;
+  Serial.print("Encoder (steps/s): ");
+  Serial.print(velocity);
+  Serial.print(" :: Counter: ");
+  Serial.print(programState.encoderCounter);
+  Serial.print(" :: Errors: ");
+  Serial.println(rotEncoder.getErrors());
 }
 
-bool isEncoderLevelOverThreshold() {
-  return programState.encoderCounter >= ENCODER_COUNTER_THRESHOLD;
-}
+/**
+ * Counts the steps taken and opens the relay once enough of them have
+ * been counted (in a single fast spin with ENCODER_RESET_WHEN_SLOW).
+ */
+void processEncoder() {
+  unsigned long now = millis();
+
+  rotEncoder.sample(now);
 
-bool isEncoderLevelOverThreshold(int idx) {
-  return isEncoderLevelOverThreshold();
+  long steps = rotEncoder.take();
+  long velocity = rotEncoder.getVelocity();
+
+  if (programState.isOpen) {
+    return;
+  }
+
+  if (ENCODER_RESET_WHEN_SLOW && abs(velocity) < ENCODER_MIN_VELOCITY) {
+    programState.encoderCounter = 0;
+    return;
+  }
+
+  if (steps == 0) {
+    return;
+  }
+
+  programState.encoderCounter += abs(steps);
+  reportEncoder(now, velocity);
+
+  if (isEncoderLevelOverThreshold()) {
+    onMaxEncoderLevel(0, 0, 0);
+  }
 }
 
 void onEncoderTimer(int idx, int v, int up) {
@@ -100,21 +141,13 @@ void onEncoderTimer(int idx, int v, int up) {
 }
 
 void initMachines() {
-  rotEncoder
-  .begin(ENC_PIN_A, ENC_PIN_B)
-  .range(ENC_RANGE_LO, ENC_RANGE_HI, true)
-  .onChange(onRotEncoderChange);
+  rotEncoder.begin();
 
   encoderLevelTimer
   .begin(ENCODER_TIMER_MS)
   .repeat(-1)
   .onTimer(onEncoderTimer)
   .start();
-
-  encoderController
-  .begin()
-  .IF(isEncoderLevelOverThreshold)
-  .onChange(true, onMaxEncoderLevel);
 }
 
 void lockRelay() {
@@ -150,4 +183,5 @@ void setup() {
 
 void loop() {
   automaton.run();
+  processEncoder();
 }
@@ -0,0 +1,298 @@
+#ifndef TAG_PRESENCE_TRACKER_H
+#define TAG_PRESENCE_TRACKER_H
+
+#include <Arduino.h>
+#include "RfidFrameParser.h"
+
+/**
+ * Time-based presence of the RFID tags on a set of readers.
+ *
+ * The sketch reports every read with seen() and calls update() from
+ * loop(). For each reader the tracker keeps the tag that is present, the
+ * tag being read now (the candidate) and when it was first and last seen:
+ *
+ * - a candidate becomes present (ARRIVE) once it has been read at least
+ *   TAG_PRESENCE_MIN_READS times and for arriveMs, and replaces a
+ *   different present tag the same way (SWAP). A single stray read never
+ *   becomes a tag;
+ * - the present tag leaves (LEAVE) when nothing has been read for leaveMs.
+ *
+ * Both delays are in milliseconds, so they do not depend on how often the
+ * readers are polled. If the tracker is not updated for longer than
+ * leaveMs (e.g. while the sketch runs a blocking effect), that time is
+ * not counted: nothing was observed, so no tag is assumed to have left.
+ * When several readers are polled in turn and each only reports a tag
+ * while it is polled, leaveMs must cover a full round of the readers.
+ *
+ * Validity is evaluated incrementally: isValid() only runs when a tag
+ * arrives or is swapped, and the result is kept in a bitmask, so
+ * areAllValid() is a single compare. update() returns true when it
+ * emitted events, which is the only time the result can change.
+ *
+ * Events go to the onEvent callback (may be NULL) and, after setLog(),
+ * are printed as "## Reader <n> :: <event> :: <tag> :: <millis>".
+ */
+
+const uint8_t TAG_PRESENCE_MAX_READERS = 8;
+
+const uint8_t TAG_PRESENCE_ARRIVE = 0;
+const uint8_t TAG_PRESENCE_LEAVE = 1;
+const uint8_t TAG_PRESENCE_SWAP = 2;
+
+const uint8_t TAG_PRESENCE_MIN_READS = 2;
+
+typedef struct tagPresenceSlot
+{
+    RfidTagId present;
+    RfidTagId candidate;
+    unsigned long candidateSince;
+    unsigned long lastSeen;
+    uint8_t candidateReads;
+    bool isPresent;
+    bool hasCandidate;
+} TagPresenceSlot;
+
+class TagPresenceTracker
+{
+public:
+    TagPresenceTracker(
+        uint8_t numReaders,
+        unsigned long arriveMs,
+        unsigned long leaveMs,
+        bool (*isValid)(uint8_t reader, const RfidTagId &tag),
+        void (*onEvent)(uint8_t reader, uint8_t event))
+        : numReaders(numReaders > TAG_PRESENCE_MAX_READERS ? TAG_PRESENCE_MAX_READERS : numReaders),
+          arriveMs(arriveMs),
+          leaveMs(leaveMs),
+          isValid(isValid),
+          onEvent(onEvent),
+          log(NULL),
+          lastUpdateMillis(0)
+    {
+        reset();
+    }
+
+    /**
+     * Prints every event on out.
+     */
+    void setLog(Print &out)
+    {
+        log = &out;
+    }
+
+    /**
+     * Forgets every tag without emitting events.
+     */
+    void reset()
+    {
+        for (uint8_t i = 0; i < numReaders; i++)
+        {
+            slots[i].isPresent = false;
+            slots[i].hasCandidate = false;
+        }
+
+        presentMask = 0;
+        validMask = 0;
+    }
+
+    /**
+     * Reports a read of tag on reader.
+     */
+    void seen(uint8_t reader, const RfidTagId &tag, unsigned long now)
+    {
+        skipGap(now);
+
+        TagPresenceSlot &slot = slots[reader];
+
+        if (!slot.hasCandidate || !isSameTag(slot.candidate, tag))
+        {
+            slot.candidate = tag;
+            slot.candidateSince = now;
+            slot.candidateReads = 0;
+            slot.hasCandidate = true;
+        }
+
+        if (slot.candidateReads < TAG_PRESENCE_MIN_READS)
+        {
+            slot.candidateReads++;
+        }
+
+        slot.lastSeen = now;
+    }
+
+    /**
+     * Emits the events that are due. Call from loop().
+     * Returns true if any event was emitted.
+     */
+    bool update(unsigned long now)
+    {
+        bool changed = false;
+
+        skipGap(now);
+
+        for (uint8_t i = 0; i < numReaders; i++)
+        {
+            TagPresenceSlot &slot = slots[i];
+            uint8_t readerBit = 1 << i;
+
+            if (!slot.hasCandidate)
+            {
+                continue;
+            }
+
+            if (now - slot.lastSeen > leaveMs)
+            {
+                slot.hasCandidate = false;
+
+                if (slot.isPresent)
+                {
+                    slot.isPresent = false;
+                    presentMask &= ~readerBit;
+                    validMask &= ~readerBit;
+                    emit(i, TAG_PRESENCE_LEAVE);
+                    changed = true;
+                }
+
+                continue;
+            }
+
+            if (slot.candidateReads < TAG_PRESENCE_MIN_READS ||
+                now - slot.candidateSince < arriveMs)
+            {
+                continue;
+            }
+
+            if (slot.isPresent && isSameTag(slot.present, slot.candidate))
+            {
+                continue;
+            }
+
+            uint8_t event = slot.isPresent ? TAG_PRESENCE_SWAP : TAG_PRESENCE_ARRIVE;
+
+            slot.present = slot.candidate;
+            slot.isPresent = true;
+            presentMask |= readerBit;
+
+            if (isValid(i, slot.present))
+            {
+                validMask |= readerBit;
+            }
+            else
+            {
+                validMask &= ~readerBit;
+            }
+
+            emit(i, event);
+            changed = true;
+        }
+
+        return changed;
+    }
+
+    bool isPresent(uint8_t reader) const
+    {
+        return slots[reader].isPresent;
+    }
+
+    const RfidTagId &tag(uint8_t reader) const
+    {
+        return slots[reader].present;
+    }
+
+    bool areAllPresent() const
+    {
+        return presentMask == allMask();
+    }
+
+    bool areAllValid() const
+    {
+        return validMask == allMask();
+    }
+
+private:
+    uint8_t numReaders;
+    unsigned long arriveMs;
+    unsigned long leaveMs;
+    bool (*isValid)(uint8_t reader, const RfidTagId &tag);
+    void (*onEvent)(uint8_t reader, uint8_t event);
+    Print *log;
+
+    TagPresenceSlot slots[TAG_PRESENCE_MAX_READERS];
+    uint8_t presentMask;
+    uint8_t validMask;
+    unsigned long lastUpdateMillis;
+
+    uint8_t allMask() const
+    {
+        return (uint8_t)((1 << numReaders) - 1);
+    }
+
+    void emit(uint8_t reader, uint8_t event)
+    {
+        if (log != NULL)
+        {
+            printEvent(*log, reader, event);
+        }
+
+        if (onEvent != NULL)
+        {
+            onEvent(reader, event);
+        }
+    }
+
+    void printEvent(Print &out, uint8_t reader, uint8_t event) const
+    {
+        out.print(F("## Reader "));
+        out.print(reader);
+
+        if (event == TAG_PRESENCE_ARRIVE)
+        {
+            out.print(F(" :: Arrive :: "));
+        }
+        else if (event == TAG_PRESENCE_SWAP)
+        {
+            out.print(F(" :: Swap :: "));
+        }
+        else
+        {
+            out.print(F(" :: Leave :: "));
+        }
+
+        if (slots[reader].isPresent)
+        {
+            rfidPrintTag(out, slots[reader].present);
+        }
+
+        out.print(F(" :: "));
+        out.println(millis());
+    }
+
+    static bool isSameTag(const RfidTagId &a, const RfidTagId &b)
+    {
+        return memcmp(a.bytes, b.bytes, RFID_TAG_ID_SIZE) == 0;
+    }
+
+    /**
+     * Moves every timestamp forward by a gap in the updates that is longer
+     * than leaveMs, as if the gap had not happened.
+     */
+    void skipGap(unsigned long now)
+    {
+        unsigned long gap = now - lastUpdateMillis;
+
+        lastUpdateMillis = now;
+
+        if (gap <= leaveMs)
+        {
+            return;
+        }
+
+        for (uint8_t i = 0; i < numReaders; i++)
+        {
+            slots[i].lastSeen += gap;
+            slots[i].candidateSince += gap;
+        }
+    }
+};
+
+#endif
@@ -1,4 +1,6 @@
 #include "rdm630.h"
+#include "RfidFrameParser.h"
+#include "TagPresenceTracker.h"
 
 /**
    Relay
@@ -26,31 +28,38 @@ RDM6300 rfidReaders[NUM_READERS] = {
     rfid04
 };
 
-const unsigned int EMPTY_TOLERANCE = 1;
-
-String currentTags[NUM_READERS];
-
 const int NUM_OPTIONS = 2;
 
-String validTags[NUM_READERS][NUM_OPTIONS] = {
-    { "1D00278F8200", "1D00278F8200" },
-    { "1D00277EC900", "1D00277EC900" },
-    { "1D00278E7600", "1D00278E7600" },
-    { "1D0027AA9B00", "1D0027AA9B00" }
+// First 10 hex chars of each tag ID
+const uint8_t VALID_TAGS[NUM_READERS][NUM_OPTIONS][RFID_TAG_ID_SIZE] PROGMEM = {
+    { { 0x1D, 0x00, 0x27, 0x8F, 0x82 }, { 0x1D, 0x00, 0x27, 0x8F, 0x82 } },
+    { { 0x1D, 0x00, 0x27, 0x7E, 0xC9 }, { 0x1D, 0x00, 0x27, 0x7E, 0xC9 } },
+    { { 0x1D, 0x00, 0x27, 0x8E, 0x76 }, { 0x1D, 0x00, 0x27, 0x8E, 0x76 } },
+    { { 0x1D, 0x00, 0x27, 0xAA, 0x9B }, { 0x1D, 0x00, 0x27, 0xAA, 0x9B } }
 };
 
+const unsigned long TAG_ARRIVE_MS = 100;
+const unsigned long TAG_LEAVE_MS = 1000;
+
+bool isValidTag(uint8_t reader, const RfidTagId &tag);
+
+TagPresenceTracker tagTracker(
+    NUM_READERS,
+    TAG_ARRIVE_MS,
+    TAG_LEAVE_MS,
+    isValidTag,
+    NULL);
+
 /**
   Structs.
 */
 
 typedef struct programState {
     bool relayOpened;
-    unsigned int emptyReadCount[NUM_READERS];
 } ProgramState;
 
 ProgramState progState = {
-    .relayOpened = false,
-    .emptyReadCount = { 0, 0, 0, 0 }
+    .relayOpened = false
 };
 
 /**
@@ -62,72 +71,34 @@ void initRfidReaders()
     for (int i = 0; i < NUM_READERS; i++) {
         rfidReaders[i].begin();
     }
+
+    tagTracker.setLog(Serial);
 }
 
 void pollRfidReaders()
 {
-    String tagId;
+    RfidTagId tag;
 
     for (int i = 0; i < NUM_READERS; i++) {
-        tagId = rfidReaders[i].getTagId();
-
-        if (tagId.length()) {
-            progState.emptyReadCount[i] = 0;
-        } else if (progState.emptyReadCount[i] <= EMPTY_TOLERANCE) {
-            progState.emptyReadCount[i] += 1;
+        if (rfidParseTag(rfidReaders[i].getTagId().c_str(), tag)) {
+            tagTracker.seen(i, tag, millis());
         }
-
-        if (!tagId.length() && currentTags[i].length() && progState.emptyReadCount[i] <= EMPTY_TOLERANCE) {
-            Serial.print("Ignoring empty read on reader: ");
-            Serial.println(i);
-            return;
-        }
-
-        currentTags[i] = tagId;
     }
-}
 
-bool isTagDefined(int idx)
-{
-    return currentTags[idx].length() > 0;
+    if (tagTracker.update(millis())) {
+        checkStatusToUpdateRelay();
+    }
 }
 
-bool areCurrentTagsValid()
+bool isValidTag(uint8_t reader, const RfidTagId &tag)
 {
-    bool isValid;
-
-    for (int i = 0; i < NUM_READERS; i++) {
-        if (!isTagDefined(i)) {
-            return false;
-        }
-
-        isValid = false;
-
-        for (int j = 0; j < NUM_OPTIONS; j++) {
-            if (validTags[i][j].compareTo(currentTags[i]) == 0) {
-                isValid = true;
-                break;
-            }
-        }
-
-        if (!isValid) {
-            return false;
+    for (int j = 0; j < NUM_OPTIONS; j++) {
+        if (rfidIsTag(tag, VALID_TAGS[reader][j])) {
+            return true;
         }
     }
 
-    return true;
-}
-
-void printCurrentTags()
-{
-    Serial.print("## Current tags :: ");
-    Serial.println(millis());
-
-    for (int i = 0; i < NUM_READERS; i++) {
-        Serial.print(i);
-        Serial.print(" :: ");
-        Serial.println(currentTags[i]);
-    }
+    return false;
 }
 
 /**
@@ -154,10 +125,12 @@ void initRelay()
 
 void checkStatusToUpdateRelay()
 {
-    if (areCurrentTagsValid() == true && progState.relayOpened == false) {
+    bool isValid = tagTracker.areAllValid();
+
+    if (isValid && progState.relayOpened == false) {
         Serial.println("Opening relay");
         openRelay();
-    } else if (areCurrentTagsValid() == false && progState.relayOpened == true) {
+    } else if (!isValid && progState.relayOpened == true) {
         Serial.println("Locking relay");
         lockRelay();
     }
@@ -180,6 +153,4 @@ void setup()
 void loop()
 {
     pollRfidReaders();
-    printCurrentTags();
-    checkStatusToUpdateRelay();
 }
@@ -3,18 +3,31 @@
 #include <CircularBuffer.h>
 
 /**
- * Set to true to print voltage values from the mics 
+ * Set to true to print voltage values (mV) from the mics
  * in an Arduino Serial Plotter compatible format.
  */
 const bool PRINT_CANDLE_VOLTS = true;
 
+/**
+ * Minimum milliseconds between candle volts prints.
+ */
+const unsigned long PRINT_CANDLE_VOLTS_MS = 50;
+
 /**
  * Mics activation sensitivity configuration.
+ * Peak-to-peak values are in millivolts.
+ * A window of SAMPLE_WINDOW_MS is finished every half window.
  */
 const int SAMPLE_WINDOW_MS = 30;
-const double PEAK_PEAK_THRESHOLD_VOLTS = 0.8;
+const uint16_t PEAK_PEAK_THRESHOLD_MV = 800;
 const int PEAK_PEAK_THRESHOLD_NUM = 3;
 
+/**
+ * Milliseconds that a mic is ignored after toggling its candle,
+ * so that the tail of the same blow does not toggle it back.
+ */
+const unsigned long ACTIVATION_HOLDOFF_MS = 600;
+
 const int NUM_CANDLES = 4;
 
 const int CANDLE_MIC_PINS[NUM_CANDLES] = {
@@ -34,7 +47,41 @@ const int CANDLE_ACTIVATION_KEY[NUM_CANDLES] = {
 const int VOLTS_BUF_SIZE = 25;
 
 CircularBuffer<int, NUM_CANDLES> candleActivationBuf;
-CircularBuffer<double, VOLTS_BUF_SIZE> voltsBufs[NUM_CANDLES];
+CircularBuffer<uint16_t, VOLTS_BUF_SIZE> voltsBufs[NUM_CANDLES];
+unsigned long candleToggleMillis[NUM_CANDLES];
+
+/**
+ * Free-running ADC sampler.
+ * The conversion-complete ISR reads one mic, starts the conversion of the
+ * next one and keeps the min / max of every mic in raw ADC units.
+ * Each hop (half a window) the ISR queues the peak-to-peak value of the
+ * last two hops, i.e. a sliding window of SAMPLE_WINDOW_MS.
+ * 16 MHz / 128 prescaler / 13 cycles: ~9600 conversions/s for all mics.
+ */
+const uint8_t ADC_PRESCALER_BITS = _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+const uint32_t ADC_CONVERSIONS_PER_SEC = F_CPU / 128 / 13;
+
+const uint16_t ADC_SAMPLES_PER_HOP =
+    (ADC_CONVERSIONS_PER_SEC / NUM_CANDLES) * (SAMPLE_WINDOW_MS / 2) / 1000;
+
+const uint16_t ADC_MAX_VALUE = 1023;
+const uint8_t ADC_QUEUE_SIZE = 8;
+
+typedef struct micChannel {
+    uint16_t hopMin;
+    uint16_t hopMax;
+    uint16_t prevMin;
+    uint16_t prevMax;
+    uint16_t numSamples;
+    uint16_t queue[ADC_QUEUE_SIZE];
+    uint8_t queueHead;
+    uint8_t queueCount;
+} MicChannel;
+
+MicChannel micChannels[NUM_CANDLES];
+uint8_t adcMux[NUM_CANDLES];
+volatile uint8_t adcChannelIdx = 0;
+volatile uint16_t adcQueueOverruns = 0;
 
 const uint16_t LED_NUM = NUM_CANDLES;
 const uint16_t LED_PIN = 8;
@@ -151,6 +198,11 @@ void pushActivation(int idx)
 
 bool isMicActivated(int micIdx)
 {
+    if (millis() - candleToggleMillis[micIdx] < ACTIVATION_HOLDOFF_MS) {
+        voltsBufs[micIdx].clear();
+        return false;
+    }
+
     if (voltsBufs[micIdx].size() < PEAK_PEAK_THRESHOLD_NUM) {
         return false;
     }
@@ -158,7 +210,7 @@ bool isMicActivated(int micIdx)
     int activeCounter = 0;
 
     for (int i = voltsBufs[micIdx].size() - 1; i >= 0; i--) {
-        if (voltsBufs[micIdx][i] >= PEAK_PEAK_THRESHOLD_VOLTS) {
+        if (voltsBufs[micIdx][i] >= PEAK_PEAK_THRESHOLD_MV) {
             activeCounter++;
         }
 
@@ -184,57 +236,141 @@ void checkMics()
             pushActivation(i);
         }
 
+        candleToggleMillis[i] = millis();
         voltsBufs[i].clear();
     }
 
     resetIfAllOut();
 }
 
-double readPeakToPeakVolts(int pin)
+void resetMicChannel(MicChannel &ch)
 {
-    const int maxAnalogVal = 1024;
+    ch.hopMin = ADC_MAX_VALUE;
+    ch.hopMax = 0;
+    ch.prevMin = ADC_MAX_VALUE;
+    ch.prevMax = 0;
+    ch.numSamples = 0;
+    ch.queueHead = 0;
+    ch.queueCount = 0;
+}
 
-    unsigned long startMillis = millis();
+ISR(ADC_vect)
+{
+    uint8_t low = ADCL;
+    uint16_t sample = (ADCH << 8) | low;
 
-    int signalMax = 0;
-    int signalMin = 1024;
-    int sample;
+    uint8_t idx = adcChannelIdx;
+    uint8_t next = (idx + 1 < NUM_CANDLES) ? idx + 1 : 0;
 
-    while ((millis() - startMillis) < SAMPLE_WINDOW_MS) {
-        sample = analogRead(pin);
+    ADMUX = adcMux[next];
+    ADCSRA |= _BV(ADSC);
+    adcChannelIdx = next;
 
-        if (sample >= maxAnalogVal) {
-            continue;
-        }
+    MicChannel &ch = micChannels[idx];
 
-        if (sample > signalMax) {
-            signalMax = sample;
-        } else if (sample < signalMin) {
-            signalMin = sample;
-        }
+    if (sample < ch.hopMin) {
+        ch.hopMin = sample;
+    }
+
+    if (sample > ch.hopMax) {
+        ch.hopMax = sample;
+    }
+
+    if (++ch.numSamples < ADC_SAMPLES_PER_HOP) {
+        return;
     }
 
-    int peakToPeak = signalMax - signalMin;
-    double volts = (peakToPeak * 5.0) / 1024;
+    uint16_t windowMin = min(ch.hopMin, ch.prevMin);
+    uint16_t windowMax = max(ch.hopMax, ch.prevMax);
 
-    return volts;
+    if (ch.queueCount == ADC_QUEUE_SIZE) {
+        ch.queueHead = (ch.queueHead + 1) % ADC_QUEUE_SIZE;
+        ch.queueCount--;
+        adcQueueOverruns++;
+    }
+
+    ch.queue[(ch.queueHead + ch.queueCount) % ADC_QUEUE_SIZE] = windowMax - windowMin;
+    ch.queueCount++;
+
+    ch.prevMin = ch.hopMin;
+    ch.prevMax = ch.hopMax;
+    ch.hopMin = ADC_MAX_VALUE;
+    ch.hopMax = 0;
+    ch.numSamples = 0;
+}
+
+void initAdcSampler()
+{
+    for (int i = 0; i < NUM_CANDLES; i++) {
+        uint8_t channel = CANDLE_MIC_PINS[i] - A0;
+        adcMux[i] = _BV(REFS0) | (channel & 0x07);
+        DIDR0 |= _BV(channel);
+        resetMicChannel(micChannels[i]);
+    }
+
+    adcChannelIdx = 0;
+    ADMUX = adcMux[0];
+    ADCSRA = _BV(ADEN) | _BV(ADIE) | ADC_PRESCALER_BITS;
+    ADCSRA |= _BV(ADSC);
+}
+
+bool popPeakToPeak(int micIdx, uint16_t &peakToPeak)
+{
+    MicChannel &ch = micChannels[micIdx];
+    bool found = false;
+
+    noInterrupts();
+
+    if (ch.queueCount > 0) {
+        peakToPeak = ch.queue[ch.queueHead];
+        ch.queueHead = (ch.queueHead + 1) % ADC_QUEUE_SIZE;
+        ch.queueCount--;
+        found = true;
+    }
+
+    interrupts();
+
+    return found;
+}
+
+uint16_t peakToPeakToMillivolts(uint16_t peakToPeak)
+{
+    // 5000 mV / 1024 steps == 625 / 128
+    return ((uint32_t)peakToPeak * 625) >> 7;
+}
+
+void printCandleVolts(const uint16_t *millivolts)
+{
+    static unsigned long lastPrintMillis = 0;
+
+    if (millis() - lastPrintMillis < PRINT_CANDLE_VOLTS_MS) {
+        return;
+    }
+
+    lastPrintMillis = millis();
+
+    for (int i = 0; i < NUM_CANDLES; i++) {
+        Serial.print(millivolts[i]);
+        Serial.print(i < (NUM_CANDLES - 1) ? "\t" : "\n");
+    }
 }
 
 void sampleMics()
 {
-    double volts;
+    static uint16_t lastMillivolts[NUM_CANDLES];
+
+    uint16_t peakToPeak;
 
     for (int i = 0; i < NUM_CANDLES; i++) {
-        volts = readPeakToPeakVolts(CANDLE_MIC_PINS[i]);
-        voltsBufs[i].push(volts);
-
-        if (PRINT_CANDLE_VOLTS && i < (NUM_CANDLES - 1)) {
-            Serial.print(volts);
-            Serial.print("\t");
-        } else if (PRINT_CANDLE_VOLTS) {
-            Serial.println(volts);
+        while (popPeakToPeak(i, peakToPeak)) {
+            lastMillivolts[i] = peakToPeakToMillivolts(peakToPeak);
+            voltsBufs[i].push(lastMillivolts[i]);
         }
     }
+
+    if (PRINT_CANDLE_VOLTS) {
+        printCandleVolts(lastMillivolts);
+    }
 }
 
 void setup()
@@ -246,6 +382,7 @@ void setup()
     initLeds();
 
     showLedStartEffect();
+    initAdcSampler();
 
     Serial.println(F(">> Starting candles program"));
 }
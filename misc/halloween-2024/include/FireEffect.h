@@ -0,0 +1,294 @@
+#ifndef FIRE_EFFECT_H
+#define FIRE_EFFECT_H
+
+#include <Arduino.h>
+
+/**
+ * Fire simulation for LED strips, integer only.
+ *
+ * Every pixel has an 8-bit heat. Each frame:
+ *
+ * - Every cell cools down by a random amount that is larger for shorter
+ *   flames, so they do not burn to the top all the time.
+ * - Heat drifts up: each cell becomes a weighted average of the two cells
+ *   below it, (h[k - 1] + 2 x h[k - 2]) / 3, computed as x 85 >> 8.
+ * - Sometimes a spark adds heat to a random cell near the base.
+ * - Heat is mapped to a color through a 256-entry palette in PROGMEM.
+ *
+ * The strip can be split into several flames of equal length, each with
+ * its base at its first pixel. Random numbers come from a 16-bit xorshift
+ * and all scaling is done with 8 x 8 multiplications, so the cost per
+ * pixel is fixed whatever the heat values are.
+ *
+ * draw() only sets the pixels: the sketch (or WS2812FX) calls show().
+ */
+
+typedef uint8_t FirePalette[256][3];
+
+// Black, red, orange, yellow, white
+const FirePalette FIRE_PALETTE_HEAT PROGMEM = {
+    {0, 0, 0}, {0, 0, 0}, {4, 0, 0}, {8, 0, 0},
+    {8, 0, 0}, {12, 0, 0}, {16, 0, 0}, {20, 0, 0},
+    {20, 0, 0}, {24, 0, 0}, {28, 0, 0}, {32, 0, 0},
+    {32, 0, 0}, {36, 0, 0}, {40, 0, 0}, {44, 0, 0},
+    {44, 0, 0}, {48, 0, 0}, {52, 0, 0}, {56, 0, 0},
+    {56, 0, 0}, {60, 0, 0}, {64, 0, 0}, {68, 0, 0},
+    {68, 0, 0}, {72, 0, 0}, {76, 0, 0}, {80, 0, 0},
+    {80, 0, 0}, {84, 0, 0}, {88, 0, 0}, {92, 0, 0},
+    {92, 0, 0}, {96, 0, 0}, {100, 0, 0}, {104, 0, 0},
+    {104, 0, 0}, {108, 0, 0}, {112, 0, 0}, {116, 0, 0},
+    {116, 0, 0}, {120, 0, 0}, {124, 0, 0}, {128, 0, 0},
+    {128, 0, 0}, {132, 0, 0}, {136, 0, 0}, {140, 0, 0},
+    {140, 0, 0}, {144, 0, 0}, {148, 0, 0}, {152, 0, 0},
+    {152, 0, 0}, {156, 0, 0}, {160, 0, 0}, {164, 0, 0},
+    {164, 0, 0}, {168, 0, 0}, {172, 0, 0}, {176, 0, 0},
+    {176, 0, 0}, {180, 0, 0}, {184, 0, 0}, {188, 0, 0},
+    {188, 0, 0}, {192, 0, 0}, {196, 0, 0}, {200, 0, 0},
+    {200, 0, 0}, {204, 0, 0}, {208, 0, 0}, {212, 0, 0},
+    {212, 0, 0}, {216, 0, 0}, {220, 0, 0}, {224, 0, 0},
+    {224, 0, 0}, {228, 0, 0}, {232, 0, 0}, {236, 0, 0},
+    {236, 0, 0}, {240, 0, 0}, {244, 0, 0}, {248, 0, 0},
+    {248, 0, 0}, {252, 0, 0}, {255, 0, 0}, {255, 4, 0},
+    {255, 4, 0}, {255, 8, 0}, {255, 12, 0}, {255, 16, 0},
+    {255, 16, 0}, {255, 20, 0}, {255, 24, 0}, {255, 28, 0},
+    {255, 28, 0}, {255, 32, 0}, {255, 36, 0}, {255, 40, 0},
+    {255, 40, 0}, {255, 44, 0}, {255, 48, 0}, {255, 52, 0},
+    {255, 52, 0}, {255, 56, 0}, {255, 60, 0}, {255, 64, 0},
+    {255, 64, 0}, {255, 68, 0}, {255, 72, 0}, {255, 76, 0},
+    {255, 76, 0}, {255, 80, 0}, {255, 84, 0}, {255, 88, 0},
+    {255, 88, 0}, {255, 92, 0}, {255, 96, 0}, {255, 100, 0},
+    {255, 100, 0}, {255, 104, 0}, {255, 108, 0}, {255, 112, 0},
+    {255, 112, 0}, {255, 116, 0}, {255, 120, 0}, {255, 124, 0},
+    {255, 124, 0}, {255, 128, 0}, {255, 132, 0}, {255, 136, 0},
+    {255, 136, 0}, {255, 140, 0}, {255, 144, 0}, {255, 148, 0},
+    {255, 148, 0}, {255, 152, 0}, {255, 156, 0}, {255, 160, 0},
+    {255, 160, 0}, {255, 164, 0}, {255, 168, 0}, {255, 172, 0},
+    {255, 172, 0}, {255, 176, 0}, {255, 180, 0}, {255, 184, 0},
+    {255, 184, 0}, {255, 188, 0}, {255, 192, 0}, {255, 196, 0},
+    {255, 196, 0}, {255, 200, 0}, {255, 204, 0}, {255, 208, 0},
+    {255, 208, 0}, {255, 212, 0}, {255, 216, 0}, {255, 220, 0},
+    {255, 220, 0}, {255, 224, 0}, {255, 228, 0}, {255, 232, 0},
+    {255, 232, 0}, {255, 236, 0}, {255, 240, 0}, {255, 244, 0},
+    {255, 244, 0}, {255, 248, 0}, {255, 252, 0}, {255, 255, 0},
+    {255, 255, 0}, {255, 255, 4}, {255, 255, 8}, {255, 255, 12},
+    {255, 255, 12}, {255, 255, 16}, {255, 255, 20}, {255, 255, 24},
+    {255, 255, 24}, {255, 255, 28}, {255, 255, 32}, {255, 255, 36},
+    {255, 255, 36}, {255, 255, 40}, {255, 255, 44}, {255, 255, 48},
+    {255, 255, 48}, {255, 255, 52}, {255, 255, 56}, {255, 255, 60},
+    {255, 255, 60}, {255, 255, 64}, {255, 255, 68}, {255, 255, 72},
+    {255, 255, 72}, {255, 255, 76}, {255, 255, 80}, {255, 255, 84},
+    {255, 255, 84}, {255, 255, 88}, {255, 255, 92}, {255, 255, 96},
+    {255, 255, 96}, {255, 255, 100}, {255, 255, 104}, {255, 255, 108},
+    {255, 255, 108}, {255, 255, 112}, {255, 255, 116}, {255, 255, 120},
+    {255, 255, 120}, {255, 255, 124}, {255, 255, 128}, {255, 255, 132},
+    {255, 255, 132}, {255, 255, 136}, {255, 255, 140}, {255, 255, 144},
+    {255, 255, 144}, {255, 255, 148}, {255, 255, 152}, {255, 255, 156},
+    {255, 255, 156}, {255, 255, 160}, {255, 255, 164}, {255, 255, 168},
+    {255, 255, 168}, {255, 255, 172}, {255, 255, 176}, {255, 255, 180},
+    {255, 255, 180}, {255, 255, 184}, {255, 255, 188}, {255, 255, 192},
+    {255, 255, 192}, {255, 255, 196}, {255, 255, 200}, {255, 255, 204},
+    {255, 255, 204}, {255, 255, 208}, {255, 255, 212}, {255, 255, 216},
+    {255, 255, 216}, {255, 255, 220}, {255, 255, 224}, {255, 255, 228},
+    {255, 255, 228}, {255, 255, 232}, {255, 255, 236}, {255, 255, 240},
+    {255, 255, 240}, {255, 255, 244}, {255, 255, 248}, {255, 255, 252},
+};
+
+// Black, blue, cyan, white
+const FirePalette FIRE_PALETTE_BLUE PROGMEM = {
+    {0, 0, 0}, {0, 0, 0}, {0, 0, 4}, {0, 0, 8},
+    {0, 0, 8}, {0, 0, 12}, {0, 0, 16}, {0, 0, 20},
+    {0, 0, 20}, {0, 0, 24}, {0, 0, 28}, {0, 0, 32},
+    {0, 0, 32}, {0, 0, 36}, {0, 0, 40}, {0, 0, 44},
+    {0, 0, 44}, {0, 0, 48}, {0, 0, 52}, {0, 0, 56},
+    {0, 0, 56}, {0, 0, 60}, {0, 0, 64}, {0, 0, 68},
+    {0, 0, 68}, {0, 0, 72}, {0, 0, 76}, {0, 0, 80},
+    {0, 0, 80}, {0, 0, 84}, {0, 0, 88}, {0, 0, 92},
+    {0, 0, 92}, {0, 0, 96}, {0, 0, 100}, {0, 0, 104},
+    {0, 0, 104}, {0, 0, 108}, {0, 0, 112}, {0, 0, 116},
+    {0, 0, 116}, {0, 0, 120}, {0, 0, 124}, {0, 0, 128},
+    {0, 0, 128}, {0, 0, 132}, {0, 0, 136}, {0, 0, 140},
+    {0, 0, 140}, {0, 0, 144}, {0, 0, 148}, {0, 0, 152},
+    {0, 0, 152}, {0, 0, 156}, {0, 0, 160}, {0, 0, 164},
+    {0, 0, 164}, {0, 0, 168}, {0, 0, 172}, {0, 0, 176},
+    {0, 0, 176}, {0, 0, 180}, {0, 0, 184}, {0, 0, 188},
+    {0, 0, 188}, {0, 0, 192}, {0, 0, 196}, {0, 0, 200},
+    {0, 0, 200}, {0, 0, 204}, {0, 0, 208}, {0, 0, 212},
+    {0, 0, 212}, {0, 0, 216}, {0, 0, 220}, {0, 0, 224},
+    {0, 0, 224}, {0, 0, 228}, {0, 0, 232}, {0, 0, 236},
+    {0, 0, 236}, {0, 0, 240}, {0, 0, 244}, {0, 0, 248},
+    {0, 0, 248}, {0, 0, 252}, {0, 0, 255}, {0, 4, 255},
+    {0, 4, 255}, {0, 8, 255}, {0, 12, 255}, {0, 16, 255},
+    {0, 16, 255}, {0, 20, 255}, {0, 24, 255}, {0, 28, 255},
+    {0, 28, 255}, {0, 32, 255}, {0, 36, 255}, {0, 40, 255},
+    {0, 40, 255}, {0, 44, 255}, {0, 48, 255}, {0, 52, 255},
+    {0, 52, 255}, {0, 56, 255}, {0, 60, 255}, {0, 64, 255},
+    {0, 64, 255}, {0, 68, 255}, {0, 72, 255}, {0, 76, 255},
+    {0, 76, 255}, {0, 80, 255}, {0, 84, 255}, {0, 88, 255},
+    {0, 88, 255}, {0, 92, 255}, {0, 96, 255}, {0, 100, 255},
+    {0, 100, 255}, {0, 104, 255}, {0, 108, 255}, {0, 112, 255},
+    {0, 112, 255}, {0, 116, 255}, {0, 120, 255}, {0, 124, 255},
+    {0, 124, 255}, {0, 128, 255}, {0, 132, 255}, {0, 136, 255},
+    {0, 136, 255}, {0, 140, 255}, {0, 144, 255}, {0, 148, 255},
+    {0, 148, 255}, {0, 152, 255}, {0, 156, 255}, {0, 160, 255},
+    {0, 160, 255}, {0, 164, 255}, {0, 168, 255}, {0, 172, 255},
+    {0, 172, 255}, {0, 176, 255}, {0, 180, 255}, {0, 184, 255},
+    {0, 184, 255}, {0, 188, 255}, {0, 192, 255}, {0, 196, 255},
+    {0, 196, 255}, {0, 200, 255}, {0, 204, 255}, {0, 208, 255},
+    {0, 208, 255}, {0, 212, 255}, {0, 216, 255}, {0, 220, 255},
+    {0, 220, 255}, {0, 224, 255}, {0, 228, 255}, {0, 232, 255},
+    {0, 232, 255}, {0, 236, 255}, {0, 240, 255}, {0, 244, 255},
+    {0, 244, 255}, {0, 248, 255}, {0, 252, 255}, {0, 255, 255},
+    {0, 255, 255}, {4, 255, 255}, {8, 255, 255}, {12, 255, 255},
+    {12, 255, 255}, {16, 255, 255}, {20, 255, 255}, {24, 255, 255},
+    {24, 255, 255}, {28, 255, 255}, {32, 255, 255}, {36, 255, 255},
+    {36, 255, 255}, {40, 255, 255}, {44, 255, 255}, {48, 255, 255},
+    {48, 255, 255}, {52, 255, 255}, {56, 255, 255}, {60, 255, 255},
+    {60, 255, 255}, {64, 255, 255}, {68, 255, 255}, {72, 255, 255},
+    {72, 255, 255}, {76, 255, 255}, {80, 255, 255}, {84, 255, 255},
+    {84, 255, 255}, {88, 255, 255}, {92, 255, 255}, {96, 255, 255},
+    {96, 255, 255}, {100, 255, 255}, {104, 255, 255}, {108, 255, 255},
+    {108, 255, 255}, {112, 255, 255}, {116, 255, 255}, {120, 255, 255},
+    {120, 255, 255}, {124, 255, 255}, {128, 255, 255}, {132, 255, 255},
+    {132, 255, 255}, {136, 255, 255}, {140, 255, 255}, {144, 255, 255},
+    {144, 255, 255}, {148, 255, 255}, {152, 255, 255}, {156, 255, 255},
+    {156, 255, 255}, {160, 255, 255}, {164, 255, 255}, {168, 255, 255},
+    {168, 255, 255}, {172, 255, 255}, {176, 255, 255}, {180, 255, 255},
+    {180, 255, 255}, {184, 255, 255}, {188, 255, 255}, {192, 255, 255},
+    {192, 255, 255}, {196, 255, 255}, {200, 255, 255}, {204, 255, 255},
+    {204, 255, 255}, {208, 255, 255}, {212, 255, 255}, {216, 255, 255},
+    {216, 255, 255}, {220, 255, 255}, {224, 255, 255}, {228, 255, 255},
+    {228, 255, 255}, {232, 255, 255}, {236, 255, 255}, {240, 255, 255},
+    {240, 255, 255}, {244, 255, 255}, {248, 255, 255}, {252, 255, 255},
+};
+
+template <typename Strip>
+class FireEffect
+{
+public:
+    /**
+     * heat holds numFlames x flameSize cells. cooling (0-255) shortens the
+     * flames, sparking (0-255) is the chance of a new spark per frame.
+     */
+    FireEffect(
+        Strip &strip,
+        uint8_t *heat,
+        uint8_t numFlames,
+        uint16_t flameSize,
+        const FirePalette &palette,
+        uint8_t cooling,
+        uint8_t sparking)
+        : strip(strip),
+          heat(heat),
+          numFlames(numFlames),
+          flameSize(flameSize),
+          palette(palette),
+          sparking(sparking),
+          sparkZone(flameSize / 8 + 1),
+          rng(1),
+          frameUs(0)
+    {
+        uint16_t coolMax = (uint16_t)cooling * 10 / flameSize + 2;
+        this->coolMax = coolMax > 255 ? 255 : coolMax;
+    }
+
+    /**
+     * Puts the fire out and seeds the random generator, so effects started
+     * one after the other do not flicker in sync.
+     */
+    void begin()
+    {
+        clear();
+
+        rng = random(1, 0x10000);
+    }
+
+    void clear()
+    {
+        memset(heat, 0, (size_t)numFlames * flameSize);
+    }
+
+    /**
+     * Advances the simulation one frame and sets the pixels.
+     */
+    void draw()
+    {
+        unsigned long start = micros();
+        uint16_t pixel = 0;
+
+        for (uint8_t f = 0; f < numFlames; f++)
+        {
+            uint8_t *cells = heat + (uint16_t)f * flameSize;
+
+            for (uint16_t k = 0; k < flameSize; k++)
+            {
+                uint8_t cool = scale(random8(), coolMax);
+                cells[k] = cells[k] > cool ? cells[k] - cool : 0;
+            }
+
+            for (uint16_t k = flameSize - 1; k >= 2; k--)
+            {
+                uint16_t sum = cells[k - 1] + 2 * cells[k - 2];
+                cells[k] = (sum * 85) >> 8;
+            }
+
+            if (random8() < sparking)
+            {
+                uint8_t y = scale(random8(), sparkZone);
+                uint8_t spark = 160 + scale(random8(), 95);
+                cells[y] = cells[y] > 255 - spark ? 255 : cells[y] + spark;
+            }
+
+            for (uint16_t k = 0; k < flameSize; k++, pixel++)
+            {
+                const uint8_t *rgb = palette[cells[k]];
+
+                strip.setPixelColor(
+                    pixel,
+                    pgm_read_byte(&rgb[0]),
+                    pgm_read_byte(&rgb[1]),
+                    pgm_read_byte(&rgb[2]));
+            }
+        }
+
+        frameUs = micros() - start;
+    }
+
+    /**
+     * Duration (us) of the last draw().
+     */
+    unsigned long getFrameMicros() const
+    {
+        return frameUs;
+    }
+
+private:
+    Strip &strip;
+    uint8_t *heat;
+    uint8_t numFlames;
+    uint16_t flameSize;
+    const FirePalette &palette;
+    uint8_t sparking;
+    uint8_t sparkZone;
+    uint8_t coolMax;
+    uint16_t rng;
+    unsigned long frameUs;
+
+    uint8_t random8()
+    {
+        rng ^= rng << 7;
+        rng ^= rng >> 9;
+        rng ^= rng << 8;
+
+        return rng >> 8;
+    }
+
+    /**
+     * value x range / 256, in 0..range - 1.
+     */
+    static uint8_t scale(uint8_t value, uint8_t range)
+    {
+        return ((uint16_t)value * range) >> 8;
+    }
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include <Automaton.h>
 #include <Adafruit_NeoPixel.h>
 #include <CircularBuffer.hpp>
+#include "FireEffect.h"
 
 /**
  * Proximity sensors.
@@ -18,18 +19,49 @@ const uint8_t LED_BRIGHTNESS = 150;
 const uint8_t LED_TORCHES_NUM = 24;
 const uint8_t LED_TORCHES_PINS[PROX_SENSORS_NUM] = {6, 7, 8};
 
-const uint32_t TORCH_COLOR = Adafruit_NeoPixel::Color(0, 0, 200);
-
 Adafruit_NeoPixel ledsTorches[PROX_SENSORS_NUM] = {
     Adafruit_NeoPixel(LED_TORCHES_NUM, LED_TORCHES_PINS[0], NEO_GRB + NEO_KHZ800),
     Adafruit_NeoPixel(LED_TORCHES_NUM, LED_TORCHES_PINS[1], NEO_GRB + NEO_KHZ800),
     Adafruit_NeoPixel(LED_TORCHES_NUM, LED_TORCHES_PINS[2], NEO_GRB + NEO_KHZ800)};
 
-const uint16_t LED_BONFIRE_NUM = 250;
+// The bonfire strip is laid out as flames of equal length, each one
+// starting at the base of the bonfire
+const uint8_t LED_BONFIRE_FLAMES = 10;
+const uint16_t LED_BONFIRE_FLAME_SIZE = 25;
+const uint16_t LED_BONFIRE_NUM = LED_BONFIRE_FLAMES * LED_BONFIRE_FLAME_SIZE;
 const uint8_t LED_BONFIRE_PIN = 12;
 
 Adafruit_NeoPixel ledBonfire = Adafruit_NeoPixel(LED_BONFIRE_NUM, LED_BONFIRE_PIN, NEO_GRB + NEO_KHZ800);
 
+/**
+ * Fire effects.
+ */
+
+const uint8_t FIRE_BONFIRE_COOLING = 55;
+const uint8_t FIRE_BONFIRE_SPARKING = 120;
+const uint8_t FIRE_TORCH_COOLING = 70;
+const uint8_t FIRE_TORCH_SPARKING = 100;
+const unsigned long FIRE_REPORT_MS = 5000;
+
+uint8_t heatBonfire[LED_BONFIRE_NUM];
+uint8_t heatTorches[PROX_SENSORS_NUM][LED_TORCHES_NUM];
+
+FireEffect<Adafruit_NeoPixel> fireBonfire(
+    ledBonfire,
+    heatBonfire,
+    LED_BONFIRE_FLAMES,
+    LED_BONFIRE_FLAME_SIZE,
+    FIRE_PALETTE_HEAT,
+    FIRE_BONFIRE_COOLING,
+    FIRE_BONFIRE_SPARKING);
+
+FireEffect<Adafruit_NeoPixel> fireTorches[PROX_SENSORS_NUM] = {
+    FireEffect<Adafruit_NeoPixel>(ledsTorches[0], heatTorches[0], 1, LED_TORCHES_NUM, FIRE_PALETTE_BLUE, FIRE_TORCH_COOLING, FIRE_TORCH_SPARKING),
+    FireEffect<Adafruit_NeoPixel>(ledsTorches[1], heatTorches[1], 1, LED_TORCHES_NUM, FIRE_PALETTE_BLUE, FIRE_TORCH_COOLING, FIRE_TORCH_SPARKING),
+    FireEffect<Adafruit_NeoPixel>(ledsTorches[2], heatTorches[2], 1, LED_TORCHES_NUM, FIRE_PALETTE_BLUE, FIRE_TORCH_COOLING, FIRE_TORCH_SPARKING)};
+
+unsigned long lastFireReportMillis = 0;
+
 /**
  * Relay.
  */
@@ -188,12 +220,14 @@ void initLeds()
     ledsTorches[i].setBrightness(LED_BRIGHTNESS);
     ledsTorches[i].clear();
     ledsTorches[i].show();
+    fireTorches[i].begin();
   }
 
   ledBonfire.begin();
   ledBonfire.setBrightness(LED_BRIGHTNESS);
   ledBonfire.clear();
   ledBonfire.show();
+  fireBonfire.begin();
 }
 
 /**
@@ -225,25 +259,18 @@ void loopBonfire()
     return;
   }
 
-  uint8_t startRed = 255, startGreen = 165, startBlue = 0; // Yellow-Orange
-  uint8_t endRed = 255, endGreen = 0, endBlue = 0;         // Pure Red
+  fireBonfire.draw();
+  ledBonfire.show();
 
-  for (uint16_t i = 0; i < LED_BONFIRE_NUM; i++)
-  {
-    float ratio = (float)i / (LED_BONFIRE_NUM - 1);
-    float red = startRed + ratio * (endRed - startRed);
-    float green = startGreen + ratio * (endGreen - startGreen);
-    float blue = startBlue + ratio * (endBlue - startBlue);
+  unsigned long now = millis();
 
-    int flicker = random(0, 21) - 10;
-    red = constrain(red + flicker, 0, 255);
-    green = constrain(green + flicker, 0, 255);
-    blue = constrain(blue + flicker, 0, 255);
+  if (now - lastFireReportMillis >= FIRE_REPORT_MS)
+  {
+    lastFireReportMillis = now;
 
-    ledBonfire.setPixelColor(i, Adafruit_NeoPixel::Color(red, green, blue));
+    Serial.print(F("Bonfire frame (us): "));
+    Serial.println(fireBonfire.getFrameMicros());
   }
-
-  ledBonfire.show();
 }
 
 void updateTorchLeds()
@@ -252,10 +279,12 @@ void updateTorchLeds()
   {
     if (progState.isTorchActive[i])
     {
-      ledsTorches[i].fill(TORCH_COLOR);
+      fireTorches[i].draw();
     }
     else
     {
+      // Put the fire out so it ignites again from the base
+      fireTorches[i].clear();
       ledsTorches[i].clear();
     }
 
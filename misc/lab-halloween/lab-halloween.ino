@@ -1,7 +1,8 @@
 #include <Automaton.h>
 #include <Adafruit_NeoPixel.h>
 #include <CircularBuffer.h>
-#include "rdm630.h"
+#include <SoftwareSerial.h>
+#include "RfidFrameParser.h"
 
 /**
  * RFID reader.
@@ -10,16 +11,22 @@
 const byte PIN_RFID_RX = 11;
 const byte PIN_RFID_TX = 13;
 
-RDM6300 rfidReader(PIN_RFID_RX, PIN_RFID_TX);
+SoftwareSerial rfidSerial(PIN_RFID_RX, PIN_RFID_TX);
+RfidFrameParser rfidParser;
+
+// Readers resend the frame while the tag stays in the field
+const unsigned long RFID_PRESENCE_TIMEOUT_MS = 500;
 
 const byte NUM_VALID_TAGS = 1;
 const byte NUM_RESET_TAGS = 1;
 
-String validTags[NUM_VALID_TAGS] = {
-    "011005CDB600"};
+// First 10 hex chars of each tag ID, sorted in ascending order
+
+const uint8_t VALID_TAGS[NUM_VALID_TAGS][RFID_TAG_ID_SIZE] PROGMEM = {
+    {0x01, 0x10, 0x05, 0xCD, 0xB6}};
 
-String resetTags[NUM_RESET_TAGS] = {
-    "011005CDB400"};
+const uint8_t RESET_TAGS[NUM_RESET_TAGS][RFID_TAG_ID_SIZE] PROGMEM = {
+    {0x01, 0x10, 0x05, 0xCD, 0xB4}};
 
 const byte RFID_TAG_NONE = 0;
 const byte RFID_TAG_VALID = 1;
@@ -418,39 +425,32 @@ void initButtons()
 
 void initRfid()
 {
-    rfidReader.begin();
+    rfidSerial.begin(9600);
+    rfidSerial.listen();
 }
 
 byte pollRfidReader()
 {
-    String tagId;
-
-    Serial.println(F("Reading RFID"));
-
-    tagId = rfidReader.getTagId();
+    if (rfidParser.poll(rfidSerial))
+    {
+        Serial.print(F("Tag :: "));
+        rfidPrintTag(Serial, rfidParser.tag());
+        Serial.println();
+    }
 
-    if (!tagId.length())
+    if (!rfidParser.isTagPresent(RFID_PRESENCE_TIMEOUT_MS))
     {
         return RFID_TAG_NONE;
     }
 
-    Serial.print(F("Tag :: "));
-    Serial.println(tagId);
-
-    for (int i = 0; i < NUM_VALID_TAGS; i++)
+    if (rfidFindTag(rfidParser.tag(), VALID_TAGS, NUM_VALID_TAGS) != -1)
     {
-        if (validTags[i].compareTo(tagId) == 0)
-        {
-            return RFID_TAG_VALID;
-        }
+        return RFID_TAG_VALID;
     }
 
-    for (int i = 0; i < NUM_RESET_TAGS; i++)
+    if (rfidFindTag(rfidParser.tag(), RESET_TAGS, NUM_RESET_TAGS) != -1)
     {
-        if (resetTags[i].compareTo(tagId) == 0)
-        {
-            return RFID_TAG_RESET;
-        }
+        return RFID_TAG_RESET;
     }
 
     return RFID_TAG_NONE;
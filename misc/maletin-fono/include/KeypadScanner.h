@@ -0,0 +1,178 @@
+#ifndef KEYPAD_SCANNER_H
+#define KEYPAD_SCANNER_H
+
+#include <Arduino.h>
+
+/**
+ * Matrix keypad scanner meant to run from a periodic timer interrupt.
+ *
+ * scan() reads the whole matrix into a bitmask (one bit per key) and
+ * debounces every key at once with two vertical counters: a key only
+ * changes state after 4 consecutive scans that disagree with it. With a
+ * 5 ms timer that is a 20 ms debounce.
+ *
+ * Debounced presses and releases are pushed into a single-producer /
+ * single-consumer FIFO that loop() drains with pop(), so keys are not
+ * lost while the sketch is blocked in an effect. Only scan() writes the
+ * head and only pop() writes the tail; both are single bytes.
+ */
+
+#define KEYPAD_SCANNER_BARRIER() asm volatile("" ::: "memory")
+
+typedef uint16_t KeypadMask;
+
+const uint8_t KEYPAD_SCANNER_MAX_KEYS = 16;
+const uint8_t KEYPAD_SCANNER_FIFO_SIZE = 16;
+const uint8_t KEYPAD_SCANNER_PRESSED = 0x80;
+
+typedef struct keypadEvent {
+    char key;
+    bool isPressed;
+} KeypadEvent;
+
+class KeypadScanner
+{
+public:
+    KeypadScanner(
+        const char *keymap,
+        const uint8_t *rowPins,
+        const uint8_t *colPins,
+        uint8_t rows,
+        uint8_t cols)
+        : keymap(keymap),
+          rowPins(rowPins),
+          colPins(colPins),
+          rows(rows),
+          cols(rows * cols > KEYPAD_SCANNER_MAX_KEYS ? KEYPAD_SCANNER_MAX_KEYS / rows : cols),
+          state(0),
+          ct0(~(KeypadMask)0),
+          ct1(~(KeypadMask)0),
+          head(0),
+          tail(0),
+          overruns(0)
+    {
+    }
+
+    /**
+     * Rows idle as inputs (high impedance) and are pulled low one at a
+     * time, so two keys pressed on the same column cannot short two rows.
+     */
+    void begin()
+    {
+        for (uint8_t r = 0; r < rows; r++) {
+            pinMode(rowPins[r], INPUT);
+        }
+
+        for (uint8_t c = 0; c < cols; c++) {
+            pinMode(colPins[c], INPUT_PULLUP);
+        }
+    }
+
+    /**
+     * Call from the timer interrupt only.
+     */
+    void scan()
+    {
+        KeypadMask delta = readMatrix() ^ state;
+
+        ct0 = ~(ct0 & delta);
+        ct1 = ct0 ^ (ct1 & delta);
+
+        KeypadMask toggled = delta & ct0 & ct1;
+
+        if (toggled == 0) {
+            return;
+        }
+
+        state ^= toggled;
+
+        for (uint8_t idx = 0; toggled != 0; idx++, toggled >>= 1) {
+            if (toggled & 1) {
+                bool isPressed = state & ((KeypadMask)1 << idx);
+                push(isPressed ? (idx | KEYPAD_SCANNER_PRESSED) : idx);
+            }
+        }
+    }
+
+    /**
+     * Call from loop() only.
+     */
+    bool pop(KeypadEvent &event)
+    {
+        if (tail == head) {
+            return false;
+        }
+
+        KEYPAD_SCANNER_BARRIER();
+        uint8_t code = fifo[tail];
+        KEYPAD_SCANNER_BARRIER();
+
+        tail = (tail + 1) & (KEYPAD_SCANNER_FIFO_SIZE - 1);
+
+        event.key = keymap[code & ~KEYPAD_SCANNER_PRESSED];
+        event.isPressed = code & KEYPAD_SCANNER_PRESSED;
+
+        return true;
+    }
+
+    uint8_t getOverruns() const
+    {
+        return overruns;
+    }
+
+private:
+    const char *keymap;
+    const uint8_t *rowPins;
+    const uint8_t *colPins;
+    uint8_t rows;
+    uint8_t cols;
+
+    KeypadMask state;
+    KeypadMask ct0;
+    KeypadMask ct1;
+
+    uint8_t fifo[KEYPAD_SCANNER_FIFO_SIZE];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    volatile uint8_t overruns;
+
+    KeypadMask readMatrix()
+    {
+        KeypadMask raw = 0;
+
+        for (uint8_t r = 0; r < rows; r++) {
+            pinMode(rowPins[r], OUTPUT);
+            digitalWrite(rowPins[r], LOW);
+
+            for (uint8_t c = 0; c < cols; c++) {
+                if (digitalRead(colPins[c]) == LOW) {
+                    raw |= (KeypadMask)1 << (r * cols + c);
+                }
+            }
+
+            digitalWrite(rowPins[r], HIGH);
+            pinMode(rowPins[r], INPUT);
+        }
+
+        return raw;
+    }
+
+    void push(uint8_t code)
+    {
+        uint8_t next = (head + 1) & (KEYPAD_SCANNER_FIFO_SIZE - 1);
+
+        if (next == tail) {
+            if (overruns < 0xFF) {
+                overruns++;
+            }
+
+            return;
+        }
+
+        fifo[head] = code;
+        KEYPAD_SCANNER_BARRIER();
+        head = next;
+    }
+};
+
+#endif
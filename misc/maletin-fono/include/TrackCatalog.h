@@ -0,0 +1,315 @@
+#ifndef TRACK_CATALOG_H
+#define TRACK_CATALOG_H
+
+#include <Arduino.h>
+#include <SD.h>
+
+/**
+ * Binary track catalogue cached on the SD card.
+ *
+ * Tracks are addressed by numeric id (the index in the paths table that
+ * the sketch compiles in). The catalogue file stores, for each id, the
+ * 8.3 path, the file size and the MP3 duration:
+ *
+ *   header: magic, version, count, CRC-32 of the entries
+ *   entries: count x TrackEntry
+ *
+ * begin() only reads and validates this file, so booting does not walk
+ * the card. The catalogue is rebuilt (one open per track plus an MP3
+ * header parse) when it is missing, corrupt, was built for a different
+ * paths table or lists a missing track. A catalogue with missing tracks is
+ * never saved, so tracks copied to the card later are picked up on boot.
+ * If a played file no longer matches its cached size, the catalogue is
+ * marked stale, removed by removeIfStale() once playback stops and
+ * rebuilt on the next boot.
+ */
+
+const char TRACK_CATALOG_PATH[] = "/TRACKS.IDX";
+const uint32_t TRACK_CATALOG_MAGIC = 0x31544354; // "TCT1"
+const uint16_t TRACK_CATALOG_VERSION = 1;
+const uint8_t TRACK_CATALOG_MAX_TRACKS = 32;
+const uint8_t TRACK_PATH_SIZE = 14; // "/" + 8.3 + NUL
+
+typedef struct trackEntry {
+    char path[TRACK_PATH_SIZE];
+    uint32_t size;
+    uint32_t durationMs;
+} TrackEntry;
+
+typedef struct trackCatalogHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t crc;
+} TrackCatalogHeader;
+
+class TrackCatalog
+{
+public:
+    TrackCatalog(const char *const *paths, uint8_t num)
+        : paths(paths),
+          num(num > TRACK_CATALOG_MAX_TRACKS ? TRACK_CATALOG_MAX_TRACKS : num),
+          isStale(false)
+    {
+        memset(entries, 0, sizeof(entries));
+    }
+
+    /**
+     * Loads the cached catalogue or rebuilds it.
+     * Call after SD.begin(). Returns false if any track is missing.
+     */
+    bool begin()
+    {
+        if (load()) {
+            Serial.println("Track catalogue OK");
+        } else {
+            Serial.println("Track catalogue rebuild");
+            rebuild();
+        }
+
+        bool allPresent = true;
+
+        for (uint8_t i = 0; i < num; i++) {
+            if (entries[i].size == 0) {
+                Serial.print("Missing track: ");
+                Serial.println(paths[i]);
+                allPresent = false;
+            }
+        }
+
+        return allPresent;
+    }
+
+    uint8_t size() const
+    {
+        return num;
+    }
+
+    /**
+     * Returns the entry of the given track or NULL if it does not exist.
+     */
+    const TrackEntry *get(uint8_t id) const
+    {
+        if (id >= num || entries[id].size == 0) {
+            return NULL;
+        }
+
+        return &entries[id];
+    }
+
+    /**
+     * Checks an opened track against the catalogue.
+     * On mismatch the catalogue is only marked stale: the track is playing
+     * and the card belongs to the player until it stops.
+     */
+    bool verify(uint8_t id, uint32_t openedSize)
+    {
+        if (id < num && entries[id].size == openedSize) {
+            return true;
+        }
+
+        Serial.println("Track catalogue stale");
+        isStale = true;
+
+        return false;
+    }
+
+    /**
+     * Removes the cached file if verify() found it stale, so it is rebuilt
+     * on boot. Call it while nothing is playing.
+     */
+    void removeIfStale()
+    {
+        if (!isStale) {
+            return;
+        }
+
+        Serial.println("Track catalogue stale: invalidating");
+        SD.remove(TRACK_CATALOG_PATH);
+        isStale = false;
+    }
+
+private:
+    const char *const *paths;
+    uint8_t num;
+    TrackEntry entries[TRACK_CATALOG_MAX_TRACKS];
+    bool isStale;
+
+    static uint32_t crc32(const uint8_t *data, size_t len)
+    {
+        uint32_t crc = 0xFFFFFFFF;
+
+        for (size_t i = 0; i < len; i++) {
+            crc ^= data[i];
+
+            for (uint8_t k = 0; k < 8; k++) {
+                crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+            }
+        }
+
+        return ~crc;
+    }
+
+    bool hasAllTracks() const
+    {
+        for (uint8_t i = 0; i < num; i++) {
+            if (entries[i].size == 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    size_t entriesBytes() const
+    {
+        return sizeof(TrackEntry) * num;
+    }
+
+    bool load()
+    {
+        File file = SD.open(TRACK_CATALOG_PATH, FILE_READ);
+
+        if (!file) {
+            return false;
+        }
+
+        TrackCatalogHeader header;
+
+        bool isValid =
+            file.read((uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+            header.magic == TRACK_CATALOG_MAGIC &&
+            header.version == TRACK_CATALOG_VERSION &&
+            header.count == num &&
+            file.read((uint8_t *)entries, entriesBytes()) == (int)entriesBytes() &&
+            header.crc == crc32((const uint8_t *)entries, entriesBytes());
+
+        file.close();
+
+        for (uint8_t i = 0; isValid && i < num; i++) {
+            isValid = strncmp(entries[i].path, paths[i], TRACK_PATH_SIZE) == 0;
+        }
+
+        return isValid && hasAllTracks();
+    }
+
+    void rebuild()
+    {
+        for (uint8_t i = 0; i < num; i++) {
+            TrackEntry &entry = entries[i];
+
+            memset(&entry, 0, sizeof(entry));
+            strncpy(entry.path, paths[i], TRACK_PATH_SIZE - 1);
+
+            File file = SD.open(paths[i], FILE_READ);
+
+            if (!file) {
+                continue;
+            }
+
+            entry.size = file.size();
+            entry.durationMs = mp3DurationMs(file);
+            file.close();
+        }
+
+        if (!hasAllTracks()) {
+            Serial.println("Track catalogue not saved: missing tracks");
+            return;
+        }
+
+        TrackCatalogHeader header;
+
+        header.magic = TRACK_CATALOG_MAGIC;
+        header.version = TRACK_CATALOG_VERSION;
+        header.count = num;
+        header.crc = crc32((const uint8_t *)entries, entriesBytes());
+
+        // FILE_WRITE appends, so start from an empty file
+        SD.remove(TRACK_CATALOG_PATH);
+
+        File file = SD.open(TRACK_CATALOG_PATH, FILE_WRITE);
+
+        if (!file) {
+            Serial.println("Cannot write track catalogue");
+            return;
+        }
+
+        file.write((const uint8_t *)&header, sizeof(header));
+        file.write((const uint8_t *)entries, entriesBytes());
+        file.close();
+    }
+
+    /**
+     * Estimates the duration from the first MPEG audio frame header.
+     * Exact for CBR files, which is what we put on the props.
+     */
+    static uint32_t mp3DurationMs(File &file)
+    {
+        // Bitrates (kbps) for MPEG-1 and MPEG-2/2.5 Layer III
+        static const uint16_t bitratesV1[16] = {
+            0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0};
+        static const uint16_t bitratesV2[16] = {
+            0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0};
+
+        const uint16_t maxScanBytes = 4096;
+
+        uint8_t head[10];
+        uint32_t audioStart = 0;
+
+        if (file.read(head, sizeof(head)) == sizeof(head) &&
+            head[0] == 'I' && head[1] == 'D' && head[2] == '3') {
+            // ID3v2 tag size is a 28-bit syncsafe integer
+            audioStart = 10 +
+                         (((uint32_t)head[6] & 0x7F) << 21) +
+                         (((uint32_t)head[7] & 0x7F) << 14) +
+                         (((uint32_t)head[8] & 0x7F) << 7) +
+                         ((uint32_t)head[9] & 0x7F);
+        }
+
+        if (!file.seek(audioStart)) {
+            return 0;
+        }
+
+        uint8_t prev = 0;
+
+        for (uint16_t i = 0; i < maxScanBytes && file.available(); i++) {
+            int c = file.read();
+
+            if (c < 0) {
+                return 0;
+            }
+
+            if (prev != 0xFF || (c & 0xE0) != 0xE0) {
+                prev = c;
+                continue;
+            }
+
+            // Only Layer III frames
+            if ((c & 0x06) != 0x02) {
+                prev = c;
+                continue;
+            }
+
+            uint8_t b2 = file.read();
+            uint32_t frameStart = audioStart + i - 1;
+            i++;
+
+            bool isV1 = (c & 0x18) == 0x18;
+            uint16_t kbps = isV1 ? bitratesV1[b2 >> 4] : bitratesV2[b2 >> 4];
+
+            if (kbps == 0) {
+                prev = 0;
+                continue;
+            }
+
+            uint32_t audioBytes = file.size() - frameStart;
+
+            // bytes * 8 / (kbps * 1000) s == bytes * 8 / kbps ms
+            return audioBytes * 8 / kbps;
+        }
+
+        return 0;
+    }
+};
+
+#endif
@@ -1,12 +1,14 @@
 #include <Adafruit_NeoPixel.h>
 #include <Adafruit_VS1053.h>
-#include <CircularBuffer.h>
-#include <Keypad.h>
+#include <Adafruit_ZeroTimer.h>
 #include <LCD.h>
 #include <LiquidCrystal_I2C.h>
 #include <SD.h>
 #include <SPI.h>
 #include <Wire.h>
+#include "CodeMatcher.h"
+#include "KeypadScanner.h"
+#include "TrackCatalog.h"
 
 #define VS1053_RESET -1 // VS1053 reset pin (not used)
 #define VS1053_CS 6 // VS1053 chip select pin (output)
@@ -34,16 +36,35 @@ Adafruit_VS1053_FilePlayer musicPlayer = Adafruit_VS1053_FilePlayer(
 const uint16_t NUM_CODES = 3;
 const uint16_t CODE_SIZE = 8;
 
-char codesArr[NUM_CODES][CODE_SIZE] = {
+const char codesArr[NUM_CODES][CODE_SIZE] = {
     { '3', '1', '4', '5', '9', '6', '0', '0' },
     { '3', '8', '7', '3', '0', '8', '5', '7' },
     { '7', '5', '4', '4', '8', '3', '7', '7' }
 };
 
-const String tracksArr[NUM_CODES] = {
-    String("/maletas.mp3"),
-    String("/picasso.mp3"),
-    String("/velaz.mp3")
+/**
+ * Audio tracks by id (index in TRACK_PATHS).
+ */
+
+const uint8_t TRACK_MALETAS = 0;
+const uint8_t TRACK_PICASSO = 1;
+const uint8_t TRACK_VELAZ = 2;
+const uint8_t TRACK_UNKNOWN = 3;
+const uint8_t TRACKS_NUM = 4;
+
+const char* const TRACK_PATHS[TRACKS_NUM] = {
+    "/maletas.mp3",
+    "/picasso.mp3",
+    "/velaz.mp3",
+    "/nada.mp3"
+};
+
+TrackCatalog trackCatalog(TRACK_PATHS, TRACKS_NUM);
+
+const uint8_t tracksArr[NUM_CODES] = {
+    TRACK_MALETAS,
+    TRACK_PICASSO,
+    TRACK_VELAZ
 };
 
 const String descriptionsArr[NUM_CODES] = {
@@ -52,7 +73,6 @@ const String descriptionsArr[NUM_CODES] = {
     String("Llamada en curso")
 };
 
-const String TRACK_UNKNOWN = String("/nada.mp3");
 const String DESCRIPTION_UNKNOWN = String("Num. desconocido");
 
 /**
@@ -62,24 +82,29 @@ const String DESCRIPTION_UNKNOWN = String("Num. desconocido");
 const uint16_t KEY_ROWS = 4;
 const uint16_t KEY_COLS = 4;
 
-char keys[KEY_ROWS][KEY_COLS] = {
+const char keys[KEY_ROWS][KEY_COLS] = {
     { '1', '2', '3', 'A' },
     { '4', '5', '6', 'B' },
     { '7', '8', '9', 'C' },
     { '*', '0', '#', 'D' }
 };
 
-uint8_t keyRowPins[KEY_ROWS] = { 12, 11, 4, 1 };
-uint8_t keyColPins[KEY_COLS] = { 0, A5, A4, A3 };
+const uint8_t keyRowPins[KEY_ROWS] = { 12, 11, 4, 1 };
+const uint8_t keyColPins[KEY_COLS] = { 0, A5, A4, A3 };
 
-Keypad kpd = Keypad(
-    makeKeymap(keys),
+KeypadScanner keypad(
+    &keys[0][0],
     keyRowPins,
     keyColPins,
     KEY_ROWS,
     KEY_COLS);
 
-CircularBuffer<char, CODE_SIZE> keyBuffer;
+// TC3 at 48 MHz / 1024 / (234 + 1) = 199.5 Hz, one scan every ~5 ms
+const uint16_t KEYPAD_TIMER_COMPARE = 234;
+
+Adafruit_ZeroTimer keypadTimer = Adafruit_ZeroTimer(3);
+
+CodeMatcher codeMatcher(&codesArr[0][0], NUM_CODES, CODE_SIZE);
 
 const uint8_t PIN_HANGUP = A2;
 const String MSG_DEFAULT = String("Telefono viejuno");
@@ -114,10 +139,14 @@ void printDisplay(String content)
 bool hangState;
 unsigned long hangEdgeMillis;
 
+// Keys since the last call: an unknown number is CODE_SIZE keys
+uint16_t dialedKeys;
+
 void initState()
 {
     hangState = true;
     hangEdgeMillis = 0;
+    dialedKeys = 0;
 }
 
 void initBoardPixel()
@@ -147,78 +176,35 @@ void displayKeyBuffer()
 {
     String val = String("");
 
-    for (int i = 0; i < keyBuffer.size(); i++) {
-        val.concat(keyBuffer[i]);
+    for (int i = 0; i < codeMatcher.size(); i++) {
+        val.concat(codeMatcher[i]);
     }
 
     printDisplay(val);
 }
 
-void updateKeyBuffer()
+void TC3_Handler()
 {
-    char key = kpd.getKey();
-
-    if (key != NO_KEY) {
-        Serial.print("Key: ");
-        Serial.println(key);
-        keyBuffer.push(key);
-        displayKeyBuffer();
-    }
+    Adafruit_ZeroTimer::timerHandler(3);
 }
 
-bool inKeyBuffer(char* val, size_t valSize)
+void onKeypadTimer()
 {
-    if (keyBuffer.size() < valSize) {
-        return false;
-    }
-
-    for (uint16_t i = 0; i < valSize; i++) {
-        if (keyBuffer[i] != val[i]) {
-            return false;
-        }
-    }
-
-    return true;
+    keypad.scan();
 }
 
-int findInBuffer()
+void initKeypad()
 {
-    for (int i = 0; i < NUM_CODES; i++) {
-        if (inKeyBuffer(codesArr[i], CODE_SIZE)) {
-            return i;
-        }
-    }
-
-    return -1;
-}
-
-void printDirectory(File dir, int numTabs)
-{
-    while (true) {
-        File entry = dir.openNextFile();
-
-        if (!entry) {
-            // No more files
-            break;
-        }
-
-        for (uint8_t i = 0; i < numTabs; i++) {
-            Serial.print('\t');
-        }
-
-        Serial.print(entry.name());
-
-        if (entry.isDirectory()) {
-            Serial.println("/");
-            printDirectory(entry, numTabs + 1);
-        } else {
-            // Files have sizes, directories do not
-            Serial.print("\t\t");
-            Serial.println(entry.size(), DEC);
-        }
-
-        entry.close();
-    }
+    keypad.begin();
+
+    keypadTimer.enable(false);
+    keypadTimer.configure(
+        TC_CLOCK_PRESCALER_DIV1024,
+        TC_COUNTER_SIZE_16BIT,
+        TC_WAVE_GENERATION_MATCH_PWM);
+    keypadTimer.setCompare(0, KEYPAD_TIMER_COMPARE);
+    keypadTimer.setCallback(true, TC_CALLBACK_CC_CHANNEL0, onKeypadTimer);
+    keypadTimer.enable(true);
 }
 
 void initAudio()
@@ -237,9 +223,10 @@ void initAudio()
     }
 
     Serial.println("SD OK");
-    Serial.println("Listing SD root");
 
-    printDirectory(SD.open("/"), 0);
+    if (!trackCatalog.begin()) {
+        Serial.println("Some tracks are missing");
+    }
 
     // Set volume for left, right channels
     // lower numbers == louder volume
@@ -247,28 +234,37 @@ void initAudio()
     musicPlayer.useInterrupt(VS1053_FILEPLAYER_PIN_INT);
 }
 
-void playTrack(String trackName)
+void playTrack(uint8_t trackId)
 {
+    const TrackEntry* track = trackCatalog.get(trackId);
+
+    if (!track) {
+        Serial.print("Unknown track: ");
+        Serial.println(trackId);
+        return;
+    }
+
     if (!musicPlayer.stopped()) {
         Serial.println("Cannot play track: musicPlayer.stopped() != false");
     }
 
     Serial.print("Playing: ");
-    Serial.println(trackName);
+    Serial.print(track->path);
+    Serial.print(" (ms): ");
+    Serial.println(track->durationMs);
 
-    musicPlayer.startPlayingFile(trackName.c_str());
-}
+    unsigned long startMicros = micros();
 
-void findAndPlay()
-{
-    if (!keyBuffer.isFull()) {
-        return;
+    if (musicPlayer.startPlayingFile(track->path)) {
+        trackCatalog.verify(trackId, musicPlayer.currentTrack.size());
     }
 
-    int codeIdx = findInBuffer();
-
-    keyBuffer.clear();
+    Serial.print("Start latency (us): ");
+    Serial.println(micros() - startMicros);
+}
 
+void playCode(int codeIdx)
+{
     if (!musicPlayer.stopped()) {
         musicPlayer.stopPlaying();
     }
@@ -282,6 +278,38 @@ void findAndPlay()
     }
 }
 
+/**
+ * Dialed keys are matched as a stream: a number is recognised as soon as
+ * its last digit is dialed, even after stray digits.
+ */
+void findAndPlay()
+{
+    KeypadEvent event;
+
+    while (keypad.pop(event)) {
+        if (!event.isPressed) {
+            continue;
+        }
+
+        Serial.print("Key: ");
+        Serial.println(event.key);
+
+        int codeIdx = codeMatcher.push(event.key);
+        dialedKeys++;
+
+        displayKeyBuffer();
+
+        if (codeIdx != CODE_MATCHER_NONE) {
+            codeMatcher.clear();
+            dialedKeys = 0;
+            playCode(codeIdx);
+        } else if (dialedKeys >= CODE_SIZE) {
+            dialedKeys = 0;
+            playCode(-1);
+        }
+    }
+}
+
 bool isPhoneHungUp()
 {
     return digitalRead(PIN_HANGUP) == LOW;
@@ -299,7 +327,8 @@ void onHangUp()
     }
 
     Serial.println("Clearing buffer");
-    keyBuffer.clear();
+    codeMatcher.clear();
+    dialedKeys = 0;
 
     printDisplay(MSG_DEFAULT);
 }
@@ -341,15 +370,20 @@ void setup()
     initState();
     initAudio();
     initDisplay();
+    initKeypad();
     pinMode(PIN_HANGUP, INPUT_PULLUP);
     initBoardPixel();
 
-    Serial.println(">> Maletin-fono");
+    Serial.print(">> Maletin-fono ready (ms): ");
+    Serial.println(millis());
 }
 
 void loop()
 {
-    updateKeyBuffer();
     findAndPlay();
     updateHangState();
+
+    if (musicPlayer.stopped()) {
+        trackCatalog.removeIfStale();
+    }
 }
@@ -1,5 +1,5 @@
+#include "AudioFxScheduler.h"
 #include <Automaton.h>
-#include <CircularBuffer.h>
 #include <LCD.h>
 #include <LiquidCrystal_I2C.h>
 #include <Wire.h>
@@ -13,32 +13,62 @@ LiquidCrystal_I2C lcd(0x27, 2, 1, 0, 4, 5, 6, 7, 3, POSITIVE);
 Atm_timer lcdTimer;
 const int LCD_TIMER_MS = 500;
 
-const String STR_DEFAULT = String("Enter morse code");
-const String STR_SUCCESS = String("Access granted");
-const String STR_KEY = String("nevaria");
+const int LCD_COLS = 16;
+
+const char STR_DEFAULT[] = "Enter morse code";
+const char STR_SUCCESS[] = "Access granted";
+const char STR_KEY[] = "nevaria";
+const byte STR_KEY_LEN = sizeof(STR_KEY) - 1;
 
 /**
- * Morse buffer.
+ * Morse decoder.
  */
 
-typedef struct morseItem {
-    unsigned long time;
-    byte val;
-} MorseItem;
-
 const byte MORSE_DOT = 0;
 const byte MORSE_DASH = 1;
 
 const int MORSE_LETTER_TIMEOUT_MS = 1000;
-const int MORSE_BUF_SIZE = 100;
 
-CircularBuffer<MorseItem, MORSE_BUF_SIZE> morseBuf;
+/**
+ * Morse tree in heap order: the root is node 1 and the children of
+ * node N are 2N (dot) and 2N + 1 (dash). A zero marks a node without
+ * a symbol. Codes up to six symbols long fit in the table.
+ */
+
+const byte MORSE_TREE_SIZE = 128;
+const byte MORSE_NODE_ROOT = 1;
+const byte MORSE_NODE_INVALID = 0;
+
+const char MORSE_TREE[MORSE_TREE_SIZE] PROGMEM = {
+    0, 0,
+    'e', 't',
+    'i', 'a', 'n', 'm',
+    's', 'u', 'r', 'w', 'd', 'k', 'g', 'o',
+    'h', 'v', 'f', 0, 'l', 0, 'p', 'j', 'b', 'x', 'c', 'y', 'z', 'q', 0, 0,
+    '5', '4', 0, '3', 0, 0, 0, '2', '&', 0, '+', 0, 0, 0, 0, '1',
+    '6', '=', '/', 0, 0, 0, '(', 0, '7', 0, 0, 0, '8', 0, '9', '0',
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '?', '_', 0, 0,
+    0, 0, '"', 0, 0, '.', 0, 0, 0, 0, '@', 0, 0, 0, '\'', 0,
+    0, '-', 0, 0, 0, 0, 0, 0, 0, 0, ';', '!', 0, ')', 0, 0,
+    0, 0, 0, ',', 0, 0, 0, 0, ':', 0, 0, 0, 0, 0, 0, 0
+};
+
+const char UNKNOWN_CHAR = '*';
 
 /**
  * Program state.
  */
 
-String strMorseDecoded = String("");
+typedef struct morseDecoder {
+    byte node;
+    unsigned long lastSymbolMillis;
+    char decoded[LCD_COLS + 1];
+    byte decodedLen;
+    byte keyFailure[STR_KEY_LEN];
+    byte keyMatched;
+} MorseDecoder;
+
+MorseDecoder decoder;
 bool isComplete = false;
 bool isTouched = false;
 
@@ -51,75 +81,9 @@ const byte PIN_AUDIO_ACT = 5;
 const byte PIN_TRACK_SUCCESS_ONE = 6;
 const byte PIN_TRACK_SUCCESS_TWO = 7;
 
-/**
- * Morse dict. 
- */
-
-byte MORSE_A[] = { MORSE_DOT, MORSE_DASH };
-byte MORSE_B[] = { MORSE_DASH, MORSE_DOT, MORSE_DOT, MORSE_DOT };
-byte MORSE_C[] = { MORSE_DASH, MORSE_DOT, MORSE_DASH, MORSE_DOT };
-byte MORSE_D[] = { MORSE_DASH, MORSE_DOT, MORSE_DOT };
-byte MORSE_E[] = { MORSE_DOT };
-byte MORSE_F[] = { MORSE_DOT, MORSE_DOT, MORSE_DASH, MORSE_DOT };
-byte MORSE_G[] = { MORSE_DASH, MORSE_DASH, MORSE_DOT };
-byte MORSE_H[] = { MORSE_DOT, MORSE_DOT, MORSE_DOT, MORSE_DOT };
-byte MORSE_I[] = { MORSE_DOT, MORSE_DOT };
-byte MORSE_J[] = { MORSE_DOT, MORSE_DASH, MORSE_DASH, MORSE_DASH };
-byte MORSE_K[] = { MORSE_DASH, MORSE_DOT, MORSE_DASH };
-byte MORSE_L[] = { MORSE_DOT, MORSE_DASH, MORSE_DOT, MORSE_DOT };
-byte MORSE_M[] = { MORSE_DASH, MORSE_DASH };
-byte MORSE_N[] = { MORSE_DASH, MORSE_DOT };
-byte MORSE_O[] = { MORSE_DASH, MORSE_DASH, MORSE_DASH };
-byte MORSE_P[] = { MORSE_DOT, MORSE_DASH, MORSE_DASH, MORSE_DOT };
-byte MORSE_Q[] = { MORSE_DASH, MORSE_DASH, MORSE_DOT, MORSE_DASH };
-byte MORSE_R[] = { MORSE_DOT, MORSE_DASH, MORSE_DOT };
-byte MORSE_S[] = { MORSE_DOT, MORSE_DOT, MORSE_DOT };
-byte MORSE_T[] = { MORSE_DASH };
-byte MORSE_U[] = { MORSE_DOT, MORSE_DOT, MORSE_DASH };
-byte MORSE_V[] = { MORSE_DOT, MORSE_DOT, MORSE_DOT, MORSE_DASH };
-byte MORSE_W[] = { MORSE_DOT, MORSE_DASH, MORSE_DASH };
-byte MORSE_X[] = { MORSE_DASH, MORSE_DOT, MORSE_DOT, MORSE_DASH };
-byte MORSE_Y[] = { MORSE_DASH, MORSE_DOT, MORSE_DASH, MORSE_DASH };
-byte MORSE_Z[] = { MORSE_DASH, MORSE_DASH, MORSE_DOT, MORSE_DOT };
-
-typedef struct morseDictEntry {
-    char val;
-    byte* def;
-    size_t size;
-} MorseDictEntry;
-
-const int MORSE_DICT_NUM = 26;
-
-MorseDictEntry morseDict[MORSE_DICT_NUM] = {
-    { 'a', MORSE_A, sizeof(MORSE_A) },
-    { 'b', MORSE_B, sizeof(MORSE_B) },
-    { 'c', MORSE_C, sizeof(MORSE_C) },
-    { 'd', MORSE_D, sizeof(MORSE_D) },
-    { 'e', MORSE_E, sizeof(MORSE_E) },
-    { 'f', MORSE_F, sizeof(MORSE_F) },
-    { 'g', MORSE_G, sizeof(MORSE_G) },
-    { 'h', MORSE_H, sizeof(MORSE_H) },
-    { 'i', MORSE_I, sizeof(MORSE_I) },
-    { 'j', MORSE_J, sizeof(MORSE_J) },
-    { 'k', MORSE_K, sizeof(MORSE_K) },
-    { 'l', MORSE_L, sizeof(MORSE_L) },
-    { 'm', MORSE_M, sizeof(MORSE_M) },
-    { 'n', MORSE_N, sizeof(MORSE_N) },
-    { 'o', MORSE_O, sizeof(MORSE_O) },
-    { 'p', MORSE_P, sizeof(MORSE_P) },
-    { 'q', MORSE_Q, sizeof(MORSE_Q) },
-    { 'r', MORSE_R, sizeof(MORSE_R) },
-    { 's', MORSE_S, sizeof(MORSE_S) },
-    { 't', MORSE_T, sizeof(MORSE_T) },
-    { 'u', MORSE_U, sizeof(MORSE_U) },
-    { 'v', MORSE_V, sizeof(MORSE_V) },
-    { 'w', MORSE_W, sizeof(MORSE_W) },
-    { 'x', MORSE_X, sizeof(MORSE_X) },
-    { 'y', MORSE_Y, sizeof(MORSE_Y) },
-    { 'z', MORSE_Z, sizeof(MORSE_Z) }
-};
+const unsigned long AUDIO_TRIGGER_MS = 300;
 
-const char UNKNOWN_CHAR = '?';
+AudioFxScheduler audio(PIN_AUDIO_ACT, AUDIO_TRIGGER_MS);
 
 /**
  * Morse buttons.
@@ -140,33 +104,13 @@ Atm_button btnDash;
  * Audio FX functions.
  */
 
-bool isTrackPlaying()
-{
-    return digitalRead(PIN_AUDIO_ACT) == LOW;
-}
-
-void playTrack(byte trackPin)
-{
-    if (isTrackPlaying()) {
-        Serial.println(F("Skipping: Audio playing"));
-        return;
-    }
-
-    Serial.print(F("Playing track on pin: "));
-    Serial.println(trackPin);
-
-    digitalWrite(trackPin, LOW);
-    pinMode(trackPin, OUTPUT);
-    delay(300);
-    pinMode(trackPin, INPUT);
-}
-
 void initAudioPins()
 {
     pinMode(PIN_TRACK_SUCCESS_ONE, INPUT);
     pinMode(PIN_TRACK_SUCCESS_TWO, INPUT);
-    pinMode(PIN_AUDIO_ACT, INPUT);
     pinMode(PIN_AUDIO_RST, INPUT);
+
+    audio.begin();
 }
 
 void resetAudio()
@@ -184,148 +128,189 @@ void resetAudio()
 }
 
 /**
- * LCD state loop function.
+ * Morse decoder functions.
  */
 
-void updateLcd()
+void initKeyMatcher()
 {
-    const int lcdCols = 16;
+    byte k = 0;
 
-    String theStr;
+    decoder.keyFailure[0] = 0;
 
-    if (strMorseDecoded.length() == 0 && !isTouched) {
-        theStr = STR_DEFAULT;
-    } else if (isComplete) {
-        theStr = STR_SUCCESS;
-    } else {
-        theStr = strMorseDecoded;
+    for (byte i = 1; i < STR_KEY_LEN; i++) {
+        while (k > 0 && STR_KEY[i] != STR_KEY[k]) {
+            k = decoder.keyFailure[k - 1];
+        }
+
+        if (STR_KEY[i] == STR_KEY[k]) {
+            k++;
+        }
+
+        decoder.keyFailure[i] = k;
     }
+}
 
-    int from = theStr.length() - lcdCols;
-    from = from < 0 ? 0 : from;
+void resetMorseDecoder()
+{
+    decoder.node = MORSE_NODE_ROOT;
+    decoder.lastSymbolMillis = 0;
+    decoder.decoded[0] = '\0';
+    decoder.decodedLen = 0;
+    decoder.keyMatched = 0;
+}
 
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print(theStr.substring(from));
+bool isLetterPending()
+{
+    return decoder.node != MORSE_NODE_ROOT;
 }
 
-/**
- * Morse logic functions.
- */
+char getNodeLetter(byte node)
+{
+    if (node == MORSE_NODE_INVALID || node >= MORSE_TREE_SIZE) {
+        return UNKNOWN_CHAR;
+    }
+
+    char letter = pgm_read_byte(&MORSE_TREE[node]);
+
+    return letter == 0 ? UNKNOWN_CHAR : letter;
+}
 
 /**
- * Arg and return value are inclusive.
+ * Advances the key matcher by one letter.
+ * Returns true when the whole key has just been matched.
  */
-int findLetterEnd(int idxStart)
+bool matchKeyLetter(char letter)
 {
-    if (idxStart > (morseBuf.size() - 1)) {
-        return -1;
+    while (decoder.keyMatched > 0 && letter != STR_KEY[decoder.keyMatched]) {
+        decoder.keyMatched = decoder.keyFailure[decoder.keyMatched - 1];
     }
 
-    int idxPivot = idxStart;
-    unsigned long diff;
-
-    for (int i = (idxStart + 1); i < morseBuf.size(); i++) {
-        diff = morseBuf[i].time - morseBuf[i - 1].time;
+    if (letter == STR_KEY[decoder.keyMatched]) {
+        decoder.keyMatched++;
+    }
 
-        if (diff >= MORSE_LETTER_TIMEOUT_MS) {
-            break;
-        } else {
-            idxPivot = i;
-        }
+    if (decoder.keyMatched == STR_KEY_LEN) {
+        decoder.keyMatched = decoder.keyFailure[STR_KEY_LEN - 1];
+        return true;
     }
 
-    return idxPivot;
+    return false;
 }
 
-int findMorseEntryIndex(int idxStart, int idxEnd)
+void appendDecodedLetter(char letter)
 {
-    if (idxStart < 0 || idxEnd >= morseBuf.size() || idxStart > idxEnd) {
-        return -1;
+    if (decoder.decodedLen == LCD_COLS) {
+        memmove(decoder.decoded, decoder.decoded + 1, LCD_COLS - 1);
+        decoder.decodedLen--;
     }
 
-    unsigned int idxDelta = idxEnd - idxStart + 1;
-    bool isValid;
+    decoder.decoded[decoder.decodedLen] = letter;
+    decoder.decodedLen++;
+    decoder.decoded[decoder.decodedLen] = '\0';
+}
+
+/**
+ * Emits the pending letter. Returns true if it completed the key.
+ */
+bool emitPendingLetter()
+{
+    if (!isLetterPending()) {
+        return false;
+    }
 
-    for (int i = 0; i < MORSE_DICT_NUM; i++) {
-        isValid = true;
+    char letter = getNodeLetter(decoder.node);
+    decoder.node = MORSE_NODE_ROOT;
 
-        if (morseDict[i].size != idxDelta) {
-            continue;
-        }
+    Serial.print(millis());
+    Serial.print(F(":Letter:"));
+    Serial.println(letter);
 
-        for (unsigned int j = 0; j < idxDelta; j++) {
-            if (morseDict[i].def[j] != morseBuf[idxStart + j].val) {
-                isValid = false;
-                break;
-            }
-        }
+    appendDecodedLetter(letter);
 
-        if (isValid) {
-            return i;
-        }
-    }
+    return matchKeyLetter(letter);
+}
 
-    return -1;
+bool isLetterGapClosed(unsigned long now)
+{
+    return isLetterPending()
+        && now - decoder.lastSymbolMillis >= MORSE_LETTER_TIMEOUT_MS;
 }
 
-void decodeMorseString()
+/**
+ * Feeds one symbol. Returns true if closing the previous letter
+ * completed the key.
+ */
+bool pushMorseSymbol(byte symbol, unsigned long now)
 {
-    strMorseDecoded = String("");
+    bool isKeyMatch = false;
 
-    if (morseBuf.isEmpty()) {
-        return;
+    if (isLetterGapClosed(now)) {
+        isKeyMatch = emitPendingLetter();
     }
 
-    int idxStart = 0;
-    int idxEnd;
-    int entryIdx;
-    char letter;
-
-    do {
-        idxEnd = findLetterEnd(idxStart);
-        entryIdx = findMorseEntryIndex(idxStart, idxEnd);
-        letter = entryIdx >= 0 ? morseDict[entryIdx].val : UNKNOWN_CHAR;
-        strMorseDecoded.concat(letter);
-        idxStart = idxEnd + 1;
-    } while (idxStart < morseBuf.size());
-}
+    decoder.lastSymbolMillis = now;
 
-bool isDecodedStringValid()
-{
-    return strMorseDecoded.indexOf(STR_KEY) > -1;
+    if (decoder.node == MORSE_NODE_INVALID) {
+        return isKeyMatch;
+    }
+
+    uint16_t next = 2 * decoder.node + symbol;
+    decoder.node = next < MORSE_TREE_SIZE ? next : MORSE_NODE_INVALID;
+
+    return isKeyMatch;
 }
 
-void onMorseCompleted()
+/**
+ * LCD state loop function.
+ */
+
+void updateLcd()
 {
-    const unsigned long msShort = 500;
-    const unsigned long msLong = 5000;
-    const unsigned long msTimeout = 10000;
+    char theStr[LCD_COLS + 1];
 
-    Serial.println(F("Completed"));
+    if (decoder.decodedLen == 0 && !isTouched) {
+        strncpy(theStr, STR_DEFAULT, LCD_COLS);
+        theStr[LCD_COLS] = '\0';
+    } else if (isComplete) {
+        strncpy(theStr, STR_SUCCESS, LCD_COLS);
+        theStr[LCD_COLS] = '\0';
+    } else {
+        const char* from = decoder.decoded;
+        byte len = decoder.decodedLen;
 
-    isComplete = true;
-    updateLcd();
-    delay(msShort);
-    playTrack(PIN_TRACK_SUCCESS_ONE);
+        if (isLetterPending() && len == LCD_COLS) {
+            from++;
+            len--;
+        }
 
-    Serial.println(F("Wait for track #1"));
+        memcpy(theStr, from, len);
 
-    unsigned long ini = millis();
+        if (isLetterPending()) {
+            theStr[len++] = getNodeLetter(decoder.node);
+        }
 
-    while (isTrackPlaying() && (millis() - ini) < msTimeout) {
-        continue;
+        theStr[len] = '\0';
     }
 
-    Serial.print(F("Waiting "));
-    Serial.print(msLong);
-    Serial.println(F(" secs"));
+    lcd.clear();
+    lcd.setCursor(0, 0);
+    lcd.print(theStr);
+}
+
+void onMorseCompleted()
+{
+    const uint16_t msShort = 500;
+    const uint16_t msLong = 5000;
 
-    delay(msLong);
+    Serial.println(F("Completed"));
 
-    Serial.println(F("Playing track #2"));
+    isComplete = true;
+    updateLcd();
 
-    playTrack(PIN_TRACK_SUCCESS_TWO);
+    // Track #2 waits in the queue until track #1 has ended
+    // and the board has then been idle for msLong.
+    audio.play(PIN_TRACK_SUCCESS_ONE, AUDIO_FX_QUEUE, 0, msShort);
+    audio.play(PIN_TRACK_SUCCESS_TWO, AUDIO_FX_QUEUE, 0, msLong);
 }
 
 /**
@@ -334,16 +319,20 @@ void onMorseCompleted()
 
 void onLcdTimer(int idx, int v, int up)
 {
-    decodeMorseString();
+    bool isKeyMatch = false;
 
-    Serial.print(millis());
-    Serial.print(F(":'"));
-    Serial.print(strMorseDecoded);
-    Serial.println(F("'"));
+    if (isLetterGapClosed(millis())) {
+        isKeyMatch = emitPendingLetter();
+
+        Serial.print(millis());
+        Serial.print(F(":'"));
+        Serial.print(decoder.decoded);
+        Serial.println(F("'"));
+    }
 
     updateLcd();
 
-    if (isComplete == false && isDecodedStringValid()) {
+    if (isComplete == false && isKeyMatch) {
         onMorseCompleted();
     }
 }
@@ -380,12 +369,15 @@ void onPressMorseButton(int idx, int v, int up)
 
     if (v > 1) {
         Serial.println(F("Clearing morse buffer"));
-        morseBuf.clear();
+        resetMorseDecoder();
         return;
     }
 
     unsigned long now = millis();
-    morseBuf.push(MorseItem { now, static_cast<byte>(idx) });
+
+    if (pushMorseSymbol(idx, now) && isComplete == false) {
+        onMorseCompleted();
+    }
 
     tone(BUZZ_PIN, BUZZ_FREQ);
 
@@ -428,6 +420,8 @@ void setup()
 {
     Serial.begin(9600);
 
+    initKeyMatcher();
+    resetMorseDecoder();
     initMorseButtons();
     initAudioPins();
     resetAudio();
@@ -438,5 +432,6 @@ void setup()
 
 void loop()
 {
+    audio.update();
     automaton.run();
 }
\ No newline at end of file
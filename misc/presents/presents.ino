@@ -1,4 +1,6 @@
-#include "rdm630.h"
+#include <SoftwareSerial.h>
+#include "RfidFrameParser.h"
+#include "TagPresenceTracker.h"
 
 /**
    Relay
@@ -13,17 +15,29 @@ const byte PIN_RELAY = 4;
 const byte NUM_READERS = 1;
 
 // RX, TX
-RDM6300 rfid01(2, 3);
+SoftwareSerial rfidSerial01(2, 3);
 
-RDM6300 rfidReaders[NUM_READERS] = {
-    rfid01};
+SoftwareSerial *rfidSerials[NUM_READERS] = {
+    &rfidSerial01};
 
-const unsigned int EMPTY_TOLERANCE = 1;
+RfidFrameParser rfidParsers[NUM_READERS];
 
-String currentTags[NUM_READERS];
+// First 10 hex chars of each tag ID
+const uint8_t VALID_TAGS[NUM_READERS][RFID_TAG_ID_SIZE] PROGMEM = {
+    {0x10, 0x00, 0x79, 0x99, 0xF0}};
 
-String validTags[NUM_READERS] = {
-    "10007999F000"};
+// Readers resend the frame while the tag stays in the field
+const unsigned long TAG_ARRIVE_MS = 100;
+const unsigned long TAG_LEAVE_MS = 500;
+
+bool isValidTag(uint8_t reader, const RfidTagId &tag);
+
+TagPresenceTracker tagTracker(
+    NUM_READERS,
+    TAG_ARRIVE_MS,
+    TAG_LEAVE_MS,
+    isValidTag,
+    NULL);
 
 /**
   Structs.
@@ -32,12 +46,10 @@ String validTags[NUM_READERS] = {
 typedef struct programState
 {
     bool relayOpened;
-    unsigned int emptyReadCount[NUM_READERS];
 } ProgramState;
 
 ProgramState progState = {
-    .relayOpened = false,
-    .emptyReadCount = {0}};
+    .relayOpened = false};
 
 /**
    RFID modules functions
@@ -47,74 +59,34 @@ void initRfidReaders()
 {
     for (int i = 0; i < NUM_READERS; i++)
     {
-        rfidReaders[i].begin();
+        rfidSerials[i]->begin(9600);
     }
+
+    rfidSerials[0]->listen();
+    tagTracker.setLog(Serial);
 }
 
 void pollRfidReaders()
 {
-    String tagId;
+    unsigned long now = millis();
 
     for (int i = 0; i < NUM_READERS; i++)
     {
-        tagId = rfidReaders[i].getTagId();
-
-        if (tagId.length())
-        {
-            progState.emptyReadCount[i] = 0;
-        }
-        else if (progState.emptyReadCount[i] <= EMPTY_TOLERANCE)
-        {
-            progState.emptyReadCount[i] += 1;
-        }
-
-        if (!tagId.length() &&
-            currentTags[i].length() &&
-            progState.emptyReadCount[i] <= EMPTY_TOLERANCE)
+        if (rfidParsers[i].poll(*rfidSerials[i]))
         {
-            Serial.print("Ignoring empty read on reader: ");
-            Serial.println(i);
-            return;
+            tagTracker.seen(i, rfidParsers[i].tag(), now);
         }
-
-        currentTags[i] = tagId;
     }
-}
-
-bool isTagDefined(int idx)
-{
-    return currentTags[idx].length() > 0;
-}
 
-bool areCurrentTagsValid()
-{
-    for (int i = 0; i < NUM_READERS; i++)
+    if (tagTracker.update(now))
     {
-        if (!isTagDefined(i))
-        {
-            return false;
-        }
-
-        if (validTags[i].compareTo(currentTags[i]) != 0)
-        {
-            return false;
-        }
+        checkStatusToUpdateRelay();
     }
-
-    return true;
 }
 
-void printCurrentTags()
+bool isValidTag(uint8_t reader, const RfidTagId &tag)
 {
-    Serial.print("## Current tags :: ");
-    Serial.println(millis());
-
-    for (int i = 0; i < NUM_READERS; i++)
-    {
-        Serial.print(i);
-        Serial.print(" :: ");
-        Serial.println(currentTags[i]);
-    }
+    return rfidIsTag(tag, VALID_TAGS[reader]);
 }
 
 /**
@@ -141,12 +113,14 @@ void initRelay()
 
 void checkStatusToUpdateRelay()
 {
-    if (areCurrentTagsValid() == true && progState.relayOpened == false)
+    bool isValid = tagTracker.areAllValid();
+
+    if (isValid && progState.relayOpened == false)
     {
         Serial.println("Opening relay");
         openRelay();
     }
-    else if (areCurrentTagsValid() == false && progState.relayOpened == true)
+    else if (!isValid && progState.relayOpened == true)
     {
         Serial.println("Locking relay");
         lockRelay();
@@ -170,6 +144,4 @@ void setup()
 void loop()
 {
     pollRfidReaders();
-    printCurrentTags();
-    checkStatusToUpdateRelay();
 }
@@ -0,0 +1,261 @@
+#ifndef RFID_READER_SCHEDULER_H
+#define RFID_READER_SCHEDULER_H
+
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+
+/**
+ * Time-multiplexes listen() across several SoftwareSerial RFID readers.
+ *
+ * Only one SoftwareSerial can receive at a time. update() keeps the active
+ * reader for the dwell time and then moves on in round-robin order.
+ * Readers with priority are visited first. A reader has priority when its
+ * tag-in-range line is asserted and no tag has been read since, or when it
+ * is marked as preferred. After each priority slot one slot goes to the
+ * next non-priority reader, so the others are never starved.
+ *
+ * Readers such as the ID-12 send a single frame per presentation, and
+ * listen() drops whatever the previous reader had buffered. So when a tag
+ * enters range the scheduler switches to that reader at once and holds it
+ * for up to holdMs, or until its frame is read. A reader that is already
+ * holding is not interrupted: the new one waits for its turn.
+ *
+ * Each reader keeps counters:
+ *  - reads;
+ *  - misses (a tag that entered and left the field without a read);
+ *  - latency from the tag entering range (or from the listen start) until
+ *    its first read.
+ */
+
+const uint8_t RFID_SCHEDULER_MAX_READERS = 4;
+const uint8_t RFID_SCHEDULER_NONE = 0xFF;
+
+typedef struct rfidReaderSlot
+{
+    bool isInRange;
+    bool isPending;
+    bool isPreferred;
+    unsigned long inRangeSince;
+    uint16_t reads;
+    uint16_t misses;
+    uint16_t lastLatencyMs;
+    uint16_t maxLatencyMs;
+} RfidReaderSlot;
+
+class RfidReaderScheduler
+{
+public:
+    RfidReaderScheduler(
+        SoftwareSerial *const *serials,
+        uint8_t num,
+        unsigned long dwellMs,
+        unsigned long holdMs = 0)
+        : serials(serials),
+          num(num > RFID_SCHEDULER_MAX_READERS ? RFID_SCHEDULER_MAX_READERS : num),
+          dwellMs(dwellMs),
+          holdMs(holdMs),
+          activeIdx(0),
+          listenSince(0)
+    {
+        memset(slots, 0, sizeof(slots));
+    }
+
+    void begin()
+    {
+        listenTo(0);
+    }
+
+    uint8_t active() const
+    {
+        return activeIdx;
+    }
+
+    /**
+     * Called from the tag-in-range line handler of a reader.
+     */
+    void setTagInRange(uint8_t idx, bool isInRange)
+    {
+        if (idx >= num)
+        {
+            return;
+        }
+
+        RfidReaderSlot &slot = slots[idx];
+
+        if (isInRange && !slot.isInRange)
+        {
+            slot.inRangeSince = millis();
+            slot.isPending = true;
+
+            if (idx != activeIdx && !isHolding())
+            {
+                listenTo(idx);
+            }
+        }
+        else if (!isInRange && slot.isPending)
+        {
+            slot.misses++;
+            slot.isPending = false;
+        }
+
+        slot.isInRange = isInRange;
+    }
+
+    void setPreferred(uint8_t idx, bool isPreferred)
+    {
+        if (idx < num)
+        {
+            slots[idx].isPreferred = isPreferred;
+        }
+    }
+
+    /**
+     * Registers a tag read on the given reader.
+     * A reader that just delivered its tag gives up the rest of its slot.
+     */
+    void onRead(uint8_t idx)
+    {
+        if (idx >= num)
+        {
+            return;
+        }
+
+        RfidReaderSlot &slot = slots[idx];
+        unsigned long now = millis();
+        unsigned long since = slot.isPending ? slot.inRangeSince : listenSince;
+        unsigned long latency = now - since;
+
+        slot.lastLatencyMs = latency > 0xFFFF ? 0xFFFF : latency;
+        slot.maxLatencyMs = slot.lastLatencyMs > slot.maxLatencyMs ? slot.lastLatencyMs : slot.maxLatencyMs;
+        slot.reads++;
+        slot.isPending = false;
+
+        if (idx == activeIdx)
+        {
+            listenSince = now - dwellMs;
+        }
+    }
+
+    /**
+     * True when a tag entered range on the given reader more than holdMs ago
+     * and no frame has been read from it yet.
+     */
+    bool isReadOverdue(uint8_t idx) const
+    {
+        return idx < num &&
+               slots[idx].isPending &&
+               millis() - slots[idx].inRangeSince >= holdMs;
+    }
+
+    /**
+     * Rotates the listening reader once the dwell time has passed.
+     * Returns the reader that is listening now.
+     */
+    uint8_t update()
+    {
+        unsigned long now = millis();
+
+        if (isHolding() || now - listenSince < dwellMs)
+        {
+            return activeIdx;
+        }
+
+        uint8_t next = pickNext();
+
+        if (next != activeIdx)
+        {
+            listenTo(next);
+        }
+        else
+        {
+            listenSince = now;
+        }
+
+        return activeIdx;
+    }
+
+    const RfidReaderSlot &stats(uint8_t idx) const
+    {
+        return slots[idx];
+    }
+
+    void printStats(Print &out)
+    {
+        for (uint8_t i = 0; i < num; i++)
+        {
+            out.print(F("RFID #"));
+            out.print(i);
+            out.print(F(" reads="));
+            out.print(slots[i].reads);
+            out.print(F(" misses="));
+            out.print(slots[i].misses);
+            out.print(F(" latency="));
+            out.print(slots[i].lastLatencyMs);
+            out.print(F(" max="));
+            out.println(slots[i].maxLatencyMs);
+        }
+    }
+
+private:
+    SoftwareSerial *const *serials;
+    uint8_t num;
+    unsigned long dwellMs;
+    unsigned long holdMs;
+    uint8_t activeIdx;
+    unsigned long listenSince;
+    RfidReaderSlot slots[RFID_SCHEDULER_MAX_READERS];
+
+    bool isHolding() const
+    {
+        const RfidReaderSlot &slot = slots[activeIdx];
+
+        return slot.isPending && millis() - slot.inRangeSince < holdMs;
+    }
+
+    bool hasPriority(uint8_t idx) const
+    {
+        return slots[idx].isPending || slots[idx].isPreferred;
+    }
+
+    uint8_t findNext(bool isPriority) const
+    {
+        for (uint8_t k = 1; k <= num; k++)
+        {
+            uint8_t idx = (activeIdx + k) % num;
+
+            if (hasPriority(idx) == isPriority)
+            {
+                return idx;
+            }
+        }
+
+        return RFID_SCHEDULER_NONE;
+    }
+
+    uint8_t pickNext() const
+    {
+        uint8_t nextPriority = findNext(true);
+        uint8_t nextOther = findNext(false);
+
+        if (nextPriority == RFID_SCHEDULER_NONE)
+        {
+            return nextOther;
+        }
+
+        if (nextOther == RFID_SCHEDULER_NONE || !hasPriority(activeIdx))
+        {
+            return nextPriority;
+        }
+
+        return nextOther;
+    }
+
+    void listenTo(uint8_t idx)
+    {
+        activeIdx = idx;
+        listenSince = millis();
+        serials[idx]->listen();
+    }
+};
+
+#endif
@@ -1,6 +1,8 @@
 #include <Adafruit_NeoPixel.h>
 #include <SoftwareSerial.h>
 #include "limits.h"
+#include "RfidFrameParser.h"
+#include "RfidReaderScheduler.h"
 
 // RX and TX pins for secondary RFID sensors
 const byte SECONDARY_RFID_01_RX = 13;
@@ -14,13 +16,6 @@ const byte SECONDARY_RFID_03_TX = 5;
 const uint16_t NEOPIXEL_NUM = 4;
 const uint8_t NEOPIXEL_PIN = 3;
 
-// For SparkFun's tags, we will receive 16 bytes on every
-// tag read, but throw 4 away. The 13th space will always
-// be 0, since proper strings in Arduino end with 0
-const int TAG_LEN = 16;
-const int ID_LEN = 13;
-const int ID_PRINTABLE_LEN = 12;
-
 // Total number of RFID readers
 const int NUM_READERS = 4;
 
@@ -36,53 +31,47 @@ const byte LOCK_RELAY_PIN = 10;
 // after all tags have been correctly placed in their RFID sensors
 const unsigned long LOCK_OPEN_DELAY_MS = 40000;
 
-// Non-printable tag buffer characters
-const int TAG_CHAR_STX = 2;
-const int TAG_CHAR_CR = 13;
-const int TAG_CHAR_LF = 10;
-const int TAG_CHAR_ETX = 3;
-
 // SoftwareSerial instances (RX, TX) connected to RFID sensors
 SoftwareSerial rSerial01(SECONDARY_RFID_01_RX, SECONDARY_RFID_01_TX);
 SoftwareSerial rSerial02(SECONDARY_RFID_02_RX, SECONDARY_RFID_02_TX);
 SoftwareSerial rSerial03(SECONDARY_RFID_03_RX, SECONDARY_RFID_03_TX);
 
+// Milliseconds that each secondary RFID sensor listens before rotating
+const unsigned long SECONDARY_RFID_DWELL_MS = 250;
+
+SoftwareSerial* const secondarySerials[NUM_READERS - 1] = {
+  &rSerial01,
+  &rSerial02,
+  &rSerial03
+};
+
+RfidReaderScheduler secondaryScheduler(
+  secondarySerials,
+  NUM_READERS - 1,
+  SECONDARY_RFID_DWELL_MS);
+
 // Initialize the NeoPixel instance
 Adafruit_NeoPixel pixelStrip = Adafruit_NeoPixel(NEOPIXEL_NUM, NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
 
 // Some NeoPixel colors
 uint32_t colorActive = pixelStrip.Color(255, 255, 255);
 
-// List of accepted tags for each RFID sensor
-char acceptedTags[NUM_READERS][ID_LEN] = {
-  "011005CD9B42",
-  "011005CD9C45",
-  "011005CE79A3",
-  "011005CDA079"
+// Accepted tag (first 10 hex chars of the tag ID) for each RFID sensor
+const uint8_t ACCEPTED_TAGS[NUM_READERS][RFID_TAG_ID_SIZE] PROGMEM = {
+  {0x01, 0x10, 0x05, 0xCD, 0x9B},
+  {0x01, 0x10, 0x05, 0xCD, 0x9C},
+  {0x01, 0x10, 0x05, 0xCE, 0x79},
+  {0x01, 0x10, 0x05, 0xCD, 0xA0}
 };
 
+// Frame parser for each RFID sensor
+RfidFrameParser rfidParsers[NUM_READERS];
+
 // Most recent tags and timestamps for each RFID sensor
-char currentTags[NUM_READERS][ID_LEN];
+RfidTagId currentTags[NUM_READERS];
+bool currentTagsDefined[NUM_READERS];
 unsigned long currentTagsMillis[NUM_READERS];
 
-/**
-   Returns true if the given byte is a printable tag character.
-   Ignored characters include the first one (2, STX, start of text) and the last three:
-   ASCII 13, CR/carriage return.
-   ASCII 10, LF/linefeed.
-   ASCII 3, ETX/end of text.
-*/
-boolean isPrintableTagChar(int readByte) {
-  if (readByte != TAG_CHAR_STX &&
-      readByte != TAG_CHAR_CR &&
-      readByte != TAG_CHAR_LF &&
-      readByte != TAG_CHAR_ETX) {
-    return true;
-  } else {
-    return false;
-  }
-}
-
 /**
    Clears the main HW serial input buffer.
 */
@@ -106,7 +95,8 @@ void clearSoftwareSerialInputBuffer(SoftwareSerial &theSerialPort) {
 */
 void clearCurrentTagsAndBuffers() {
   for (int i = 0; i < NUM_READERS; i++) {
-    memset(currentTags[i], 0, sizeof(currentTags[i]));
+    currentTagsDefined[i] = false;
+    rfidParsers[i].reset();
   }
 
   clearHardwareSerialInputBuffer();
@@ -116,93 +106,43 @@ void clearCurrentTagsAndBuffers() {
 }
 
 /**
-   Takes a buffer of bytes and tries to retrieve the most recent tag.
+   Stores a freshly read tag for the given RFID sensor.
 */
-void findTagInBuffer(char buf[], int bufSize, char newTag[]) {
-  memset(newTag, 0, ID_LEN);
-
-  if (bufSize < TAG_LEN) {
-    return;
-  }
-
-  const int stxIdx = bufSize - TAG_LEN;
-
-  if (buf[stxIdx] != TAG_CHAR_STX) {
-    return;
-  }
-
-  int counter = 0;
-
-  for (int i = stxIdx; i < bufSize; i++) {
-    if (isPrintableTagChar(buf[i])) {
-      // Check if we are reading more bytes than expected
-      if (counter >= (ID_LEN - 1)) {
-        memset(newTag, 0, ID_LEN);
-        return;
-      }
-
-      newTag[counter] = buf[i];
-      counter++;
-    }
-  }
-
-  // Check if the output array does not have the string length
-  if (strlen(newTag) != ID_PRINTABLE_LEN) {
-    memset(newTag, 0, ID_LEN);
-  }
+void setCurrentTag(int portIndex, const RfidTagId &newTag) {
+  currentTags[portIndex] = newTag;
+  currentTagsDefined[portIndex] = true;
+  currentTagsMillis[portIndex] = millis();
 }
 
 /**
    Reads the main RFID reader on the HW serial port.
 */
 void readMainTag() {
-  if (Serial.available() > 0 && Serial.peek() != TAG_CHAR_STX) {
-    Serial.println("Unexpected start byte in HW serial: clearing input buffer");
-    Serial.flush();
-
-    clearHardwareSerialInputBuffer();
-  }
-
-  if (Serial.available() < TAG_LEN) {
+  if (!rfidParsers[0].poll(Serial)) {
     return;
   }
 
-  char newTag[ID_LEN];
-
-  int bufSize = Serial.available();
-  char buf[bufSize];
-
-  for (int i = 0; i < bufSize; i++) {
-    buf[i] = Serial.read();
-  }
-
-  findTagInBuffer(buf, bufSize, newTag);
+  const RfidTagId &newTag = rfidParsers[0].tag();
 
-  if (strlen(newTag) == ID_PRINTABLE_LEN) {
-    Serial.print("Read main tag: ");
-    Serial.print(newTag);
-    Serial.println();
-    Serial.flush();
-
-    for (int k = 0; k < ID_LEN - 1; k++) {
-      currentTags[0][k] = newTag[k];
-    }
+  Serial.print("Read main tag: ");
+  rfidPrintTag(Serial, newTag);
+  Serial.println();
+  Serial.flush();
 
-    currentTagsMillis[0] = millis();
+  setCurrentTag(0, newTag);
 
-    memset(currentTags[1], 0, sizeof(currentTags[1]));
-    memset(currentTags[2], 0, sizeof(currentTags[2]));
-    memset(currentTags[3], 0, sizeof(currentTags[3]));
+  currentTagsDefined[1] = false;
+  currentTagsDefined[2] = false;
+  currentTagsDefined[3] = false;
 
-    clearSoftwareSerialInputBuffer(rSerial01);
-    clearSoftwareSerialInputBuffer(rSerial02);
-    clearSoftwareSerialInputBuffer(rSerial03);
+  clearSoftwareSerialInputBuffer(rSerial01);
+  clearSoftwareSerialInputBuffer(rSerial02);
+  clearSoftwareSerialInputBuffer(rSerial03);
 
-    turnOffPixels();
+  turnOffPixels();
 
-    if (isTagEqual(newTag, acceptedTags[0]) == true) {
-      turnOnPixel(0);
-    }
+  if (isTagAccepted(0)) {
+    turnOnPixel(0);
   }
 }
 
@@ -210,49 +150,24 @@ void readMainTag() {
    Reads a secondary RFID reader on a SW serial port.
 */
 void readSecondaryTag(SoftwareSerial &theSerialPort, int portIndex) {
-  if (theSerialPort.available() > 0 && theSerialPort.peek() != TAG_CHAR_STX) {
-    Serial.print("Unexpected start byte in SW serial #");
-    Serial.print(portIndex);
-    Serial.print(": clearing input buffer");
-    Serial.println();
-    Serial.flush();
-
-    clearSoftwareSerialInputBuffer(theSerialPort);
-  }
-
-  if (theSerialPort.available() < TAG_LEN) {
+  if (!rfidParsers[portIndex].poll(theSerialPort)) {
     return;
   }
 
-  char newTag[ID_LEN];
-
-  int bufSize = theSerialPort.available();
-  char buf[bufSize];
-
-  for (int i = 0; i < bufSize; i++) {
-    buf[i] = theSerialPort.read();
-  }
-
-  findTagInBuffer(buf, bufSize, newTag);
+  const RfidTagId &newTag = rfidParsers[portIndex].tag();
 
-  if (strlen(newTag) == ID_PRINTABLE_LEN) {
-    Serial.print("Read tag: ");
-    Serial.print(newTag);
-    Serial.print(" in port #");
-    Serial.print(portIndex);
-    Serial.println();
-    Serial.flush();
-
-    for (int k = 0; k < ID_LEN - 1; k++) {
-      currentTags[portIndex][k] = newTag[k];
-    }
+  Serial.print("Read tag: ");
+  rfidPrintTag(Serial, newTag);
+  Serial.print(" in port #");
+  Serial.print(portIndex);
+  Serial.println();
+  Serial.flush();
 
-    currentTagsMillis[portIndex] = millis();
+  setCurrentTag(portIndex, newTag);
+  secondaryScheduler.onRead(portIndex - 1);
 
-    if (isTagDefined(0) &&
-        isTagEqual(newTag, acceptedTags[portIndex]) == true) {
-      turnOnPixel(portIndex);
-    }
+  if (isTagDefined(0) && isTagAccepted(portIndex)) {
+    turnOnPixel(portIndex);
   }
 }
 
@@ -260,32 +175,29 @@ void readSecondaryTag(SoftwareSerial &theSerialPort, int portIndex) {
    Returns true if the tag with the given index is defined.
 */
 bool isTagDefined(int portIdx) {
-  return strlen(currentTags[portIdx]) == ID_PRINTABLE_LEN;
+  return currentTagsDefined[portIdx];
 }
 
 /**
-   Checks the current status and updates the SW serial port that is listening.
+   Gives priority to the SW serial port that is expected to read the next tag.
+   The scheduler still rotates through the other ports.
 */
 void updateListenerPort() {
+  int expectedPort;
+
   if (isTagDefined(0) && isTagDefined(1) && isTagDefined(2)) {
-    if (rSerial03.isListening() == false) {
-      Serial.println("Listening on port #3");
-      Serial.flush();
-      rSerial03.listen();
-    }
+    expectedPort = 3;
   } else if (isTagDefined(0) && isTagDefined(1)) {
-    if (rSerial02.isListening() == false) {
-      Serial.println("Listening on port #2");
-      Serial.flush();
-      rSerial02.listen();
-    }
+    expectedPort = 2;
   } else {
-    if (rSerial01.isListening() == false) {
-      Serial.println("Listening on port #1");
-      Serial.flush();
-      rSerial01.listen();
-    }
+    expectedPort = 1;
   }
+
+  for (int i = 1; i < NUM_READERS; i++) {
+    secondaryScheduler.setPreferred(i - 1, i == expectedPort);
+  }
+
+  secondaryScheduler.update();
 }
 
 /**
@@ -382,22 +294,11 @@ void pulsatePixels(unsigned long durationMs) {
 }
 
 /**
-   This function steps through both newTag and one of the known tags.
-   If there is a mismatch anywhere in the tag, it will return 0,
-   but if every character in the tag is the same, it returns 1.
+   Returns true if the current tag of the given sensor is its accepted tag.
 */
-bool isTagEqual(char nTag[], char oTag[]) {
-  if (strlen(nTag) != ID_PRINTABLE_LEN || strlen(oTag) != ID_PRINTABLE_LEN) {
-    return false;
-  }
-
-  for (int i = 0; i < ID_LEN; i++) {
-    if (nTag[i] != oTag[i]) {
-      return false;
-    }
-  }
-
-  return true;
+bool isTagAccepted(int portIdx) {
+  return currentTagsDefined[portIdx] &&
+         rfidIsTag(currentTags[portIdx], ACCEPTED_TAGS[portIdx]);
 }
 
 /**
@@ -407,12 +308,12 @@ bool tagsAreActivated() {
   unsigned long now = millis();
 
   for (int i = 0; i < NUM_READERS; i++) {
-    if (strlen(currentTags[i]) == 0) {
+    if (!isTagDefined(i)) {
       // This RFID sensor has not seen any tags yet
       return false;
     }
 
-    if (isTagEqual(currentTags[i], acceptedTags[i]) == false) {
+    if (isTagAccepted(i) == false) {
       // Incorrect tag
       return false;
     }
@@ -450,6 +351,7 @@ void setup() {
   Serial.println("Starting RFID electronic lock program");
   Serial.flush();
 
+  secondaryScheduler.begin();
   updateListenerPort();
 
   pixelStrip.begin();
@@ -0,0 +1,406 @@
+#ifndef ANSWER_CAPTURE_H
+#define ANSWER_CAPTURE_H
+
+#include <Arduino.h>
+#include "InputEventQueue.h"
+
+/**
+ * Answer buttons of up to 16 players (32 buttons), sampled together and
+ * timestamped with micros() so players can be ranked by answer speed.
+ *
+ * A reader returns a snapshot of every button in one pass (bit
+ * player * numOptions + option, set while pressed):
+ *
+ * - ButtonPortReader: buttons wired to free pins (to GND, pulled up).
+ *   Each port register is read once and the pins are picked from those
+ *   values, so all buttons are sampled within a few cycles.
+ * - ShiftRegisterReader: buttons wired to a chain of 74HC165 (pulled up,
+ *   to GND). Loading the chain latches all inputs at the same instant;
+ *   the bits are then shifted in through port registers.
+ *
+ * scan() runs from a timer interrupt. A button that becomes pressed after
+ * being stable for debounceUs is a press and is queued with the time of
+ * the scan that saw it; the edges that follow within debounceUs (bounces)
+ * are dropped. The resolution of the timestamps is the scan interval,
+ * plus any time interrupts are off (e.g. a NeoPixel show()).
+ *
+ * loop() calls poll(), which replays the presses of the open phase in
+ * capture order. The last press of a player is its answer, timed from
+ * openPhase(). rank() sorts the players of the phase.
+ */
+
+typedef uint32_t ButtonMask;
+
+const uint8_t ANSWER_CAPTURE_MAX_BUTTONS = 32;
+const uint8_t ANSWER_CAPTURE_MAX_PLAYERS = 16;
+const uint8_t ANSWER_CAPTURE_NONE = 0xFF;
+
+const uint8_t BUTTON_PORT_READER_MAX_PORTS = 4;
+
+class ButtonPortReader
+{
+public:
+    ButtonPortReader(const uint8_t *pins, uint8_t numPins)
+        : pins(pins),
+          numPins(numPins > ANSWER_CAPTURE_MAX_BUTTONS ? ANSWER_CAPTURE_MAX_BUTTONS : numPins),
+          numPorts(0)
+    {
+    }
+
+    void begin()
+    {
+        for (uint8_t i = 0; i < numPins; i++)
+        {
+            pinMode(pins[i], INPUT_PULLUP);
+
+            volatile uint8_t *reg = portInputRegister(digitalPinToPort(pins[i]));
+            uint8_t port = 0;
+
+            while (port < numPorts && portRegs[port] != reg)
+            {
+                port++;
+            }
+
+            if (port == numPorts && numPorts < BUTTON_PORT_READER_MAX_PORTS)
+            {
+                portRegs[numPorts++] = reg;
+            }
+
+            pinPorts[i] = port;
+            pinMasks[i] = digitalPinToBitMask(pins[i]);
+        }
+    }
+
+    ButtonMask read() const
+    {
+        uint8_t values[BUTTON_PORT_READER_MAX_PORTS];
+        ButtonMask pressed = 0;
+
+        for (uint8_t port = 0; port < numPorts; port++)
+        {
+            values[port] = *portRegs[port];
+        }
+
+        for (uint8_t i = 0; i < numPins; i++)
+        {
+            if (!(values[pinPorts[i]] & pinMasks[i]))
+            {
+                pressed |= (ButtonMask)1 << i;
+            }
+        }
+
+        return pressed;
+    }
+
+private:
+    const uint8_t *pins;
+    uint8_t numPins;
+
+    volatile uint8_t *portRegs[BUTTON_PORT_READER_MAX_PORTS];
+    uint8_t numPorts;
+    uint8_t pinPorts[ANSWER_CAPTURE_MAX_BUTTONS];
+    uint8_t pinMasks[ANSWER_CAPTURE_MAX_BUTTONS];
+};
+
+/**
+ * Input 0 is the first bit shifted out: H of the 74HC165 whose QH goes to
+ * dataPin, then G, F... and on through the chain. CLK INH is tied low.
+ */
+class ShiftRegisterReader
+{
+public:
+    ShiftRegisterReader(uint8_t loadPin, uint8_t clockPin, uint8_t dataPin, uint8_t numInputs)
+        : loadPin(loadPin),
+          clockPin(clockPin),
+          dataPin(dataPin),
+          numInputs(numInputs > ANSWER_CAPTURE_MAX_BUTTONS ? ANSWER_CAPTURE_MAX_BUTTONS : numInputs)
+    {
+    }
+
+    void begin()
+    {
+        pinMode(loadPin, OUTPUT);
+        pinMode(clockPin, OUTPUT);
+        pinMode(dataPin, INPUT);
+
+        digitalWrite(loadPin, HIGH);
+        digitalWrite(clockPin, LOW);
+
+        loadReg = portOutputRegister(digitalPinToPort(loadPin));
+        clockReg = portOutputRegister(digitalPinToPort(clockPin));
+        dataReg = portInputRegister(digitalPinToPort(dataPin));
+        loadMask = digitalPinToBitMask(loadPin);
+        clockMask = digitalPinToBitMask(clockPin);
+        dataMask = digitalPinToBitMask(dataPin);
+    }
+
+    /**
+     * Call with interrupts off (e.g. from the ISR): the port writes are
+     * read-modify-write.
+     */
+    ButtonMask read() const
+    {
+        ButtonMask pressed = 0;
+
+        // SH/LD low latches all inputs at once
+        *loadReg &= ~loadMask;
+        *loadReg |= loadMask;
+
+        for (uint8_t i = 0; i < numInputs; i++)
+        {
+            if (!(*dataReg & dataMask))
+            {
+                pressed |= (ButtonMask)1 << i;
+            }
+
+            *clockReg |= clockMask;
+            *clockReg &= ~clockMask;
+        }
+
+        return pressed;
+    }
+
+private:
+    uint8_t loadPin;
+    uint8_t clockPin;
+    uint8_t dataPin;
+    uint8_t numInputs;
+
+    volatile uint8_t *loadReg;
+    volatile uint8_t *clockReg;
+    volatile uint8_t *dataReg;
+    uint8_t loadMask;
+    uint8_t clockMask;
+    uint8_t dataMask;
+};
+
+template <typename Reader>
+class AnswerCapture
+{
+public:
+    AnswerCapture(
+        Reader &reader,
+        uint8_t numPlayers,
+        uint8_t numOptions,
+        unsigned long debounceUs,
+        void (*onAnswer)(uint8_t player, uint8_t option))
+        : reader(reader),
+          numPlayers(numPlayers > ANSWER_CAPTURE_MAX_PLAYERS ? ANSWER_CAPTURE_MAX_PLAYERS : numPlayers),
+          numOptions(numOptions),
+          debounceUs(debounceUs),
+          onAnswer(onAnswer),
+          rawState(0),
+          phaseStartMicros(0),
+          isOpen(false)
+    {
+        for (uint8_t p = 0; p < ANSWER_CAPTURE_MAX_PLAYERS; p++)
+        {
+            choices[p] = ANSWER_CAPTURE_NONE;
+            answerMicros[p] = 0;
+        }
+    }
+
+    /**
+     * Call before the timer that drives scan() is started.
+     */
+    void begin()
+    {
+        reader.begin();
+        rawState = reader.read();
+
+        unsigned long now = micros();
+
+        for (uint8_t b = 0; b < ANSWER_CAPTURE_MAX_BUTTONS; b++)
+        {
+            lastEdgeMicros[b] = now - debounceUs;
+        }
+    }
+
+    /**
+     * Call from the timer ISR only.
+     */
+    void scan()
+    {
+        unsigned long now = micros();
+        ButtonMask raw = reader.read();
+        ButtonMask changed = raw ^ rawState;
+
+        rawState = raw;
+
+        for (uint8_t b = 0; changed != 0; b++, changed >>= 1)
+        {
+            if (!(changed & 1))
+            {
+                continue;
+            }
+
+            bool isStable = now - lastEdgeMicros[b] >= debounceUs;
+
+            lastEdgeMicros[b] = now;
+
+            if (isStable && (raw & ((ButtonMask)1 << b)))
+            {
+                queue.push(b, LOW, now);
+            }
+        }
+    }
+
+    /**
+     * Forgets the answers and starts timing them. Presses captured
+     * before are dropped.
+     */
+    void openPhase()
+    {
+        InputEvent event;
+
+        while (queue.pop(event))
+        {
+        }
+
+        for (uint8_t p = 0; p < numPlayers; p++)
+        {
+            choices[p] = ANSWER_CAPTURE_NONE;
+            answerMicros[p] = 0;
+        }
+
+        phaseStartMicros = micros();
+        isOpen = true;
+    }
+
+    /**
+     * Takes the presses captured so far and stops accepting answers.
+     */
+    void closePhase()
+    {
+        poll();
+        isOpen = false;
+    }
+
+    /**
+     * Replays the queued presses of the open phase. Call from loop().
+     */
+    void poll()
+    {
+        InputEvent event;
+
+        while (queue.pop(event))
+        {
+            // Captured between the queue drain and the phase start
+            if (!isOpen || (long)(event.micros - phaseStartMicros) < 0)
+            {
+                continue;
+            }
+
+            uint8_t player = event.pin / numOptions;
+            uint8_t option = event.pin % numOptions;
+
+            if (player >= numPlayers)
+            {
+                continue;
+            }
+
+            choices[player] = option;
+            answerMicros[player] = event.micros - phaseStartMicros;
+
+            onAnswer(player, option);
+        }
+    }
+
+    bool isPhaseOpen() const
+    {
+        return isOpen;
+    }
+
+    /**
+     * Option of the last press of the player, or ANSWER_CAPTURE_NONE.
+     */
+    uint8_t getChoice(uint8_t player) const
+    {
+        return choices[player];
+    }
+
+    /**
+     * Time (us) from openPhase() to the last press of the player.
+     */
+    unsigned long getAnswerMicros(uint8_t player) const
+    {
+        return answerMicros[player];
+    }
+
+    /**
+     * Fills order with the players from first to last: right answers,
+     * fastest first, then wrong answers, fastest first, then players that
+     * did not answer. Ties keep the player order. Returns the number of
+     * right answers.
+     */
+    uint8_t rank(uint8_t rightOption, uint8_t *order) const
+    {
+        uint8_t numRight = 0;
+
+        for (uint8_t p = 0; p < numPlayers; p++)
+        {
+            uint8_t j = p;
+
+            while (j > 0 && isAhead(p, order[j - 1], rightOption))
+            {
+                order[j] = order[j - 1];
+                j--;
+            }
+
+            order[j] = p;
+
+            if (choices[p] == rightOption)
+            {
+                numRight++;
+            }
+        }
+
+        return numRight;
+    }
+
+    uint8_t getOverruns() const
+    {
+        return queue.getOverruns();
+    }
+
+private:
+    Reader &reader;
+    uint8_t numPlayers;
+    uint8_t numOptions;
+    unsigned long debounceUs;
+    void (*onAnswer)(uint8_t player, uint8_t option);
+
+    InputEventQueue<32> queue;
+    ButtonMask rawState;
+    unsigned long lastEdgeMicros[ANSWER_CAPTURE_MAX_BUTTONS];
+
+    uint8_t choices[ANSWER_CAPTURE_MAX_PLAYERS];
+    unsigned long answerMicros[ANSWER_CAPTURE_MAX_PLAYERS];
+    unsigned long phaseStartMicros;
+    bool isOpen;
+
+    uint8_t group(uint8_t player, uint8_t rightOption) const
+    {
+        if (choices[player] == ANSWER_CAPTURE_NONE)
+        {
+            return 2;
+        }
+
+        return choices[player] == rightOption ? 0 : 1;
+    }
+
+    bool isAhead(uint8_t a, uint8_t b, uint8_t rightOption) const
+    {
+        uint8_t groupA = group(a, rightOption);
+        uint8_t groupB = group(b, rightOption);
+
+        if (groupA != groupB)
+        {
+            return groupA < groupB;
+        }
+
+        return groupA != 2 && answerMicros[a] < answerMicros[b];
+    }
+};
+
+#endif
@@ -0,0 +1,205 @@
+#ifndef INPUT_EVENT_QUEUE_H
+#define INPUT_EVENT_QUEUE_H
+
+#include <Arduino.h>
+
+/**
+ * Timestamped input edges captured from interrupts.
+ *
+ * A pin change ISR pushes one (pin, level, micros) event per pin that
+ * changed; loop() pops and replays them in order. The queue is a
+ * single-producer / single-consumer ring: only the ISR writes head and
+ * only loop() writes tail, each index is a single byte (atomic on AVR),
+ * so neither side needs to disable interrupts.
+ *
+ * Debouncing happens on consumption with InputDebouncer, using the
+ * capture timestamps, so it does not matter how late events are read.
+ *
+ * Edges are only lost if the queue overflows (counted in overruns) or a
+ * pin toggles twice while interrupts are off (e.g. during a NeoPixel
+ * show()); the pending ISR then still reports the pin's final level.
+ */
+
+// Keeps the compiler from reordering slot accesses across index updates
+#define INPUT_EVENT_BARRIER() asm volatile("" ::: "memory")
+
+typedef struct inputEvent
+{
+    uint8_t pin;
+    uint8_t level;
+    unsigned long micros;
+} InputEvent;
+
+template <uint8_t SIZE>
+class InputEventQueue
+{
+    static_assert((SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two");
+
+public:
+    InputEventQueue()
+        : head(0),
+          tail(0),
+          overruns(0)
+    {
+    }
+
+    /**
+     * Producer side: call only from the ISR.
+     */
+    bool push(uint8_t pin, uint8_t level, unsigned long micros)
+    {
+        uint8_t next = (head + 1) & (SIZE - 1);
+
+        if (next == tail)
+        {
+            if (overruns < 0xFF)
+            {
+                overruns++;
+            }
+
+            return false;
+        }
+
+        events[head].pin = pin;
+        events[head].level = level;
+        events[head].micros = micros;
+
+        INPUT_EVENT_BARRIER();
+        head = next;
+
+        return true;
+    }
+
+    /**
+     * Consumer side: call only from loop().
+     */
+    bool pop(InputEvent &event)
+    {
+        if (tail == head)
+        {
+            return false;
+        }
+
+        INPUT_EVENT_BARRIER();
+        event = events[tail];
+        INPUT_EVENT_BARRIER();
+
+        tail = (tail + 1) & (SIZE - 1);
+
+        return true;
+    }
+
+    uint8_t getOverruns() const
+    {
+        return overruns;
+    }
+
+private:
+    InputEvent events[SIZE];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    volatile uint8_t overruns;
+};
+
+/**
+ * Per-pin debouncer over captured edges.
+ *
+ * accept() takes an edge right away when it changes the stable level of
+ * its pin and at least debounceUs have passed since the last accepted
+ * edge, so a press is seen with no added latency and the bounces that
+ * follow it are dropped.
+ *
+ * An edge dropped that way may still be real (a tap shorter than the
+ * window). settle() reports it once the pin has stayed at that level for
+ * debounceUs, so the stable level never gets stuck.
+ */
+
+const uint8_t INPUT_DEBOUNCER_MAX_PINS = 20;
+
+class InputDebouncer
+{
+public:
+    InputDebouncer(unsigned long debounceUs)
+        : debounceUs(debounceUs)
+    {
+        memset(levels, HIGH, sizeof(levels));
+        memset(rawLevels, HIGH, sizeof(rawLevels));
+        memset(lastMicros, 0, sizeof(lastMicros));
+        memset(rawMicros, 0, sizeof(rawMicros));
+    }
+
+    /**
+     * Sets the stable level of a pin, before its edges are captured.
+     */
+    void begin(uint8_t pin, uint8_t level)
+    {
+        if (pin < INPUT_DEBOUNCER_MAX_PINS)
+        {
+            levels[pin] = level;
+            rawLevels[pin] = level;
+        }
+    }
+
+    /**
+     * Returns true if the edge is a debounced transition.
+     */
+    bool accept(const InputEvent &event)
+    {
+        uint8_t pin = event.pin;
+
+        if (pin >= INPUT_DEBOUNCER_MAX_PINS)
+        {
+            return false;
+        }
+
+        rawLevels[pin] = event.level;
+        rawMicros[pin] = event.micros;
+
+        if (event.level == levels[pin] ||
+            event.micros - lastMicros[pin] < debounceUs)
+        {
+            return false;
+        }
+
+        levels[pin] = event.level;
+        lastMicros[pin] = event.micros;
+
+        return true;
+    }
+
+    /**
+     * Reports one dropped edge that has been stable since before nowMicros.
+     * Call until it returns false.
+     */
+    bool settle(unsigned long nowMicros, InputEvent &event)
+    {
+        for (uint8_t pin = 0; pin < INPUT_DEBOUNCER_MAX_PINS; pin++)
+        {
+            if (rawLevels[pin] == levels[pin] ||
+                nowMicros - rawMicros[pin] < debounceUs)
+            {
+                continue;
+            }
+
+            levels[pin] = rawLevels[pin];
+            lastMicros[pin] = rawMicros[pin];
+
+            event.pin = pin;
+            event.level = levels[pin];
+            event.micros = rawMicros[pin];
+
+            return true;
+        }
+
+        return false;
+    }
+
+private:
+    unsigned long debounceUs;
+    uint8_t levels[INPUT_DEBOUNCER_MAX_PINS];
+    uint8_t rawLevels[INPUT_DEBOUNCER_MAX_PINS];
+    unsigned long lastMicros[INPUT_DEBOUNCER_MAX_PINS];
+    unsigned long rawMicros[INPUT_DEBOUNCER_MAX_PINS];
+};
+
+#endif
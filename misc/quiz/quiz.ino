@@ -1,5 +1,6 @@
 #include <Automaton.h>
 #include <Adafruit_NeoPixel.h>
+#include "AnswerCapture.h"
 
 /**
  * Player buttons.
@@ -8,7 +9,7 @@
 const int PLAYERS_NUM = 3;
 const int OPTIONS_NUM = 2;
 
-const int BUTTONS_PINS[PLAYERS_NUM][OPTIONS_NUM] = {
+const uint8_t BUTTONS_PINS[PLAYERS_NUM][OPTIONS_NUM] = {
     {A0, 3},
     {4, 5},
     {6, 7}};
@@ -18,7 +19,32 @@ const int BUTTONS_LEDS_PINS[PLAYERS_NUM][OPTIONS_NUM] = {
     {A3, A2},
     {A4, A5}};
 
-Atm_button buttons[PLAYERS_NUM][OPTIONS_NUM];
+/**
+ * Answer capture.
+ */
+
+// All player buttons are sampled together from a timer interrupt and each
+// press is timestamped. For more players than free pins, wire the buttons
+// to a chain of 74HC165 and use instead:
+// ShiftRegisterReader buttonReader(LOAD_PIN, CLOCK_PIN, DATA_PIN, PLAYERS_NUM * OPTIONS_NUM);
+
+const unsigned long BUTTON_DEBOUNCE_US = 30000;
+
+// Timer2 CTC: 16 MHz / 32 / (124 + 1) = 4 kHz, one scan every 250 us
+const uint8_t BUTTON_TIMER_OCR = 124;
+
+void onPlayerButton(uint8_t plyIdx, uint8_t optIdx);
+
+ButtonPortReader buttonReader(&BUTTONS_PINS[0][0], PLAYERS_NUM * OPTIONS_NUM);
+
+AnswerCapture<ButtonPortReader> answerCapture(
+    buttonReader,
+    PLAYERS_NUM,
+    OPTIONS_NUM,
+    BUTTON_DEBOUNCE_US,
+    onPlayerButton);
+
+uint8_t reportedOverruns = 0;
 
 /**
  * Show host button.
@@ -43,6 +69,15 @@ Atm_timer timerLedCountdown;
 
 const int TIMER_LED_COUNTDOWN_MS = 150;
 
+/**
+ * Correct answer blink timer.
+ */
+
+Atm_timer timerBlink;
+
+const int TIMER_BLINK_MS = 60;
+const int TIMER_BLINK_REPEATS = 90;
+
 /**
  * Colors.
  */
@@ -117,16 +152,18 @@ const int SOLUTION_KEY[NUM_PHASES] = {
 
 typedef struct programState
 {
-    int currChoices[PLAYERS_NUM];
     bool phaseResults[PLAYERS_NUM][NUM_PHASES];
+    uint8_t phaseRankings[NUM_PHASES][PLAYERS_NUM];
     int currPhase;
+    int blinkPhase;
     unsigned long countdownStartMillis;
 } ProgramState;
 
 ProgramState progState = {
-    .currChoices = {0},
     .phaseResults = {{false}},
+    .phaseRankings = {{0}},
     .currPhase = 0,
+    .blinkPhase = 0,
     .countdownStartMillis = 0};
 
 void initState()
@@ -136,12 +173,12 @@ void initState()
         for (int f = 0; f < NUM_PHASES; f++)
         {
             progState.phaseResults[p][f] = false;
+            progState.phaseRankings[f][p] = p;
         }
-
-        progState.currChoices[p] = 0;
     }
 
     progState.currPhase = 0;
+    progState.blinkPhase = 0;
     progState.countdownStartMillis = 0;
 }
 
@@ -156,6 +193,10 @@ void resetProgram()
 
     initState();
 
+    timerCountdown.stop();
+    stopBlinkCorrectLeds();
+    answerCapture.closePhase();
+
     // for (int p = 0; p < PLAYERS_NUM; p++)
     // {
     //     ledPlayerStrips[p].clear();
@@ -285,53 +326,80 @@ bool isTimerCountdownIdle()
     return timerCountdown.state() == Atm_timer::IDLE;
 }
 
-void blockAndWaitForReset()
+void clearButtonLeds()
 {
-    const unsigned long iterDelayMs = 5000;
-
-    while (true)
+    for (int p = 0; p < PLAYERS_NUM; p++)
     {
-        Serial.println(F("The end"));
-
-        delay(iterDelayMs);
-
-        if (digitalRead(HOST_BUTTON_PIN) == LOW)
+        for (int o = 0; o < OPTIONS_NUM; o++)
         {
-            resetProgram();
-            delay(iterDelayMs);
-            break;
+            digitalWrite(BUTTONS_LEDS_PINS[p][o], LOW);
         }
     }
 }
 
-void blinkCorrectLeds()
+void onTimerBlink(int idx, int v, int up)
 {
-    const int numRepeats = 90;
-    const int delayRepeatMs = 60;
-
-    for (int i = 0; i < numRepeats; i++)
+    for (int p = 0; p < PLAYERS_NUM; p++)
     {
-        for (int p = 0; p < PLAYERS_NUM; p++)
+        for (int o = 0; o < OPTIONS_NUM; o++)
         {
-            for (int o = 0; o < OPTIONS_NUM; o++)
-            {
-                digitalWrite(
-                    BUTTONS_LEDS_PINS[p][o],
-                    (progState.phaseResults[p][progState.currPhase])
-                        ? !digitalRead(BUTTONS_LEDS_PINS[p][o])
-                        : LOW);
-            }
+            digitalWrite(
+                BUTTONS_LEDS_PINS[p][o],
+                (progState.phaseResults[p][progState.blinkPhase])
+                    ? !digitalRead(BUTTONS_LEDS_PINS[p][o])
+                    : LOW);
         }
-
-        delay(delayRepeatMs);
     }
+}
 
-    for (int p = 0; p < PLAYERS_NUM; p++)
+void onTimerBlinkFinish(int idx, int v, int up)
+{
+    clearButtonLeds();
+}
+
+void startBlinkCorrectLeds(int phase)
+{
+    progState.blinkPhase = phase;
+    timerBlink.start();
+}
+
+void stopBlinkCorrectLeds()
+{
+    timerBlink.stop();
+    clearButtonLeds();
+}
+
+void initTimerBlink()
+{
+    timerBlink
+        .begin(TIMER_BLINK_MS)
+        .repeat(TIMER_BLINK_REPEATS)
+        .onTimer(onTimerBlink)
+        .onFinish(onTimerBlinkFinish);
+}
+
+void printPhaseRanking(int phase)
+{
+    Serial.print(F("Ranking :: Phase #"));
+    Serial.println(phase);
+
+    for (int r = 0; r < PLAYERS_NUM; r++)
     {
-        for (int o = 0; o < OPTIONS_NUM; o++)
+        uint8_t p = progState.phaseRankings[phase][r];
+
+        Serial.print(r + 1);
+        Serial.print(F(" :: Player #"));
+        Serial.print(p);
+
+        if (answerCapture.getChoice(p) == ANSWER_CAPTURE_NONE)
         {
-            digitalWrite(BUTTONS_LEDS_PINS[p][o], LOW);
+            Serial.println(F(" :: No answer"));
+            continue;
         }
+
+        Serial.print(progState.phaseResults[p][phase] ? F(" :: OK :: ") : F(" :: Error :: "));
+        Serial.print(answerCapture.getAnswerMicros(p));
+        Serial.println(F(" us"));
     }
 }
 
@@ -345,12 +413,14 @@ void onTimerCountdown(int idx, int v, int up)
         return;
     }
 
+    answerCapture.closePhase();
+
     int validChoice = SOLUTION_KEY[progState.currPhase];
     bool isValidChoice;
 
     for (int p = 0; p < PLAYERS_NUM; p++)
     {
-        isValidChoice = progState.currChoices[p] == validChoice;
+        isValidChoice = answerCapture.getChoice(p) == validChoice;
         progState.phaseResults[p][progState.currPhase] = isValidChoice;
 
         Serial.print(F("Player #"));
@@ -370,7 +440,10 @@ void onTimerCountdown(int idx, int v, int up)
         }
     }
 
-    blinkCorrectLeds();
+    answerCapture.rank(validChoice, progState.phaseRankings[progState.currPhase]);
+    printPhaseRanking(progState.currPhase);
+
+    startBlinkCorrectLeds(progState.currPhase);
 
     progState.currPhase++;
     progState.countdownStartMillis = 0;
@@ -378,7 +451,7 @@ void onTimerCountdown(int idx, int v, int up)
 
     if (isFinished())
     {
-        blockAndWaitForReset();
+        Serial.println(F("The end :: Press the host button to reset"));
     }
 }
 
@@ -396,6 +469,8 @@ void startTimerCountdown()
     {
         Serial.println(F("Starting countdown timer"));
         clearPlayerLeds();
+        stopBlinkCorrectLeds();
+        answerCapture.openPhase();
         progState.countdownStartMillis = millis();
         timerCountdown.start();
     }
@@ -450,26 +525,8 @@ void initTimerLedCountdown()
  * Player button functions.
  */
 
-int flattenButtonIndex(int plyIdx, int optIdx)
-{
-    return optIdx + plyIdx * OPTIONS_NUM;
-}
-
-int flatToPlayerIndex(int flatIdx)
+void onPlayerButton(uint8_t plyIdx, uint8_t optIdx)
 {
-    return floor(((float)flatIdx) / ((float)OPTIONS_NUM));
-}
-
-int flatToOptionIndex(int flatIdx)
-{
-    return flatIdx % OPTIONS_NUM;
-}
-
-void onPlayerButton(int idx, int v, int up)
-{
-    int plyIdx = flatToPlayerIndex(idx);
-    int optIdx = flatToOptionIndex(idx);
-
     Serial.print(F("Button::P"));
     Serial.print(plyIdx);
     Serial.print(F("::O"));
@@ -481,8 +538,23 @@ void onPlayerButton(int idx, int v, int up)
             BUTTONS_LEDS_PINS[plyIdx][i],
             (i == optIdx) ? HIGH : LOW);
     }
+}
+
+ISR(TIMER2_COMPA_vect)
+{
+    answerCapture.scan();
+}
+
+void pollPlayerButtons()
+{
+    answerCapture.poll();
 
-    progState.currChoices[plyIdx] = optIdx;
+    if (answerCapture.getOverruns() != reportedOverruns)
+    {
+        reportedOverruns = answerCapture.getOverruns();
+        Serial.print(F("Warning :: Button queue overruns: "));
+        Serial.println(reportedOverruns);
+    }
 }
 
 void initPlayerButtons()
@@ -493,12 +565,18 @@ void initPlayerButtons()
         {
             pinMode(BUTTONS_LEDS_PINS[p][o], OUTPUT);
             digitalWrite(BUTTONS_LEDS_PINS[p][o], LOW);
-
-            buttons[p][o]
-                .begin(BUTTONS_PINS[p][o])
-                .onPress(onPlayerButton, flattenButtonIndex(p, o));
         }
     }
+
+    answerCapture.begin();
+
+    noInterrupts();
+    TCCR2A = bit(WGM21);
+    TCCR2B = bit(CS21) | bit(CS20);
+    OCR2A = BUTTON_TIMER_OCR;
+    TCNT2 = 0;
+    TIMSK2 = bit(OCIE2A);
+    interrupts();
 }
 
 /**
@@ -508,6 +586,13 @@ void initPlayerButtons()
 void onHostButton(int idx, int v, int up)
 {
     Serial.println(F("Host button"));
+
+    if (isFinished())
+    {
+        resetProgram();
+        return;
+    }
+
     startTimerCountdown();
 }
 
@@ -534,11 +619,13 @@ void setup()
     initCountdownLed();
     initGlobalLed();
     initTimerLedCountdown();
+    initTimerBlink();
 
     Serial.println(F(">> Starting quiz program"));
 }
 
 void loop()
 {
+    pollPlayerButtons();
     automaton.run();
 }
\ No newline at end of file
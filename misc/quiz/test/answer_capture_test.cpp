@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <vector>
+#include <ArduinoSim.h>
+#include "../AnswerCapture.h"
+
+/**
+ * Host test of AnswerCapture: bouncing presses of 12 players scanned
+ * every 250 us (the 4 kHz timer of the sketch) while loop() only drains
+ * the queue every 20 ms, and a ButtonPortReader on simulated pins.
+ *
+ * Build and run from this directory with the native simulation core:
+ *
+ *   g++ -O2 -I ../../../native-sim/ArduinoSim/src answer_capture_test.cpp \
+ *       ../../../native-sim/ArduinoSim/src/ArduinoSim.cpp -o answer_capture_test
+ *   ./answer_capture_test
+ *
+ * Exits with 1 if a check fails.
+ */
+
+const uint8_t NUM_PLAYERS = 12;
+const uint8_t NUM_OPTIONS = 2;
+const unsigned long DEBOUNCE_US = 30000;
+const unsigned long SCAN_US = 250;
+const unsigned long POLL_US = 20000;
+
+int numFailures = 0;
+
+#define CHECK(cond)                                           \
+    do                                                        \
+    {                                                         \
+        if (!(cond))                                          \
+        {                                                     \
+            printf("FAIL line %d: %s\n", __LINE__, #cond);    \
+            numFailures++;                                    \
+        }                                                     \
+    } while (0)
+
+/**
+ * Reader whose buttons are set by the test.
+ */
+class FakeReader
+{
+public:
+    FakeReader() : mask(0) {}
+
+    void begin()
+    {
+    }
+
+    ButtonMask read() const
+    {
+        return mask;
+    }
+
+    ButtonMask mask;
+};
+
+typedef struct edge
+{
+    unsigned long micros;
+    uint8_t button;
+    bool isDown;
+} Edge;
+
+std::vector<Edge> edges;
+std::vector<uint8_t> answers;
+
+void onAnswer(uint8_t player, uint8_t)
+{
+    answers.push_back(player);
+}
+
+/**
+ * A press at atUs held for 80 ms, with bounces of 300 us on both edges.
+ */
+void schedulePress(uint8_t button, unsigned long atUs, int bounces)
+{
+    unsigned long releaseUs = atUs + 80000;
+
+    for (int i = 0; i < bounces; i++)
+    {
+        edges.push_back({atUs + i * 600, button, true});
+        edges.push_back({atUs + i * 600 + 300, button, false});
+        edges.push_back({releaseUs + i * 600, button, false});
+        edges.push_back({releaseUs + i * 600 + 300, button, true});
+    }
+
+    edges.push_back({atUs + bounces * 600, button, true});
+    edges.push_back({releaseUs + bounces * 600, button, false});
+}
+
+template <typename Capture>
+void runUntil(Capture &capture, FakeReader &reader, unsigned long untilUs)
+{
+    std::stable_sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) {
+        return a.micros < b.micros;
+    });
+
+    size_t k = 0;
+
+    for (; micros() < untilUs; sim::advanceMicros(SCAN_US))
+    {
+        for (; k < edges.size() && edges[k].micros <= micros(); k++)
+        {
+            ButtonMask bit = (ButtonMask)1 << edges[k].button;
+            reader.mask = edges[k].isDown ? reader.mask | bit : reader.mask & ~bit;
+        }
+
+        capture.scan();
+
+        if (micros() % POLL_US == 0)
+        {
+            capture.poll();
+        }
+    }
+
+    edges.erase(edges.begin(), edges.begin() + k);
+}
+
+void testRanking()
+{
+    FakeReader reader;
+    AnswerCapture<FakeReader> capture(reader, NUM_PLAYERS, NUM_OPTIONS, DEBOUNCE_US, onAnswer);
+
+    sim::reset();
+    sim::advance(1000);
+    capture.begin();
+
+    // Before the phase opens: dropped
+    schedulePress(0, micros() + 1000, 2);
+    runUntil(capture, reader, micros() + 200000);
+
+    capture.openPhase();
+    unsigned long start = micros();
+
+    // Player p answers option p % 2 at 100 ms + (12 - p) * 7 ms, so later
+    // players are faster. Player 5 does not answer.
+    for (uint8_t p = 0; p < NUM_PLAYERS; p++)
+    {
+        if (p != 5)
+        {
+            schedulePress(p * NUM_OPTIONS + p % 2, start + 100000 + (NUM_PLAYERS - p) * 7000, p % 3);
+        }
+    }
+
+    // Player 3 changes its answer to option 0
+    schedulePress(3 * NUM_OPTIONS, start + 400000, 1);
+
+    runUntil(capture, reader, start + 700000);
+    capture.closePhase();
+
+    CHECK(answers.size() == NUM_PLAYERS);
+    CHECK(capture.getChoice(5) == ANSWER_CAPTURE_NONE);
+    CHECK(capture.getChoice(3) == 0);
+    CHECK(capture.getOverruns() == 0);
+
+    // Timed to the scan that saw the press
+    for (uint8_t p = 0; p < NUM_PLAYERS; p++)
+    {
+        if (p == 3 || p == 5)
+        {
+            continue;
+        }
+
+        long error = (long)capture.getAnswerMicros(p) - (long)(100000 + (NUM_PLAYERS - p) * 7000);
+
+        CHECK(error >= 0 && error < (long)SCAN_US);
+    }
+
+    // Right (option 1): 11, 9, 7, 1. Then the wrong ones, fastest first,
+    // ending with player 3 (changed late), then player 5 (no answer).
+    uint8_t order[NUM_PLAYERS];
+    uint8_t numRight = capture.rank(1, order);
+
+    CHECK(numRight == 4);
+    CHECK(order[0] == 11 && order[3] == 1);
+    CHECK(order[4] == 10);
+    CHECK(order[NUM_PLAYERS - 2] == 3);
+    CHECK(order[NUM_PLAYERS - 1] == 5);
+
+    // After the phase closes: not replayed
+    answers.clear();
+    schedulePress(2, micros() + 1000, 0);
+    runUntil(capture, reader, micros() + 200000);
+    capture.poll();
+
+    CHECK(answers.empty());
+}
+
+void testButtonPortReader()
+{
+    const uint8_t pins[] = {2, 3, 9, A0};
+
+    sim::reset();
+
+    ButtonPortReader reader(pins, 4);
+    reader.begin();
+
+    CHECK(reader.read() == 0);
+
+    sim::setPin(9, LOW);
+    sim::setPin(A0, LOW);
+
+    CHECK(reader.read() == 0b1100);
+
+    sim::setPin(9, HIGH);
+    sim::setPin(2, LOW);
+
+    CHECK(reader.read() == 0b1001);
+}
+
+void setup()
+{
+}
+
+void loop()
+{
+}
+
+int main()
+{
+    testRanking();
+    testButtonPortReader();
+
+    printf(numFailures == 0 ? "OK\n" : "FAILED\n");
+
+    return numFailures == 0 ? 0 : 1;
+}
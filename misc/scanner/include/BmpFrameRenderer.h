@@ -0,0 +1,242 @@
+#ifndef BMP_FRAME_RENDERER_H
+#define BMP_FRAME_RENDERER_H
+
+#include <Arduino.h>
+#include "FrameRenderer.h"
+
+/**
+ * Draws uncompressed 24 or 32-bit BMP files on an Adafruit SPI TFT, only
+ * repainting what changed since the last frame.
+ *
+ * The pixels on the panel are not kept in RAM (a 480x320 frame is 300 KB).
+ * Instead each row is split in segments of BMP_RENDERER_SEGMENT_PX pixels
+ * and a 32-bit hash of every segment on the panel is kept (19 KB for
+ * 480x320). A row of the new frame is read and converted into a line
+ * buffer, hashed, and only the span from its first to its last changed
+ * segment is sent. Consecutive rows with the same span share one address
+ * window.
+ *
+ * The whole file is still read from the card, so this saves the transfer
+ * to the panel, not the read. Pixels outside a frame are black. After
+ * invalidate() the next frame is drawn in full.
+ */
+
+const uint16_t BMP_RENDERER_MAX_WIDTH = FRAME_RENDERER_MAX_WIDTH;
+const uint16_t BMP_RENDERER_MAX_HEIGHT = 320;
+const uint8_t BMP_RENDERER_SEGMENT_PX = 32;
+const uint8_t BMP_RENDERER_SEGMENTS =
+    (BMP_RENDERER_MAX_WIDTH + BMP_RENDERER_SEGMENT_PX - 1) / BMP_RENDERER_SEGMENT_PX;
+
+template <typename Display>
+class BmpFrameRenderer
+{
+public:
+    BmpFrameRenderer(Display &tft)
+        : tft(tft),
+          isKnown(false),
+          bufIdx(0)
+    {
+        stats.renderUs = 0;
+        stats.rects = 0;
+        stats.pixels = 0;
+    }
+
+    /**
+     * Call when something else has drawn on the panel.
+     */
+    void invalidate()
+    {
+        isKnown = false;
+    }
+
+    /**
+     * Draws an opened BMP file. Returns false, without touching the
+     * panel, if the file is not a BMP this renderer can read.
+     */
+    template <typename File>
+    bool draw(File &file)
+    {
+        unsigned long start = micros();
+        BmpInfo info;
+
+        if (!readInfo(file, info)) {
+            return false;
+        }
+
+        int16_t width = min(tft.width(), (int16_t)BMP_RENDERER_MAX_WIDTH);
+        int16_t height = min(tft.height(), (int16_t)BMP_RENDERER_MAX_HEIGHT);
+        uint8_t numSegments = (width + BMP_RENDERER_SEGMENT_PX - 1) / BMP_RENDERER_SEGMENT_PX;
+
+        stats.rects = 0;
+        stats.pixels = 0;
+
+        int16_t windowX0 = 0;
+        int16_t windowX1 = -1;
+
+        tft.startWrite();
+
+        for (int16_t y = 0; y < height; y++) {
+            uint16_t *line = lineBufs[bufIdx];
+
+            // The other buffer may still be in flight
+            readRow(file, info, y, width, line);
+
+            int16_t x0 = 0;
+            int16_t x1 = -1;
+
+            for (uint8_t s = 0; s < numSegments; s++) {
+                int16_t segX0 = s * BMP_RENDERER_SEGMENT_PX;
+                int16_t segX1 = min((int16_t)(segX0 + BMP_RENDERER_SEGMENT_PX), width) - 1;
+                uint32_t hash = hashSpan(line + segX0, segX1 - segX0 + 1);
+
+                if (!isKnown || hash != hashes[y][s]) {
+                    if (x1 < x0) {
+                        x0 = segX0;
+                    }
+
+                    x1 = segX1;
+                    hashes[y][s] = hash;
+                }
+            }
+
+            if (x1 < x0) {
+                windowX1 = -1;
+                continue;
+            }
+
+            if (x0 != windowX0 || x1 != windowX1) {
+                // Open to the bottom of the panel: the next rows with the
+                // same span are streamed into the same window
+                tft.dmaWait();
+                tft.setAddrWindow(x0, y, x1 - x0 + 1, height - y);
+                windowX0 = x0;
+                windowX1 = x1;
+                stats.rects++;
+            }
+
+            tft.writePixels(line + x0, x1 - x0 + 1, false, true);
+            bufIdx ^= 1;
+            stats.pixels += x1 - x0 + 1;
+        }
+
+        tft.dmaWait();
+        tft.endWrite();
+
+        isKnown = true;
+        stats.renderUs = micros() - start;
+
+        return true;
+    }
+
+    /**
+     * Time, address windows and pixels of the last draw().
+     */
+    const FrameStats &getStats() const
+    {
+        return stats;
+    }
+
+private:
+    typedef struct bmpInfo {
+        uint32_t offset;
+        int32_t width;
+        int32_t height;
+        uint32_t stride;
+        uint8_t bytesPerPixel;
+        bool isTopDown;
+    } BmpInfo;
+
+    Display &tft;
+    bool isKnown;
+
+    uint32_t hashes[BMP_RENDERER_MAX_HEIGHT][BMP_RENDERER_SEGMENTS];
+    uint16_t lineBufs[2][BMP_RENDERER_MAX_WIDTH];
+    uint8_t fileBuf[BMP_RENDERER_MAX_WIDTH * 4];
+    uint8_t bufIdx;
+    FrameStats stats;
+
+    static uint16_t readLE16(const uint8_t *p)
+    {
+        return p[0] | ((uint16_t)p[1] << 8);
+    }
+
+    static uint32_t readLE32(const uint8_t *p)
+    {
+        return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    template <typename File>
+    static bool readInfo(File &file, BmpInfo &info)
+    {
+        uint8_t head[34];
+
+        if (!file.seekSet(0) || file.read(head, sizeof(head)) != (int)sizeof(head)) {
+            return false;
+        }
+
+        if (head[0] != 'B' || head[1] != 'M') {
+            return false;
+        }
+
+        uint16_t depth = readLE16(head + 28);
+        uint32_t compression = readLE32(head + 30);
+
+        if ((depth != 24 && depth != 32) || (compression != 0 && compression != 3)) {
+            return false;
+        }
+
+        info.offset = readLE32(head + 10);
+        info.width = (int32_t)readLE32(head + 18);
+        info.height = (int32_t)readLE32(head + 22);
+        info.isTopDown = info.height < 0;
+        info.height = info.isTopDown ? -info.height : info.height;
+        info.bytesPerPixel = depth / 8;
+        info.stride = (info.width * info.bytesPerPixel + 3) & ~3UL;
+
+        return info.width > 0 && info.width <= BMP_RENDERER_MAX_WIDTH;
+    }
+
+    /**
+     * Row y of the panel, byte-swapped to the order the panel expects.
+     */
+    template <typename File>
+    void readRow(File &file, const BmpInfo &info, int16_t y, int16_t width, uint16_t *line)
+    {
+        int16_t x = 0;
+
+        if (y < info.height) {
+            uint32_t src = info.isTopDown ? y : info.height - 1 - y;
+            int16_t numPx = min((int16_t)info.width, width);
+            int numBytes = numPx * info.bytesPerPixel;
+
+            if (file.seekSet(info.offset + src * info.stride) &&
+                file.read(fileBuf, numBytes) == numBytes) {
+                const uint8_t *p = fileBuf;
+
+                for (; x < numPx; x++, p += info.bytesPerPixel) {
+                    uint16_t color = ((p[2] & 0xF8) << 8) | ((p[1] & 0xFC) << 3) | (p[0] >> 3);
+                    line[x] = (color << 8) | (color >> 8);
+                }
+            }
+        }
+
+        for (; x < width; x++) {
+            line[x] = 0;
+        }
+    }
+
+    // FNV-1a
+    static uint32_t hashSpan(const uint16_t *px, int16_t len)
+    {
+        uint32_t hash = 2166136261UL;
+
+        for (int16_t i = 0; i < len; i++) {
+            hash = (hash ^ (px[i] & 0xFF)) * 16777619UL;
+            hash = (hash ^ (px[i] >> 8)) * 16777619UL;
+        }
+
+        return hash;
+    }
+};
+
+#endif
@@ -0,0 +1,283 @@
+#ifndef FRAME_RENDERER_H
+#define FRAME_RENDERER_H
+
+#include <Arduino.h>
+
+/**
+ * Draws run-length encoded frames (see scripts/gen_frames.py) on an
+ * Adafruit SPI TFT, only repainting what changed since the last frame.
+ *
+ * The renderer remembers the frame that is on the panel. For each row the
+ * runs of the old and the new frame are walked side by side to find the
+ * first and last pixel that differ, without decoding either of them.
+ * Consecutive dirty rows whose spans overlap are merged into one
+ * rectangle, so each rectangle costs a single address window.
+ *
+ * Rows of a rectangle are decoded into two alternating line buffers,
+ * already byte-swapped to the order the panel expects, and sent with
+ * non-blocking writePixels(). When the GFX library drives the SPI with
+ * DMA, decoding the next row overlaps the transfer of the previous one.
+ *
+ * Pixels outside a frame are black. After invalidate() the content of the
+ * panel is unknown and the next frame is drawn in full.
+ *
+ * Runs are 4 bytes, so the encoding only suits flat artwork with long
+ * runs. Photographic frames are larger than raw RGB565 and are better
+ * drawn from the card with BmpFrameRenderer.
+ */
+
+const uint16_t FRAME_RENDERER_MAX_WIDTH = 480;
+
+typedef struct rleRun {
+    uint16_t length;
+    uint16_t color;
+} RleRun;
+
+typedef struct rleFrame {
+    uint16_t width;
+    uint16_t height;
+    // Index of the first run of each row, plus the end of the last row
+    const uint32_t *rows;
+    const RleRun *runs;
+} RleFrame;
+
+typedef struct rleSequence {
+    const char *name;
+    const RleFrame *frames;
+    uint8_t numFrames;
+    uint16_t frameMs;
+} RleSequence;
+
+typedef struct frameStats {
+    unsigned long renderUs;
+    uint16_t rects;
+    uint32_t pixels;
+} FrameStats;
+
+template <typename Display>
+class FrameRenderer
+{
+public:
+    FrameRenderer(Display &tft)
+        : tft(tft),
+          current(NULL),
+          isKnown(false),
+          bufIdx(0)
+    {
+        stats.renderUs = 0;
+        stats.rects = 0;
+        stats.pixels = 0;
+    }
+
+    /**
+     * Clears the panel to black.
+     */
+    void clear()
+    {
+        tft.fillScreen(0);
+        current = NULL;
+        isKnown = true;
+    }
+
+    /**
+     * Call when something else has drawn on the panel.
+     */
+    void invalidate()
+    {
+        isKnown = false;
+    }
+
+    void draw(const RleFrame *frame)
+    {
+        unsigned long start = micros();
+        int16_t width = tft.width();
+        int16_t height = tft.height();
+
+        if (width > (int16_t)FRAME_RENDERER_MAX_WIDTH) {
+            width = FRAME_RENDERER_MAX_WIDTH;
+        }
+
+        stats.rects = 0;
+        stats.pixels = 0;
+
+        int16_t rectX0 = 0;
+        int16_t rectX1 = -1;
+        int16_t rectY0 = 0;
+
+        tft.startWrite();
+
+        for (int16_t y = 0; y <= height; y++) {
+            int16_t x0 = 0;
+            int16_t x1 = -1;
+
+            if (y < height) {
+                if (isKnown) {
+                    findDirtySpan(frame, y, width, x0, x1);
+                } else {
+                    x1 = width - 1;
+                }
+            }
+
+            bool isOpen = rectX1 >= rectX0;
+            bool isDirty = x1 >= x0;
+
+            if (isOpen && isDirty && x0 <= rectX1 && x1 >= rectX0) {
+                rectX0 = min(rectX0, x0);
+                rectX1 = max(rectX1, x1);
+                continue;
+            }
+
+            if (isOpen) {
+                drawRect(frame, rectX0, rectX1, rectY0, y);
+            }
+
+            rectX0 = x0;
+            rectX1 = x1;
+            rectY0 = y;
+        }
+
+        tft.dmaWait();
+        tft.endWrite();
+
+        current = frame;
+        isKnown = true;
+        stats.renderUs = micros() - start;
+    }
+
+    /**
+     * Time, rectangles and pixels of the last draw().
+     */
+    const FrameStats &getStats() const
+    {
+        return stats;
+    }
+
+private:
+    Display &tft;
+    const RleFrame *current;
+    bool isKnown;
+
+    uint16_t lineBufs[2][FRAME_RENDERER_MAX_WIDTH];
+    uint8_t bufIdx;
+    FrameStats stats;
+
+    /**
+     * Cursor over the runs of one row. Past the end of the row (or of the
+     * frame) the color is black until the edge of the panel.
+     */
+    typedef struct rowCursor {
+        const RleRun *run;
+        const RleRun *end;
+        int16_t x;
+        int16_t runEnd;
+    } RowCursor;
+
+    static void openRow(const RleFrame *frame, int16_t y, int16_t width, RowCursor &cur)
+    {
+        cur.x = 0;
+
+        if (frame == NULL || y >= (int16_t)frame->height) {
+            cur.run = cur.end = NULL;
+            cur.runEnd = width;
+            return;
+        }
+
+        cur.run = frame->runs + frame->rows[y];
+        cur.end = frame->runs + frame->rows[y + 1];
+        cur.runEnd = cur.run < cur.end ? cur.run->length : width;
+    }
+
+    static uint16_t colorAt(const RowCursor &cur)
+    {
+        return cur.run < cur.end ? cur.run->color : 0;
+    }
+
+    static void advance(RowCursor &cur, int16_t x, int16_t width)
+    {
+        cur.x = x;
+
+        while (cur.runEnd <= x && cur.run < cur.end) {
+            cur.run++;
+            cur.runEnd = cur.run < cur.end ? cur.runEnd + cur.run->length : width;
+        }
+    }
+
+    void findDirtySpan(const RleFrame *frame, int16_t y, int16_t width, int16_t &x0, int16_t &x1) const
+    {
+        RowCursor a;
+        RowCursor b;
+
+        openRow(current, y, width, a);
+        openRow(frame, y, width, b);
+
+        x0 = 0;
+        x1 = -1;
+
+        int16_t x = 0;
+
+        while (x < width) {
+            int16_t next = min(min(a.runEnd, b.runEnd), width);
+
+            if (colorAt(a) != colorAt(b)) {
+                if (x1 < x0) {
+                    x0 = x;
+                }
+
+                x1 = next - 1;
+            }
+
+            x = next;
+            advance(a, x, width);
+            advance(b, x, width);
+        }
+    }
+
+    /**
+     * Draws columns x0..x1 of rows y0..y1 - 1.
+     */
+    void drawRect(const RleFrame *frame, int16_t x0, int16_t x1, int16_t y0, int16_t y1)
+    {
+        int16_t w = x1 - x0 + 1;
+
+        tft.dmaWait();
+        tft.setAddrWindow(x0, y0, w, y1 - y0);
+
+        for (int16_t y = y0; y < y1; y++) {
+            uint16_t *line = lineBufs[bufIdx];
+
+            decodeSpan(frame, y, x0, x1, line);
+
+            // The other buffer may still be in flight
+            tft.writePixels(line, w, false, true);
+            bufIdx ^= 1;
+        }
+
+        stats.rects++;
+        stats.pixels += (uint32_t)w * (y1 - y0);
+    }
+
+    void decodeSpan(const RleFrame *frame, int16_t y, int16_t x0, int16_t x1, uint16_t *line)
+    {
+        RowCursor cur;
+
+        openRow(frame, y, x1 + 1, cur);
+        advance(cur, x0, x1 + 1);
+
+        int16_t x = x0;
+
+        while (x <= x1) {
+            int16_t next = min(cur.runEnd, (int16_t)(x1 + 1));
+            uint16_t color = colorAt(cur);
+            uint16_t swapped = (color << 8) | (color >> 8);
+
+            while (x < next) {
+                *line++ = swapped;
+                x++;
+            }
+
+            advance(cur, x, x1 + 1);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,12 @@
+// Generated by scripts/gen_frames.py from frames/: do not edit
+
+#ifndef FRAME_SEQUENCES_H
+#define FRAME_SEQUENCES_H
+
+#include <Arduino.h>
+#include "FrameRenderer.h"
+
+const uint8_t FRAME_SEQUENCES_NUM = 0;
+const RleSequence *const FRAME_SEQUENCES = NULL;
+
+#endif
@@ -0,0 +1,223 @@
+"""
+Generates include/FrameSequences.h from the BMP frames in frames/.
+
+Each sequence is a directory of 24 or 32-bit uncompressed BMPs, drawn in
+file name order:
+
+    frames/seq01/000.bmp
+    frames/seq01/001.bmp
+
+Frames are converted to RGB565 and run-length encoded row by row, so a
+run never crosses a row and the sketch can decode any horizontal span of
+a frame without touching the rest. The runs are stored in the internal
+flash of the board together with the index of the first run of each row.
+
+Pixels outside a frame are black, the same as a cleared screen.
+
+Each run takes 4 bytes (length and color), plus 4 bytes per row for the
+index. This only pays off on flat artwork: a run must cover 2 pixels to
+break even with raw RGB565. Photographs, gradients and dithered images
+encode to more than their raw size (a noisy 480x320 frame takes about
+600 KB), and even a single one does not fit. Frames larger than raw are
+reported. If the data does not fit in MAX_DATA_BYTES, the build fails.
+Such sequences belong on the card, where the sketch draws the BMPs with
+its own dirty tracking.
+
+Runs before every PlatformIO build (extra_scripts = pre:...). It can also
+be run by hand. Without a frames/ directory the header has no sequences
+and the sketch plays the BMPs from the microSD card of the FeatherWing.
+"""
+
+import os
+import struct
+
+FRAME_MS = 100
+MAX_WIDTH = 480
+MAX_HEIGHT = 320
+MAX_RUN = 0xFFFF
+# Leaves room for the sketch in the 512 KB of the Feather M4
+MAX_DATA_BYTES = 400 * 1024
+
+
+def read_bmp(path):
+    with open(path, "rb") as fh:
+        data = fh.read()
+
+    if data[:2] != b"BM":
+        raise ValueError("{} is not a BMP".format(path))
+
+    offset = struct.unpack_from("<I", data, 10)[0]
+    width, height, _, depth, compression = struct.unpack_from("<iiHHI", data, 18)
+
+    if depth not in (24, 32) or compression not in (0, 3):
+        raise ValueError("{}: only uncompressed 24/32-bit BMPs are supported".format(path))
+
+    top_down = height < 0
+    height = abs(height)
+
+    if width > MAX_WIDTH or height > MAX_HEIGHT:
+        raise ValueError("{}: {}x{} is larger than the panel".format(path, width, height))
+
+    stride = (width * depth // 8 + 3) & ~3
+    step = depth // 8
+    rows = []
+
+    for y in range(height):
+        src = y if top_down else height - 1 - y
+        start = offset + src * stride
+        row = []
+
+        for x in range(width):
+            b, g, r = data[start + x * step:start + x * step + 3]
+            row.append(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3))
+
+        rows.append(row)
+
+    return width, height, rows
+
+
+def encode_rows(rows):
+    row_index = []
+    runs = []
+
+    for row in rows:
+        row_index.append(len(runs))
+        x = 0
+
+        while x < len(row):
+            color = row[x]
+            length = 1
+
+            while x + length < len(row) and row[x + length] == color and length < MAX_RUN:
+                length += 1
+
+            runs.append((length, color))
+            x += length
+
+    row_index.append(len(runs))
+
+    return row_index, runs
+
+
+def read_sequences(frames_dir):
+    sequences = []
+
+    if not os.path.isdir(frames_dir):
+        return sequences
+
+    for name in sorted(os.listdir(frames_dir)):
+        seq_dir = os.path.join(frames_dir, name)
+
+        if not os.path.isdir(seq_dir):
+            continue
+
+        files = sorted(f for f in os.listdir(seq_dir) if f.lower().endswith(".bmp"))
+
+        if not files:
+            continue
+
+        frames = []
+
+        for file_name in files:
+            width, height, rows = read_bmp(os.path.join(seq_dir, file_name))
+            row_index, runs = encode_rows(rows)
+            frames.append((width, height, row_index, runs))
+
+            encoded = len(row_index) * 4 + len(runs) * 4
+            raw = width * height * 2
+
+            if encoded > raw:
+                print("Warning: {}/{} encodes to {} bytes, raw is {}: "
+                      "not suitable for run-length encoding".format(name, file_name, encoded, raw))
+
+        sequences.append((name, frames))
+
+    return sequences
+
+
+def ident(name):
+    return "".join(c if c.isalnum() else "_" for c in name).upper()
+
+
+def wrap(items, per_line):
+    return ["    " + ", ".join(items[i:i + per_line]) + "," for i in range(0, len(items), per_line)]
+
+
+def render_header(sequences):
+    lines = [
+        "// Generated by scripts/gen_frames.py from frames/: do not edit",
+        "",
+        "#ifndef FRAME_SEQUENCES_H",
+        "#define FRAME_SEQUENCES_H",
+        "",
+        "#include <Arduino.h>",
+        "#include \"FrameRenderer.h\"",
+        "",
+    ]
+
+    total = 0
+
+    for name, frames in sequences:
+        for f, (width, height, row_index, runs) in enumerate(frames):
+            prefix = "FRAME_{}_{}".format(ident(name), f)
+            total += len(row_index) * 4 + len(runs) * 4
+
+            lines.append("const uint32_t {}_ROWS[] = {{".format(prefix))
+            lines += wrap([str(i) for i in row_index], 12)
+            lines += ["};", ""]
+            lines.append("const RleRun {}_RUNS[] = {{".format(prefix))
+            lines += wrap(["{{{}, 0x{:04X}}}".format(length, color) for length, color in runs], 6)
+            lines += ["};", ""]
+
+        lines.append("const RleFrame FRAMES_{}[] = {{".format(ident(name)))
+
+        for f, (width, height, _, _) in enumerate(frames):
+            prefix = "FRAME_{}_{}".format(ident(name), f)
+            lines.append("    {{{}, {}, {}_ROWS, {}_RUNS}},".format(width, height, prefix, prefix))
+
+        lines += ["};", ""]
+
+    if total > MAX_DATA_BYTES:
+        raise ValueError("Encoded frames take {} bytes (max {})".format(total, MAX_DATA_BYTES))
+
+    lines.append("const uint8_t FRAME_SEQUENCES_NUM = {};".format(len(sequences)))
+
+    if sequences:
+        lines.append("")
+        lines.append("const RleSequence FRAME_SEQUENCES_DATA[FRAME_SEQUENCES_NUM] = {")
+        lines += [
+            "    {{\"{}\", FRAMES_{}, {}, {}}},".format(name, ident(name), len(frames), FRAME_MS)
+            for name, frames in sequences
+        ]
+        lines += ["};", "", "const RleSequence *const FRAME_SEQUENCES = FRAME_SEQUENCES_DATA;"]
+    else:
+        lines.append("const RleSequence *const FRAME_SEQUENCES = NULL;")
+
+    lines += ["", "#endif", ""]
+
+    return "\n".join(lines), total
+
+
+def generate(project_dir):
+    frames_dir = os.path.join(project_dir, "frames")
+    header_path = os.path.join(project_dir, "include", "FrameSequences.h")
+    sequences = read_sequences(frames_dir)
+    content, total = render_header(sequences)
+
+    if os.path.exists(header_path):
+        with open(header_path) as fh:
+            if fh.read() == content:
+                return
+
+    with open(header_path, "w") as fh:
+        fh.write(content)
+
+    print("Generated {} ({} sequences, {} bytes)".format(header_path, len(sequences), total))
+
+
+try:
+    Import("env")
+    generate(env.subst("$PROJECT_DIR"))
+except NameError:
+    if __name__ == "__main__":
+        generate(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
@@ -1,7 +1,22 @@
 #include <FeatherWingTFT35.h>
+#include <SdFat.h>
 #include <SerialRFID.h>
+#include "BmpFrameRenderer.h"
+#include "FrameRenderer.h"
+#include "FrameSequences.h"
 
 FeatherWingTFT35 tftWing;
+FrameRenderer<Adafruit_HX8357> frameRenderer(tftWing.tft);
+BmpFrameRenderer<Adafruit_HX8357> bmpRenderer(tftWing.tft);
+
+// microSD slot of the FeatherWing: sequences are read from
+// /<sequence>/000.bmp, /<sequence>/001.bmp... (the layout of frames/)
+const uint8_t SD_CS_PIN = 5;
+const uint16_t BMP_FRAME_MS = 100;
+const uint8_t BMP_MAX_FRAMES = 100;
+
+SdFat sd;
+bool isSdReady = false;
 SerialRFID rfid(Serial1);
 char tagBuf[SIZE_TAG_ID];
 const int NUM_TAGS = 3;
@@ -38,6 +53,86 @@ int getCurrentTagIndex()
     return -1;
 }
 
+const RleSequence *findFrameSequence(const String &name)
+{
+    for (uint8_t i = 0; i < FRAME_SEQUENCES_NUM; i++) {
+        if (name.equals(FRAME_SEQUENCES[i].name)) {
+            return &FRAME_SEQUENCES[i];
+        }
+    }
+
+    return NULL;
+}
+
+void printFrameStats(uint8_t idx, const FrameStats &stats)
+{
+    Serial.print(F("Frame #"));
+    Serial.print(idx);
+    Serial.print(F(" :: Render (us): "));
+    Serial.print(stats.renderUs);
+    Serial.print(F(" :: Rects: "));
+    Serial.print(stats.rects);
+    Serial.print(F(" :: Pixels: "));
+    Serial.println(stats.pixels);
+}
+
+/**
+ * Plays a pre-encoded sequence from flash, only repainting the pixels
+ * that differ from what is on the panel.
+ */
+void playFrameSequence(const RleSequence *sequence)
+{
+    for (uint8_t i = 0; i < sequence->numFrames; i++) {
+        unsigned long start = millis();
+
+        frameRenderer.draw(&sequence->frames[i]);
+        printFrameStats(i, frameRenderer.getStats());
+
+        while (i + 1 < sequence->numFrames && millis() - start < sequence->frameMs) {
+            delay(1);
+        }
+    }
+}
+
+/**
+ * Plays a sequence of BMPs from the card, only repainting the rows and
+ * segments that differ from what is on the panel.
+ * Returns false if the card has no such sequence.
+ */
+bool playBmpSequence(const String &name)
+{
+    char path[24];
+    uint8_t i = 0;
+
+    for (; i < BMP_MAX_FRAMES; i++) {
+        snprintf(path, sizeof(path), "/%s/%03u.bmp", name.c_str(), i);
+
+        unsigned long start = millis();
+        File file = sd.open(path, O_RDONLY);
+
+        if (!file) {
+            break;
+        }
+
+        bool isDrawn = bmpRenderer.draw(file);
+        file.close();
+
+        if (!isDrawn) {
+            Serial.print(F("Unsupported BMP: "));
+            Serial.println(path);
+            break;
+        }
+
+        printFrameStats(i, bmpRenderer.getStats());
+
+        while (millis() - start < BMP_FRAME_MS) {
+            delay(1);
+        }
+    }
+
+    return i > 0;
+}
+
 void drawTagSequence()
 {
     int tagIdx = getCurrentTagIndex();
@@ -49,7 +144,29 @@ void drawTagSequence()
     Serial.print(F("Drawing sequence "));
     Serial.println(sequenceNames[tagIdx]);
 
+    const RleSequence *sequence = findFrameSequence(sequenceNames[tagIdx]);
+
+    if (sequence != NULL) {
+        playFrameSequence(sequence);
+        bmpRenderer.invalidate();
+        return;
+    }
+
+    if (isSdReady && playBmpSequence(sequenceNames[tagIdx])) {
+        frameRenderer.invalidate();
+        return;
+    }
+
+    // Neither pre-encoded nor on the card: draw the BMPs with the
+    // FeatherWing library and forget what is on the panel
+    unsigned long start = millis();
+
     tftWing.drawSequence(sequenceNames[tagIdx]);
+    frameRenderer.invalidate();
+    bmpRenderer.invalidate();
+
+    Serial.print(F("Render BMP (ms): "));
+    Serial.println(millis() - start);
 }
 
 void setup(void)
@@ -64,7 +181,13 @@ void setup(void)
         }
     }
 
-    tftWing.tft.fillScreen(0);
+    frameRenderer.clear();
+
+    isSdReady = sd.begin(SD_CS_PIN);
+
+    if (!isSdReady) {
+        Serial.println(F("SD failed or not found"));
+    }
 
     Serial.println(F(">> Starting scanner"));
 }
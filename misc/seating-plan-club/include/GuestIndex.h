@@ -0,0 +1,128 @@
+// Generated by scripts/gen_guest_index.py from guests.csv: do not edit
+
+#ifndef GUEST_INDEX_H
+#define GUEST_INDEX_H
+
+#include <Arduino.h>
+
+const uint16_t GUEST_INDEX_NUM = 55;
+const uint8_t GUEST_INDEX_ROUNDS = 4;
+
+// Sorted 40-bit tag IDs
+const uint8_t GUEST_INDEX_IDS[GUEST_INDEX_NUM][5] PROGMEM = {
+    {0x3F, 0x00, 0xFB, 0x08, 0xBB},
+    {0x4B, 0x00, 0xF4, 0x45, 0xC3},
+    {0x4B, 0x00, 0xF4, 0x54, 0x3B},
+    {0x4B, 0x00, 0xF4, 0x63, 0x4D},
+    {0x4B, 0x00, 0xF8, 0x1A, 0x94},
+    {0x4B, 0x00, 0xFD, 0x83, 0x96},
+    {0x4C, 0x00, 0x34, 0x87, 0xC2},
+    {0x4C, 0x00, 0x35, 0x5B, 0x40},
+    {0x4C, 0x00, 0x35, 0x6A, 0x31},
+    {0x4C, 0x00, 0x35, 0xB5, 0x72},
+    {0x4C, 0x00, 0x35, 0xC5, 0x41},
+    {0x4C, 0x00, 0x36, 0x4B, 0xC3},
+    {0x4C, 0x00, 0x36, 0x8E, 0x8C},
+    {0x4C, 0x00, 0x36, 0xB1, 0x9B},
+    {0x4C, 0x00, 0x37, 0x0E, 0x65},
+    {0x4C, 0x00, 0x37, 0x16, 0xAB},
+    {0x4C, 0x00, 0x70, 0x71, 0x68},
+    {0x4C, 0x00, 0x70, 0xE8, 0x49},
+    {0x4C, 0x00, 0x9C, 0x1C, 0xC9},
+    {0x4C, 0x00, 0x9C, 0x1C, 0xCB},
+    {0x4C, 0x00, 0x9C, 0x87, 0xF9},
+    {0x4C, 0x00, 0x9C, 0x87, 0xFA},
+    {0x4C, 0x00, 0x9C, 0xB4, 0x7C},
+    {0x4C, 0x00, 0x9C, 0xB8, 0x81},
+    {0x4C, 0x00, 0xA0, 0x8D, 0x2C},
+    {0x4C, 0x00, 0xA0, 0xD1, 0xAD},
+    {0x4C, 0x00, 0xA1, 0x1D, 0xD1},
+    {0x4C, 0x00, 0xA1, 0x1D, 0xF5},
+    {0x4C, 0x00, 0xE1, 0x54, 0x7F},
+    {0x4C, 0x00, 0xE1, 0x56, 0x68},
+    {0x4C, 0x00, 0xE2, 0xF7, 0xA2},
+    {0x4D, 0x00, 0x9D, 0xDA, 0x97},
+    {0x4D, 0x00, 0x9D, 0xE5, 0xCE},
+    {0x4D, 0x00, 0x9E, 0x1C, 0x52},
+    {0x4D, 0x00, 0x9E, 0x97, 0xF2},
+    {0x4D, 0x00, 0x9E, 0xAD, 0xC4},
+    {0x4D, 0x00, 0x9E, 0xC6, 0x5A},
+    {0x4D, 0x00, 0xA3, 0xD0, 0x16},
+    {0x4D, 0x00, 0xA4, 0x27, 0x8A},
+    {0x4D, 0x00, 0xC7, 0x35, 0xE1},
+    {0x4D, 0x00, 0xC7, 0x42, 0xA1},
+    {0x4D, 0x00, 0xC7, 0x65, 0xE8},
+    {0x4D, 0x00, 0xC7, 0xB0, 0x62},
+    {0x4D, 0x00, 0xC7, 0xDE, 0x04},
+    {0x4D, 0x00, 0xC7, 0xE4, 0x0D},
+    {0x4D, 0x00, 0xC7, 0xFE, 0xB7},
+    {0x4D, 0x00, 0xC8, 0x0C, 0x9A},
+    {0x4D, 0x00, 0xC8, 0x1C, 0x7A},
+    {0x4D, 0x00, 0xC8, 0x1E, 0x22},
+    {0x4D, 0x00, 0xC8, 0x27, 0x8F},
+    {0x4D, 0x00, 0xC8, 0x31, 0xA7},
+    {0x4D, 0x00, 0xC8, 0x40, 0x5E},
+    {0x4D, 0x00, 0xC8, 0x56, 0xE9},
+    {0x4D, 0x00, 0xD0, 0xE1, 0x25},
+    {0x4D, 0x00, 0xDB, 0xD0, 0xC4},
+};
+
+const uint8_t GUEST_INDEX_TABLES[GUEST_INDEX_NUM][GUEST_INDEX_ROUNDS] PROGMEM = {
+    {1, 2, 2, 1},
+    {2, 4, 0, 0},
+    {3, 2, 1, 4},
+    {1, 4, 2, 0},
+    {1, 1, 3, 2},
+    {3, 0, 4, 1},
+    {0, 2, 4, 3},
+    {2, 4, 1, 1},
+    {3, 2, 0, 0},
+    {4, 1, 0, 4},
+    {0, 4, 0, 2},
+    {2, 3, 0, 4},
+    {3, 4, 0, 1},
+    {0, 0, 0, 1},
+    {2, 0, 0, 3},
+    {4, 2, 1, 3},
+    {0, 4, 2, 3},
+    {2, 0, 1, 4},
+    {1, 0, 4, 2},
+    {1, 1, 4, 1},
+    {4, 1, 4, 2},
+    {2, 3, 4, 2},
+    {0, 3, 2, 2},
+    {0, 0, 1, 3},
+    {3, 1, 3, 3},
+    {1, 1, 1, 0},
+    {3, 3, 1, 1},
+    {4, 0, 3, 4},
+    {3, 0, 2, 2},
+    {1, 0, 0, 0},
+    {2, 4, 3, 2},
+    {0, 0, 3, 0},
+    {3, 2, 3, 2},
+    {4, 2, 4, 4},
+    {0, 2, 0, 4},
+    {2, 2, 3, 1},
+    {1, 3, 4, 4},
+    {2, 1, 4, 4},
+    {3, 1, 4, 0},
+    {3, 4, 2, 4},
+    {3, 3, 2, 3},
+    {0, 1, 2, 4},
+    {2, 3, 3, 0},
+    {4, 3, 2, 0},
+    {2, 1, 2, 3},
+    {1, 3, 1, 3},
+    {4, 0, 4, 3},
+    {1, 3, 3, 1},
+    {4, 4, 1, 2},
+    {0, 1, 1, 1},
+    {4, 3, 3, 2},
+    {1, 2, 3, 0},
+    {4, 4, 2, 1},
+    {4, 4, 0, 3},
+    {0, 2, 1, 0},
+};
+
+#endif
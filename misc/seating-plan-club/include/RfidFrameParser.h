@@ -0,0 +1,288 @@
+#ifndef RFID_FRAME_PARSER_H
+#define RFID_FRAME_PARSER_H
+
+#include <Arduino.h>
+
+/**
+ * Byte-at-a-time parser for RDM630 / ID-12 125 kHz RFID frames.
+ *
+ * RDM630: STX, 10 hex data chars, 2 hex checksum chars, ETX (14 bytes).
+ * ID-12 sends CR LF before ETX; those are skipped.
+ *
+ * Each byte costs a constant amount of work and nothing is allocated, so
+ * feed() can be driven from a serial drain loop or from an RX interrupt.
+ * A frame is accepted only when the checksum (XOR of the five data bytes)
+ * matches. The tag ID is packed into five bytes, most significant first,
+ * so memcmp() order is numeric order.
+ */
+
+const uint8_t RFID_TAG_ID_SIZE = 5;
+
+const uint8_t RFID_CHAR_STX = 0x02;
+const uint8_t RFID_CHAR_ETX = 0x03;
+const uint8_t RFID_CHAR_CR = 0x0D;
+const uint8_t RFID_CHAR_LF = 0x0A;
+
+const uint8_t RFID_FRAME_NIBBLES = (RFID_TAG_ID_SIZE + 1) * 2;
+
+typedef struct rfidTagId
+{
+    uint8_t bytes[RFID_TAG_ID_SIZE];
+} RfidTagId;
+
+/**
+ * Value of a hex char, or -1.
+ */
+inline int8_t rfidHexNibble(uint8_t c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+
+    return -1;
+}
+
+class RfidFrameParser
+{
+public:
+    RfidFrameParser()
+        : state(STATE_IDLE),
+          nibbles(0),
+          checksum(0),
+          lastFrameMillis(0),
+          hasFrame(false),
+          errors(0)
+    {
+    }
+
+    void reset()
+    {
+        state = STATE_IDLE;
+        hasFrame = false;
+    }
+
+    /**
+     * Consumes one byte. Returns true when it completes a valid frame.
+     */
+    bool feed(uint8_t c)
+    {
+        if (c == RFID_CHAR_STX)
+        {
+            if (state != STATE_IDLE)
+            {
+                errors++;
+            }
+
+            state = STATE_BODY;
+            nibbles = 0;
+            checksum = 0;
+            return false;
+        }
+
+        if (state == STATE_BODY)
+        {
+            int8_t nibble = rfidHexNibble(c);
+
+            if (nibble < 0)
+            {
+                fail();
+                return false;
+            }
+
+            uint8_t idx = nibbles >> 1;
+
+            if ((nibbles & 1) == 0)
+            {
+                pending[idx] = nibble << 4;
+            }
+            else
+            {
+                pending[idx] |= nibble;
+                checksum ^= pending[idx];
+            }
+
+            if (++nibbles == RFID_FRAME_NIBBLES)
+            {
+                state = STATE_TAIL;
+            }
+
+            return false;
+        }
+
+        if (state == STATE_TAIL)
+        {
+            if (c == RFID_CHAR_CR || c == RFID_CHAR_LF)
+            {
+                return false;
+            }
+
+            // The checksum byte is XORed in too, so a valid frame gives 0
+            if (c != RFID_CHAR_ETX || checksum != 0)
+            {
+                fail();
+                return false;
+            }
+
+            memcpy(tagId.bytes, pending, RFID_TAG_ID_SIZE);
+            lastFrameMillis = millis();
+            hasFrame = true;
+            state = STATE_IDLE;
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * Drains every byte available on the stream.
+     * Returns true if at least one valid frame was completed.
+     */
+    bool poll(Stream &stream)
+    {
+        bool completed = false;
+
+        while (stream.available() > 0)
+        {
+            completed |= feed(stream.read());
+        }
+
+        return completed;
+    }
+
+    const RfidTagId &tag() const
+    {
+        return tagId;
+    }
+
+    /**
+     * Readers resend the frame while a tag stays in the field, so a tag
+     * is present while frames keep arriving within the timeout.
+     */
+    bool isTagPresent(unsigned long timeoutMs) const
+    {
+        return hasFrame && (millis() - lastFrameMillis) <= timeoutMs;
+    }
+
+    uint16_t getErrors() const
+    {
+        return errors;
+    }
+
+private:
+    static const uint8_t STATE_IDLE = 0;
+    static const uint8_t STATE_BODY = 1;
+    static const uint8_t STATE_TAIL = 2;
+
+    uint8_t state;
+    uint8_t nibbles;
+    uint8_t checksum;
+    uint8_t pending[RFID_TAG_ID_SIZE + 1];
+    RfidTagId tagId;
+    unsigned long lastFrameMillis;
+    bool hasFrame;
+    uint16_t errors;
+
+    void fail()
+    {
+        errors++;
+        state = STATE_IDLE;
+    }
+};
+
+/**
+ * Packs the first 10 hex chars of a tag ID given as text (e.g. by a
+ * reader library that returns a String) into tag. Returns false if the
+ * text is shorter or not hex.
+ */
+inline bool rfidParseTag(const char *hex, RfidTagId &tag)
+{
+    for (uint8_t i = 0; i < RFID_TAG_ID_SIZE * 2; i++)
+    {
+        int8_t nibble = rfidHexNibble(hex[i]);
+
+        if (nibble < 0)
+        {
+            return false;
+        }
+
+        if ((i & 1) == 0)
+        {
+            tag.bytes[i >> 1] = nibble << 4;
+        }
+        else
+        {
+            tag.bytes[i >> 1] |= nibble;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Binary search of a tag in a PROGMEM table sorted in ascending order.
+ * Returns the table index or -1.
+ */
+inline int rfidFindTag(
+    const RfidTagId &tag,
+    const uint8_t table[][RFID_TAG_ID_SIZE],
+    int size)
+{
+    int lo = 0;
+    int hi = size - 1;
+
+    while (lo <= hi)
+    {
+        int mid = (lo + hi) >> 1;
+        int cmp = memcmp_P(tag.bytes, table[mid], RFID_TAG_ID_SIZE);
+
+        if (cmp == 0)
+        {
+            return mid;
+        }
+
+        if (cmp > 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Compares a tag with a single PROGMEM entry.
+ */
+inline bool rfidIsTag(const RfidTagId &tag, const uint8_t *entry)
+{
+    return memcmp_P(tag.bytes, entry, RFID_TAG_ID_SIZE) == 0;
+}
+
+inline void rfidPrintTag(Print &out, const RfidTagId &tag)
+{
+    for (uint8_t i = 0; i < RFID_TAG_ID_SIZE; i++)
+    {
+        if (tag.bytes[i] < 0x10)
+        {
+            out.print('0');
+        }
+
+        out.print(tag.bytes[i], HEX);
+    }
+}
+
+#endif
@@ -0,0 +1,198 @@
+// Generated by scripts/gen_guest_index.py from guests.csv: do not edit
+
+#ifndef GUEST_INDEX_H
+#define GUEST_INDEX_H
+
+#include <Arduino.h>
+
+const uint16_t GUEST_INDEX_NUM = 90;
+const uint8_t GUEST_INDEX_ROUNDS = 1;
+
+// Sorted 40-bit tag IDs
+const uint8_t GUEST_INDEX_IDS[GUEST_INDEX_NUM][5] PROGMEM = {
+    {0x0A, 0x00, 0x53, 0x0A, 0x29},
+    {0x0A, 0x00, 0x53, 0x9F, 0x0E},
+    {0x0A, 0x00, 0x53, 0x9F, 0x36},
+    {0x0A, 0x00, 0x55, 0xD0, 0xC8},
+    {0x0A, 0x00, 0x59, 0xE9, 0x7E},
+    {0x0A, 0x00, 0x59, 0xEB, 0xEC},
+    {0x0A, 0x00, 0x5A, 0x9D, 0x2B},
+    {0x0B, 0x00, 0x26, 0x91, 0x58},
+    {0x0B, 0x00, 0x27, 0x5F, 0xDB},
+    {0x0B, 0x00, 0x27, 0xCF, 0x4A},
+    {0x0B, 0x00, 0x27, 0xDC, 0xE5},
+    {0x0B, 0x00, 0x29, 0x2E, 0xF5},
+    {0x0B, 0x00, 0x29, 0x53, 0x51},
+    {0x0B, 0x00, 0x29, 0x54, 0xAD},
+    {0x0B, 0x00, 0x29, 0x61, 0x84},
+    {0x0B, 0x00, 0x29, 0x88, 0x52},
+    {0x0B, 0x00, 0x2A, 0x2E, 0xAB},
+    {0x0C, 0x00, 0x7C, 0xD2, 0x03},
+    {0x0C, 0x00, 0x7C, 0xE3, 0x96},
+    {0x0C, 0x00, 0x7C, 0xE7, 0x7F},
+    {0x0C, 0x00, 0x7D, 0x08, 0x73},
+    {0x0C, 0x00, 0x7D, 0x1E, 0xA5},
+    {0x0C, 0x00, 0x7D, 0x43, 0xE7},
+    {0x0C, 0x00, 0x7D, 0x45, 0x03},
+    {0x0C, 0x00, 0x7D, 0x49, 0xBE},
+    {0x0C, 0x00, 0x7D, 0x5F, 0x5E},
+    {0x0C, 0x00, 0x7D, 0x78, 0x03},
+    {0x0C, 0x00, 0x7D, 0x7B, 0xDD},
+    {0x0C, 0x00, 0x7D, 0x8A, 0xBA},
+    {0x0C, 0x00, 0x7D, 0x9F, 0xBC},
+    {0x0C, 0x00, 0x7D, 0xBD, 0xAA},
+    {0x0C, 0x00, 0x7D, 0xC1, 0xCF},
+    {0x0C, 0x00, 0x7D, 0xCB, 0x57},
+    {0x0C, 0x00, 0x7D, 0xD6, 0x9C},
+    {0x0C, 0x00, 0x7D, 0xF0, 0xB9},
+    {0x0C, 0x00, 0x7D, 0xF7, 0x1D},
+    {0x0C, 0x00, 0x7E, 0x25, 0xDD},
+    {0x0C, 0x00, 0x7E, 0x2A, 0x21},
+    {0x3C, 0x00, 0x87, 0xF1, 0xCE},
+    {0x3C, 0x00, 0x87, 0xF2, 0x55},
+    {0x3C, 0x00, 0x87, 0xF6, 0x83},
+    {0x3C, 0x00, 0x88, 0x47, 0x5E},
+    {0x3C, 0x00, 0x88, 0xD7, 0xE8},
+    {0x3C, 0x00, 0x88, 0xDF, 0xF9},
+    {0x3C, 0x00, 0x89, 0x00, 0xF5},
+    {0x3C, 0x00, 0x89, 0x06, 0x13},
+    {0x3C, 0x00, 0x89, 0x19, 0xB0},
+    {0x3C, 0x00, 0x89, 0x1D, 0xE0},
+    {0x3C, 0x00, 0xD5, 0x27, 0x49},
+    {0x3C, 0x00, 0xD5, 0x2A, 0x1B},
+    {0x3C, 0x00, 0xD5, 0x2B, 0x2E},
+    {0x3C, 0x00, 0xD5, 0x2D, 0x9B},
+    {0x3C, 0x00, 0xD5, 0x30, 0xB0},
+    {0x3C, 0x00, 0xD5, 0x35, 0x57},
+    {0x3C, 0x00, 0xD5, 0x41, 0xB3},
+    {0x3C, 0x00, 0xD5, 0x45, 0x68},
+    {0x3C, 0x00, 0xD5, 0x49, 0x9F},
+    {0x3C, 0x00, 0xD5, 0x4B, 0x51},
+    {0x3C, 0x00, 0xD5, 0x4F, 0x74},
+    {0x3C, 0x00, 0xD5, 0x52, 0x29},
+    {0x3C, 0x00, 0xD5, 0x55, 0xEB},
+    {0x3C, 0x00, 0xD5, 0x5D, 0xAD},
+    {0x3C, 0x00, 0xD5, 0x5D, 0xB5},
+    {0x3C, 0x00, 0xD5, 0x5F, 0x7D},
+    {0x3C, 0x00, 0xD5, 0x61, 0xE5},
+    {0x3C, 0x00, 0xD5, 0x62, 0xA8},
+    {0x3C, 0x00, 0xD5, 0x62, 0xC4},
+    {0x3C, 0x00, 0xD5, 0x67, 0x06},
+    {0x3C, 0x00, 0xD5, 0x74, 0x9B},
+    {0x3C, 0x00, 0xD5, 0x95, 0x10},
+    {0x3C, 0x00, 0xD5, 0xA0, 0x0C},
+    {0x3C, 0x00, 0xD5, 0xA3, 0x03},
+    {0x3C, 0x00, 0xD5, 0xA8, 0x8D},
+    {0x3C, 0x00, 0xD5, 0xAA, 0x46},
+    {0x3C, 0x00, 0xD5, 0xAD, 0x57},
+    {0x3C, 0x00, 0xD5, 0xC9, 0x40},
+    {0x3C, 0x00, 0xD5, 0xD4, 0xA2},
+    {0x3C, 0x00, 0xD5, 0xD5, 0x5B},
+    {0x3C, 0x00, 0xD5, 0xE9, 0x8F},
+    {0x3C, 0x00, 0xD5, 0xF9, 0x4A},
+    {0x3C, 0x00, 0xD6, 0x07, 0x20},
+    {0x3C, 0x00, 0xD6, 0x11, 0xA5},
+    {0x3C, 0x00, 0xD6, 0x11, 0xE6},
+    {0x3C, 0x00, 0xD6, 0x26, 0x0E},
+    {0x3C, 0x00, 0xD6, 0x37, 0xED},
+    {0x3C, 0x00, 0xD6, 0x43, 0x16},
+    {0x3C, 0x00, 0xD6, 0x50, 0xB7},
+    {0x3C, 0x00, 0xD6, 0x53, 0xF2},
+    {0x3C, 0x00, 0xD6, 0x58, 0xB4},
+    {0x3D, 0x00, 0xD6, 0x43, 0x01},
+};
+
+const uint8_t GUEST_INDEX_TABLES[GUEST_INDEX_NUM][GUEST_INDEX_ROUNDS] PROGMEM = {
+    {5},
+    {2},
+    {2},
+    {4},
+    {8},
+    {9},
+    {3},
+    {6},
+    {3},
+    {6},
+    {3},
+    {5},
+    {5},
+    {5},
+    {5},
+    {2},
+    {3},
+    {10},
+    {1},
+    {1},
+    {4},
+    {9},
+    {10},
+    {8},
+    {10},
+    {8},
+    {3},
+    {4},
+    {4},
+    {10},
+    {6},
+    {10},
+    {4},
+    {4},
+    {8},
+    {10},
+    {7},
+    {6},
+    {4},
+    {8},
+    {7},
+    {3},
+    {4},
+    {7},
+    {7},
+    {7},
+    {7},
+    {7},
+    {9},
+    {2},
+    {1},
+    {6},
+    {9},
+    {2},
+    {9},
+    {2},
+    {4},
+    {0},
+    {3},
+    {2},
+    {1},
+    {2},
+    {2},
+    {8},
+    {9},
+    {5},
+    {4},
+    {4},
+    {6},
+    {8},
+    {8},
+    {5},
+    {2},
+    {10},
+    {9},
+    {10},
+    {1},
+    {4},
+    {10},
+    {2},
+    {5},
+    {1},
+    {0},
+    {4},
+    {9},
+    {1},
+    {5},
+    {8},
+    {6},
+    {6},
+};
+
+#endif
@@ -0,0 +1,445 @@
+#ifndef GUEST_TABLE_H
+#define GUEST_TABLE_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "RfidFrameParser.h"
+
+/**
+ * Guest to table lookup over a sorted, packed tag index.
+ *
+ * Records are a 40-bit tag ID followed by one table index per round. They
+ * are sorted by tag ID and found with a binary search. The built-in index
+ * lives in PROGMEM (see GuestIndex.h). An updated guest list uploaded over
+ * Serial is stored in EEPROM and replaces the built-in one until it is
+ * cleared, so a changed guest list does not need a reflash.
+ *
+ * Serial upload protocol (one command per line, every line is answered
+ * with OK or ERR):
+ *
+ *   BEGIN <count>
+ *   <tag hex> <table>[,<table>...]    (count lines, sorted by tag)
+ *   END <checksum>                    (XOR of all record bytes)
+ *   CLEAR                             (back to the built-in index)
+ *   STATUS
+ *
+ * The upload is only stored if the checksum matches the records received.
+ *
+ * EEPROM layout: 'G' 'T' rounds countLo countHi checksum, then records.
+ */
+
+const int16_t GUEST_NOT_FOUND = -1;
+
+const uint8_t GUEST_EEPROM_MAGIC_0 = 'G';
+const uint8_t GUEST_EEPROM_MAGIC_1 = 'T';
+const uint8_t GUEST_EEPROM_HEADER_SIZE = 6;
+const uint8_t GUEST_UPLOAD_LINE_SIZE = 48;
+
+class GuestTable
+{
+public:
+    GuestTable(
+        const uint8_t (*ids)[RFID_TAG_ID_SIZE],
+        const uint8_t *tables,
+        uint16_t num,
+        uint8_t rounds)
+        : ids(ids),
+          tables(tables),
+          numBuiltin(num),
+          rounds(rounds),
+          num(num),
+          isEeprom(false),
+          isUploading(false),
+          lineLen(0)
+    {
+    }
+
+    /**
+     * Switches to the EEPROM guest list if a valid one is stored.
+     */
+    void begin()
+    {
+        if (loadEeprom())
+        {
+            Serial.print(F("Guests from EEPROM: "));
+        }
+        else
+        {
+            Serial.print(F("Guests from PROGMEM: "));
+        }
+
+        Serial.println(num);
+    }
+
+    uint16_t size() const
+    {
+        return num;
+    }
+
+    bool isFromEeprom() const
+    {
+        return isEeprom;
+    }
+
+    int16_t find(const RfidTagId &tag)
+    {
+        int16_t lo = 0;
+        int16_t hi = num - 1;
+
+        while (lo <= hi)
+        {
+            int16_t mid = (lo + hi) >> 1;
+            int8_t cmp = compareId(tag.bytes, mid);
+
+            if (cmp == 0)
+            {
+                return mid;
+            }
+
+            if (cmp > 0)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid - 1;
+            }
+        }
+
+        return GUEST_NOT_FOUND;
+    }
+
+    uint8_t getTable(uint16_t idx, uint8_t round)
+    {
+        if (isEeprom)
+        {
+            return EEPROM.read(recordAddress(idx) + RFID_TAG_ID_SIZE + round);
+        }
+
+        return pgm_read_byte(&tables[idx * rounds + round]);
+    }
+
+    /**
+     * Consumes pending upload commands without blocking.
+     */
+    void pollUpload(Stream &stream)
+    {
+        while (stream.available() > 0)
+        {
+            char c = stream.read();
+
+            if (c == '\r')
+            {
+                continue;
+            }
+
+            if (c != '\n')
+            {
+                if (lineLen < GUEST_UPLOAD_LINE_SIZE - 1)
+                {
+                    line[lineLen++] = c;
+                }
+
+                continue;
+            }
+
+            line[lineLen] = '\0';
+
+            if (lineLen > 0)
+            {
+                handleLine(stream);
+            }
+
+            lineLen = 0;
+        }
+    }
+
+private:
+    const uint8_t (*ids)[RFID_TAG_ID_SIZE];
+    const uint8_t *tables;
+    uint16_t numBuiltin;
+    uint8_t rounds;
+    uint16_t num;
+    bool isEeprom;
+
+    bool isUploading;
+    uint16_t uploadExpected;
+    uint16_t uploadCount;
+    uint8_t uploadChecksum;
+    uint8_t uploadLastId[RFID_TAG_ID_SIZE];
+
+    char line[GUEST_UPLOAD_LINE_SIZE];
+    uint8_t lineLen;
+
+    uint8_t recordSize() const
+    {
+        return RFID_TAG_ID_SIZE + rounds;
+    }
+
+    int recordAddress(uint16_t idx) const
+    {
+        return GUEST_EEPROM_HEADER_SIZE + idx * recordSize();
+    }
+
+    uint16_t eepromCapacity() const
+    {
+        return (EEPROM.length() - GUEST_EEPROM_HEADER_SIZE) / recordSize();
+    }
+
+    int8_t compareId(const uint8_t *id, uint16_t idx)
+    {
+        for (uint8_t i = 0; i < RFID_TAG_ID_SIZE; i++)
+        {
+            uint8_t other = isEeprom
+                                ? EEPROM.read(recordAddress(idx) + i)
+                                : pgm_read_byte(&ids[idx][i]);
+
+            if (id[i] != other)
+            {
+                return id[i] > other ? 1 : -1;
+            }
+        }
+
+        return 0;
+    }
+
+    bool loadEeprom()
+    {
+        isEeprom = false;
+        num = numBuiltin;
+
+        if (EEPROM.read(0) != GUEST_EEPROM_MAGIC_0 ||
+            EEPROM.read(1) != GUEST_EEPROM_MAGIC_1 ||
+            EEPROM.read(2) != rounds)
+        {
+            return false;
+        }
+
+        uint16_t count = EEPROM.read(3) | (EEPROM.read(4) << 8);
+
+        if (count == 0 || count > eepromCapacity())
+        {
+            return false;
+        }
+
+        uint8_t checksum = 0;
+        int end = recordAddress(count);
+
+        for (int addr = GUEST_EEPROM_HEADER_SIZE; addr < end; addr++)
+        {
+            checksum ^= EEPROM.read(addr);
+        }
+
+        if (checksum != EEPROM.read(5))
+        {
+            return false;
+        }
+
+        num = count;
+        isEeprom = true;
+
+        return true;
+    }
+
+    void invalidateEeprom()
+    {
+        EEPROM.update(0, 0xFF);
+        isEeprom = false;
+        num = numBuiltin;
+    }
+
+    static int8_t hexNibble(char c)
+    {
+        if (c >= '0' && c <= '9')
+        {
+            return c - '0';
+        }
+
+        if (c >= 'A' && c <= 'F')
+        {
+            return c - 'A' + 10;
+        }
+
+        if (c >= 'a' && c <= 'f')
+        {
+            return c - 'a' + 10;
+        }
+
+        return -1;
+    }
+
+    /**
+     * Parses "<tag hex> <t>[,<t>...]" into a packed record.
+     */
+    bool parseRecord(uint8_t *record)
+    {
+        const char *p = line;
+
+        for (uint8_t i = 0; i < RFID_TAG_ID_SIZE; i++)
+        {
+            int8_t hi = hexNibble(p[0]);
+            int8_t lo = hi < 0 ? -1 : hexNibble(p[1]);
+
+            if (lo < 0)
+            {
+                return false;
+            }
+
+            record[i] = (hi << 4) | lo;
+            p += 2;
+        }
+
+        // Skip the checksum chars of a full 12-char tag ID
+        while (hexNibble(*p) >= 0)
+        {
+            p++;
+        }
+
+        for (uint8_t r = 0; r < rounds; r++)
+        {
+            if (*p != (r == 0 ? ' ' : ','))
+            {
+                return false;
+            }
+
+            p++;
+
+            if (*p < '0' || *p > '9')
+            {
+                return false;
+            }
+
+            uint16_t val = 0;
+
+            while (*p >= '0' && *p <= '9')
+            {
+                val = val * 10 + (*p - '0');
+                p++;
+            }
+
+            if (val > 0xFF)
+            {
+                return false;
+            }
+
+            record[RFID_TAG_ID_SIZE + r] = val;
+        }
+
+        return *p == '\0';
+    }
+
+    void reply(Stream &stream, bool ok, const __FlashStringHelper *msg)
+    {
+        stream.print(ok ? F("OK ") : F("ERR "));
+        stream.println(msg);
+    }
+
+    void abortUpload(Stream &stream, const __FlashStringHelper *msg)
+    {
+        isUploading = false;
+        reply(stream, false, msg);
+    }
+
+    void handleRecord(Stream &stream)
+    {
+        uint8_t record[RFID_TAG_ID_SIZE + 8];
+
+        if (rounds > 8 || !parseRecord(record))
+        {
+            abortUpload(stream, F("bad record"));
+            return;
+        }
+
+        if (uploadCount >= uploadExpected)
+        {
+            abortUpload(stream, F("too many records"));
+            return;
+        }
+
+        if (uploadCount > 0 &&
+            memcmp(record, uploadLastId, RFID_TAG_ID_SIZE) <= 0)
+        {
+            abortUpload(stream, F("records not sorted"));
+            return;
+        }
+
+        int addr = recordAddress(uploadCount);
+
+        for (uint8_t i = 0; i < recordSize(); i++)
+        {
+            EEPROM.update(addr + i, record[i]);
+            uploadChecksum ^= record[i];
+        }
+
+        memcpy(uploadLastId, record, RFID_TAG_ID_SIZE);
+        uploadCount++;
+        reply(stream, true, F("record"));
+    }
+
+    void handleLine(Stream &stream)
+    {
+        if (strncmp(line, "BEGIN ", 6) == 0)
+        {
+            long count = atol(line + 6);
+
+            if (count <= 0 || count > eepromCapacity())
+            {
+                reply(stream, false, F("bad count"));
+                return;
+            }
+
+            invalidateEeprom();
+            isUploading = true;
+            uploadExpected = count;
+            uploadCount = 0;
+            uploadChecksum = 0;
+            reply(stream, true, F("begin"));
+        }
+        else if (strncmp(line, "END", 3) == 0)
+        {
+            if (!isUploading || uploadCount != uploadExpected)
+            {
+                abortUpload(stream, F("incomplete upload"));
+                return;
+            }
+
+            if (line[3] != ' ' || atol(line + 4) != uploadChecksum)
+            {
+                abortUpload(stream, F("bad checksum"));
+                return;
+            }
+
+            isUploading = false;
+            EEPROM.update(2, rounds);
+            EEPROM.update(3, uploadCount & 0xFF);
+            EEPROM.update(4, uploadCount >> 8);
+            EEPROM.update(5, uploadChecksum);
+            EEPROM.update(1, GUEST_EEPROM_MAGIC_1);
+            EEPROM.update(0, GUEST_EEPROM_MAGIC_0);
+
+            reply(stream, loadEeprom(), F("end"));
+        }
+        else if (strcmp(line, "CLEAR") == 0)
+        {
+            isUploading = false;
+            invalidateEeprom();
+            reply(stream, true, F("clear"));
+        }
+        else if (strcmp(line, "STATUS") == 0)
+        {
+            stream.print(F("OK "));
+            stream.print(isEeprom ? F("eeprom ") : F("progmem "));
+            stream.println(num);
+        }
+        else if (isUploading)
+        {
+            handleRecord(stream);
+        }
+        else
+        {
+            reply(stream, false, F("unknown command"));
+        }
+    }
+};
+
+#endif
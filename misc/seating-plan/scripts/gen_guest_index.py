@@ -0,0 +1,172 @@
+"""
+Generates include/GuestIndex.h from guests.csv.
+
+Each CSV row is a tag ID followed by one table index per round:
+
+    3C00D54B51F3,0
+
+Only the first 10 hex chars of the tag ID (the 40-bit tag) are kept.
+The rows are sorted by tag so the sketch can binary search them.
+
+Runs before every PlatformIO build (extra_scripts = pre:...). It can also
+be run by hand. Pass --upload to send the same table to the EEPROM of a
+running board over Serial (see GuestTable.h). Each line waits for its OK,
+as EEPROM writes are slower than the serial line. Needs pyserial, which
+ships with PlatformIO:
+
+    python scripts/gen_guest_index.py --upload /dev/ttyUSB0
+"""
+
+import csv
+import os
+import sys
+import time
+
+TAG_ID_HEX_LEN = 10
+UPLOAD_BAUD = 9600
+UPLOAD_BANNER = ">> Seating plan"
+UPLOAD_TIMEOUT_S = 15
+
+
+def read_guests(csv_path):
+    guests = []
+
+    with open(csv_path) as fh:
+        for row in csv.reader(fh):
+            row = [col.strip() for col in row if col.strip()]
+
+            if not row or row[0].startswith("#"):
+                continue
+
+            tag = row[0].upper()[:TAG_ID_HEX_LEN]
+            int(tag, 16)
+            tables = [int(col) for col in row[1:]]
+            guests.append((tag, tables))
+
+    if not guests:
+        raise ValueError("No guests in {}".format(csv_path))
+
+    rounds = len(guests[0][1])
+
+    for tag, tables in guests:
+        if len(tables) != rounds:
+            raise ValueError("Tag {} has {} tables, expected {}".format(tag, len(tables), rounds))
+
+    guests.sort(key=lambda item: item[0])
+
+    for prev, curr in zip(guests, guests[1:]):
+        if prev[0] == curr[0]:
+            raise ValueError("Duplicate tag {}".format(curr[0]))
+
+    return guests, rounds
+
+
+def tag_bytes(tag):
+    return ", ".join("0x" + tag[i:i + 2] for i in range(0, TAG_ID_HEX_LEN, 2))
+
+
+def render_header(guests, rounds):
+    lines = [
+        "// Generated by scripts/gen_guest_index.py from guests.csv: do not edit",
+        "",
+        "#ifndef GUEST_INDEX_H",
+        "#define GUEST_INDEX_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "const uint16_t GUEST_INDEX_NUM = {};".format(len(guests)),
+        "const uint8_t GUEST_INDEX_ROUNDS = {};".format(rounds),
+        "",
+        "// Sorted 40-bit tag IDs",
+        "const uint8_t GUEST_INDEX_IDS[GUEST_INDEX_NUM][5] PROGMEM = {",
+    ]
+
+    lines += ["    {{{}}},".format(tag_bytes(tag)) for tag, _ in guests]
+    lines += [
+        "};",
+        "",
+        "const uint8_t GUEST_INDEX_TABLES[GUEST_INDEX_NUM][GUEST_INDEX_ROUNDS] PROGMEM = {",
+    ]
+    lines += ["    {{{}}},".format(", ".join(str(t) for t in tables)) for _, tables in guests]
+    lines += ["};", "", "#endif", ""]
+
+    return "\n".join(lines)
+
+
+def upload_checksum(guests):
+    checksum = 0
+
+    for tag, tables in guests:
+        for byte in bytes.fromhex(tag) + bytes(tables):
+            checksum ^= byte
+
+    return checksum
+
+
+def render_upload(guests):
+    lines = ["BEGIN {}".format(len(guests))]
+    lines += ["{} {}".format(tag, ",".join(str(t) for t in tables)) for tag, tables in guests]
+    lines += ["END {}".format(upload_checksum(guests))]
+
+    return lines
+
+
+def read_reply(port, prefixes):
+    deadline = time.time() + UPLOAD_TIMEOUT_S
+
+    while time.time() < deadline:
+        line = port.readline().decode("ascii", "replace").strip()
+
+        if line.startswith(prefixes):
+            return line
+
+    raise IOError("Timeout waiting for {}".format(prefixes))
+
+
+def upload(project_dir, port_name):
+    import serial
+
+    guests = read_guests(os.path.join(project_dir, "guests.csv"))[0]
+
+    # Opening the port resets the board: wait for the end of setup()
+    with serial.Serial(port_name, UPLOAD_BAUD, timeout=1) as port:
+        read_reply(port, (UPLOAD_BANNER,))
+
+        for line in render_upload(guests):
+            port.write((line + "\n").encode("ascii"))
+            reply = read_reply(port, ("OK", "ERR"))
+
+            if not reply.startswith("OK"):
+                raise IOError("{} -> {}".format(line, reply))
+
+    print("Uploaded {} guests to {}".format(len(guests), port_name))
+
+
+def generate(project_dir):
+    csv_path = os.path.join(project_dir, "guests.csv")
+    header_path = os.path.join(project_dir, "include", "GuestIndex.h")
+    guests, rounds = read_guests(csv_path)
+    content = render_header(guests, rounds)
+
+    if os.path.exists(header_path):
+        with open(header_path) as fh:
+            if fh.read() == content:
+                return
+
+    with open(header_path, "w") as fh:
+        fh.write(content)
+
+    print("Generated {} ({} guests)".format(header_path, len(guests)))
+
+
+try:
+    Import("env")
+    generate(env.subst("$PROJECT_DIR"))
+except NameError:
+    if __name__ == "__main__":
+        project_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+        if len(sys.argv) == 3 and sys.argv[1] == "--upload":
+            upload(project_dir, sys.argv[2])
+        else:
+            generate(project_dir)
@@ -1,22 +1,33 @@
 #include <Adafruit_NeoPixel.h>
-#include <SerialRFID.h>
 #include <SoftwareSerial.h>
+#include "RfidFrameParser.h"
+#include "GuestIndex.h"
+#include "GuestTable.h"
+#include "AudioFxScheduler.h"
 
 const uint8_t PIN_AUDIO_RST = 6;
 const uint8_t PIN_AUDIO_ACT = 7;
 const uint8_t PIN_AUDIO_TRACK_GUEST = 8;
 const uint8_t PIN_AUDIO_TRACK_HOSTS = 9;
+const uint16_t AUDIO_PLAY_DELAY_MS = 200;
+
+AudioFxScheduler audio(PIN_AUDIO_ACT, AUDIO_PLAY_DELAY_MS);
 
 const uint8_t RFID_PIN_RX = 2;
 const uint8_t RFID_PIN_TX = 3;
 
 SoftwareSerial rfidSoftSerial = SoftwareSerial(RFID_PIN_RX, RFID_PIN_TX);
-SerialRFID rfidReader = SerialRFID(rfidSoftSerial);
+RfidFrameParser rfidParser;
+
+GuestTable guestTable(
+    GUEST_INDEX_IDS,
+    &GUEST_INDEX_TABLES[0][0],
+    GUEST_INDEX_NUM,
+    GUEST_INDEX_ROUNDS);
 
 const int16_t TAG_NOT_FOUND = -1;
 const int16_t TAG_UNKNOWN = -2;
 
-const uint8_t NUM_GUESTS = 90;
 const uint8_t NUM_TABLES = 11;
 
 const uint8_t HOSTS_TABLE_IDX = 0;
@@ -33,139 +44,15 @@ const uint16_t EFFECT_ITER_MS = 200;
 const uint32_t EFFECT_COLOR_RANDOM = Adafruit_NeoPixel::Color(150, 150, 150);
 const uint32_t EFFECT_COLOR_FINAL = Adafruit_NeoPixel::Color(0, 240, 0);
 
-struct GuestTag
-{
-  char tagId[SIZE_TAG_ID];
-  uint8_t tableIdx;
-};
-
-GuestTag GUEST_TAGS[NUM_GUESTS] = {
-    {"3C00D54B51F3", 0},
-    {"3C00D611E61D", 0},
-    {"0C007CE39605", 1},
-    {"3C00D5D4A29F", 1},
-    {"3C00D611A55E", 1},
-    {"0C007CE77FE8", 1},
-    {"3C00D555EB57", 1},
-    {"3C00D52B2EEC", 1},
-    {"3C00D64316BF", 1},
-    {"3C00D5522992", 2},
-    {"3C00D54568C4", 2},
-    {"0A00539F36F0", 2},
-    {"3C00D55DB501", 2},
-    {"3C00D55DAD19", 2},
-    {"3C00D5A88DCC", 2},
-    {"3C00D52A1BD8", 2},
-    {"3C00D535578B", 2},
-    {"0A00539F0EC8", 2},
-    {"3C00D5F94A5A", 2},
-    {"0B00298852F8", 2},
-    {"0A005A9D2BE6", 3},
-    {"3C0088475EAD", 3},
-    {"0C007D78030A", 3},
-    {"3C00D54F74D2", 3},
-    {"0B002A2EABA4", 3},
-    {"0B0027DCE515", 3},
-    {"0B00275FDBA8", 3},
-    {"3C0088D7E88B", 4},
-    {"3C00D5670688", 4},
-    {"0C007DD69C3B", 4},
-    {"0C007D7BDDD7", 4},
-    {"3C00D6260EC2", 4},
-    {"3C00D5499F3F", 4},
-    {"0C007D08730A", 4},
-    {"0C007D8ABA41", 4},
-    {"3C00D562C44F", 4},
-    {"3C0087F1CE84", 4},
-    {"0A0055D0C847", 4},
-    {"3C00D5D55B67", 4},
-    {"0C007DCB57ED", 4},
-    {"0A00530A297A", 5},
-    {"3C00D60720CD", 5},
-    {"0B002954ADDB", 5},
-    {"0B0029535120", 5},
-    {"0B00296184C7", 5},
-    {"3C00D5A30349", 5},
-    {"3C00D650B70D", 5},
-    {"0B00292EF5F9", 5},
-    {"3C00D562A823", 5},
-    {"3C00D52D9B5F", 6},
-    {"0C007E2A2179", 6},
-    {"3D00D64301A9", 6},
-    {"3C00D658B406", 6},
-    {"3C00D5749B06", 6},
-    {"0C007DBDAA66", 6},
-    {"0B0027CF4AA9", 6},
-    {"0B00269158E4", 6},
-    {"3C00890613A0", 7},
-    {"3C0088DFF992", 7},
-    {"3C008900F540", 7},
-    {"0C007E25DD8A", 7},
-    {"3C00891DE048", 7},
-    {"3C008919B01C", 7},
-    {"3C0087F683CE", 7},
-    {"3C00D5A00C45", 8},
-    {"3C00D55F7DCB", 8},
-    {"0C007DF0B938", 8},
-    {"0A0059E97EC4", 8},
-    {"0C007D450337", 8},
-    {"0C007D5F5E70", 8},
-    {"3C00D653F24B", 8},
-    {"3C0087F2551C", 8},
-    {"3C00D595106C", 8},
-    {"0C007D1EA5CA", 9},
-    {"3C00D541B31B", 9},
-    {"3C00D530B069", 9},
-    {"3C00D5AD5713", 9},
-    {"3C00D637ED30", 9},
-    {"3C00D561E56D", 9},
-    {"3C00D5274987", 9},
-    {"0A0059EBEC54", 9},
-    {"0C007D9FBC52", 10},
-    {"3C00D5AA4605", 10},
-    {"0C007D49BE86", 10},
-    {"3C00D5E98F8F", 10},
-    {"0C007CD203A1", 10},
-    {"3C00D5C94060", 10},
-    {"0C007DC1CF7F", 10},
-    {"0C007D43E7D5", 10},
-    {"0C007DF71D9B", 10}};
-
 const uint16_t CLEAR_DELAY_MS = 5000;
 uint32_t lastEventMillis = 0;
 
-char tagBuffer[SIZE_TAG_ID];
-
-bool isTrackPlaying()
-{
-  return digitalRead(PIN_AUDIO_ACT) == LOW;
-}
-
-void playTrack(uint8_t trackPin)
-{
-  const uint16_t delayPlayMs = 200;
-
-  if (isTrackPlaying())
-  {
-    Serial.println(F("Skipping: Audio still playing"));
-    return;
-  }
-
-  Serial.print(F("Playing track on pin: "));
-  Serial.println(trackPin);
-
-  digitalWrite(trackPin, LOW);
-  pinMode(trackPin, OUTPUT);
-  delay(delayPlayMs);
-  pinMode(trackPin, INPUT);
-}
-
 void initAudioPins()
 {
-  pinMode(PIN_AUDIO_ACT, INPUT);
   pinMode(PIN_AUDIO_RST, INPUT);
   pinMode(PIN_AUDIO_TRACK_GUEST, INPUT);
   pinMode(PIN_AUDIO_TRACK_HOSTS, INPUT);
+  audio.begin();
 }
 
 void resetAudio()
@@ -219,30 +106,28 @@ void showStartupEffect()
 
 int16_t readRfid()
 {
-  bool tagFound = rfidReader.readTag(tagBuffer, sizeof(tagBuffer));
-
-  if (!tagFound)
+  if (!rfidParser.poll(rfidSoftSerial))
   {
     return TAG_NOT_FOUND;
   }
 
   Serial.print(F("Tag: "));
-  Serial.println(tagBuffer);
+  rfidPrintTag(Serial, rfidParser.tag());
+  Serial.println();
+
+  int16_t idxGuest = guestTable.find(rfidParser.tag());
 
-  for (uint8_t idxGuest = 0; idxGuest < NUM_GUESTS; idxGuest++)
+  if (idxGuest == GUEST_NOT_FOUND)
   {
-    if (SerialRFID::isEqualTag(tagBuffer, GUEST_TAGS[idxGuest].tagId))
-    {
-      Serial.print(F("Guest: "));
-      Serial.print(idxGuest);
-      Serial.print(F(" Table: "));
-      Serial.println(GUEST_TAGS[idxGuest].tableIdx);
-
-      return idxGuest;
-    }
+    return TAG_UNKNOWN;
   }
 
-  return TAG_UNKNOWN;
+  Serial.print(F("Guest: "));
+  Serial.print(idxGuest);
+  Serial.print(F(" Table: "));
+  Serial.println(guestTable.getTable(idxGuest, 0));
+
+  return idxGuest;
 }
 
 uint16_t getTableFirstPixel(uint8_t tableIdx)
@@ -250,15 +135,15 @@ uint16_t getTableFirstPixel(uint8_t tableIdx)
   return tableIdx * LED_PER_TABLE;
 }
 
-void showGuest(uint8_t idxGuest)
+void showGuest(uint16_t idxGuest)
 {
-  if (idxGuest >= NUM_GUESTS)
+  if (idxGuest >= guestTable.size())
   {
     Serial.println(F("WARN: Unexpected guest index"));
     return;
   }
 
-  uint8_t tableIdx = GUEST_TAGS[idxGuest].tableIdx;
+  uint8_t tableIdx = guestTable.getTable(idxGuest, 0);
 
   if (tableIdx >= NUM_TABLES)
   {
@@ -268,11 +153,11 @@ void showGuest(uint8_t idxGuest)
 
   if (tableIdx == HOSTS_TABLE_IDX)
   {
-    playTrack(PIN_AUDIO_TRACK_HOSTS);
+    audio.play(PIN_AUDIO_TRACK_HOSTS, AUDIO_FX_SKIP_IF_BUSY);
   }
   else
   {
-    playTrack(PIN_AUDIO_TRACK_GUEST);
+    audio.play(PIN_AUDIO_TRACK_GUEST, AUDIO_FX_SKIP_IF_BUSY);
   }
 
   Serial.println(F("LED effect: start"));
@@ -288,7 +173,7 @@ void showGuest(uint8_t idxGuest)
 
     ledStrip.show();
 
-    delay(EFFECT_ITER_MS);
+    audio.wait(EFFECT_ITER_MS);
   }
 
   Serial.println(F("LED effect: end"));
@@ -307,6 +192,8 @@ void showGuest(uint8_t idxGuest)
 
 void mainLoop()
 {
+  guestTable.pollUpload(Serial);
+
   uint32_t diffLast = millis() - lastEventMillis;
 
   if (lastEventMillis > 0 && diffLast >= CLEAR_DELAY_MS)
@@ -340,10 +227,13 @@ void setup()
 
   showStartupEffect();
 
+  guestTable.begin();
+
   Serial.println(F(">> Seating plan"));
 }
 
 void loop()
 {
   mainLoop();
+  audio.update();
 }
\ No newline at end of file
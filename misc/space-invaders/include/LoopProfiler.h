@@ -0,0 +1,250 @@
+#ifndef LOOP_PROFILER_H
+#define LOOP_PROFILER_H
+
+/**
+ * Loop latency and jitter profiler.
+ *
+ * Define LOOP_PROFILER before including this header to enable it. When it
+ * is not defined every PROFILE_* macro expands to nothing and the profiler
+ * takes no flash or RAM.
+ *
+ * PROFILE_LOOP() goes at the top of loop() and records the time between
+ * consecutive passes. PROFILE_SECTION(id) records the time until the end
+ * of the enclosing scope. Timings go into fixed-size log2 histograms of
+ * microseconds. Send 'p' over Serial to print min / p50 / p99 / max for
+ * each timer and 'r' to reset them. Any other byte is left in the Serial
+ * buffer for the sketch.
+ *
+ * When a bucket is about to overflow, every bucket is halved, so the
+ * percentiles keep following the distribution over long runs.
+ */
+
+#ifdef LOOP_PROFILER
+
+#include <Arduino.h>
+
+const uint8_t PROFILE_SECTION_LOOP = 0;
+const uint8_t PROFILE_SECTION_LED = 1;
+const uint8_t PROFILE_SECTION_AUDIO = 2;
+const uint8_t PROFILE_SECTIONS_NUM = 3;
+
+const uint8_t PROFILE_BUCKETS_NUM = 24;
+
+typedef struct profileHistogram
+{
+    uint16_t counts[PROFILE_BUCKETS_NUM];
+    uint32_t weight;
+    uint32_t total;
+    unsigned long minUs;
+    unsigned long maxUs;
+} ProfileHistogram;
+
+class LoopProfiler
+{
+public:
+    LoopProfiler()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        lastLoopUs = 0;
+
+        for (uint8_t i = 0; i < PROFILE_SECTIONS_NUM; i++)
+        {
+            memset(hists[i].counts, 0, sizeof(hists[i].counts));
+            hists[i].weight = 0;
+            hists[i].total = 0;
+            hists[i].minUs = 0xFFFFFFFF;
+            hists[i].maxUs = 0;
+        }
+    }
+
+    void record(uint8_t section, unsigned long us)
+    {
+        if (section >= PROFILE_SECTIONS_NUM)
+        {
+            return;
+        }
+
+        ProfileHistogram &hist = hists[section];
+        uint8_t bucket = bucketFor(us);
+
+        if (hist.counts[bucket] == 0xFFFF)
+        {
+            halve(hist);
+        }
+
+        hist.counts[bucket]++;
+        hist.weight++;
+        hist.total++;
+        hist.minUs = us < hist.minUs ? us : hist.minUs;
+        hist.maxUs = us > hist.maxUs ? us : hist.maxUs;
+    }
+
+    void onLoop()
+    {
+        unsigned long now = micros();
+
+        if (lastLoopUs != 0)
+        {
+            record(PROFILE_SECTION_LOOP, now - lastLoopUs);
+        }
+
+        pollSerial();
+
+        lastLoopUs = micros();
+    }
+
+    /**
+     * Upper bound (in microseconds) of the bucket holding the given
+     * percentile, capped at the largest value seen.
+     */
+    unsigned long percentile(uint8_t section, uint8_t pct)
+    {
+        ProfileHistogram &hist = hists[section];
+
+        if (hist.weight == 0)
+        {
+            return 0;
+        }
+
+        uint32_t target = (hist.weight * pct + 99) / 100;
+        uint32_t seen = 0;
+
+        for (uint8_t i = 0; i < PROFILE_BUCKETS_NUM; i++)
+        {
+            seen += hist.counts[i];
+
+            if (seen >= target)
+            {
+                unsigned long upper = (1UL << (i + 1)) - 1;
+                return upper < hist.maxUs ? upper : hist.maxUs;
+            }
+        }
+
+        return hist.maxUs;
+    }
+
+    void dump()
+    {
+        Serial.println(F(">> Profiler (us)"));
+
+        for (uint8_t i = 0; i < PROFILE_SECTIONS_NUM; i++)
+        {
+            if (hists[i].total == 0)
+            {
+                continue;
+            }
+
+            printSectionName(i);
+            Serial.print(F(" :: n="));
+            Serial.print(hists[i].total);
+            Serial.print(F(" min="));
+            Serial.print(hists[i].minUs);
+            Serial.print(F(" p50="));
+            Serial.print(percentile(i, 50));
+            Serial.print(F(" p99="));
+            Serial.print(percentile(i, 99));
+            Serial.print(F(" max="));
+            Serial.println(hists[i].maxUs);
+        }
+    }
+
+private:
+    ProfileHistogram hists[PROFILE_SECTIONS_NUM];
+    unsigned long lastLoopUs;
+
+    uint8_t bucketFor(unsigned long us)
+    {
+        uint8_t bucket = 0;
+
+        while (us > 1 && bucket < PROFILE_BUCKETS_NUM - 1)
+        {
+            us >>= 1;
+            bucket++;
+        }
+
+        return bucket;
+    }
+
+    void halve(ProfileHistogram &hist)
+    {
+        hist.weight = 0;
+
+        for (uint8_t i = 0; i < PROFILE_BUCKETS_NUM; i++)
+        {
+            hist.counts[i] >>= 1;
+            hist.weight += hist.counts[i];
+        }
+    }
+
+    void printSectionName(uint8_t section)
+    {
+        switch (section)
+        {
+        case PROFILE_SECTION_LOOP:
+            Serial.print(F("loop"));
+            break;
+        case PROFILE_SECTION_LED:
+            Serial.print(F("led"));
+            break;
+        case PROFILE_SECTION_AUDIO:
+            Serial.print(F("audio"));
+            break;
+        }
+    }
+
+    void pollSerial()
+    {
+        int cmd = Serial.peek();
+
+        if (cmd == 'p')
+        {
+            Serial.read();
+            dump();
+        }
+        else if (cmd == 'r')
+        {
+            Serial.read();
+            reset();
+            Serial.println(F(">> Profiler reset"));
+        }
+    }
+};
+
+LoopProfiler loopProfiler;
+
+class LoopProfilerScope
+{
+public:
+    LoopProfilerScope(uint8_t section) : section(section), startUs(micros()) {}
+
+    ~LoopProfilerScope()
+    {
+        loopProfiler.record(section, micros() - startUs);
+    }
+
+private:
+    uint8_t section;
+    unsigned long startUs;
+};
+
+#define LOOP_PROFILER_CONCAT_(a, b) a##b
+#define LOOP_PROFILER_CONCAT(a, b) LOOP_PROFILER_CONCAT_(a, b)
+
+#define PROFILE_LOOP() loopProfiler.onLoop()
+#define PROFILE_SECTION(id) \
+    LoopProfilerScope LOOP_PROFILER_CONCAT(profilerScope, __LINE__)(id)
+#define PROFILE_DUMP() loopProfiler.dump()
+
+#else
+
+#define PROFILE_LOOP()
+#define PROFILE_SECTION(id)
+#define PROFILE_DUMP()
+
+#endif
+
+#endif
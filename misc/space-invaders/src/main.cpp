@@ -3,6 +3,10 @@
 #include <Adafruit_NeoPixel.h>
 #include <CircularBuffer.h>
 
+// #define LOOP_PROFILER
+#include "LoopProfiler.h"
+#include "AudioFxScheduler.h"
+
 /**
  * Controller buttons.
  */
@@ -91,6 +95,8 @@ const uint8_t PIN_AUDIO_TRACK_VICTORY = 4;
 const uint8_t PIN_AUDIO_SECOND_PHASE = 5;
 const unsigned long AUDIO_PLAY_DELAY_MS = 200;
 
+AudioFxScheduler audio(PIN_AUDIO_ACT, AUDIO_PLAY_DELAY_MS);
+
 /**
  * Relays.
  */
@@ -104,9 +110,6 @@ const int PIN_RELAY = 7;
 const uint8_t BUTTONS_BUF_SIZE = 5;
 CircularBuffer<uint8_t, BUTTONS_BUF_SIZE> buttonBuf;
 
-const uint8_t AUDIO_BUF_SIZE = 2;
-CircularBuffer<uint8_t, AUDIO_BUF_SIZE> audioPinsQueue;
-
 const uint32_t TIMER_GENERAL_MS = 200;
 Atm_timer timerGeneral;
 
@@ -124,7 +127,6 @@ typedef struct programState
   uint8_t *invaderColorIdxs;
   uint8_t signalColorIdx;
   bool *invaderFlags;
-  unsigned long audioPlayMillis;
 } ProgramState;
 
 ProgramState progState = {
@@ -132,14 +134,12 @@ ProgramState progState = {
     .buttonColorIdxs = buttonColorIdxs,
     .invaderColorIdxs = invaderColorIdxs,
     .signalColorIdx = 0,
-    .invaderFlags = invaderFlags,
-    .audioPlayMillis = 0};
+    .invaderFlags = invaderFlags};
 
 void cleanState()
 {
   progState.isSecondPhase = false;
   progState.signalColorIdx = 0;
-  progState.audioPlayMillis = 0;
 
   for (uint8_t i = 0; i < BUTTONS_NUM; i++)
   {
@@ -153,7 +153,7 @@ void cleanState()
   }
 
   buttonBuf.clear();
-  audioPinsQueue.clear();
+  audio.clear();
 }
 
 /**
@@ -185,8 +185,8 @@ void initAudioPins()
   pinMode(PIN_AUDIO_TRACK_ERROR, INPUT);
   pinMode(PIN_AUDIO_TRACK_VICTORY, INPUT);
   pinMode(PIN_AUDIO_SECOND_PHASE, INPUT);
-  pinMode(PIN_AUDIO_ACT, INPUT);
   pinMode(PIN_AUDIO_RST, INPUT);
+  audio.begin();
 }
 
 void resetAudio()
@@ -212,78 +212,6 @@ void initAudio()
   resetAudio();
 }
 
-bool isTrackPlaying()
-{
-  return progState.audioPlayMillis > 0 || digitalRead(PIN_AUDIO_ACT) == LOW;
-}
-
-void playTrack(uint8_t trackPin, bool async = true)
-{
-  if (isTrackPlaying())
-  {
-    Serial.println(F("Skipping: Audio still playing"));
-    return;
-  }
-
-  digitalWrite(trackPin, LOW);
-  pinMode(trackPin, OUTPUT);
-
-  if (async)
-  {
-    progState.audioPlayMillis = millis();
-  }
-  else
-  {
-    progState.audioPlayMillis = 0;
-    delay(AUDIO_PLAY_DELAY_MS);
-    pinMode(trackPin, INPUT);
-  }
-}
-
-void clearAudioPins()
-{
-  progState.audioPlayMillis = 0;
-  pinMode(PIN_AUDIO_TRACK_ERROR, INPUT);
-  pinMode(PIN_AUDIO_TRACK_VICTORY, INPUT);
-  pinMode(PIN_AUDIO_SECOND_PHASE, INPUT);
-}
-
-void checkClearAudioPins()
-{
-  if (progState.audioPlayMillis == 0)
-  {
-    return;
-  }
-
-  unsigned long now = millis();
-  unsigned long diffMs = now - progState.audioPlayMillis;
-
-  if (diffMs >= AUDIO_PLAY_DELAY_MS)
-  {
-    Serial.println(F("Clearing audio pins"));
-    clearAudioPins();
-  }
-}
-
-void processAudioQueue()
-{
-  if (audioPinsQueue.isEmpty() || isTrackPlaying())
-  {
-    return;
-  }
-
-  Serial.print(F("Audio queue size: "));
-  Serial.println(audioPinsQueue.size());
-
-  int trackPin = audioPinsQueue.shift();
-  playTrack(trackPin);
-}
-
-void enqueueTrack(uint8_t trackPin)
-{
-  audioPinsQueue.push(trackPin);
-}
-
 /**
  * Functions to update the state of the LEDs.
  */
@@ -345,6 +273,8 @@ void initLeds()
 
 void showInvaderLeds()
 {
+  PROFILE_SECTION(PROFILE_SECTION_LED);
+
   if (!progState.isSecondPhase)
   {
     return;
@@ -376,6 +306,8 @@ void showInvaderLeds()
 
 void showSignalLeds()
 {
+  PROFILE_SECTION(PROFILE_SECTION_LED);
+
   if (!progState.isSecondPhase)
   {
     return;
@@ -396,6 +328,8 @@ void showSignalLeds()
 
 void showButtonLeds()
 {
+  PROFILE_SECTION(PROFILE_SECTION_LED);
+
   ledButtons.clear();
 
   for (uint8_t idxButton = 0; idxButton < BUTTONS_NUM; idxButton++)
@@ -469,15 +403,15 @@ void checkVictory()
   const unsigned long delayMs = 200;
   const unsigned long endMillis = millis() + 12000;
 
-  clearAudioPins();
-  playTrack(PIN_AUDIO_TRACK_VICTORY, false);
+  audio.clear();
+  audio.play(PIN_AUDIO_TRACK_VICTORY, AUDIO_FX_SKIP_IF_BUSY);
 
   openRelay();
 
   uint32_t color;
   uint8_t colorIdx;
 
-  while (isTrackPlaying() || (millis() < endMillis))
+  while (audio.isBusy() || (millis() < endMillis))
   {
     colorIdx = random(0, NUM_COLORS_SECOND_PHASE);
     color = COLORS_SECOND_PHASE[colorIdx];
@@ -487,14 +421,14 @@ void checkVictory()
     ledButtons.show();
     ledInvaders.show();
 
-    delay(delayMs);
+    audio.wait(delayMs);
 
     ledButtons.clear();
     ledInvaders.clear();
     ledButtons.show();
     ledInvaders.show();
 
-    delay(delayMs);
+    audio.wait(delayMs);
   }
 
   cleanState();
@@ -539,7 +473,7 @@ void checkTransitionToSecondPhase()
     progState.invaderColorIdxs[idxInvader] = randomSecondPhaseColorIdx();
   }
 
-  enqueueTrack(PIN_AUDIO_SECOND_PHASE);
+  audio.play(PIN_AUDIO_SECOND_PHASE);
   progState.isSecondPhase = true;
 }
 
@@ -571,20 +505,20 @@ void runSecondPhaseErrorEffect()
   const uint32_t white = Adafruit_NeoPixel::Color(255, 255, 255);
   const unsigned long endMillis = millis() + 1500;
 
-  clearAudioPins();
-  playTrack(PIN_AUDIO_TRACK_ERROR, false);
+  audio.clear();
+  audio.play(PIN_AUDIO_TRACK_ERROR, AUDIO_FX_SKIP_IF_BUSY);
 
-  while (isTrackPlaying() || (millis() < endMillis))
+  while (audio.isBusy() || (millis() < endMillis))
   {
     ledButtons.fill(white);
     ledButtons.show();
 
-    delay(delayMs);
+    audio.wait(delayMs);
 
     ledButtons.clear();
     ledButtons.show();
 
-    delay(delayMs);
+    audio.wait(delayMs);
   }
 }
 
@@ -641,8 +575,6 @@ void onTimerGeneral(int idx, int v, int up)
   checkTransitionToSecondPhase();
   showInvaderLeds();
   showSignalLeds();
-  checkClearAudioPins();
-  processAudioQueue();
   checkVictory();
 }
 
@@ -683,7 +615,15 @@ void setup()
   showLedStartEffect();
 }
 
+void updateAudio()
+{
+  PROFILE_SECTION(PROFILE_SECTION_AUDIO);
+  audio.update();
+}
+
 void loop()
 {
+  PROFILE_LOOP();
   automaton.run();
+  updateAudio();
 }
@@ -0,0 +1,227 @@
+#ifndef MUX_SCANNER_H
+#define MUX_SCANNER_H
+
+#include <Arduino.h>
+
+/**
+ * Bulk scanner for two CD74HC4067 16-channel multiplexers with
+ * active-low inputs (pulled up, switch to GND).
+ *
+ * Both muxes are stepped together through their 16 channels in Gray-code
+ * order, so each step flips a single select line per mux. The line is
+ * flipped by writing its bit to the PINx register (a one-cycle toggle on
+ * AVR) instead of going through digitalWrite(). After a configurable
+ * settle time both signal pins are read in the same pass.
+ *
+ * A scan produces a 32-bit snapshot (bit = mux * 16 + channel, set when
+ * pressed). Snapshots are debounced for all channels at once with two
+ * vertical counters: a channel changes state after 4 agreeing scans, so
+ * the debounce time is 4 x the scan interval. Only changes are reported,
+ * mapped through the per-mux code tables.
+ */
+
+typedef uint32_t MuxMask;
+
+const uint8_t MUX_SCANNER_NUM_MUX = 2;
+const uint8_t MUX_SCANNER_CHANNELS = 16;
+const uint8_t MUX_SCANNER_SELECT_LINES = 4;
+
+class MuxScanner
+{
+public:
+    MuxScanner(
+        const uint8_t (*selectPins)[MUX_SCANNER_SELECT_LINES],
+        const uint8_t *sigPins,
+        const uint8_t *const *maps,
+        unsigned long intervalUs,
+        uint8_t settleUs,
+        void (*onChange)(uint8_t code, bool isPressed))
+        : selectPins(selectPins),
+          sigPins(sigPins),
+          maps(maps),
+          intervalUs(intervalUs),
+          settleUs(settleUs),
+          onChange(onChange),
+          state(0),
+          ct0(~(MuxMask)0),
+          ct1(~(MuxMask)0),
+          lastScanMicros(0),
+          scanUs(0),
+          numScans(0)
+    {
+    }
+
+    void begin()
+    {
+        for (uint8_t m = 0; m < MUX_SCANNER_NUM_MUX; m++)
+        {
+            for (uint8_t j = 0; j < MUX_SCANNER_SELECT_LINES; j++)
+            {
+                uint8_t pin = selectPins[m][j];
+
+                pinMode(pin, OUTPUT);
+                digitalWrite(pin, LOW);
+
+                toggleRegs[j][m] = portInputRegister(digitalPinToPort(pin));
+                toggleMasks[j][m] = digitalPinToBitMask(pin);
+            }
+
+            pinMode(sigPins[m], INPUT_PULLUP);
+
+            sigRegs[m] = portInputRegister(digitalPinToPort(sigPins[m]));
+            sigMasks[m] = digitalPinToBitMask(sigPins[m]);
+        }
+    }
+
+    /**
+     * Scans if the scan interval has passed. Call from loop().
+     */
+    void update()
+    {
+        unsigned long now = micros();
+
+        if (now - lastScanMicros < intervalUs)
+        {
+            return;
+        }
+
+        lastScanMicros = now;
+
+        MuxMask raw = readAll();
+
+        scanUs = micros() - now;
+        numScans++;
+
+        debounce(raw);
+    }
+
+    /**
+     * Debounced snapshot (bit set = pressed).
+     */
+    MuxMask getState() const
+    {
+        return state;
+    }
+
+    /**
+     * Duration (us) of the last full scan of both muxes.
+     */
+    unsigned long getScanMicros() const
+    {
+        return scanUs;
+    }
+
+    /**
+     * Returns the number of scans since the last call.
+     */
+    unsigned long takeScanCount()
+    {
+        unsigned long count = numScans;
+        numScans = 0;
+
+        return count;
+    }
+
+private:
+    const uint8_t (*selectPins)[MUX_SCANNER_SELECT_LINES];
+    const uint8_t *sigPins;
+    const uint8_t *const *maps;
+    unsigned long intervalUs;
+    uint8_t settleUs;
+    void (*onChange)(uint8_t code, bool isPressed);
+
+    volatile uint8_t *toggleRegs[MUX_SCANNER_SELECT_LINES][MUX_SCANNER_NUM_MUX];
+    uint8_t toggleMasks[MUX_SCANNER_SELECT_LINES][MUX_SCANNER_NUM_MUX];
+    volatile uint8_t *sigRegs[MUX_SCANNER_NUM_MUX];
+    uint8_t sigMasks[MUX_SCANNER_NUM_MUX];
+
+    MuxMask state;
+    MuxMask ct0;
+    MuxMask ct1;
+
+    unsigned long lastScanMicros;
+    unsigned long scanUs;
+    unsigned long numScans;
+
+    void toggleSelect(uint8_t line)
+    {
+        for (uint8_t m = 0; m < MUX_SCANNER_NUM_MUX; m++)
+        {
+            *toggleRegs[line][m] = toggleMasks[line][m];
+        }
+    }
+
+    /**
+     * Starts and ends on channel 0, so the first read of the next scan
+     * has had the whole interval to settle.
+     */
+    MuxMask readAll()
+    {
+        MuxMask raw = 0;
+
+        for (uint8_t step = 0; step < MUX_SCANNER_CHANNELS; step++)
+        {
+            if (step > 0)
+            {
+                // Going from Gray(step - 1) to Gray(step) flips the
+                // lowest set bit of step
+                uint8_t line = 0;
+
+                while (!(step & (1 << line)))
+                {
+                    line++;
+                }
+
+                toggleSelect(line);
+                delayMicroseconds(settleUs);
+            }
+
+            uint8_t channel = step ^ (step >> 1);
+
+            for (uint8_t m = 0; m < MUX_SCANNER_NUM_MUX; m++)
+            {
+                if (!(*sigRegs[m] & sigMasks[m]))
+                {
+                    raw |= (MuxMask)1 << (m * MUX_SCANNER_CHANNELS + channel);
+                }
+            }
+        }
+
+        // Gray(15) = 8: back to channel 0
+        toggleSelect(MUX_SCANNER_SELECT_LINES - 1);
+
+        return raw;
+    }
+
+    void debounce(MuxMask raw)
+    {
+        MuxMask delta = raw ^ state;
+
+        ct0 = ~(ct0 & delta);
+        ct1 = ct0 ^ (ct1 & delta);
+
+        MuxMask toggled = delta & ct0 & ct1;
+
+        if (toggled == 0)
+        {
+            return;
+        }
+
+        state ^= toggled;
+
+        for (uint8_t idx = 0; toggled != 0; idx++, toggled >>= 1)
+        {
+            if (!(toggled & 1))
+            {
+                continue;
+            }
+
+            uint8_t m = idx / MUX_SCANNER_CHANNELS;
+            uint8_t code = maps[m][idx % MUX_SCANNER_CHANNELS];
+
+            onChange(code, state & ((MuxMask)1 << idx));
+        }
+    }
+};
+
+#endif
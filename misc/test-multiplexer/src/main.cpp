@@ -1,14 +1,17 @@
 #include <Arduino.h>
-#include <CD74HC4067.h>
+#include "MuxScanner.h"
 
 // s0 s1 s2 s3
-CD74HC4067 muxOne(5, 4, 3, 2);
-CD74HC4067 muxTwo(10, 9, 8, 7);
+const uint8_t MUX_SELECT_PINS[MUX_SCANNER_NUM_MUX][MUX_SCANNER_SELECT_LINES] = {
+    {5, 4, 3, 2},
+    {10, 9, 8, 7}};
 
 // Select a pin to share with the 16 channels of the CD74HC4067
 const int MUX_ONE_SIG = A0;
 const int MUX_TWO_SIG = A1;
 
+const uint8_t MUX_SIG_PINS[MUX_SCANNER_NUM_MUX] = {MUX_ONE_SIG, MUX_TWO_SIG};
+
 const int NUM_MUX_INPUTS = 16;
 
 const uint8_t CODE_RETURN = 0xB0;
@@ -20,36 +23,81 @@ const uint8_t MUX_ONE_MAP[NUM_MUX_INPUTS] = {
 const uint8_t MUX_TWO_MAP[NUM_MUX_INPUTS] = {
     'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', CODE_RETURN, CODE_DELETE, CODE_RETURN, CODE_RETURN, CODE_RETURN, CODE_RETURN};
 
-void setup()
-{
-  Serial.begin(9600);
-  pinMode(MUX_ONE_SIG, INPUT_PULLUP);
-  pinMode(MUX_TWO_SIG, INPUT_PULLUP);
-}
+const uint8_t *const MUX_MAPS[MUX_SCANNER_NUM_MUX] = {MUX_ONE_MAP, MUX_TWO_MAP};
 
-void loop()
+// One scan every 4 ms: changes are debounced over 4 scans (16 ms)
+const unsigned long MUX_SCAN_INTERVAL_US = 4000;
+
+// Time for the signal line to settle after a select line flips
+// (the pull-up has to charge the line after a pressed channel)
+const uint8_t MUX_SETTLE_US = 5;
+
+const unsigned long SCAN_REPORT_MS = 5000;
+
+unsigned long lastReportMillis = 0;
+
+void onMuxChange(uint8_t code, bool isPressed)
 {
-  for (int i = 0; i < 16; i++)
+  Serial.print(millis());
+  Serial.print(isPressed ? F(" :: Press :: ") : F(" :: Release :: "));
+
+  if (code == CODE_RETURN)
+  {
+    Serial.println(F("RETURN"));
+  }
+  else if (code == CODE_DELETE)
+  {
+    Serial.println(F("DELETE"));
+  }
+  else
   {
-    muxOne.channel(i);
-
-    if (digitalRead(MUX_ONE_SIG) == LOW)
-    {
-      Serial.print(millis());
-      Serial.print(F(" :: Channel 0 :: "));
-      Serial.println(i);
-    }
+    Serial.println((char)code);
   }
+}
 
-  for (int i = 0; i < 16; i++)
+MuxScanner muxScanner(
+    MUX_SELECT_PINS,
+    MUX_SIG_PINS,
+    MUX_MAPS,
+    MUX_SCAN_INTERVAL_US,
+    MUX_SETTLE_US,
+    onMuxChange);
+
+/**
+ * Prints how long a full scan of both muxes takes and the panel scan
+ * rate it allows, to size larger panels.
+ */
+void reportScanRate()
+{
+  unsigned long now = millis();
+
+  if (now - lastReportMillis < SCAN_REPORT_MS)
   {
-    muxTwo.channel(i);
-
-    if (digitalRead(MUX_TWO_SIG) == LOW)
-    {
-      Serial.print(millis());
-      Serial.print(F(" :: Channel 1 :: "));
-      Serial.println(i);
-    }
+    return;
   }
+
+  unsigned long scans = muxScanner.takeScanCount();
+  unsigned long scanUs = muxScanner.getScanMicros();
+  unsigned long elapsedMs = now - lastReportMillis;
+
+  lastReportMillis = now;
+
+  Serial.print(F("Scan (us): "));
+  Serial.print(scanUs);
+  Serial.print(F(" :: Scans/s: "));
+  Serial.print(scans * 1000 / elapsedMs);
+  Serial.print(F(" :: Max full-panel rate (Hz): "));
+  Serial.println(scanUs > 0 ? 1000000UL / scanUs : 0);
+}
+
+void setup()
+{
+  Serial.begin(9600);
+  muxScanner.begin();
+}
+
+void loop()
+{
+  muxScanner.update();
+  reportScanRate();
 }
@@ -0,0 +1,232 @@
+#ifndef PARALLEL_NEOPIXEL_H
+#define PARALLEL_NEOPIXEL_H
+
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+
+/**
+ * Sends up to 8 NeoPixel strips (RGB, 800 kHz) at the same time on a
+ * SAMD51, so a frame takes as long as the longest strip instead of the
+ * sum of all of them.
+ *
+ * The strips are still Adafruit_NeoPixel objects: they hold the pixels
+ * (with brightness and color order applied) and are drawn as usual, but
+ * only this driver's show() is called. It transposes the strips into one
+ * byte per bit slot (bit s = the bit that strip s sends in that slot) and
+ * then bit-bangs all lines together, timed with the DWT cycle counter:
+ *
+ * - all lines high at the start of the slot,
+ * - lines sending a 0 low after T0H (0.4 us),
+ * - every line low after T1H (0.8 us),
+ * - next slot after 1.25 us.
+ *
+ * Pins can be on PORT groups A and B; both groups are written in the same
+ * slot. Shorter strips are padded with zeros, which the last pixel of the
+ * strip passes on to nothing.
+ *
+ * Interrupts are off during the transfer, as with Adafruit_NeoPixel.
+ */
+
+const uint8_t PARALLEL_NEOPIXEL_MAX_STRIPS = 8;
+const uint8_t PARALLEL_NEOPIXEL_GROUPS = 2;
+const uint8_t PARALLEL_NEOPIXEL_BYTES_PER_PIXEL = 3;
+const uint32_t PARALLEL_NEOPIXEL_LATCH_US = 300;
+
+const uint32_t PARALLEL_NEOPIXEL_CYCLES_BIT = F_CPU / 800000;
+const uint32_t PARALLEL_NEOPIXEL_CYCLES_T0H = F_CPU / 2500000;
+const uint32_t PARALLEL_NEOPIXEL_CYCLES_T1H = F_CPU / 1250000;
+
+class ParallelNeoPixel
+{
+public:
+    ParallelNeoPixel(Adafruit_NeoPixel *const *strips, uint8_t numStrips)
+        : strips(strips),
+          numStrips(numStrips > PARALLEL_NEOPIXEL_MAX_STRIPS ? PARALLEL_NEOPIXEL_MAX_STRIPS : numStrips),
+          slots(NULL),
+          numSlots(0),
+          lastShowMicros(0),
+          transferUs(0),
+          frameUs(0)
+    {
+    }
+
+    /**
+     * Call after begin() on every strip. Returns false if a pin is not on
+     * PORT group A or B, or the frame buffer cannot be allocated.
+     */
+    bool begin()
+    {
+        uint16_t maxPixels = 0;
+
+        memset(groupMasks, 0, sizeof(groupMasks));
+
+        for (uint8_t s = 0; s < numStrips; s++) {
+            int16_t pin = strips[s]->getPin();
+
+            if (pin < 0 || g_APinDescription[pin].ulPort >= PARALLEL_NEOPIXEL_GROUPS) {
+                return false;
+            }
+
+            stripGroups[s] = g_APinDescription[pin].ulPort;
+            stripPinMasks[s] = 1ul << g_APinDescription[pin].ulPin;
+
+            if (strips[s]->numPixels() > maxPixels) {
+                maxPixels = strips[s]->numPixels();
+            }
+        }
+
+        // Port bits of every subset of strips, for each group
+        for (uint16_t subset = 0; subset < 256; subset++) {
+            for (uint8_t s = 0; s < numStrips; s++) {
+                if (subset & (1 << s)) {
+                    groupMasks[stripGroups[s]][subset] |= stripPinMasks[s];
+                }
+            }
+        }
+
+        numSlots = (uint32_t)maxPixels * PARALLEL_NEOPIXEL_BYTES_PER_PIXEL * 8;
+        slots = (uint8_t *)malloc(numSlots);
+
+        if (slots == NULL) {
+            numSlots = 0;
+            return false;
+        }
+
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+        return true;
+    }
+
+    /**
+     * Falls back to one show() per strip if begin() failed.
+     */
+    void show()
+    {
+        if (slots == NULL) {
+            for (uint8_t s = 0; s < numStrips; s++) {
+                strips[s]->show();
+            }
+
+            return;
+        }
+
+        uint32_t frameStart = DWT->CYCCNT;
+
+        transpose();
+
+        while (micros() - lastShowMicros < PARALLEL_NEOPIXEL_LATCH_US) {
+        }
+
+        uint32_t transferStart = DWT->CYCCNT;
+
+        noInterrupts();
+        transmit();
+        interrupts();
+
+        uint32_t end = DWT->CYCCNT;
+        uint32_t cyclesPerUs = F_CPU / 1000000;
+
+        transferUs = (end - transferStart) / cyclesPerUs;
+        frameUs = (end - frameStart) / cyclesPerUs;
+        lastShowMicros = micros();
+    }
+
+    /**
+     * Time (us) with interrupts off sending the last frame.
+     */
+    unsigned long getTransferMicros() const
+    {
+        return transferUs;
+    }
+
+    /**
+     * Time (us) of the last show(), including the transpose and the wait
+     * for the previous latch.
+     */
+    unsigned long getFrameMicros() const
+    {
+        return frameUs;
+    }
+
+private:
+    Adafruit_NeoPixel *const *strips;
+    uint8_t numStrips;
+
+    uint8_t stripGroups[PARALLEL_NEOPIXEL_MAX_STRIPS];
+    uint32_t stripPinMasks[PARALLEL_NEOPIXEL_MAX_STRIPS];
+    uint32_t groupMasks[PARALLEL_NEOPIXEL_GROUPS][256];
+
+    uint8_t *slots;
+    uint32_t numSlots;
+
+    unsigned long lastShowMicros;
+    unsigned long transferUs;
+    unsigned long frameUs;
+
+    void transpose()
+    {
+        memset(slots, 0, numSlots);
+
+        for (uint8_t s = 0; s < numStrips; s++) {
+            const uint8_t *pixels = strips[s]->getPixels();
+            uint32_t numBytes = (uint32_t)strips[s]->numPixels() * PARALLEL_NEOPIXEL_BYTES_PER_PIXEL;
+            uint8_t stripBit = 1 << s;
+            uint8_t *slot = slots;
+
+            for (uint32_t i = 0; i < numBytes; i++) {
+                uint8_t value = pixels[i];
+
+                for (uint8_t mask = 0x80; mask != 0; mask >>= 1, slot++) {
+                    if (value & mask) {
+                        *slot |= stripBit;
+                    }
+                }
+            }
+        }
+    }
+
+    void transmit()
+    {
+        uint8_t allStrips = (1 << numStrips) - 1;
+        uint32_t allA = groupMasks[0][allStrips];
+        uint32_t allB = groupMasks[1][allStrips];
+
+        volatile uint32_t *setA = &PORT->Group[0].OUTSET.reg;
+        volatile uint32_t *clrA = &PORT->Group[0].OUTCLR.reg;
+        volatile uint32_t *setB = &PORT->Group[1].OUTSET.reg;
+        volatile uint32_t *clrB = &PORT->Group[1].OUTCLR.reg;
+
+        uint32_t start = DWT->CYCCNT - PARALLEL_NEOPIXEL_CYCLES_BIT;
+
+        for (uint32_t i = 0; i < numSlots; i++) {
+            uint8_t zeros = ~slots[i] & allStrips;
+            uint32_t zerosA = groupMasks[0][zeros];
+            uint32_t zerosB = groupMasks[1][zeros];
+
+            while (DWT->CYCCNT - start < PARALLEL_NEOPIXEL_CYCLES_BIT) {
+            }
+
+            start = DWT->CYCCNT;
+            *setA = allA;
+            *setB = allB;
+
+            while (DWT->CYCCNT - start < PARALLEL_NEOPIXEL_CYCLES_T0H) {
+            }
+
+            *clrA = zerosA;
+            *clrB = zerosB;
+
+            while (DWT->CYCCNT - start < PARALLEL_NEOPIXEL_CYCLES_T1H) {
+            }
+
+            *clrA = allA;
+            *clrB = allB;
+        }
+
+        while (DWT->CYCCNT - start < PARALLEL_NEOPIXEL_CYCLES_BIT) {
+        }
+    }
+};
+
+#endif
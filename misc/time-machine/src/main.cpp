@@ -1,8 +1,10 @@
 #include <Adafruit_NeoPixel.h>
+#include "ParallelNeoPixel.h"
 #include <Adafruit_VS1053.h>
 #include <Automaton.h>
 #include <SD.h>
 #include <SPI.h>
+#include "TrackCatalog.h"
 
 #define VS1053_RESET -1 // VS1053 reset pin (not used)
 #define VS1053_CS 6 // VS1053 chip select pin (output)
@@ -22,10 +24,17 @@ Adafruit_VS1053_FilePlayer musicPlayer = Adafruit_VS1053_FilePlayer(
     CARDCS);
 
 /**
- * Audio track names. 
+ * Audio tracks by id (index in TRACK_PATHS).
  */
 
-const String TRACK_LED_EFFECT = String("/effect.mp3");
+const uint8_t TRACK_LED_EFFECT = 0;
+const uint8_t TRACKS_NUM = 1;
+
+const char* const TRACK_PATHS[TRACKS_NUM] = {
+    "/effect.mp3"
+};
+
+TrackCatalog trackCatalog(TRACK_PATHS, TRACKS_NUM);
 
 const uint16_t TRACK_MARK_MS_ONE = 8000;
 
@@ -69,6 +78,25 @@ Adafruit_NeoPixel ledWheel = Adafruit_NeoPixel(
     LED_PIN_WHEEL,
     NEO_GRB + NEO_KHZ800);
 
+/**
+ * Parallel output of the bars and the wheel.
+ */
+
+const uint8_t LED_STRIPS_NUM = BARS_NUM + 1;
+
+Adafruit_NeoPixel *const LED_STRIPS[LED_STRIPS_NUM] = {
+    &ledsBar[0],
+    &ledsBar[1],
+    &ledsBar[2],
+    &ledWheel
+};
+
+ParallelNeoPixel ledsOut(LED_STRIPS, LED_STRIPS_NUM);
+
+const unsigned long LED_REPORT_MS = 5000;
+
+unsigned long lastLedReportMillis = 0;
+
 /**
  * LED effects timer.
  */
@@ -131,35 +159,6 @@ void initState()
     progState.ledPivotWheel = 0;
 }
 
-void printDirectory(File dir, int numTabs)
-{
-    while (true) {
-        File entry = dir.openNextFile();
-
-        if (!entry) {
-            // No more files
-            break;
-        }
-
-        for (uint8_t i = 0; i < numTabs; i++) {
-            Serial.print('\t');
-        }
-
-        Serial.print(entry.name());
-
-        if (entry.isDirectory()) {
-            Serial.println("/");
-            printDirectory(entry, numTabs + 1);
-        } else {
-            // Files have sizes, directories do not
-            Serial.print("\t\t");
-            Serial.println(entry.size(), DEC);
-        }
-
-        entry.close();
-    }
-}
-
 void boardPixelBlink(uint32_t color, uint16_t numLoops = 2, unsigned long delayMs = 25)
 {
     uint16_t counter = 0;
@@ -193,9 +192,11 @@ void initAudio()
     }
 
     Serial.println("SD OK");
-    Serial.println("Listing SD root");
 
-    printDirectory(SD.open("/"), 0);
+    if (!trackCatalog.begin()) {
+        Serial.println("Some tracks are missing");
+        boardPixelBlink(COLOR_ORANGE, 10, 250);
+    }
 
     // Set volume for left, right channels
     // lower numbers == louder volume
@@ -203,16 +204,33 @@ void initAudio()
     musicPlayer.useInterrupt(VS1053_FILEPLAYER_PIN_INT);
 }
 
-void playTrack(String trackName)
+void playTrack(uint8_t trackId)
 {
+    const TrackEntry* track = trackCatalog.get(trackId);
+
+    if (!track) {
+        Serial.print("Unknown track: ");
+        Serial.println(trackId);
+        return;
+    }
+
     if (!musicPlayer.stopped()) {
         Serial.println("Cannot play track: musicPlayer.stopped() != false");
     }
 
     Serial.print("Playing: ");
-    Serial.println(trackName);
+    Serial.print(track->path);
+    Serial.print(" (ms): ");
+    Serial.println(track->durationMs);
+
+    unsigned long startMicros = micros();
 
-    musicPlayer.startPlayingFile(trackName.c_str());
+    if (musicPlayer.startPlayingFile(track->path)) {
+        trackCatalog.verify(trackId, musicPlayer.currentTrack.size());
+    }
+
+    Serial.print("Start latency (us): ");
+    Serial.println(micros() - startMicros);
 }
 
 void initLeds()
@@ -221,13 +239,17 @@ void initLeds()
         ledsBar[i].begin();
         ledsBar[i].setBrightness(LED_BRIGHTNESS);
         ledsBar[i].clear();
-        ledsBar[i].show();
     }
 
     ledWheel.begin();
     ledWheel.setBrightness(LED_BRIGHTNESS);
     ledWheel.clear();
-    ledWheel.show();
+
+    if (!ledsOut.begin()) {
+        Serial.println("Parallel LED output failed: showing strips one by one");
+    }
+
+    ledsOut.show();
 
     boardPixel.begin();
     boardPixel.setBrightness(LED_BRIGHTNESS);
@@ -288,7 +310,6 @@ void refreshLedBars()
     if (!progState.isLedBarsUnlocked) {
         for (uint8_t i = 0; i < BARS_NUM; i++) {
             ledsBar[i].clear();
-            ledsBar[i].show();
         }
 
         return;
@@ -304,7 +325,6 @@ void refreshLedBars()
 
             if (fillCount > 0) {
                 ledsBar[i].fill(COLOR_ORANGE, 0, fillCount);
-                ledsBar[i].show();
             }
         }
 
@@ -316,7 +336,6 @@ void refreshLedBars()
 
         for (uint8_t i = 0; i < BARS_NUM; i++) {
             ledsBar[i].fill(color);
-            ledsBar[i].show();
         }
     }
 }
@@ -327,7 +346,6 @@ void refreshLedWheel()
 
     if (!progState.isLedWheelUnlocked) {
         ledWheel.clear();
-        ledWheel.show();
         return;
     }
 
@@ -335,7 +353,27 @@ void refreshLedWheel()
 
     ledWheel.clear();
     ledWheel.fill(COLOR_ORANGE, fillFirst, fillCount);
-    ledWheel.show();
+}
+
+/**
+ * Sends the bars and the wheel in a single parallel transfer.
+ */
+void showLeds()
+{
+    ledsOut.show();
+
+    unsigned long now = millis();
+
+    if (now - lastLedReportMillis < LED_REPORT_MS) {
+        return;
+    }
+
+    lastLedReportMillis = now;
+
+    Serial.print("LED transfer (us): ");
+    Serial.print(ledsOut.getTransferMicros());
+    Serial.print(" :: Frame (us): ");
+    Serial.println(ledsOut.getFrameMicros());
 }
 
 void updateUnlockState()
@@ -354,6 +392,7 @@ void onLedTimer(int idx, int v, int up)
 {
     refreshLedBars();
     refreshLedWheel();
+    showLeds();
     updateUnlockState();
     ledTick();
 }
@@ -397,7 +436,8 @@ void setup()
     initButtons();
     initAudio();
 
-    Serial.println(">> Time machine");
+    Serial.print(">> Time machine ready (ms): ");
+    Serial.println(millis());
 
     boardPixelBlink(COLOR_GREEN, 10, 50);
 }
@@ -405,4 +445,8 @@ void setup()
 void loop()
 {
     automaton.run();
+
+    if (musicPlayer.stopped()) {
+        trackCatalog.removeIfStale();
+    }
 }
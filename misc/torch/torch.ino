@@ -1,12 +1,13 @@
 #include <WS2812FX.h>
+#include "FireEffect.h"
 
 /**
  * LED strips.
  */
 
 const int LED_BRIGHTNESS = 200;
-// From 10 (very fast) to 5000 (very slow)
-const int LED_SPEED = 1000;
+// Frame time (ms) of the fire effect
+const int LED_SPEED = 30;
 const int LED_NUM = 20;
 const int LED_PIN = 10;
 
@@ -15,17 +16,47 @@ WS2812FX ws2812fx = WS2812FX(
     LED_PIN,
     NEO_GRB + NEO_KHZ800);
 
+/**
+ * Fire effect.
+ */
+
+const uint8_t FIRE_COOLING = 60;
+const uint8_t FIRE_SPARKING = 110;
+
+uint8_t heatTorch[LED_NUM];
+
+FireEffect<WS2812FX> fireTorch(
+    ws2812fx,
+    heatTorch,
+    1,
+    LED_NUM,
+    FIRE_PALETTE_HEAT,
+    FIRE_COOLING,
+    FIRE_SPARKING);
+
 /**
  * LED functions.
  */
 
+/**
+ * Custom WS2812FX mode: returns the delay (ms) until the next frame.
+ */
+uint16_t fireMode()
+{
+    fireTorch.draw();
+
+    return ws2812fx.getSpeed();
+}
+
 void initLed()
 {
+    fireTorch.begin();
+
     ws2812fx.init();
     ws2812fx.setBrightness(LED_BRIGHTNESS);
     ws2812fx.setSpeed(LED_SPEED);
-    ws2812fx.setColor(RED);
-    ws2812fx.setMode(FX_MODE_FIRE_FLICKER_INTENSE);
+    ws2812fx.setCustomMode(fireMode);
+    ws2812fx.setMode(FX_MODE_CUSTOM);
     ws2812fx.start();
 }
 
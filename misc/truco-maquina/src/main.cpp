@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include <Automaton.h>
 #include <CircularBuffer.h>
+#include "AudioFxScheduler.h"
 
 /**
  * Buttons.
@@ -30,6 +31,8 @@ const uint8_t PIN_AUDIO_TRACK_VICTORY = 5;
 const uint8_t PIN_AUDIO_TRACK_CLEANER = 6;
 const unsigned long AUDIO_PLAY_DELAY_MS = 200;
 
+AudioFxScheduler audio(PIN_AUDIO_ACT, AUDIO_PLAY_DELAY_MS);
+
 /**
  * Relays.
  */
@@ -43,25 +46,13 @@ const int PIN_RELAY_TWO = 11;
 
 CircularBuffer<uint8_t, BUTTON_COMBINATION_VICTORY_SIZE> buttonBuf;
 
-const uint8_t AUDIO_BUF_SIZE = 2;
-CircularBuffer<uint8_t, AUDIO_BUF_SIZE> audioPinsQueue;
-
 const uint32_t TIMER_GENERAL_MS = 150;
 Atm_timer timerGeneral;
 
-typedef struct programState
-{
-  unsigned long audioPlayMillis;
-} ProgramState;
-
-ProgramState progState = {
-    .audioPlayMillis = 0};
-
 void cleanState()
 {
-  progState.audioPlayMillis = 0;
   buttonBuf.clear();
-  audioPinsQueue.clear();
+  audio.clear();
 }
 
 /**
@@ -96,8 +87,8 @@ void initAudioPins()
   pinMode(PIN_AUDIO_TRACK_BACKGROUND, INPUT);
   pinMode(PIN_AUDIO_TRACK_VICTORY, INPUT);
   pinMode(PIN_AUDIO_TRACK_CLEANER, INPUT);
-  pinMode(PIN_AUDIO_ACT, INPUT);
   pinMode(PIN_AUDIO_RST, INPUT);
+  audio.begin();
 }
 
 void resetAudio()
@@ -123,78 +114,6 @@ void initAudio()
   resetAudio();
 }
 
-bool isTrackPlaying()
-{
-  return progState.audioPlayMillis > 0 || digitalRead(PIN_AUDIO_ACT) == LOW;
-}
-
-void playTrack(uint8_t trackPin, bool async = true)
-{
-  if (isTrackPlaying())
-  {
-    Serial.println(F("Skipping: Audio still playing"));
-    return;
-  }
-
-  digitalWrite(trackPin, LOW);
-  pinMode(trackPin, OUTPUT);
-
-  if (async)
-  {
-    progState.audioPlayMillis = millis();
-  }
-  else
-  {
-    progState.audioPlayMillis = 0;
-    delay(AUDIO_PLAY_DELAY_MS);
-    pinMode(trackPin, INPUT);
-  }
-}
-
-void clearAudioPins()
-{
-  progState.audioPlayMillis = 0;
-  pinMode(PIN_AUDIO_TRACK_BACKGROUND, INPUT);
-  pinMode(PIN_AUDIO_TRACK_VICTORY, INPUT);
-  pinMode(PIN_AUDIO_TRACK_CLEANER, INPUT);
-}
-
-void checkClearAudioPins()
-{
-  if (progState.audioPlayMillis == 0)
-  {
-    return;
-  }
-
-  unsigned long now = millis();
-  unsigned long diffMs = now - progState.audioPlayMillis;
-
-  if (diffMs >= AUDIO_PLAY_DELAY_MS)
-  {
-    Serial.println(F("Clearing audio pins"));
-    clearAudioPins();
-  }
-}
-
-void processAudioQueue()
-{
-  if (audioPinsQueue.isEmpty() || isTrackPlaying())
-  {
-    return;
-  }
-
-  Serial.print(F("Audio queue size: "));
-  Serial.println(audioPinsQueue.size());
-
-  int trackPin = audioPinsQueue.shift();
-  playTrack(trackPin);
-}
-
-void enqueueTrack(uint8_t trackPin)
-{
-  audioPinsQueue.push(trackPin);
-}
-
 /**
  * Function to check whether the button combination is correct.
  */
@@ -225,20 +144,20 @@ void onButtonCombinationCorrect()
 {
   const unsigned long iterDelayMs = 100;
   Serial.println(F("Button combination correct"));
-  clearAudioPins();
-  playTrack(PIN_AUDIO_TRACK_VICTORY, false);
+  audio.clear();
+  audio.play(PIN_AUDIO_TRACK_VICTORY, AUDIO_FX_SKIP_IF_BUSY);
 
-  while (isTrackPlaying())
+  while (audio.isBusy())
   {
-    delay(iterDelayMs);
+    audio.wait(iterDelayMs);
   }
 
   openRelays();
-  playTrack(PIN_AUDIO_TRACK_CLEANER, false);
+  audio.play(PIN_AUDIO_TRACK_CLEANER, AUDIO_FX_SKIP_IF_BUSY);
 
-  while (isTrackPlaying())
+  while (audio.isBusy())
   {
-    delay(iterDelayMs);
+    audio.wait(iterDelayMs);
   }
 }
 
@@ -270,9 +189,6 @@ void initButtons()
 
 void onTimerGeneral(int idx, int v, int up)
 {
-  checkClearAudioPins();
-  processAudioQueue();
-
   if (isButtonCombinationCorrect())
   {
     onButtonCombinationCorrect();
@@ -303,4 +219,5 @@ void setup()
 void loop()
 {
   automaton.run();
+  audio.update();
 }
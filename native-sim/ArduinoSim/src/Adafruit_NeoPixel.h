@@ -0,0 +1,319 @@
+#ifndef ARDUINO_SIM_ADAFRUIT_NEOPIXEL_H
+#define ARDUINO_SIM_ADAFRUIT_NEOPIXEL_H
+
+#include <Arduino.h>
+
+/**
+ * Host stand-in for Adafruit_NeoPixel. Pixels live in a buffer laid out
+ * as the library lays it out (wire order, brightness applied on write),
+ * so subclasses such as DirtyNeoPixel work on the same protected members.
+ * show() does not transfer anything: it counts the transfers and keeps
+ * the number of bytes a real strip would have been sent.
+ */
+
+typedef uint16_t neoPixelType;
+
+#define NEO_RGB ((0 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_RBG ((0 << 6) | (0 << 4) | (2 << 2) | (1))
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_GBR ((2 << 6) | (2 << 4) | (0 << 2) | (1))
+#define NEO_BRG ((1 << 6) | (1 << 4) | (2 << 2) | (0))
+#define NEO_BGR ((2 << 6) | (2 << 4) | (1 << 2) | (0))
+#define NEO_RGBW ((3 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_GRBW ((3 << 6) | (1 << 4) | (0 << 2) | (2))
+
+#define NEO_KHZ800 0x0000
+#define NEO_KHZ400 0x0100
+
+class Adafruit_NeoPixel
+{
+public:
+    Adafruit_NeoPixel(uint16_t n, uint16_t pin = 6, neoPixelType type = NEO_GRB + NEO_KHZ800)
+        : begun(false),
+          brightness(0),
+          pixels(NULL),
+          pin(pin),
+          numLEDs(0),
+          numBytes(0),
+          showCount(0),
+          bytesShown(0)
+    {
+        updateType(type);
+        updateLength(n);
+    }
+
+    Adafruit_NeoPixel()
+        : begun(false),
+          brightness(0),
+          pixels(NULL),
+          pin(-1),
+          numLEDs(0),
+          numBytes(0),
+          showCount(0),
+          bytesShown(0)
+    {
+        updateType(NEO_GRB + NEO_KHZ800);
+    }
+
+    ~Adafruit_NeoPixel()
+    {
+        free(pixels);
+    }
+
+    void begin()
+    {
+        if (pin >= 0)
+        {
+            pinMode(pin, OUTPUT);
+        }
+
+        begun = true;
+    }
+
+    void show()
+    {
+        showCount++;
+        bytesShown += numBytes;
+    }
+
+    void setPin(uint16_t p)
+    {
+        pin = p;
+    }
+
+    void updateLength(uint16_t n)
+    {
+        free(pixels);
+
+        numBytes = n * ((wOffset == rOffset) ? 3 : 4);
+        pixels = (uint8_t *)calloc(numBytes, 1);
+        numLEDs = pixels != NULL ? n : 0;
+        numBytes = pixels != NULL ? numBytes : 0;
+    }
+
+    void updateType(neoPixelType t)
+    {
+        wOffset = (t >> 6) & 0b11;
+        rOffset = (t >> 4) & 0b11;
+        gOffset = (t >> 2) & 0b11;
+        bOffset = t & 0b11;
+    }
+
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b)
+    {
+        if (n >= numLEDs)
+        {
+            return;
+        }
+
+        if (brightness)
+        {
+            r = (r * brightness) >> 8;
+            g = (g * brightness) >> 8;
+            b = (b * brightness) >> 8;
+        }
+
+        uint8_t *p = &pixels[n * (wOffset == rOffset ? 3 : 4)];
+
+        if (wOffset != rOffset)
+        {
+            p[wOffset] = 0;
+        }
+
+        p[rOffset] = r;
+        p[gOffset] = g;
+        p[bOffset] = b;
+    }
+
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+    {
+        setPixelColor(n, r, g, b);
+
+        if (n < numLEDs && wOffset != rOffset)
+        {
+            pixels[n * 4 + wOffset] = brightness ? (w * brightness) >> 8 : w;
+        }
+    }
+
+    void setPixelColor(uint16_t n, uint32_t c)
+    {
+        if (wOffset != rOffset)
+        {
+            setPixelColor(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c, (uint8_t)(c >> 24));
+        }
+        else
+        {
+            setPixelColor(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c);
+        }
+    }
+
+    void fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0)
+    {
+        if (first >= numLEDs)
+        {
+            return;
+        }
+
+        uint16_t end = count == 0 ? numLEDs : first + count;
+        end = end > numLEDs ? numLEDs : end;
+
+        for (uint16_t i = first; i < end; i++)
+        {
+            setPixelColor(i, c);
+        }
+    }
+
+    /**
+     * Scales the buffer the way the library does, so the result is as
+     * lossy as on the board.
+     */
+    void setBrightness(uint8_t b)
+    {
+        uint8_t newBrightness = b + 1;
+
+        if (newBrightness == brightness)
+        {
+            return;
+        }
+
+        uint8_t oldBrightness = brightness - 1;
+        uint16_t scale;
+
+        if (oldBrightness == 0)
+        {
+            scale = 0;
+        }
+        else if (b == 255)
+        {
+            scale = 65535 / oldBrightness;
+        }
+        else
+        {
+            scale = (((uint16_t)newBrightness << 8) - 1) / oldBrightness;
+        }
+
+        for (uint16_t i = 0; i < numBytes; i++)
+        {
+            pixels[i] = (pixels[i] * scale) >> 8;
+        }
+
+        brightness = newBrightness;
+    }
+
+    void clear()
+    {
+        memset(pixels, 0, numBytes);
+    }
+
+    uint32_t getPixelColor(uint16_t n) const
+    {
+        if (n >= numLEDs)
+        {
+            return 0;
+        }
+
+        const uint8_t *p = &pixels[n * (wOffset == rOffset ? 3 : 4)];
+        uint32_t c = ((uint32_t)p[rOffset] << 16) | ((uint32_t)p[gOffset] << 8) | p[bOffset];
+
+        if (wOffset != rOffset)
+        {
+            c |= (uint32_t)p[wOffset] << 24;
+        }
+
+        if (!brightness)
+        {
+            return c;
+        }
+
+        uint32_t r = (((c >> 16) & 0xFF) << 8) / brightness;
+        uint32_t g = (((c >> 8) & 0xFF) << 8) / brightness;
+        uint32_t b = ((c & 0xFF) << 8) / brightness;
+        uint32_t w = ((c >> 24) << 8) / brightness;
+
+        return (w << 24) | (r << 16) | (g << 8) | b;
+    }
+
+    uint8_t *getPixels() const
+    {
+        return pixels;
+    }
+
+    uint8_t getBrightness() const
+    {
+        return brightness - 1;
+    }
+
+    int16_t getPin() const
+    {
+        return pin;
+    }
+
+    uint16_t numPixels() const
+    {
+        return numLEDs;
+    }
+
+    bool canShow() const
+    {
+        return true;
+    }
+
+    /**
+     * Number of show() calls, i.e. transfers a real strip would do.
+     */
+    unsigned long getShowCount() const
+    {
+        return showCount;
+    }
+
+    unsigned long getBytesShown() const
+    {
+        return bytesShown;
+    }
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b)
+    {
+        return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    }
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+    {
+        return ((uint32_t)w << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    }
+
+    static uint8_t gamma8(uint8_t x)
+    {
+        // Same curve as the library's table: (x / 255) ^ 2.6
+        return (uint8_t)(pow(x / 255.0, 2.6) * 255.0 + 0.5);
+    }
+
+    static uint32_t gamma32(uint32_t x)
+    {
+        uint8_t *y = (uint8_t *)&x;
+
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            y[i] = gamma8(y[i]);
+        }
+
+        return x;
+    }
+
+protected:
+    bool begun;
+    uint8_t brightness;
+    uint8_t *pixels;
+    int16_t pin;
+    uint16_t numLEDs;
+    uint16_t numBytes;
+    uint8_t rOffset;
+    uint8_t gOffset;
+    uint8_t bOffset;
+    uint8_t wOffset;
+
+private:
+    unsigned long showCount;
+    unsigned long bytesShown;
+};
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef ARDUINO_SIM_ARDUINO_H
+#define ARDUINO_SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/**
+ * Host stand-in for the subset of the Arduino AVR core used by the
+ * sketches. Time is virtual: millis() and micros() only move when the
+ * simulation advances them (see ArduinoSim.h), and delay() advances the
+ * clock instead of sleeping. Pins are plain arrays the tests can drive.
+ */
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define BIN 2
+#define OCT 8
+#define DEC 10
+#define HEX 16
+
+const uint8_t A0 = 14;
+const uint8_t A1 = 15;
+const uint8_t A2 = 16;
+const uint8_t A3 = 17;
+const uint8_t A4 = 18;
+const uint8_t A5 = 19;
+const uint8_t A6 = 20;
+const uint8_t A7 = 21;
+
+const uint8_t NUM_DIGITAL_PINS = 22;
+
+/**
+ * Pins are grouped in 8-bit ports (pin / 8), whose input and output
+ * registers can be read and written directly as on the board.
+ */
+const uint8_t NUM_PORTS = (NUM_DIGITAL_PINS + 7) / 8;
+
+extern volatile uint8_t simPortInputs[NUM_PORTS];
+extern volatile uint8_t simPortOutputs[NUM_PORTS];
+
+#define digitalPinToPort(pin) ((uint8_t)(pin) / 8)
+#define digitalPinToBitMask(pin) ((uint8_t)(1 << ((uint8_t)(pin) % 8)))
+#define portInputRegister(port) (&simPortInputs[(port)])
+#define portOutputRegister(port) (&simPortOutputs[(port)])
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr) (*(void *const *)(addr))
+#define memcpy_P memcpy
+#define strcmp_P strcmp
+#define strlen_P strlen
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define abs(x) ((x) > 0 ? (x) : -(x))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define sq(x) ((x) * (x))
+
+#define bit(b) (1UL << (b))
+#define bitRead(value, b) (((value) >> (b)) & 0x01)
+#define bitSet(value, b) ((value) |= (1UL << (b)))
+#define bitClear(value, b) ((value) &= ~(1UL << (b)))
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+
+#define interrupts()
+#define noInterrupts()
+#define cli()
+#define sei()
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+class Print
+{
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+
+    size_t write(const char *str);
+    size_t write(const uint8_t *buffer, size_t size);
+
+    size_t print(const __FlashStringHelper *str);
+    size_t print(const char *str);
+    size_t print(char c);
+    size_t print(unsigned char n, int base = DEC);
+    size_t print(int n, int base = DEC);
+    size_t print(unsigned int n, int base = DEC);
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+
+    size_t println();
+
+    template <typename T>
+    size_t println(T value)
+    {
+        size_t n = print(value);
+        return n + println();
+    }
+
+    template <typename T>
+    size_t println(T value, int format)
+    {
+        size_t n = print(value, format);
+        return n + println();
+    }
+
+private:
+    size_t printNumber(unsigned long n, uint8_t base);
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+/**
+ * Serial port whose output is captured (see sim::serialOutput()) and
+ * whose input is fed with sim::serialInput().
+ */
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long) {}
+    void end() {}
+
+    int available();
+    int read();
+    int peek();
+    size_t write(uint8_t c);
+
+    using Print::write;
+
+    operator bool() const
+    {
+        return true;
+    }
+};
+
+extern HardwareSerial Serial;
+
+void setup();
+void loop();
+
+#endif
@@ -0,0 +1,412 @@
+#include <deque>
+#include <string>
+#include <ArduinoSim.h>
+
+namespace
+{
+
+const unsigned long DEFAULT_MAX_BLOCK_MILLIS = 60000;
+
+unsigned long long clockMicros = 0;
+unsigned long long blockedMicros = 0;
+unsigned long long loopBlockedMicros = 0;
+unsigned long long maxBlockMicros = DEFAULT_MAX_BLOCK_MILLIS * 1000ULL;
+bool isInLoop = false;
+bool hasTimedOut = false;
+
+uint8_t pinModes[NUM_DIGITAL_PINS];
+int analogValues[NUM_DIGITAL_PINS];
+
+std::string serialOut;
+std::deque<uint8_t> serialIn;
+
+uint32_t randomState = 1;
+
+void writePortBit(volatile uint8_t *reg, uint8_t pin, uint8_t level)
+{
+    if (level)
+    {
+        *reg |= digitalPinToBitMask(pin);
+    }
+    else
+    {
+        *reg &= ~digitalPinToBitMask(pin);
+    }
+}
+
+uint8_t readPortBit(const volatile uint8_t *reg, uint8_t pin)
+{
+    return *reg & digitalPinToBitMask(pin) ? HIGH : LOW;
+}
+
+uint32_t nextRandom()
+{
+    // xorshift32: deterministic across hosts, unlike rand()
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+
+    return randomState;
+}
+
+}
+
+namespace sim
+{
+
+void reset()
+{
+    clockMicros = 0;
+    blockedMicros = 0;
+    loopBlockedMicros = 0;
+    maxBlockMicros = DEFAULT_MAX_BLOCK_MILLIS * 1000ULL;
+    isInLoop = false;
+    hasTimedOut = false;
+
+    for (uint8_t port = 0; port < NUM_PORTS; port++)
+    {
+        simPortInputs[port] = 0;
+        simPortOutputs[port] = 0;
+    }
+
+    memset(pinModes, INPUT, sizeof(pinModes));
+    memset(analogValues, 0, sizeof(analogValues));
+
+    serialOut.clear();
+    serialIn.clear();
+
+    randomState = 1;
+}
+
+void setMaxBlockMillis(unsigned long ms)
+{
+    maxBlockMicros = ms * 1000ULL;
+}
+
+void advance(unsigned long ms)
+{
+    advanceMicros(ms * 1000UL);
+}
+
+void advanceMicros(unsigned long us)
+{
+    clockMicros += us;
+}
+
+void setPin(uint8_t pin, uint8_t level)
+{
+    if (pin < NUM_DIGITAL_PINS)
+    {
+        writePortBit(portInputRegister(digitalPinToPort(pin)), pin, level);
+    }
+}
+
+uint8_t getPin(uint8_t pin)
+{
+    if (pin >= NUM_DIGITAL_PINS)
+    {
+        return LOW;
+    }
+
+    uint8_t port = digitalPinToPort(pin);
+
+    return pinModes[pin] == OUTPUT
+               ? readPortBit(portOutputRegister(port), pin)
+               : readPortBit(portInputRegister(port), pin);
+}
+
+uint8_t getPinMode(uint8_t pin)
+{
+    return pin < NUM_DIGITAL_PINS ? pinModes[pin] : INPUT;
+}
+
+void setAnalog(uint8_t pin, int value)
+{
+    if (pin < NUM_DIGITAL_PINS)
+    {
+        analogValues[pin] = value;
+    }
+}
+
+unsigned long runFor(unsigned long ms, unsigned long stepUs)
+{
+    unsigned long long end = clockMicros + ms * 1000ULL;
+    unsigned long iterations = 0;
+
+    isInLoop = true;
+
+    try
+    {
+        while (clockMicros < end)
+        {
+            loopBlockedMicros = 0;
+            loop();
+            iterations++;
+            clockMicros += stepUs;
+        }
+    }
+    catch (const Timeout &)
+    {
+        hasTimedOut = true;
+    }
+
+    isInLoop = false;
+
+    return iterations;
+}
+
+bool timedOut()
+{
+    return hasTimedOut;
+}
+
+unsigned long blockedMillis()
+{
+    return blockedMicros / 1000ULL;
+}
+
+void press(uint8_t pin, unsigned long holdMs, unsigned long releaseMs)
+{
+    setPin(pin, LOW);
+    runFor(holdMs);
+    setPin(pin, HIGH);
+    runFor(releaseMs);
+}
+
+const std::string &serialOutput()
+{
+    return serialOut;
+}
+
+void clearSerial()
+{
+    serialOut.clear();
+}
+
+void serialInput(const std::string &data)
+{
+    serialIn.insert(serialIn.end(), data.begin(), data.end());
+}
+
+}
+
+/**
+ * Arduino core.
+ */
+
+HardwareSerial Serial;
+
+volatile uint8_t simPortInputs[NUM_PORTS];
+volatile uint8_t simPortOutputs[NUM_PORTS];
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin >= NUM_DIGITAL_PINS)
+    {
+        return;
+    }
+
+    pinModes[pin] = mode;
+
+    if (mode == INPUT_PULLUP)
+    {
+        sim::setPin(pin, HIGH);
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (pin < NUM_DIGITAL_PINS)
+    {
+        writePortBit(portOutputRegister(digitalPinToPort(pin)), pin, val);
+    }
+}
+
+int digitalRead(uint8_t pin)
+{
+    return sim::getPin(pin);
+}
+
+int analogRead(uint8_t pin)
+{
+    return pin < NUM_DIGITAL_PINS ? analogValues[pin] : 0;
+}
+
+void analogWrite(uint8_t pin, int val)
+{
+    digitalWrite(pin, val > 127 ? HIGH : LOW);
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(clockMicros / 1000ULL);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)clockMicros;
+}
+
+void delay(unsigned long ms)
+{
+    clockMicros += ms * 1000ULL;
+    blockedMicros += ms * 1000ULL;
+    loopBlockedMicros += ms * 1000ULL;
+
+    if (isInLoop && loopBlockedMicros > maxBlockMicros)
+    {
+        throw sim::Timeout();
+    }
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    clockMicros += us;
+}
+
+long random(long howBig)
+{
+    return howBig <= 0 ? 0 : nextRandom() % howBig;
+}
+
+long random(long howSmall, long howBig)
+{
+    return howSmall >= howBig ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed)
+{
+    randomState = seed != 0 ? seed : 1;
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+/**
+ * Print.
+ */
+
+size_t Print::write(const char *str)
+{
+    return str == NULL ? 0 : write((const uint8_t *)str, strlen(str));
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+
+    while (size--)
+    {
+        n += write(*buffer++);
+    }
+
+    return n;
+}
+
+size_t Print::print(const __FlashStringHelper *str)
+{
+    return write(reinterpret_cast<const char *>(str));
+}
+
+size_t Print::print(const char *str)
+{
+    return write(str);
+}
+
+size_t Print::print(char c)
+{
+    return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char n, int base)
+{
+    return print((unsigned long)n, base);
+}
+
+size_t Print::print(int n, int base)
+{
+    return print((long)n, base);
+}
+
+size_t Print::print(unsigned int n, int base)
+{
+    return print((unsigned long)n, base);
+}
+
+size_t Print::print(long n, int base)
+{
+    if (base == DEC && n < 0)
+    {
+        return write('-') + printNumber(-(unsigned long)n, DEC);
+    }
+
+    return printNumber((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+    return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits)
+{
+    char buf[32];
+
+    snprintf(buf, sizeof(buf), "%.*f", digits, n);
+
+    return write(buf);
+}
+
+size_t Print::println()
+{
+    return write("\r\n");
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base)
+{
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+
+    *str = '\0';
+    base = base < 2 ? 10 : base;
+
+    do
+    {
+        char c = n % base;
+        n /= base;
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+
+    return write(str);
+}
+
+int HardwareSerial::available()
+{
+    return serialIn.size();
+}
+
+int HardwareSerial::read()
+{
+    if (serialIn.empty())
+    {
+        return -1;
+    }
+
+    uint8_t c = serialIn.front();
+    serialIn.pop_front();
+
+    return c;
+}
+
+int HardwareSerial::peek()
+{
+    return serialIn.empty() ? -1 : serialIn.front();
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    serialOut.push_back((char)c);
+    return 1;
+}
@@ -0,0 +1,90 @@
+#ifndef ARDUINO_SIM_H
+#define ARDUINO_SIM_H
+
+#include <string>
+#include <Arduino.h>
+
+/**
+ * Control side of the host simulation: the virtual clock, the pins and
+ * the serial port, and a driver that runs the sketch's loop().
+ *
+ * The clock starts at 0 and only moves with advance(), runFor() and
+ * delay(). runFor() calls loop() and then advances the clock by one step,
+ * so a sketch that does not block sees loop() called every step. A
+ * blocking effect (delay() in a loop) is fast-forwarded: delay() moves the
+ * clock by its full duration at once and the time is added to
+ * blockedMillis(). An effect that never returns (e.g. a final animation
+ * that loops forever) is cut short once a single loop() call has blocked
+ * for longer than setMaxBlockMillis(): that runFor() then stops and
+ * timedOut() reports it.
+ */
+
+namespace sim
+{
+
+/**
+ * Thrown by delay() when loop() has blocked for too long.
+ */
+struct Timeout
+{
+};
+
+/**
+ * Puts the clock at 0, every pin LOW with no pull-up, the serial buffers
+ * empty and random() back to its first sequence. Does not reset the
+ * sketch's globals.
+ */
+void reset();
+
+/**
+ * Longest time a single loop() call may spend in delay() (default 60 s).
+ */
+void setMaxBlockMillis(unsigned long ms);
+
+void advance(unsigned long ms);
+void advanceMicros(unsigned long us);
+
+/**
+ * Drives an input pin as a button or sensor would.
+ */
+void setPin(uint8_t pin, uint8_t level);
+
+/**
+ * Level of a pin: what the sketch wrote to it, or the input level.
+ */
+uint8_t getPin(uint8_t pin);
+
+uint8_t getPinMode(uint8_t pin);
+
+void setAnalog(uint8_t pin, int value);
+
+/**
+ * Calls loop() and advances the clock by stepUs, until ms have passed.
+ * Returns the number of loop() calls.
+ */
+unsigned long runFor(unsigned long ms, unsigned long stepUs = 100);
+
+/**
+ * True if a runFor() since reset() was ended by a loop() that blocked for
+ * longer than setMaxBlockMillis().
+ */
+bool timedOut();
+
+/**
+ * Virtual time spent inside delay() since reset().
+ */
+unsigned long blockedMillis();
+
+/**
+ * Holds a button wired to GND (pulled up) pressed for holdMs, running
+ * the sketch, then releases it and runs it for releaseMs.
+ */
+void press(uint8_t pin, unsigned long holdMs = 50, unsigned long releaseMs = 50);
+
+const std::string &serialOutput();
+void clearSerial();
+void serialInput(const std::string &data);
+
+}
+
+#endif
@@ -0,0 +1,23 @@
+#include <Automaton.h>
+
+Appliance automaton;
+
+void Appliance::add(Machine &machine)
+{
+    if (machine.isRegistered)
+    {
+        return;
+    }
+
+    machine.isRegistered = true;
+    machine.next = first;
+    first = &machine;
+}
+
+void Appliance::run()
+{
+    for (Machine *machine = first; machine != NULL; machine = machine->next)
+    {
+        machine->cycle();
+    }
+}
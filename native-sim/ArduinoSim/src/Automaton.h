@@ -0,0 +1,385 @@
+#ifndef ARDUINO_SIM_AUTOMATON_H
+#define ARDUINO_SIM_AUTOMATON_H
+
+#include <Arduino.h>
+
+/**
+ * Host stand-in for the Automaton machines used by the sketches:
+ * Atm_timer, Atm_button and Atm_led. Machines register with the global
+ * appliance on begin() and automaton.run() cycles each of them once,
+ * against the virtual clock.
+ *
+ * Only the behaviour the sketches rely on is modelled: timer intervals
+ * and repeat counts, debounced button presses and LED on/off/blink.
+ */
+
+typedef void (*atm_cb_push_t)(int idx, int v, int up);
+
+const int ATM_COUNTER_OFF = -1;
+
+class Machine
+{
+public:
+    Machine() : next(NULL), isRegistered(false) {}
+    virtual ~Machine() {}
+
+    virtual void cycle() = 0;
+
+    Machine *next;
+    bool isRegistered;
+};
+
+class Appliance
+{
+public:
+    Appliance() : first(NULL) {}
+
+    void add(Machine &machine);
+
+    /**
+     * Cycles every machine once.
+     */
+    void run();
+
+private:
+    Machine *first;
+};
+
+extern Appliance automaton;
+
+struct atm_callback
+{
+    atm_cb_push_t callback;
+    int idx;
+
+    void push(int v, int up) const
+    {
+        if (callback != NULL)
+        {
+            callback(idx, v, up);
+        }
+    }
+};
+
+class Atm_timer : public Machine
+{
+public:
+    enum { IDLE, START, WAITD, TRIGGER, FINISH };
+    enum { EVT_START = 10, EVT_STOP, EVT_TOGGLE };
+
+    Atm_timer() : interval(0), repeats(1), count(0), current(IDLE), since(0)
+    {
+        ontimer.callback = NULL;
+        onfinish.callback = NULL;
+    }
+
+    Atm_timer &begin(unsigned long ms = 0, int repeatCount = 1)
+    {
+        interval = ms;
+        repeats = repeatCount;
+        current = IDLE;
+        automaton.add(*this);
+        return *this;
+    }
+
+    Atm_timer &interval_millis(unsigned long ms)
+    {
+        interval = ms;
+        return *this;
+    }
+
+    Atm_timer &repeat(int n)
+    {
+        repeats = n;
+        return *this;
+    }
+
+    Atm_timer &onTimer(atm_cb_push_t callback, int idx = 0)
+    {
+        ontimer.callback = callback;
+        ontimer.idx = idx;
+        return *this;
+    }
+
+    Atm_timer &onFinish(atm_cb_push_t callback, int idx = 0)
+    {
+        onfinish.callback = callback;
+        onfinish.idx = idx;
+        return *this;
+    }
+
+    Atm_timer &start()
+    {
+        count = 0;
+        since = millis();
+        current = WAITD;
+        return *this;
+    }
+
+    Atm_timer &stop()
+    {
+        current = IDLE;
+        return *this;
+    }
+
+    Atm_timer &trigger(int event)
+    {
+        if (event == EVT_START || (event == EVT_TOGGLE && current == IDLE))
+        {
+            start();
+        }
+        else
+        {
+            stop();
+        }
+
+        return *this;
+    }
+
+    int state() const
+    {
+        return current;
+    }
+
+    void cycle()
+    {
+        if (current != WAITD || millis() - since < interval)
+        {
+            return;
+        }
+
+        since = millis();
+        count++;
+        ontimer.push(count, 0);
+
+        if (current == WAITD && repeats != ATM_COUNTER_OFF && count >= repeats)
+        {
+            current = IDLE;
+            onfinish.push(count, 0);
+        }
+    }
+
+private:
+    unsigned long interval;
+    int repeats;
+    int count;
+    int current;
+    unsigned long since;
+    atm_callback ontimer;
+    atm_callback onfinish;
+};
+
+/**
+ * Button wired to GND with the internal pull-up: pressed reads LOW.
+ */
+class Atm_button : public Machine
+{
+public:
+    enum { IDLE, WAIT, PRESSED, REPEAT, RELEASE, LIDLE, LWAIT, LPRESSED, LRELEASE, WRELEASE, AUTO };
+    enum { BTN_PASS4 = -4, BTN_PASS3, BTN_PASS2, BTN_PASS1, BTN_RELEASE, BTN_PRESS1, BTN_PRESS2, BTN_PRESS3, BTN_PRESS4 };
+
+    static const unsigned long DEBOUNCE = 5;
+
+    Atm_button() : pin(0), debounceMs(DEBOUNCE), current(IDLE), since(0)
+    {
+        onpress.callback = NULL;
+        onrelease.callback = NULL;
+    }
+
+    Atm_button &begin(int attachedPin)
+    {
+        pin = attachedPin;
+        current = IDLE;
+        pinMode(pin, INPUT_PULLUP);
+        automaton.add(*this);
+        return *this;
+    }
+
+    Atm_button &debounce(int ms)
+    {
+        debounceMs = ms;
+        return *this;
+    }
+
+    Atm_button &onPress(atm_cb_push_t callback, int idx = 0)
+    {
+        onpress.callback = callback;
+        onpress.idx = idx;
+        return *this;
+    }
+
+    Atm_button &onRelease(atm_cb_push_t callback, int idx = 0)
+    {
+        onrelease.callback = callback;
+        onrelease.idx = idx;
+        return *this;
+    }
+
+    int state() const
+    {
+        return current;
+    }
+
+    void cycle()
+    {
+        bool isDown = digitalRead(pin) == LOW;
+
+        if (current == IDLE && isDown)
+        {
+            current = WAIT;
+            since = millis();
+        }
+        else if (current == WAIT && !isDown)
+        {
+            current = IDLE;
+        }
+        else if (current == WAIT && millis() - since >= debounceMs)
+        {
+            current = PRESSED;
+            onpress.push(1, 1);
+        }
+        else if (current == PRESSED && !isDown)
+        {
+            current = RELEASE;
+            since = millis();
+        }
+        else if (current == RELEASE && isDown)
+        {
+            current = PRESSED;
+        }
+        else if (current == RELEASE && millis() - since >= debounceMs)
+        {
+            current = IDLE;
+            onrelease.push(0, 0);
+        }
+    }
+
+private:
+    int pin;
+    unsigned long debounceMs;
+    int current;
+    unsigned long since;
+    atm_callback onpress;
+    atm_callback onrelease;
+};
+
+class Atm_led : public Machine
+{
+public:
+    enum { IDLE, ON, START, BLINK_OFF, LOOP, DONE, OFF, WT_ON, WT_START };
+    enum { EVT_ON_TIMER, EVT_OFF_TIMER, EVT_WT_TIMER, EVT_COUNTER, EVT_ON, EVT_OFF, EVT_BLINK, EVT_TOGGLE, EVT_TOGGLE_BLINK };
+
+    Atm_led() : pin(0), activeLow(false), onMs(500), offMs(500), repeats(ATM_COUNTER_OFF), count(0), current(IDLE), since(0) {}
+
+    Atm_led &begin(int attachedPin, bool isActiveLow = false)
+    {
+        pin = attachedPin;
+        activeLow = isActiveLow;
+        pinMode(pin, OUTPUT);
+        write(false);
+        current = IDLE;
+        automaton.add(*this);
+        return *this;
+    }
+
+    Atm_led &blink(unsigned long duration, unsigned long pauseDuration, int repeatCount = ATM_COUNTER_OFF)
+    {
+        onMs = duration;
+        offMs = pauseDuration;
+        repeats = repeatCount;
+        return *this;
+    }
+
+    Atm_led &blink()
+    {
+        return trigger(EVT_BLINK);
+    }
+
+    Atm_led &on()
+    {
+        return trigger(EVT_ON);
+    }
+
+    Atm_led &off()
+    {
+        return trigger(EVT_OFF);
+    }
+
+    Atm_led &start()
+    {
+        return trigger(EVT_BLINK);
+    }
+
+    Atm_led &trigger(int event)
+    {
+        if (event == EVT_ON)
+        {
+            current = ON;
+            write(true);
+        }
+        else if (event == EVT_OFF)
+        {
+            current = IDLE;
+            write(false);
+        }
+        else if (event == EVT_BLINK)
+        {
+            current = START;
+            count = 0;
+            since = millis();
+            write(true);
+        }
+        else if (event == EVT_TOGGLE)
+        {
+            trigger(current == IDLE ? EVT_ON : EVT_OFF);
+        }
+
+        return *this;
+    }
+
+    int state() const
+    {
+        return current;
+    }
+
+    void cycle()
+    {
+        if (current == START && millis() - since >= onMs)
+        {
+            current = BLINK_OFF;
+            since = millis();
+            write(false);
+        }
+        else if (current == BLINK_OFF && millis() - since >= offMs)
+        {
+            count++;
+
+            if (repeats != ATM_COUNTER_OFF && count >= repeats)
+            {
+                current = DONE;
+                return;
+            }
+
+            current = START;
+            since = millis();
+            write(true);
+        }
+    }
+
+private:
+    int pin;
+    bool activeLow;
+    unsigned long onMs;
+    unsigned long offMs;
+    int repeats;
+    int count;
+    int current;
+    unsigned long since;
+
+    void write(bool isOn)
+    {
+        digitalWrite(pin, isOn != activeLow ? HIGH : LOW);
+    }
+};
+
+#endif
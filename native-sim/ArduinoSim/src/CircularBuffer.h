@@ -0,0 +1,114 @@
+#ifndef ARDUINO_SIM_CIRCULAR_BUFFER_H
+#define ARDUINO_SIM_CIRCULAR_BUFFER_H
+
+#include <Arduino.h>
+
+/**
+ * Host stand-in for the CircularBuffer library (rlogiacco): same API,
+ * same overwrite-the-oldest behaviour on push() when full.
+ */
+
+template <typename T, size_t S, typename IT = uint16_t>
+class CircularBuffer
+{
+public:
+    typedef IT index_t;
+
+    static const IT capacity = S;
+
+    CircularBuffer() : head(0), count(0) {}
+
+    bool unshift(T value)
+    {
+        head = head == 0 ? S - 1 : head - 1;
+        buffer[head] = value;
+
+        if (count == S)
+        {
+            return false;
+        }
+
+        count++;
+
+        return true;
+    }
+
+    bool push(T value)
+    {
+        if (count == S)
+        {
+            buffer[head] = value;
+            head = (head + 1) % S;
+            return false;
+        }
+
+        buffer[(head + count) % S] = value;
+        count++;
+
+        return true;
+    }
+
+    T shift()
+    {
+        T value = buffer[head];
+        head = (head + 1) % S;
+        count--;
+
+        return value;
+    }
+
+    T pop()
+    {
+        count--;
+
+        return buffer[(head + count) % S];
+    }
+
+    T first() const
+    {
+        return buffer[head];
+    }
+
+    T last() const
+    {
+        return buffer[(head + count - 1) % S];
+    }
+
+    T operator[](IT index) const
+    {
+        return buffer[(head + index) % S];
+    }
+
+    IT size() const
+    {
+        return count;
+    }
+
+    IT available() const
+    {
+        return S - count;
+    }
+
+    bool isEmpty() const
+    {
+        return count == 0;
+    }
+
+    bool isFull() const
+    {
+        return count == S;
+    }
+
+    void clear()
+    {
+        head = 0;
+        count = 0;
+    }
+
+private:
+    T buffer[S];
+    IT head;
+    IT count;
+};
+
+#endif
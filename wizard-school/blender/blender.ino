@@ -1,4 +1,6 @@
 #include "rdm630.h"
+#include "RfidFrameParser.h"
+#include "TagPresenceTracker.h"
 #include <Automaton.h>
 #include <Atm_servo.h>
 #include <Adafruit_NeoPixel.h>
@@ -28,15 +30,24 @@ RDM6300 rfidReaders[NUM_READERS] = {
     rfid03,
     rfid04};
 
-const unsigned int EMPTY_TOLERANCE = 1;
+// First 10 hex chars of each tag ID
+const uint8_t VALID_TAGS[NUM_READERS][RFID_TAG_ID_SIZE] PROGMEM = {
+    {0x2B, 0x00, 0x46, 0x3A, 0x21},
+    {0x1D, 0x00, 0x27, 0xF7, 0x93},
+    {0x2B, 0x00, 0x45, 0xA3, 0xD8},
+    {0x2B, 0x00, 0x45, 0x5B, 0x47}};
 
-String currentTags[NUM_READERS];
+const unsigned long TAG_ARRIVE_MS = 100;
+const unsigned long TAG_LEAVE_MS = 1000;
 
-String validTags[NUM_READERS] = {
-    "2B00463A2100",
-    "1D0027F79300",
-    "2B0045A3D800",
-    "2B00455B4700"};
+bool isValidTag(uint8_t reader, const RfidTagId &tag);
+
+TagPresenceTracker tagTracker(
+    NUM_READERS,
+    TAG_ARRIVE_MS,
+    TAG_LEAVE_MS,
+    isValidTag,
+    NULL);
 
 /**
  * LED.
@@ -86,7 +97,6 @@ typedef struct programState
     bool isRfidEnabled;
     bool isLedBlobEnabled;
     int currLedIndex;
-    unsigned int emptyReadCount[NUM_READERS];
 } ProgramState;
 
 ProgramState progState = {
@@ -94,8 +104,7 @@ ProgramState progState = {
     .isServoEnabled = false,
     .isRfidEnabled = true,
     .isLedBlobEnabled = false,
-    .currLedIndex = 0,
-    .emptyReadCount = {0, 0, 0, 0}};
+    .currLedIndex = 0};
 
 void enableEffects()
 {
@@ -111,12 +120,15 @@ void disableEffects()
     progState.isRfidEnabled = true;
 }
 
+/**
+ * Called when the tags on the readers change.
+ */
 void updateState()
 {
     const int effectDelayMs = 5000;
 
-    bool defined = areTagsDefined();
-    bool valid = areTagsValid();
+    bool defined = tagTracker.areAllPresent();
+    bool valid = tagTracker.areAllValid();
 
     if (defined && valid && !progState.isRelayOpen)
     {
@@ -131,19 +143,16 @@ void updateState()
         }
 
         disableEffects();
-        emptyTags();
         openRelay();
     }
     else if (defined && !valid && !progState.isRelayOpen)
     {
         Serial.println(F("State :: Defined && !Valid && !Open"));
-        emptyTags();
         showLedError();
     }
     else if (!valid && progState.isRelayOpen)
     {
         Serial.println(F("State :: !Valid && Open"));
-        emptyTags();
         lockRelay();
     }
 }
@@ -183,100 +192,37 @@ void initServo()
  * RFID functions.
  */
 
-void emptyTags()
-{
-    for (int i = 0; i < NUM_READERS; i++)
-    {
-        currentTags[i] = "";
-    }
-}
-
 void initRfidReaders()
 {
     for (int i = 0; i < NUM_READERS; i++)
     {
         rfidReaders[i].begin();
     }
-}
-
-void pollRfidReaders()
-{
-    String tagId;
-
-    for (int i = 0; i < NUM_READERS; i++)
-    {
-        tagId = rfidReaders[i].getTagId();
-
-        if (tagId.length())
-        {
-            progState.emptyReadCount[i] = 0;
-        }
-        else if (progState.emptyReadCount[i] <= EMPTY_TOLERANCE)
-        {
-            progState.emptyReadCount[i] += 1;
-        }
-
-        if (!tagId.length() &&
-            currentTags[i].length() &&
-            progState.emptyReadCount[i] <= EMPTY_TOLERANCE)
-        {
-            Serial.print(F("Ignoring empty read on reader: "));
-            Serial.println(i);
-            continue;
-        }
-
-        currentTags[i] = tagId;
-    }
-}
-
-bool areTagsDefined()
-{
-    for (int i = 0; i < NUM_READERS; i++)
-    {
-        if (!isTagDefined(i))
-        {
-            return false;
-        }
-    }
 
-    return true;
+    tagTracker.setLog(Serial);
 }
 
-bool isTagDefined(int idx)
+/**
+ * Returns true if the tags on the readers changed.
+ */
+bool pollRfidReaders()
 {
-    return currentTags[idx].length() > 0;
-}
+    RfidTagId tag;
 
-bool areTagsValid()
-{
     for (int i = 0; i < NUM_READERS; i++)
     {
-        if (!isTagDefined(i))
-        {
-            return false;
-        }
-
-        if (validTags[i].compareTo(currentTags[i]) != 0)
+        if (rfidParseTag(rfidReaders[i].getTagId().c_str(), tag))
         {
-            return false;
+            tagTracker.seen(i, tag, millis());
         }
     }
 
-    return true;
+    return tagTracker.update(millis());
 }
 
-void printCurrentTags()
+bool isValidTag(uint8_t reader, const RfidTagId &tag)
 {
-
-    Serial.print(F("## Current tags :: "));
-    Serial.println(millis());
-
-    for (int i = 0; i < NUM_READERS; i++)
-    {
-        Serial.print(i);
-        Serial.print(F(" :: "));
-        Serial.println(currentTags[i]);
-    }
+    return rfidIsTag(tag, VALID_TAGS[reader]);
 }
 
 /**
@@ -382,15 +328,8 @@ void setup()
 
 void loop()
 {
-    if (progState.isRfidEnabled)
+    if (progState.isRfidEnabled && pollRfidReaders())
     {
-        pollRfidReaders();
-        printCurrentTags();
+        updateState();
     }
-    else
-    {
-        emptyTags();
-    }
-
-    updateState();
 }
@@ -0,0 +1,231 @@
+#ifndef KNOCK_MATCHER_H
+#define KNOCK_MATCHER_H
+
+#include <Arduino.h>
+
+/**
+ * Streaming matcher of a knock rhythm played at any tempo within bounds.
+ *
+ * The pattern is the offset of each knock from the first one, learnt as
+ * the running mean of the samples passed to learn() and written to the
+ * array given to the constructor.
+ *
+ * Every knock may start the pattern, so up to KNOCK_PATTERN_SIZE
+ * candidate alignments are live at a time. A candidate keeps the range
+ * of tempos that fit every knock it matched so far: at tempo t the knock
+ * j is expected at t * (pattern[j] +- tol). Each knock narrows the range,
+ * so no single early or late knock sets the tempo. feed() costs
+ * O(KNOCK_PATTERN_SIZE) per knock.
+ */
+
+const uint8_t KNOCK_PATTERN_SIZE = 5;
+
+// Fixed-point (x256) factors: tolerance is relative to the mean
+// knock interval, tempo bounds are relative to the learnt pattern
+const uint32_t KNOCK_TOLERANCE_Q8 = 64;
+const uint32_t KNOCK_TEMPO_MIN_Q8 = 179;
+const uint32_t KNOCK_TEMPO_MAX_Q8 = 358;
+const uint16_t KNOCK_LEARN_MAX_SAMPLES = 32;
+
+typedef struct knockCandidate
+{
+    unsigned long start;
+    uint16_t tempoMinQ8;
+    uint16_t tempoMaxQ8;
+    uint8_t matched;
+} KnockCandidate;
+
+class KnockMatcher
+{
+public:
+    KnockMatcher(unsigned int *pattern)
+        : pattern(pattern),
+          patternSamples(0),
+          toleranceQ8(0),
+          numCandidates(0),
+          lastKnocksHead(0),
+          isMatch(false)
+    {
+        memset(patternSums, 0, sizeof(patternSums));
+    }
+
+    /**
+     * Folds one sample (knock offsets from the first knock) into the
+     * running mean that defines the pattern. Once the sample cap is
+     * reached the oldest contribution is approximated by the current mean.
+     */
+    void learn(const unsigned int *offsets)
+    {
+        if (patternSamples >= KNOCK_LEARN_MAX_SAMPLES)
+        {
+            for (uint8_t i = 0; i < KNOCK_PATTERN_SIZE; i++)
+            {
+                patternSums[i] -= pattern[i];
+            }
+
+            patternSamples--;
+        }
+
+        patternSamples++;
+
+        uint16_t n = patternSamples;
+
+        for (uint8_t i = 0; i < KNOCK_PATTERN_SIZE; i++)
+        {
+            patternSums[i] += offsets[i];
+            pattern[i] = (patternSums[i] + n / 2) / n;
+        }
+
+        // The mean interval telescopes to the last offset over the gap count
+        uint32_t meanDiff = pattern[KNOCK_PATTERN_SIZE - 1] / (KNOCK_PATTERN_SIZE - 1);
+        toleranceQ8 = meanDiff * KNOCK_TOLERANCE_Q8;
+    }
+
+    /**
+     * The matched knocks are always the last KNOCK_PATTERN_SIZE ones.
+     * Their offsets are normalized to the learnt tempo, taken over all of
+     * them, and learnt.
+     */
+    void learnLastMatch()
+    {
+        unsigned int offsets[KNOCK_PATTERN_SIZE];
+        unsigned long start = lastKnocks[lastKnocksHead];
+        uint32_t elapsedSum = 0;
+        uint32_t patternSum = 0;
+
+        for (uint8_t i = 1; i < KNOCK_PATTERN_SIZE; i++)
+        {
+            elapsedSum += lastKnock(i) - start;
+            patternSum += pattern[i];
+        }
+
+        if (elapsedSum == 0)
+        {
+            return;
+        }
+
+        for (uint8_t i = 0; i < KNOCK_PATTERN_SIZE; i++)
+        {
+            unsigned long elapsed = lastKnock(i) - start;
+            offsets[i] = (elapsed * patternSum + elapsedSum / 2) / elapsedSum;
+        }
+
+        learn(offsets);
+    }
+
+    void reset()
+    {
+        numCandidates = 0;
+        lastKnocksHead = 0;
+        isMatch = false;
+    }
+
+    /**
+     * Advances every live alignment with the new knock and starts a new
+     * one at it.
+     */
+    void feed(unsigned long now)
+    {
+        lastKnocks[lastKnocksHead] = now;
+        lastKnocksHead = (lastKnocksHead + 1) % KNOCK_PATTERN_SIZE;
+
+        uint8_t kept = 0;
+
+        for (uint8_t i = 0; i < numCandidates; i++)
+        {
+            KnockCandidate candidate = candidates[i];
+
+            if (!advance(candidate, now))
+            {
+                continue;
+            }
+
+            if (candidate.matched == KNOCK_PATTERN_SIZE)
+            {
+                isMatch = true;
+                continue;
+            }
+
+            candidates[kept++] = candidate;
+        }
+
+        if (kept < KNOCK_PATTERN_SIZE)
+        {
+            candidates[kept].start = now;
+            candidates[kept].tempoMinQ8 = KNOCK_TEMPO_MIN_Q8;
+            candidates[kept].tempoMaxQ8 = KNOCK_TEMPO_MAX_Q8;
+            candidates[kept].matched = 1;
+            kept++;
+        }
+
+        numCandidates = kept;
+    }
+
+    bool isMatched() const
+    {
+        return isMatch;
+    }
+
+private:
+    unsigned int *pattern;
+    uint32_t patternSums[KNOCK_PATTERN_SIZE];
+    uint16_t patternSamples;
+    uint32_t toleranceQ8;
+
+    KnockCandidate candidates[KNOCK_PATTERN_SIZE];
+    uint8_t numCandidates;
+    unsigned long lastKnocks[KNOCK_PATTERN_SIZE];
+    uint8_t lastKnocksHead;
+    bool isMatch;
+
+    /**
+     * The i-th of the last KNOCK_PATTERN_SIZE knocks, oldest first.
+     */
+    unsigned long lastKnock(uint8_t i) const
+    {
+        return lastKnocks[(lastKnocksHead + i) % KNOCK_PATTERN_SIZE];
+    }
+
+    /**
+     * Checks a candidate against the knock at the given time. The knock
+     * fits the tempos from elapsed / (offset + tol) to
+     * elapsed / (offset - tol). The candidate lives on while that range
+     * overlaps the one left by its previous knocks.
+     */
+    bool advance(KnockCandidate &candidate, unsigned long now)
+    {
+        uint32_t elapsed = now - candidate.start;
+        uint32_t offset = pattern[candidate.matched];
+        uint32_t maxElapsed = ((uint32_t)pattern[KNOCK_PATTERN_SIZE - 1] * KNOCK_TEMPO_MAX_Q8) >> 8;
+
+        if (elapsed > maxElapsed || offset == 0)
+        {
+            return false;
+        }
+
+        uint32_t elapsedQ8 = elapsed << 8;
+        uint32_t tol = toleranceQ8 >> 8;
+        uint32_t tempoMin = elapsedQ8 / (offset + tol);
+        uint32_t tempoMax = offset > tol ? elapsedQ8 / (offset - tol) : KNOCK_TEMPO_MAX_Q8;
+
+        if (tempoMin > candidate.tempoMaxQ8 || tempoMax < candidate.tempoMinQ8)
+        {
+            return false;
+        }
+
+        if (tempoMin > candidate.tempoMinQ8)
+        {
+            candidate.tempoMinQ8 = tempoMin;
+        }
+
+        if (tempoMax < candidate.tempoMaxQ8)
+        {
+            candidate.tempoMaxQ8 = tempoMax;
+        }
+
+        candidate.matched++;
+        return true;
+    }
+};
+
+#endif
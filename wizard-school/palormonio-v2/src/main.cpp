@@ -2,6 +2,7 @@
 #include <Adafruit_NeoPixel.h>
 #include <CircularBuffer.h>
 #include "limits.h"
+#include "KnockMatcher.h"
 
 /**
   Program state.
@@ -48,10 +49,7 @@ const int KNOCK_RANGE_MIN = 0;
 const int KNOCK_RANGE_MAX = 100;
 const int KNOCK_THRESHOLD = 20;
 const int KNOCK_SAMPLERATE = 50;
-const int KNOCK_BUF_SIZE = 30;
 const int KNOCK_TRAINING_SIZE = 5;
-const int KNOCK_PATTERN_SIZE = 5;
-const float KNOCK_TOLERANCE = 0.6;
 const unsigned int KNOCK_DELAY_MS = 150;
 
 unsigned int knockTrainingSet[KNOCK_TRAINING_SIZE][KNOCK_PATTERN_SIZE] = {
@@ -63,9 +61,8 @@ unsigned int knockTrainingSet[KNOCK_TRAINING_SIZE][KNOCK_PATTERN_SIZE] = {
 
 Atm_analog knockAnalog;
 Atm_controller knockController;
-CircularBuffer<unsigned long, KNOCK_BUF_SIZE> knockHistory;
-float knockPattern[KNOCK_PATTERN_SIZE];
-float meanKnockPatternDiff;
+unsigned int knockPattern[KNOCK_PATTERN_SIZE];
+KnockMatcher knockMatcher(knockPattern);
 
 /**
  * Proximity sensors.
@@ -167,21 +164,8 @@ void resetAudio()
    Knock sensor functions.
 */
 
-void setKnockPattern()
+void printKnockPattern()
 {
-  for (int i = 0; i < KNOCK_PATTERN_SIZE; i++)
-  {
-    float val = 0;
-
-    for (int j = 0; j < KNOCK_TRAINING_SIZE; j++)
-    {
-      val = val + knockTrainingSet[j][i];
-    }
-
-    val = val / KNOCK_TRAINING_SIZE;
-    knockPattern[i] = val;
-  }
-
   Serial.print(F("Knock pattern: "));
 
   for (int i = 0; i < KNOCK_PATTERN_SIZE; i++)
@@ -193,67 +177,19 @@ void setKnockPattern()
   Serial.println(F(""));
 }
 
-void setMeanKnockPatternDiff()
+void initKnockPattern()
 {
-  float val = 0;
-
-  for (int i = 1; i < KNOCK_PATTERN_SIZE; i++)
+  for (int i = 0; i < KNOCK_TRAINING_SIZE; i++)
   {
-    val = val + (knockPattern[i] - knockPattern[i - 1]);
+    knockMatcher.learn(knockTrainingSet[i]);
   }
 
-  val = val / (KNOCK_PATTERN_SIZE - 1);
-
-  Serial.print(F("Avg. knock pattern wait (ms): "));
-  Serial.println(val);
-
-  meanKnockPatternDiff = val;
+  printKnockPattern();
 }
 
 bool isValidKnockPattern()
 {
-  if (knockHistory.size() < KNOCK_PATTERN_SIZE)
-  {
-    return false;
-  }
-
-  float tol = meanKnockPatternDiff * KNOCK_TOLERANCE;
-
-  int currIdx;
-  unsigned long baseTime;
-  unsigned long currTime;
-  float timeMin;
-  float timeMax;
-  bool isValid;
-
-  int maxOffset = knockHistory.size() - KNOCK_PATTERN_SIZE;
-
-  for (int i = 0; i <= maxOffset; i++)
-  {
-    isValid = true;
-    baseTime = knockHistory[i];
-
-    for (int j = 0; j < KNOCK_PATTERN_SIZE; j++)
-    {
-      currIdx = i + j;
-      currTime = knockHistory[currIdx] - baseTime;
-      timeMin = knockPattern[j] > tol ? knockPattern[j] - tol : 0;
-      timeMax = knockPattern[j] + tol;
-
-      if (currTime < timeMin || currTime > timeMax)
-      {
-        isValid = false;
-        break;
-      }
-    }
-
-    if (isValid)
-    {
-      return true;
-    }
-  }
-
-  return false;
+  return knockMatcher.isMatched();
 }
 
 void showLedsKnock()
@@ -279,7 +215,7 @@ void onKnock(int idx, int v, int up)
   {
     Serial.println(F("Millis overflow: History reset"));
     progState.lastKnock = 0;
-    knockHistory.clear();
+    knockMatcher.reset();
     return;
   }
 
@@ -291,7 +227,7 @@ void onKnock(int idx, int v, int up)
     Serial.println(F("::K"));
 
     progState.lastKnock = now;
-    knockHistory.push(now);
+    knockMatcher.feed(now);
     showLedsKnock();
     progState.ledKnockClearCountdown = LED_KNOCK_SHOW_ITERS;
   }
@@ -299,8 +235,8 @@ void onKnock(int idx, int v, int up)
 
 void initKnockSensor()
 {
-  setKnockPattern();
-  setMeanKnockPatternDiff();
+  initKnockPattern();
+  knockMatcher.reset();
 
   knockAnalog
       .begin(KNOCK_PIN, KNOCK_SAMPLERATE)
@@ -462,8 +398,8 @@ void updateLedPattern()
 
   unsigned long diff = now - progState.ledPatternStartMillis;
 
-  float limitMillisSoft = knockPattern[KNOCK_PATTERN_SIZE - 1];
-  float limitMillisHard = limitMillisSoft + LED_PATTERN_CLEAR_MS;
+  unsigned long limitMillisSoft = knockPattern[KNOCK_PATTERN_SIZE - 1];
+  unsigned long limitMillisHard = limitMillisSoft + LED_PATTERN_CLEAR_MS;
 
   if (diff >= limitMillisSoft)
   {
@@ -498,7 +434,7 @@ void updateLedPattern()
     return;
   }
 
-  float limitMillisShow = knockPattern[currIdx] + LED_PATTERN_CLEAR_MS;
+  unsigned long limitMillisShow = knockPattern[currIdx] + LED_PATTERN_CLEAR_MS;
 
   if (diff < limitMillisShow)
   {
@@ -598,6 +534,8 @@ void updateState()
 
   if (!progState.isRelayOpen && isValidKnockPattern())
   {
+    knockMatcher.learnLastMatch();
+    printKnockPattern();
     openRelay();
   }
 
@@ -0,0 +1,183 @@
+#include <random>
+#include <ArduinoSim.h>
+#include "../../include/KnockMatcher.h"
+
+/**
+ * Host test of KnockMatcher: the learnt pattern of the sketch replayed at
+ * several tempos with one knock early or late and some jitter on the
+ * others, after a couple of stray knocks, and random knocking.
+ *
+ * Build and run from this directory with the native simulation core:
+ *
+ *   g++ -O2 -I ../../../../native-sim/ArduinoSim/src knock_matcher_test.cpp \
+ *       ../../../../native-sim/ArduinoSim/src/ArduinoSim.cpp -o knock_matcher_test
+ *   ./knock_matcher_test
+ *
+ * Exits with 1 if a check fails. It is not a PlatformIO test, so the
+ * board environment ignores this directory.
+ */
+
+const int NUM_RUNS = 500;
+const int NUM_RANDOM_RUNS = 2000;
+
+// Training set of the sketch
+const unsigned int TRAINING_SET[][KNOCK_PATTERN_SIZE] = {
+    {0, 478, 1279, 1609, 2292},
+    {0, 595, 1448, 1775, 2354},
+    {0, 596, 1446, 1751, 2409},
+    {0, 621, 1549, 1840, 2462},
+    {0, 556, 1542, 1846, 2477}};
+
+int numFailures = 0;
+
+#define CHECK(cond)                                           \
+    do                                                        \
+    {                                                         \
+        if (!(cond))                                          \
+        {                                                     \
+            printf("FAIL line %d: %s\n", __LINE__, #cond);    \
+            numFailures++;                                    \
+        }                                                     \
+    } while (0)
+
+unsigned int pattern[KNOCK_PATTERN_SIZE];
+KnockMatcher matcher(pattern);
+std::mt19937 rng(1);
+
+/**
+ * Plays the pattern at the given tempo with knock 1 moved by shiftMs
+ * (scaled by the tempo) and 40 ms of jitter on knocks 2 and up.
+ */
+bool playPattern(double tempo, double shiftMs)
+{
+    std::normal_distribution<double> jitter(0, 40 * tempo);
+    unsigned long start = 10000;
+
+    matcher.reset();
+    matcher.feed(start - 3000);
+    matcher.feed(start - 1700);
+
+    for (int i = 0; i < KNOCK_PATTERN_SIZE; i++)
+    {
+        double offset = pattern[i] * tempo;
+
+        if (i == 1)
+        {
+            offset += shiftMs * tempo;
+        }
+        else if (i > 1)
+        {
+            offset += jitter(rng);
+        }
+
+        matcher.feed(start + (unsigned long)offset);
+    }
+
+    return matcher.isMatched();
+}
+
+int countMatches(double tempo, double shiftMs)
+{
+    int matches = 0;
+
+    for (int k = 0; k < NUM_RUNS; k++)
+    {
+        matches += playPattern(tempo, shiftMs);
+    }
+
+    printf("tempo %.2f, knock 1 %+4.0f ms: %d/%d\n", tempo, shiftMs, matches, NUM_RUNS);
+
+    return matches;
+}
+
+void testTempoAndShift()
+{
+    const double tempos[] = {0.75, 1.0, 1.3};
+    const double shifts[] = {0, -150, 150};
+
+    for (double tempo : tempos)
+    {
+        for (double shift : shifts)
+        {
+            CHECK(countMatches(tempo, shift) >= NUM_RUNS * 99 / 100);
+        }
+    }
+
+    // Out of the tempo bounds
+    CHECK(countMatches(0.6, 0) == 0);
+    CHECK(countMatches(1.5, 0) == 0);
+}
+
+void testRandomKnocking()
+{
+    std::uniform_int_distribution<int> gap(150, 1500);
+    int matches = 0;
+
+    for (int k = 0; k < NUM_RANDOM_RUNS; k++)
+    {
+        unsigned long now = 10000;
+
+        matcher.reset();
+
+        for (int j = 0; j < 8; j++)
+        {
+            now += gap(rng);
+            matcher.feed(now);
+        }
+
+        matches += matcher.isMatched();
+    }
+
+    printf("random: %d/%d\n", matches, NUM_RANDOM_RUNS);
+
+    // The fixed +-0.6 x mean window the sketch used before matched 366
+    CHECK(matches < 340);
+}
+
+void testLearnLastMatch()
+{
+    unsigned int before = pattern[KNOCK_PATTERN_SIZE - 1];
+
+    // A slow but exact play is learnt at the learnt tempo
+    matcher.reset();
+
+    for (int i = 0; i < KNOCK_PATTERN_SIZE; i++)
+    {
+        matcher.feed(50000 + pattern[i] * 5 / 4);
+    }
+
+    CHECK(matcher.isMatched());
+
+    matcher.learnLastMatch();
+
+    long drift = (long)pattern[KNOCK_PATTERN_SIZE - 1] - (long)before;
+
+    CHECK(drift >= -2 && drift <= 2);
+}
+
+void setup()
+{
+}
+
+void loop()
+{
+}
+
+int main()
+{
+    for (const unsigned int *offsets : TRAINING_SET)
+    {
+        matcher.learn(offsets);
+    }
+
+    CHECK(pattern[0] == 0);
+    CHECK(pattern[KNOCK_PATTERN_SIZE - 1] == 2399);
+
+    testTempoAndShift();
+    testRandomKnocking();
+    testLearnLastMatch();
+
+    printf(numFailures == 0 ? "OK\n" : "FAILED\n");
+
+    return numFailures == 0 ? 0 : 1;
+}
@@ -1,5 +1,6 @@
 #include <Automaton.h>
 #include <Adafruit_NeoPixel.h>
+#include "AudioFxScheduler.h"
 
 /**
  * Relay.
@@ -18,6 +19,9 @@ const byte PIN_TRACK_FAIL = A1;
 const byte PIN_TRACK_VICTORY = 11;
 
 const int TRACK_VICTORY_MS = 9000;
+const unsigned long AUDIO_TRIGGER_MS = 300;
+
+AudioFxScheduler audio(PIN_AUDIO_ACT, AUDIO_TRIGGER_MS);
 
 /**
  * Proximity sensors.
@@ -108,8 +112,9 @@ ProgramState progState = {
 
 void onVictory()
 {
-    playTrack(PIN_TRACK_VICTORY);
-    delay(TRACK_VICTORY_MS);
+    audio.clear();
+    audio.play(PIN_TRACK_VICTORY, AUDIO_FX_INTERRUPT);
+    audio.wait(TRACK_VICTORY_MS);
     progState.isVictory = true;
     openRelay();
     Serial.println(F("Victory"));
@@ -139,13 +144,13 @@ void onSensorPress(int idx, int v, int up)
 
     if (isResultsError())
     {
-        playTrack(PIN_TRACK_FAIL);
+        audio.play(PIN_TRACK_FAIL, AUDIO_FX_SKIP_IF_BUSY);
         emptyResults();
         showErrorSensorLedsPattern();
     }
     else
     {
-        playTrack(PIN_TRACK_GOAL);
+        audio.play(PIN_TRACK_GOAL, AUDIO_FX_SKIP_IF_BUSY);
         showGoalLeds(idx);
     }
 
@@ -271,9 +276,9 @@ void showErrorSensorLedsPattern()
     for (int i = 0; i < LED_SENSOR_ERROR_ITERS; i++)
     {
         clearSensorLeds();
-        delay(LED_SENSOR_ERROR_DELAY_MS);
+        audio.wait(LED_SENSOR_ERROR_DELAY_MS);
         showRedSensorLeds();
-        delay(LED_SENSOR_ERROR_DELAY_MS);
+        audio.wait(LED_SENSOR_ERROR_DELAY_MS);
     }
 
     clearSensorLeds();
@@ -295,7 +300,7 @@ void showVictoryLedsPattern()
             sensorLedStrips[i].show();
         }
 
-        delay(delayMs);
+        audio.wait(delayMs);
     }
 }
 
@@ -318,7 +323,7 @@ void showGoalLeds(int goalIdx)
         sensorLedStrips[i].show();
     }
 
-    delay(LED_SENSOR_GOAL_DELAY_MS);
+    audio.wait(LED_SENSOR_GOAL_DELAY_MS);
     clearSensorLeds();
 }
 
@@ -356,7 +361,7 @@ bool mustUpdateSensorConfig()
 void updateSensorsConfig()
 {
     clearSensorLeds();
-    delay(SENSOR_UPDATE_DELAY_MS);
+    audio.wait(SENSOR_UPDATE_DELAY_MS);
     progState.updateMillis = millis();
     randomSensorsConfig();
     showSensorsConfig();
@@ -479,35 +484,14 @@ bool isResultsValid()
  * Audio FX functions.
  */
 
-void playTrack(byte trackPin)
-{
-    if (isTrackPlaying())
-    {
-        Serial.println(F("Skipping: Audio playing"));
-        return;
-    }
-
-    Serial.print(F("Playing track on pin: "));
-    Serial.println(trackPin);
-
-    digitalWrite(trackPin, LOW);
-    pinMode(trackPin, OUTPUT);
-    delay(300);
-    pinMode(trackPin, INPUT);
-}
-
 void initAudioPins()
 {
     pinMode(PIN_TRACK_GOAL, INPUT);
     pinMode(PIN_TRACK_FAIL, INPUT);
     pinMode(PIN_TRACK_VICTORY, INPUT);
-    pinMode(PIN_AUDIO_ACT, INPUT);
     pinMode(PIN_AUDIO_RST, INPUT);
-}
 
-bool isTrackPlaying()
-{
-    return digitalRead(PIN_AUDIO_ACT) == LOW;
+    audio.begin();
 }
 
 void resetAudio()
@@ -565,6 +549,7 @@ void setup()
 
 void loop()
 {
+    audio.update();
     automaton.run();
 
     if (progState.isVictory)
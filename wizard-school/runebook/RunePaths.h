@@ -0,0 +1,175 @@
+#ifndef RUNE_PATHS_H
+#define RUNE_PATHS_H
+
+#include <Arduino.h>
+
+/**
+ * Shortest paths in the LED matrix.
+ *  [
+ *    {00, 01, 02, 03, 04, 05, 06},
+ *    {07, 08, 09, 10, 11, 12, 13},
+ *    {14, 15, 16, 17, 18, 19, 20},
+ *    {21, 22, 23, 24, 25, 26, 27},
+ *    {28, 29, 30, 31, 32, 33, 34},
+ *    {35, 36, 37, 38, 39, 40, 41},
+ *    {42, 43, 44, 45, 46, 47, 48}
+ *  ]
+ */
+
+const byte PATHS_SIZE = 20;
+const byte PATHS_ITEM_LEN = 4;
+
+const byte PATHS[PATHS_SIZE][PATHS_ITEM_LEN] = {
+    {0, 1, 2, 3},
+    {0, 7, 14, 21},
+    {0, 8, 16, 24},
+    {3, 4, 5, 6},
+    {3, 9, 15, 21},
+    {3, 10, 17, 24},
+    {3, 11, 19, 27},
+    {6, 12, 18, 24},
+    {6, 13, 20, 27},
+    {21, 22, 23, 24},
+    {21, 28, 35, 42},
+    {21, 29, 37, 45},
+    {24, 25, 26, 27},
+    {24, 30, 36, 42},
+    {24, 31, 38, 45},
+    {24, 32, 40, 48},
+    {27, 33, 39, 45},
+    {27, 34, 41, 48},
+    {42, 43, 44, 45},
+    {45, 46, 47, 48}};
+
+/**
+ * Runes, as the cells of the matrix that draw them.
+ */
+
+const int RUNES_NUM = 12;
+
+constexpr byte RUNE_RESET_PATH[] = {
+    0, 1, 2, 3, 4, 5, 6,
+    42, 43, 44, 45, 46, 47, 48,
+    0, 7, 14, 21, 28, 35, 42,
+    6, 13, 20, 27, 34, 41, 48};
+
+constexpr byte RUNE_PATH_00[] = {
+    3, 4, 5, 6,
+    3, 10, 17, 24,
+    21, 22, 23, 24, 25, 26, 27,
+    21, 29, 37, 45,
+    27, 33, 39, 45};
+
+constexpr byte RUNE_PATH_01[] = {
+    0, 1, 2, 3, 4, 5, 6,
+    6, 13, 20, 27, 34, 41, 48,
+    21, 22, 23, 24, 25, 26, 27,
+    42, 43, 44, 45, 46, 47, 48,
+    21, 28, 35, 42,
+    0, 8, 16, 24, 32, 40, 48};
+
+constexpr byte RUNE_PATH_02[] = {
+    3, 9, 15, 21,
+    3, 11, 19, 27,
+    21, 28, 35, 42,
+    27, 34, 41, 48,
+    24, 30, 36, 42,
+    24, 32, 40, 48};
+
+constexpr byte RUNE_PATH_03[] = {
+    42, 43, 44, 45, 46, 47, 48,
+    21, 22, 23, 24, 25, 26, 27,
+    0, 7, 14, 21,
+    6, 13, 20, 27,
+    0, 8, 16, 24, 32, 40, 48,
+    6, 12, 18, 24, 30, 36, 42};
+
+constexpr byte RUNE_PATH_04[] = {
+    0, 1, 2, 3, 4, 5, 6,
+    42, 43, 44, 45, 46, 47, 48,
+    0, 8, 16, 24, 32, 40, 48,
+    6, 12, 18, 24, 30, 36, 42};
+
+constexpr byte RUNE_PATH_05[] = {
+    21, 22, 23, 24, 25, 26, 27,
+    3, 10, 17, 24, 31, 38, 45,
+    0, 8, 16, 24, 32, 40, 48,
+    6, 12, 18, 24, 30, 36, 42,
+    3, 4, 5, 6,
+    42, 43, 44, 45,
+    0, 7, 14, 21,
+    27, 34, 41, 48};
+
+constexpr byte RUNE_PATH_06[] = {
+    21, 22, 23, 24, 25, 26, 27,
+    0, 7, 14, 21,
+    6, 13, 20, 27,
+    21, 29, 37, 45,
+    27, 33, 39, 45,
+    6, 12, 18, 24,
+    0, 8, 16, 24};
+
+constexpr byte RUNE_PATH_07[] = {
+    0, 1, 2, 3, 4, 5, 6,
+    21, 22, 23, 24,
+    45, 46, 47, 48,
+    0, 7, 14, 21,
+    6, 13, 20, 27, 34, 41, 48,
+    6, 12, 18, 24,
+    24, 31, 38, 45};
+
+constexpr byte RUNE_PATH_08[] = {
+    21, 22, 23, 24, 25, 26, 27,
+    3, 10, 17, 24, 31, 38, 45,
+    21, 29, 37, 45,
+    27, 33, 39, 45};
+
+constexpr byte RUNE_PATH_09[] = {
+    0, 1, 2, 3, 4, 5, 6,
+    42, 43, 44, 45, 46, 47, 48,
+    6, 12, 18, 24, 30, 36, 42};
+
+constexpr byte RUNE_PATH_10[] = {
+    42, 43, 44, 45, 46, 47, 48,
+    3, 11, 19, 27,
+    3, 9, 15, 21,
+    27, 33, 39, 45,
+    21, 29, 37, 45};
+
+constexpr byte RUNE_PATH_11[] = {
+    21, 22, 23, 24, 25, 26, 27,
+    3, 10, 17, 24, 31, 38, 45,
+    3, 11, 19, 27};
+
+/**
+ * Rune paths as bitmasks of the 49 matrix cells (bit N is cell N).
+ * Two paths draw the same rune when they cover the same set of cells,
+ * so matching a drawn path is a single 64-bit comparison.
+ */
+
+constexpr uint64_t pathToCellMask(const byte *path, size_t len)
+{
+    return len == 0
+               ? 0
+               : ((uint64_t)1 << path[len - 1]) | pathToCellMask(path, len - 1);
+}
+
+#define RUNE_CELL_MASK(path) pathToCellMask(path, sizeof(path))
+
+constexpr uint64_t RUNE_RESET_MASK = RUNE_CELL_MASK(RUNE_RESET_PATH);
+
+constexpr uint64_t RUNES_MASKS[RUNES_NUM] = {
+    RUNE_CELL_MASK(RUNE_PATH_00),
+    RUNE_CELL_MASK(RUNE_PATH_01),
+    RUNE_CELL_MASK(RUNE_PATH_02),
+    RUNE_CELL_MASK(RUNE_PATH_03),
+    RUNE_CELL_MASK(RUNE_PATH_04),
+    RUNE_CELL_MASK(RUNE_PATH_05),
+    RUNE_CELL_MASK(RUNE_PATH_06),
+    RUNE_CELL_MASK(RUNE_PATH_07),
+    RUNE_CELL_MASK(RUNE_PATH_08),
+    RUNE_CELL_MASK(RUNE_PATH_09),
+    RUNE_CELL_MASK(RUNE_PATH_10),
+    RUNE_CELL_MASK(RUNE_PATH_11)};
+
+#endif
@@ -1,9 +1,11 @@
 #include <Automaton.h>
 #include <Adafruit_NeoPixel.h>
-#include <ArduinoSTL.h>
-#include <set>
-#include <vector>
 #include "rdm630.h"
+#include "DirtyNeoPixel.h"
+#include "RunePaths.h"
+
+// #define LOOP_PROFILER
+#include "LoopProfiler.h"
 #include <Servo.h>
 
 /**
@@ -22,46 +24,12 @@ const int RELAY_PIN_RFID = 24;
 const int RELAY_PIN_FURNACE = 52;
 
 /**
- * Shortest paths in the LED matrix.
- *  [
- *    {00, 01, 02, 03, 04, 05, 06},
- *    {07, 08, 09, 10, 11, 12, 13},
- *    {14, 15, 16, 17, 18, 19, 20},
- *    {21, 22, 23, 24, 25, 26, 27},
- *    {28, 29, 30, 31, 32, 33, 34},
- *    {35, 36, 37, 38, 39, 40, 41},
- *    {42, 43, 44, 45, 46, 47, 48}
- *  ]
+ * Shortest path buffers (paths and runes are in RunePaths.h).
  */
 
-const byte PATHS_SIZE = 20;
-const byte PATHS_ITEM_LEN = 4;
-
 int pathBuf[PATHS_ITEM_LEN];
 int ledPathBuf[PATHS_ITEM_LEN];
 
-const byte PATHS[PATHS_SIZE][PATHS_ITEM_LEN] = {
-    {0, 1, 2, 3},
-    {0, 7, 14, 21},
-    {0, 8, 16, 24},
-    {3, 4, 5, 6},
-    {3, 9, 15, 21},
-    {3, 10, 17, 24},
-    {3, 11, 19, 27},
-    {6, 12, 18, 24},
-    {6, 13, 20, 27},
-    {21, 22, 23, 24},
-    {21, 28, 35, 42},
-    {21, 29, 37, 45},
-    {24, 25, 26, 27},
-    {24, 30, 36, 42},
-    {24, 31, 38, 45},
-    {24, 32, 40, 48},
-    {27, 33, 39, 45},
-    {27, 34, 41, 48},
-    {42, 43, 44, 45},
-    {45, 46, 47, 48}};
-
 /**
  * LED index map.
  */
@@ -147,7 +115,7 @@ const int LED_BOOK_PATTERN_TAIL_SIZE = 5;
 const int LED_BOOK_FADE_MS = 15;
 const uint32_t LED_BOOK_COLOR = Adafruit_NeoPixel::Color(128, 0, 128);
 
-Adafruit_NeoPixel ledBook = Adafruit_NeoPixel(
+DirtyNeoPixel ledBook(
     LED_BOOK_NUM,
     LED_BOOK_PIN,
     NEO_GRB + NEO_KHZ800);
@@ -172,12 +140,14 @@ const int LED_PIPES_SUCCESS_ANIMATE_DELAY = 20;
 const int LED_PIPES_ERROR_DELAY_STEP = 5;
 const int LED_PIPES_ERROR_NUM_ITERS = 20;
 const int LED_PIPES_ERROR_INI_DELAY = 10;
+const int LED_PIPES_FRAME_MS = 20;
 const uint32_t LED_PIPES_COLOR = Adafruit_NeoPixel::Color(128, 0, 128);
 
-Adafruit_NeoPixel ledPipes = Adafruit_NeoPixel(
+DirtyNeoPixel ledPipes(
     LED_PIPES_NUM,
     LED_PIPES_PIN,
-    NEO_GRB + NEO_KHZ800);
+    NEO_GRB + NEO_KHZ800,
+    LED_PIPES_FRAME_MS);
 
 /**
  * 0: Rabano Vivaz
@@ -195,7 +165,6 @@ Adafruit_NeoPixel ledPipes = Adafruit_NeoPixel(
  * 12: RESET
  */
 
-const int RUNES_NUM = 12;
 const int RUNES_KEY_NUM = 4;
 
 const int RUNES_VALID_KEY[RUNES_KEY_NUM] = {
@@ -215,78 +184,6 @@ const int RUNES_LED_INDEX[RUNES_NUM] = {
     58,
     62};
 
-std::vector<byte> RUNE_RESET_PATH = {
-    0, 1, 2, 3, 4, 5, 6,
-    42, 43, 44, 45, 46, 47, 48,
-    0, 7, 14, 21, 28, 35, 42,
-    6, 13, 20, 27, 34, 41, 48};
-
-std::vector<byte> RUNES_PATHS[RUNES_NUM] = {
-    {3, 4, 5, 6,
-     3, 10, 17, 24,
-     21, 22, 23, 24, 25, 26, 27,
-     21, 29, 37, 45,
-     27, 33, 39, 45},
-    {0, 1, 2, 3, 4, 5, 6,
-     6, 13, 20, 27, 34, 41, 48,
-     21, 22, 23, 24, 25, 26, 27,
-     42, 43, 44, 45, 46, 47, 48,
-     21, 28, 35, 42,
-     0, 8, 16, 24, 32, 40, 48},
-    {3, 9, 15, 21,
-     3, 11, 19, 27,
-     21, 28, 35, 42,
-     27, 34, 41, 48,
-     24, 30, 36, 42,
-     24, 32, 40, 48},
-    {42, 43, 44, 45, 46, 47, 48,
-     21, 22, 23, 24, 25, 26, 27,
-     0, 7, 14, 21,
-     6, 13, 20, 27,
-     0, 8, 16, 24, 32, 40, 48,
-     6, 12, 18, 24, 30, 36, 42},
-    {0, 1, 2, 3, 4, 5, 6,
-     42, 43, 44, 45, 46, 47, 48,
-     0, 8, 16, 24, 32, 40, 48,
-     6, 12, 18, 24, 30, 36, 42},
-    {21, 22, 23, 24, 25, 26, 27,
-     3, 10, 17, 24, 31, 38, 45,
-     0, 8, 16, 24, 32, 40, 48,
-     6, 12, 18, 24, 30, 36, 42,
-     3, 4, 5, 6,
-     42, 43, 44, 45,
-     0, 7, 14, 21,
-     27, 34, 41, 48},
-    {21, 22, 23, 24, 25, 26, 27,
-     0, 7, 14, 21,
-     6, 13, 20, 27,
-     21, 29, 37, 45,
-     27, 33, 39, 45,
-     6, 12, 18, 24,
-     0, 8, 16, 24},
-    {0, 1, 2, 3, 4, 5, 6,
-     21, 22, 23, 24,
-     45, 46, 47, 48,
-     0, 7, 14, 21,
-     6, 13, 20, 27, 34, 41, 48,
-     6, 12, 18, 24,
-     24, 31, 38, 45},
-    {21, 22, 23, 24, 25, 26, 27,
-     3, 10, 17, 24, 31, 38, 45,
-     21, 29, 37, 45,
-     27, 33, 39, 45},
-    {0, 1, 2, 3, 4, 5, 6,
-     42, 43, 44, 45, 46, 47, 48,
-     6, 12, 18, 24, 30, 36, 42},
-    {42, 43, 44, 45, 46, 47, 48,
-     3, 11, 19, 27,
-     3, 9, 15, 21,
-     27, 33, 39, 45,
-     21, 29, 37, 45},
-    {21, 22, 23, 24, 25, 26, 27,
-     3, 10, 17, 24, 31, 38, 45,
-     3, 11, 19, 27}};
-
 /**
  * Servo.
  */
@@ -311,6 +208,10 @@ const byte PIN_TRACK_RUNE_DRAWN = 40;
 const byte PIN_TRACK_RUNE_UPLOADED = 42;
 const byte PIN_TRACK_RUNE_SET_ERROR = 44;
 const byte PIN_TRACK_FURNACE_OK = 46;
+const unsigned long AUDIO_TRIGGER_MS = 300;
+const unsigned long AUDIO_WAIT_MARGIN_MS = 200;
+const unsigned long AUDIO_WAIT_ITER_MS = 50;
+const unsigned long AUDIO_WAIT_MAX_MS = 10000;
 
 /**
  * Program state.
@@ -334,6 +235,7 @@ typedef struct programState
     int *historySensor;
     int *historyPath;
     int *historyPathLed;
+    uint64_t historyPathMask;
     int *historyRunes;
     unsigned long lastSensorActivation;
     int *furnaceLedLevel;
@@ -348,12 +250,73 @@ ProgramState progState = {
     .historySensor = historySensor,
     .historyPath = historyPath,
     .historyPathLed = historyPathLed,
+    .historyPathMask = 0,
     .historyRunes = historyRunes,
     .lastSensorActivation = 0,
     .furnaceLedLevel = furnaceLedLevel,
     .furnaceLastRead = furnaceLastRead,
     .furnaceValidLevelCounter = 0};
 
+/**
+ * Animation engine state.
+ * Animation steps are queued and rendered from loop() one frame at a time.
+ * The book and the pipes have their own track, so one strip animates
+ * while the other one is busy. Steps in a track run in order.
+ */
+
+const byte ANIM_QUEUE_SIZE = 16;
+const int ANIM_WAIT_TRACK_MS = 20;
+
+const byte ANIM_TRACK_BOOK = 0;
+const byte ANIM_TRACK_PIPES = 1;
+const byte ANIM_TRACKS_NUM = 2;
+
+const byte ANIM_STEP_BOOK_PATTERN = 1;
+const byte ANIM_STEP_BOOK_FADE = 2;
+const byte ANIM_STEP_PIPES_PULSE = 3;
+const byte ANIM_STEP_PIPES_BLOB = 4;
+const byte ANIM_STEP_PIPES_COIL = 5;
+const byte ANIM_STEP_PIPES_SUCCESS = 6;
+const byte ANIM_STEP_PIPES_ERROR = 7;
+const byte ANIM_STEP_PLAY_TRACK = 8;
+const byte ANIM_STEP_WAIT_AUDIO = 9;
+const byte ANIM_STEP_CALLBACK = 10;
+const byte ANIM_STEP_WAIT_TRACK = 11;
+
+typedef struct animStep
+{
+    byte type;
+    int arg;
+    int arg2;
+    void (*callback)();
+} AnimStep;
+
+typedef struct animTrack
+{
+    AnimStep queue[ANIM_QUEUE_SIZE];
+    byte queueHead;
+    byte queueSize;
+    AnimStep current;
+    bool isRunning;
+    int frame;
+    unsigned long frameDelay;
+    unsigned long lastFrame;
+    unsigned long stepStart;
+    unsigned int numQueued;
+    unsigned int numDone;
+} AnimTrack;
+
+typedef struct animationState
+{
+    AnimTrack tracks[ANIM_TRACKS_NUM];
+    byte bookPath[HISTORY_PATH_SIZE];
+    int bookPathLen;
+    unsigned long lastLoop;
+    unsigned long maxLatencyMs;
+} AnimationState;
+
+AnimationState animState;
+
 bool shouldListenToProxSensors()
 {
     return progState.isRunePhaseComplete == false;
@@ -362,7 +325,8 @@ bool shouldListenToProxSensors()
 bool shouldListenToRfid()
 {
     return progState.isRunePhaseComplete == true &&
-           progState.isRfidPhaseComplete == false;
+           progState.isRfidPhaseComplete == false &&
+           !isAnimationBusy();
 }
 
 bool shouldListenToFurnaceButtons()
@@ -511,7 +475,7 @@ void addRuneToHistory(int runeIdx)
 
 bool isSensorPatternConfirmed()
 {
-    if (progState.lastSensorActivation == 0)
+    if (progState.lastSensorActivation == 0 || isAnimTrackBusy(ANIM_TRACK_BOOK))
     {
         return false;
     }
@@ -543,26 +507,33 @@ void cleanSensorState()
     progState.lastSensorActivation = 0;
 }
 
-void onRunePhaseComplete()
+void onRunePhaseAnimationsDone()
 {
-    Serial.println(F("Rune phase complete"));
-
-    playTrack(PIN_TRACK_RUNE_SET_COMPLETE);
-    animateLedPipesSuccess();
-    waitForAudio();
-
     clearLedsBook();
     ledPipes.fill(getPipeColor());
     ledPipes.show();
+}
+
+void onRunePhaseComplete()
+{
+    Serial.println(F("Rune phase complete"));
 
+    // Set now so no other pattern is accepted while the pipes catch up
     progState.isRunePhaseComplete = true;
+
+    queueAnimWaitTrack(ANIM_TRACK_PIPES, ANIM_TRACK_BOOK);
+    queueAnimTrack(ANIM_TRACK_PIPES, PIN_TRACK_RUNE_SET_COMPLETE);
+    queueAnimStep(ANIM_TRACK_PIPES, ANIM_STEP_PIPES_SUCCESS);
+    queueAnimStep(ANIM_TRACK_PIPES, ANIM_STEP_WAIT_AUDIO);
+    queueAnimCallback(ANIM_TRACK_PIPES, onRunePhaseAnimationsDone);
 }
 
 void onSensorPatternConfirmed()
 {
     Serial.println(F("Pattern confirmed"));
 
-    animateBookLedPattern();
+    snapshotAnimBookPath();
+    queueAnimStep(ANIM_TRACK_BOOK, ANIM_STEP_BOOK_PATTERN);
 
     int runeIdx = getHistoryPathRune();
 
@@ -585,13 +556,19 @@ void onSensorPatternConfirmed()
         {
             addRuneToHistory(runeIdx);
 
-            playTrack(PIN_TRACK_RUNE_DRAWN);
-            fadeBookLedPattern();
-            waitForAudio();
+            int runesLen = getHistoryRunesSize();
+
+            queueAnimTrack(ANIM_TRACK_BOOK, PIN_TRACK_RUNE_DRAWN);
+            queueAnimStep(ANIM_TRACK_BOOK, ANIM_STEP_BOOK_FADE);
+            queueAnimStep(ANIM_TRACK_BOOK, ANIM_STEP_WAIT_AUDIO);
 
-            playTrack(PIN_TRACK_RUNE_UPLOADED);
-            animateRunePipeBlob(runeIdx);
-            waitForAudio();
+            // The upload starts once the book is done with this rune
+            queueAnimWaitTrack(ANIM_TRACK_PIPES, ANIM_TRACK_BOOK);
+            queueAnimTrack(ANIM_TRACK_PIPES, PIN_TRACK_RUNE_UPLOADED);
+            queueAnimRuneStep(ANIM_STEP_PIPES_PULSE, runeIdx, runesLen);
+            queueAnimRuneStep(ANIM_STEP_PIPES_BLOB, runeIdx, runesLen);
+            queueAnimRuneStep(ANIM_STEP_PIPES_COIL, runeIdx, runesLen);
+            queueAnimStep(ANIM_TRACK_PIPES, ANIM_STEP_WAIT_AUDIO);
         }
     }
 
@@ -609,9 +586,10 @@ void onSensorPatternConfirmed()
         Serial.println("Invalid runes combination");
         emptyHistoryRunes();
 
-        playTrack(PIN_TRACK_RUNE_SET_ERROR);
-        animateLedPipesError();
-        waitForAudio();
+        queueAnimWaitTrack(ANIM_TRACK_PIPES, ANIM_TRACK_BOOK);
+        queueAnimTrack(ANIM_TRACK_PIPES, PIN_TRACK_RUNE_SET_ERROR);
+        queueAnimStep(ANIM_TRACK_PIPES, ANIM_STEP_PIPES_ERROR);
+        queueAnimStep(ANIM_TRACK_PIPES, ANIM_STEP_WAIT_AUDIO);
     }
 }
 
@@ -668,37 +646,19 @@ void reverseRange(int *arr, int lft, int rgt)
 
 bool isHistoryPathResetRune()
 {
-    std::set<int> histPathSet(
-        progState.historyPath,
-        progState.historyPath + getHistoryPathSize());
-
-    std::set<int> resetRuneSet(
-        RUNE_RESET_PATH.begin(),
-        RUNE_RESET_PATH.end());
-
-    return histPathSet == resetRuneSet;
+    return progState.historyPathMask == RUNE_RESET_MASK;
 }
 
 int getHistoryPathRune()
 {
-    int currSize = getHistoryPathSize();
-
-    if (currSize == 0)
+    if (progState.historyPathMask == 0)
     {
         return -1;
     }
 
-    std::set<int> histPathSet(
-        progState.historyPath,
-        progState.historyPath + currSize);
-
     for (int i = 0; i < RUNES_NUM; i++)
     {
-        std::set<int> runeSet(
-            RUNES_PATHS[i].begin(),
-            RUNES_PATHS[i].end());
-
-        if (histPathSet == runeSet)
+        if (progState.historyPathMask == RUNES_MASKS[i])
         {
             return i;
         }
@@ -707,25 +667,6 @@ int getHistoryPathRune()
     return -1;
 }
 
-int getHistoryPathSize()
-{
-    int currSize = 0;
-
-    for (int i = 0; i < HISTORY_PATH_SIZE; i++)
-    {
-        if (progState.historyPath[i] != -1)
-        {
-            currSize++;
-        }
-        else
-        {
-            break;
-        }
-    }
-
-    return currSize;
-}
-
 void emptyHistorySensor()
 {
     for (int i = 0; i < HISTORY_SENSOR_SIZE; i++)
@@ -741,6 +682,8 @@ void emptyHistoryPath()
         progState.historyPath[i] = -1;
         progState.historyPathLed[i] = -1;
     }
+
+    progState.historyPathMask = 0;
 }
 
 bool isSensorAdjacent(int idxOne, int idxOther)
@@ -842,6 +785,7 @@ void refreshHistoryPath()
         {
             progState.historyPath[pathPivot] = pathBuf[j];
             progState.historyPathLed[pathPivot] = ledPathBuf[j];
+            progState.historyPathMask |= (uint64_t)1 << pathBuf[j];
 
             pathPivot++;
         }
@@ -964,270 +908,543 @@ void clearLedsPipes()
     ledPipes.show();
 }
 
-void fadeBookLedPattern()
+int getLedCoilLoopSize(int runesHistoryLen)
 {
-    clearLedsBook();
+    float coilProgress = (float)runesHistoryLen / RUNES_KEY_NUM;
+    return (LED_PIPES_COIL_END - LED_PIPES_COIL_INI) * coilProgress;
+}
 
-    const int iniVal = 0;
-    const int endVal = 250;
+int getLedCoilLoopSize()
+{
+    return getLedCoilLoopSize(getHistoryRunesSize());
+}
+
+uint32_t getPipeColor()
+{
+    return Adafruit_NeoPixel::Color(0, random(150, 250), random(150, 250));
+}
+
+void refreshLedsBook()
+{
+    PROFILE_SECTION(PROFILE_SECTION_LED);
+
+    ledBook.clear();
+
+    for (int i = 0; i < HISTORY_PATH_SIZE; i++)
+    {
+        if (progState.historyPathLed[i] == -1)
+        {
+            break;
+        }
+
+        ledBook.setPixelColor(progState.historyPathLed[i], LED_BOOK_COLOR);
+    }
+
+    ledBook.show();
+}
+
+void refreshLedsPipes()
+{
+    PROFILE_SECTION(PROFILE_SECTION_LED);
+
+    ledPipes.clear();
 
-    for (int k = iniVal; k < endVal; k++)
+    int currRuneIdx;
+
+    for (int i = 0; i < RUNES_KEY_NUM; i++)
     {
-        for (int i = 0; i < HISTORY_PATH_SIZE; i++)
+        if (progState.historyRunes[i] == -1)
         {
-            if (progState.historyPathLed[i] == -1)
-            {
-                break;
-            }
+            break;
+        }
 
-            ledBook.setPixelColor(progState.historyPathLed[i], 0, 0, k);
+        currRuneIdx = RUNES_LED_INDEX[progState.historyRunes[i]];
+
+        for (int j = 0; j < LED_PIPES_BLOB_SIZE; j++)
+        {
+            ledPipes.setPixelColor(currRuneIdx + j, getPipeColor());
         }
+    }
 
-        ledBook.show();
+    int coilSize = getLedCoilLoopSize();
 
-        delay(LED_BOOK_FADE_MS);
+    for (int i = 0; i < coilSize; i++)
+    {
+        ledPipes.setPixelColor(LED_PIPES_COIL_END - i, getPipeColor());
     }
+
+    ledPipes.show();
+}
+
+int furnaceLevelToLedIndex(int ledLevel)
+{
+    return ledLevel;
 }
 
-void animateBookLedPattern()
+void refreshLedsFurnace()
 {
-    int pivotIdx;
+    PROFILE_SECTION(PROFILE_SECTION_LED);
 
-    for (int i = 0; i < HISTORY_PATH_SIZE; i++)
+    for (int i = 0; i < FBUTTONS_NUM; i++)
     {
-        clearLedsBook();
+        ledsFurnace[i].clear();
 
-        if (progState.historyPathLed[i] == -1)
+        for (int j = 0; j < progState.furnaceLedLevel[i]; j++)
         {
-            break;
+            ledsFurnace[i].setPixelColor(
+                furnaceLevelToLedIndex(j),
+                LED_FBUTTONS_COLOR);
         }
 
-        for (int j = 0; j < LED_BOOK_PATTERN_TAIL_SIZE; j++)
-        {
-            pivotIdx = i + j;
+        ledsFurnace[i].show();
+    }
+}
+
+/**
+ * Animation engine functions.
+ * Each step renders one frame per tick and returns the delay until its
+ * next frame (or -1 once finished), so the animations never block loop().
+ */
+
+bool isAnimTrackBusy(byte trackIdx)
+{
+    AnimTrack &track = animState.tracks[trackIdx];
 
-            if (progState.historyPathLed[pivotIdx] == -1)
-            {
-                break;
-            }
+    return track.isRunning || track.queueSize > 0;
+}
 
-            ledBook.setPixelColor(progState.historyPathLed[pivotIdx], LED_BOOK_COLOR);
+bool isAnimationBusy()
+{
+    for (byte i = 0; i < ANIM_TRACKS_NUM; i++)
+    {
+        if (isAnimTrackBusy(i))
+        {
+            return true;
         }
+    }
 
-        ledBook.show();
+    return false;
+}
 
-        delay(LED_BOOK_PATTERN_ANIMATE_MS);
+bool queueAnimStep(byte trackIdx, byte type, int arg, int arg2, void (*callback)())
+{
+    AnimTrack &track = animState.tracks[trackIdx];
+
+    if (track.queueSize >= ANIM_QUEUE_SIZE)
+    {
+        Serial.println(F("Animation queue full"));
+        return false;
     }
 
-    clearLedsBook();
+    int idx = (track.queueHead + track.queueSize) % ANIM_QUEUE_SIZE;
+
+    track.queue[idx].type = type;
+    track.queue[idx].arg = arg;
+    track.queue[idx].arg2 = arg2;
+    track.queue[idx].callback = callback;
+    track.queueSize++;
+    track.numQueued++;
+
+    return true;
 }
 
-int getLedCoilLoopSize(int runesHistoryLen)
+void queueAnimStep(byte trackIdx, byte type)
 {
-    float coilProgress = (float)runesHistoryLen / RUNES_KEY_NUM;
-    return (LED_PIPES_COIL_END - LED_PIPES_COIL_INI) * coilProgress;
+    queueAnimStep(trackIdx, type, 0, 0, NULL);
 }
 
-int getLedCoilLoopSize()
+void queueAnimRuneStep(byte type, int runeIdx, int runesLen)
 {
-    return getLedCoilLoopSize(getHistoryRunesSize());
+    queueAnimStep(ANIM_TRACK_PIPES, type, runeIdx, runesLen, NULL);
 }
 
-uint32_t getPipeColor()
+void queueAnimTrack(byte trackIdx, byte trackPin)
 {
-    return Adafruit_NeoPixel::Color(0, random(150, 250), random(150, 250));
+    queueAnimStep(trackIdx, ANIM_STEP_PLAY_TRACK, trackPin, 0, NULL);
 }
 
-void animateRunePipeBlob(int runeIdx)
+void queueAnimCallback(byte trackIdx, void (*callback)())
 {
-    int prevRunesLen = getHistoryRunesSize();
-    prevRunesLen = prevRunesLen > 0 ? prevRunesLen - 1 : 0;
-    int prevCoilSize = getLedCoilLoopSize(prevRunesLen);
+    queueAnimStep(trackIdx, ANIM_STEP_CALLBACK, 0, 0, callback);
+}
 
-    int blobEnd = LED_PIPES_COIL_END - prevCoilSize;
-    int pivotIdx = RUNES_LED_INDEX[runeIdx];
+/**
+ * Holds a track until the steps queued so far on another one are done.
+ */
+void queueAnimWaitTrack(byte trackIdx, byte otherIdx)
+{
+    queueAnimStep(
+        trackIdx,
+        ANIM_STEP_WAIT_TRACK,
+        otherIdx,
+        animState.tracks[otherIdx].numQueued,
+        NULL);
+}
+
+void snapshotAnimBookPath()
+{
+    animState.bookPathLen = 0;
+
+    for (int i = 0; i < HISTORY_PATH_SIZE; i++)
+    {
+        if (progState.historyPathLed[i] == -1)
+        {
+            break;
+        }
+
+        animState.bookPath[animState.bookPathLen] = progState.historyPathLed[i];
+        animState.bookPathLen++;
+    }
+}
 
-    for (int i = 0; i < blobEnd; i++)
+void clearLedsPipesRange(int end)
+{
+    for (int i = 0; i < end; i++)
     {
         ledPipes.setPixelColor(i, 0);
     }
+}
 
-    ledPipes.show();
+void setLedsPipesBlob(int pivotIdx, bool isOn)
+{
+    for (int i = 0; i < LED_PIPES_BLOB_SIZE; i++)
+    {
+        ledPipes.setPixelColor(pivotIdx + i, isOn ? getPipeColor() : 0);
+    }
+}
+
+int getBlobEnd(int runesLen)
+{
+    int prevRunesLen = runesLen > 0 ? runesLen - 1 : 0;
+    return LED_PIPES_COIL_END - getLedCoilLoopSize(prevRunesLen);
+}
 
-    for (int k = 0; k < LED_PIPES_BLOB_NUM_PULSES; k++)
+long renderBookPatternFrame(int frame)
+{
+    ledBook.clear();
+
+    if (frame >= animState.bookPathLen)
     {
-        for (int i = 0; i < LED_PIPES_BLOB_SIZE; i++)
+        ledBook.show();
+        return -1;
+    }
+
+    for (int j = 0; j < LED_BOOK_PATTERN_TAIL_SIZE; j++)
+    {
+        if (frame + j >= animState.bookPathLen)
         {
-            ledPipes.setPixelColor(pivotIdx + i, getPipeColor());
+            break;
         }
 
-        ledPipes.show();
-        delay(LED_PIPES_BLOB_PULSE_DELAY);
+        ledBook.setPixelColor(animState.bookPath[frame + j], LED_BOOK_COLOR);
+    }
 
-        for (int i = 0; i < LED_PIPES_BLOB_SIZE; i++)
-        {
-            ledPipes.setPixelColor(pivotIdx + i, 0);
-        }
+    ledBook.show();
 
-        ledPipes.show();
-        delay(LED_PIPES_BLOB_PULSE_DELAY);
+    return LED_BOOK_PATTERN_ANIMATE_MS;
+}
+
+long renderBookFadeFrame(int frame)
+{
+    const int endVal = 250;
+
+    if (frame >= endVal)
+    {
+        return -1;
     }
 
-    while (pivotIdx < blobEnd)
+    if (frame == 0)
     {
-        for (int i = 0; i < blobEnd; i++)
-        {
-            ledPipes.setPixelColor(i, 0);
-        }
+        ledBook.clear();
+    }
 
-        for (int i = 0; i < LED_PIPES_BLOB_SIZE; i++)
-        {
-            ledPipes.setPixelColor(pivotIdx + i, getPipeColor());
-        }
+    for (int i = 0; i < animState.bookPathLen; i++)
+    {
+        ledBook.setPixelColor(animState.bookPath[i], 0, 0, frame);
+    }
 
-        pivotIdx++;
-        ledPipes.show();
-        delay(LED_PIPES_ANIMATE_BLOB_DELAY_MS);
+    ledBook.show();
+
+    return LED_BOOK_FADE_MS;
+}
+
+long renderPipesPulseFrame(int frame, int runeIdx, int runesLen)
+{
+    if (frame >= LED_PIPES_BLOB_NUM_PULSES * 2)
+    {
+        return -1;
     }
 
-    for (int i = 0; i < blobEnd; i++)
+    if (frame == 0)
     {
-        ledPipes.setPixelColor(i, 0);
+        clearLedsPipesRange(getBlobEnd(runesLen));
     }
 
+    setLedsPipesBlob(RUNES_LED_INDEX[runeIdx], frame % 2 == 0);
     ledPipes.show();
 
-    int coilIni = LED_PIPES_COIL_END - getLedCoilLoopSize();
+    return LED_PIPES_BLOB_PULSE_DELAY;
+}
+
+long renderPipesBlobFrame(int frame, int runeIdx, int runesLen)
+{
+    int blobEnd = getBlobEnd(runesLen);
+    int pivotIdx = RUNES_LED_INDEX[runeIdx] + frame;
+
+    clearLedsPipesRange(blobEnd);
 
-    for (int i = blobEnd; i >= coilIni; i--)
+    if (pivotIdx >= blobEnd)
     {
-        ledPipes.setPixelColor(i, getPipeColor());
         ledPipes.show();
-        delay(LED_PIPES_COIL_FILL_DELAY_MS);
+        return -1;
     }
+
+    setLedsPipesBlob(pivotIdx, true);
+    ledPipes.show();
+
+    return LED_PIPES_ANIMATE_BLOB_DELAY_MS;
 }
 
-void animateLedPipesSuccess()
+long renderPipesCoilFrame(int frame, int runesLen)
 {
-    clearLedsPipes();
+    int pivotIdx = getBlobEnd(runesLen) - frame;
+    int coilIni = LED_PIPES_COIL_END - getLedCoilLoopSize(runesLen);
+
+    if (pivotIdx < coilIni)
+    {
+        return -1;
+    }
 
-    int incPivotIdx = LED_PIPES_COIL_END;
-    int decPivotIdx = LED_PIPES_COIL_END;
+    ledPipes.setPixelColor(pivotIdx, getPipeColor());
+    ledPipes.show();
 
-    while (incPivotIdx < LED_PIPES_NUM || decPivotIdx >= 0)
+    return LED_PIPES_COIL_FILL_DELAY_MS;
+}
+
+long renderPipesSuccessFrame(int frame)
+{
+    int incPivotIdx = LED_PIPES_COIL_END + frame;
+    int decPivotIdx = LED_PIPES_COIL_END - frame;
+
+    if (frame == 0)
     {
-        if (incPivotIdx < LED_PIPES_NUM)
-        {
-            ledPipes.setPixelColor(incPivotIdx, getPipeColor());
-            incPivotIdx++;
-        }
+        ledPipes.clear();
+    }
 
-        if (decPivotIdx >= 0)
-        {
-            ledPipes.setPixelColor(decPivotIdx, getPipeColor());
-            decPivotIdx--;
-        }
+    if (incPivotIdx >= LED_PIPES_NUM && decPivotIdx < 0)
+    {
+        return -1;
+    }
 
-        ledPipes.show();
-        delay(LED_PIPES_SUCCESS_ANIMATE_DELAY);
+    if (incPivotIdx < LED_PIPES_NUM)
+    {
+        ledPipes.setPixelColor(incPivotIdx, getPipeColor());
+    }
+
+    if (decPivotIdx >= 0)
+    {
+        ledPipes.setPixelColor(decPivotIdx, getPipeColor());
     }
+
+    ledPipes.show();
+
+    return LED_PIPES_SUCCESS_ANIMATE_DELAY;
 }
 
-void animateLedPipesError()
+long renderPipesErrorFrame(int frame)
 {
-    clearLedsPipes();
+    int iter = frame / 2;
 
-    int delayMs = LED_PIPES_ERROR_INI_DELAY;
+    if (iter >= LED_PIPES_ERROR_NUM_ITERS)
+    {
+        return -1;
+    }
 
-    for (int k = 0; k < LED_PIPES_ERROR_NUM_ITERS; k++)
+    for (int i = 0; i < LED_PIPES_NUM; i++)
     {
-        for (int i = 0; i < LED_PIPES_NUM; i++)
+        if (frame % 2 == 0)
         {
             ledPipes.setPixelColor(i, random(150, 250), 0, 0);
         }
-
-        ledPipes.show();
-        delay(delayMs);
-
-        for (int i = 0; i < LED_PIPES_NUM; i++)
+        else
         {
             ledPipes.setPixelColor(i, 0);
         }
+    }
 
-        ledPipes.show();
-        delay(delayMs);
+    ledPipes.show();
 
-        delayMs = delayMs + LED_PIPES_ERROR_DELAY_STEP;
-    }
+    return LED_PIPES_ERROR_INI_DELAY + iter * LED_PIPES_ERROR_DELAY_STEP;
 }
 
-void refreshLedsBook()
+long renderPlayTrackFrame(int frame, byte trackPin)
 {
-    ledBook.clear();
+    PROFILE_SECTION(PROFILE_SECTION_AUDIO);
 
-    for (int i = 0; i < HISTORY_PATH_SIZE; i++)
+    if (frame == 0)
     {
-        if (progState.historyPathLed[i] == -1)
+        if (isTrackPlaying())
         {
-            break;
+            Serial.println(F("Skipping: Audio playing"));
+            return -1;
         }
 
-        ledBook.setPixelColor(progState.historyPathLed[i], LED_BOOK_COLOR);
+        Serial.print(F("Playing track on pin: "));
+        Serial.println(trackPin);
+
+        digitalWrite(trackPin, LOW);
+        pinMode(trackPin, OUTPUT);
+
+        return AUDIO_TRIGGER_MS;
     }
 
-    ledBook.show();
+    pinMode(trackPin, INPUT);
+
+    return -1;
 }
 
-void refreshLedsPipes()
+long renderWaitAudioFrame(AnimTrack &track, int frame)
 {
-    ledPipes.clear();
+    if (frame == 0)
+    {
+        return AUDIO_WAIT_MARGIN_MS;
+    }
 
-    int currRuneIdx;
+    unsigned long elapsed = millis() - track.stepStart;
 
-    for (int i = 0; i < RUNES_KEY_NUM; i++)
+    if (!isTrackPlaying() || elapsed > AUDIO_WAIT_MAX_MS)
     {
-        if (progState.historyRunes[i] == -1)
+        return -1;
+    }
+
+    return AUDIO_WAIT_ITER_MS;
+}
+
+long renderWaitTrackFrame(byte otherIdx, unsigned int numSteps)
+{
+    // Wrap-safe: numDone has not reached numSteps yet
+    int pending = (int)(numSteps - animState.tracks[otherIdx].numDone);
+
+    return pending > 0 ? ANIM_WAIT_TRACK_MS : -1;
+}
+
+long renderAnimFrame(AnimTrack &track)
+{
+    AnimStep &step = track.current;
+    int frame = track.frame;
+
+    switch (step.type)
+    {
+    case ANIM_STEP_BOOK_PATTERN:
+        return renderBookPatternFrame(frame);
+    case ANIM_STEP_BOOK_FADE:
+        return renderBookFadeFrame(frame);
+    case ANIM_STEP_PIPES_PULSE:
+        return renderPipesPulseFrame(frame, step.arg, step.arg2);
+    case ANIM_STEP_PIPES_BLOB:
+        return renderPipesBlobFrame(frame, step.arg, step.arg2);
+    case ANIM_STEP_PIPES_COIL:
+        return renderPipesCoilFrame(frame, step.arg2);
+    case ANIM_STEP_PIPES_SUCCESS:
+        return renderPipesSuccessFrame(frame);
+    case ANIM_STEP_PIPES_ERROR:
+        return renderPipesErrorFrame(frame);
+    case ANIM_STEP_PLAY_TRACK:
+        return renderPlayTrackFrame(frame, step.arg);
+    case ANIM_STEP_WAIT_AUDIO:
+        return renderWaitAudioFrame(track, frame);
+    case ANIM_STEP_WAIT_TRACK:
+        return renderWaitTrackFrame(step.arg, step.arg2);
+    case ANIM_STEP_CALLBACK:
+        if (step.callback != NULL)
         {
-            break;
+            step.callback();
         }
+        return -1;
+    default:
+        return -1;
+    }
+}
 
-        currRuneIdx = RUNES_LED_INDEX[progState.historyRunes[i]];
+void onAnimationsDone()
+{
+    Serial.print(F("Animations done :: Max input latency (ms): "));
+    Serial.println(animState.maxLatencyMs);
 
-        for (int j = 0; j < LED_PIPES_BLOB_SIZE; j++)
+    animState.maxLatencyMs = 0;
+}
+
+/**
+ * Renders the next frame of a track if it is due.
+ * Returns true when the track has just finished its last step.
+ */
+bool tickAnimTrack(AnimTrack &track, unsigned long now)
+{
+    if (!track.isRunning)
+    {
+        if (track.queueSize == 0)
         {
-            ledPipes.setPixelColor(currRuneIdx + j, getPipeColor());
+            return false;
         }
+
+        track.current = track.queue[track.queueHead];
+        track.queueHead = (track.queueHead + 1) % ANIM_QUEUE_SIZE;
+        track.queueSize--;
+        track.isRunning = true;
+        track.frame = 0;
+        track.frameDelay = 0;
+        track.stepStart = now;
+        track.lastFrame = now;
     }
 
-    int coilSize = getLedCoilLoopSize();
+    if (now - track.lastFrame < track.frameDelay)
+    {
+        return false;
+    }
 
-    for (int i = 0; i < coilSize; i++)
+    long nextDelay = renderAnimFrame(track);
+
+    track.lastFrame = now;
+    track.frame++;
+
+    if (nextDelay >= 0)
     {
-        ledPipes.setPixelColor(LED_PIPES_COIL_END - i, getPipeColor());
+        track.frameDelay = nextDelay;
+        return false;
     }
 
-    ledPipes.show();
+    track.isRunning = false;
+    track.numDone++;
+
+    return track.queueSize == 0;
 }
 
-int furnaceLevelToLedIndex(int ledLevel)
+void tickAnimations()
 {
-    return ledLevel;
+    unsigned long now = millis();
+    bool isDone = false;
+
+    for (byte i = 0; i < ANIM_TRACKS_NUM; i++)
+    {
+        isDone |= tickAnimTrack(animState.tracks[i], now);
+    }
+
+    if (isDone && !isAnimationBusy())
+    {
+        onAnimationsDone();
+    }
 }
 
-void refreshLedsFurnace()
+void updateLoopLatency()
 {
-    for (int i = 0; i < FBUTTONS_NUM; i++)
-    {
-        ledsFurnace[i].clear();
+    unsigned long now = millis();
+    unsigned long diff = now - animState.lastLoop;
 
-        for (int j = 0; j < progState.furnaceLedLevel[i]; j++)
-        {
-            ledsFurnace[i].setPixelColor(
-                furnaceLevelToLedIndex(j),
-                LED_FBUTTONS_COLOR);
-        }
+    animState.lastLoop = now;
 
-        ledsFurnace[i].show();
+    if (isAnimationBusy() && diff > animState.maxLatencyMs)
+    {
+        animState.maxLatencyMs = diff;
     }
 }
 
@@ -1347,10 +1564,10 @@ void decreaseFurnaceLedLevel()
 void onFurnacePhaseComplete()
 {
     Serial.println(F("Fbuttons :: Completed"));
-    playTrack(PIN_TRACK_FURNACE_OK);
-    waitForAudio();
-    openRelayFurnace();
     progState.isFurnacePhaseComplete = true;
+    queueAnimTrack(ANIM_TRACK_PIPES, PIN_TRACK_FURNACE_OK);
+    queueAnimStep(ANIM_TRACK_PIPES, ANIM_STEP_WAIT_AUDIO);
+    queueAnimCallback(ANIM_TRACK_PIPES, openRelayFurnace);
 }
 
 bool isFurnacePhaseComplete()
@@ -1466,44 +1683,6 @@ void initRelays()
  * Audio FX functions.
  */
 
-void playTrack(byte trackPin)
-{
-    if (isTrackPlaying())
-    {
-        Serial.println(F("Skipping: Audio playing"));
-        return;
-    }
-
-    Serial.print(F("Playing track on pin: "));
-    Serial.println(trackPin);
-
-    digitalWrite(trackPin, LOW);
-    pinMode(trackPin, OUTPUT);
-    delay(300);
-    pinMode(trackPin, INPUT);
-}
-
-void waitForAudio()
-{
-    const unsigned long maxWaitMs = 10000;
-    const unsigned long delayIterMs = 50;
-    const unsigned long marginDelayMs = 200;
-
-    delay(marginDelayMs);
-
-    unsigned long timeoutMillis = millis() + maxWaitMs;
-
-    while (isTrackPlaying())
-    {
-        delay(delayIterMs);
-
-        if (millis() > timeoutMillis)
-        {
-            break;
-        }
-    }
-}
-
 void initAudioPins()
 {
     pinMode(PIN_TRACK_RUNE_SET_COMPLETE, INPUT);
@@ -1560,11 +1739,24 @@ void setup()
 
 void loop()
 {
+    PROFILE_LOOP();
+    updateLoopLatency();
     automaton.run();
+    tickAnimations();
+    ledPipes.tick();
 
-    if (shouldListenToProxSensors())
+    if (!shouldListenToProxSensors())
+    {
+        return;
+    }
+
+    if (!isAnimTrackBusy(ANIM_TRACK_BOOK))
     {
         refreshLedsBook();
+    }
+
+    if (!isAnimTrackBusy(ANIM_TRACK_PIPES))
+    {
         refreshLedsPipes();
     }
 }
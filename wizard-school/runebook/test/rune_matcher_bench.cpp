@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <random>
+#include <set>
+#include <vector>
+#include <Arduino.h>
+#include "../RunePaths.h"
+
+/**
+ * Host benchmark of the rune matcher: the std::set matcher the sketch
+ * used to have against the cell bitmask matcher it has now, over random
+ * sensor walks expanded into matrix cells the way refreshHistoryPath()
+ * does. Both must recognise the same rune on every walk.
+ *
+ * Build and run from this directory with the native simulation core:
+ *
+ *   g++ -O2 -I ../../../native-sim/ArduinoSim/src rune_matcher_bench.cpp \
+ *       ../../../native-sim/ArduinoSim/src/ArduinoSim.cpp -o rune_matcher_bench
+ *   ./rune_matcher_bench
+ *
+ * Exits with 1 if the matchers disagree.
+ */
+
+const int HISTORY_SENSOR_SIZE = 9 * 3;
+const int HISTORY_PATH_SIZE = HISTORY_SENSOR_SIZE * (PATHS_ITEM_LEN + 1);
+
+const int NUM_WALKS = 20000;
+const int NUM_DRAWN_PER_RUNE = 500;
+const int NUM_ROUNDS = 20;
+
+struct RunePath
+{
+    const byte *cells;
+    size_t len;
+};
+
+#define RUNE_PATH(path) {path, sizeof(path)}
+
+const RunePath RUNES_PATHS[RUNES_NUM] = {
+    RUNE_PATH(RUNE_PATH_00),
+    RUNE_PATH(RUNE_PATH_01),
+    RUNE_PATH(RUNE_PATH_02),
+    RUNE_PATH(RUNE_PATH_03),
+    RUNE_PATH(RUNE_PATH_04),
+    RUNE_PATH(RUNE_PATH_05),
+    RUNE_PATH(RUNE_PATH_06),
+    RUNE_PATH(RUNE_PATH_07),
+    RUNE_PATH(RUNE_PATH_08),
+    RUNE_PATH(RUNE_PATH_09),
+    RUNE_PATH(RUNE_PATH_10),
+    RUNE_PATH(RUNE_PATH_11)};
+
+const RunePath RUNE_RESET = RUNE_PATH(RUNE_RESET_PATH);
+
+// Result of a match: 0..RUNES_NUM - 1, RESET or NONE
+const int RESULT_RESET = RUNES_NUM;
+const int RESULT_NONE = -1;
+
+typedef struct drawnPath
+{
+    int historyPath[HISTORY_PATH_SIZE];
+    uint64_t historyPathMask;
+} DrawnPath;
+
+/**
+ * Heap allocations, counted by the global operator new.
+ */
+
+unsigned long numAllocations = 0;
+
+void *operator new(size_t size)
+{
+    numAllocations++;
+
+    void *p = malloc(size);
+
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+/**
+ * The matcher as it was: a set of the drawn cells against a set per rune.
+ */
+
+int getHistoryPathSize(const DrawnPath &drawn)
+{
+    int currSize = 0;
+
+    while (currSize < HISTORY_PATH_SIZE && drawn.historyPath[currSize] != -1)
+    {
+        currSize++;
+    }
+
+    return currSize;
+}
+
+bool isResetRuneSet(const DrawnPath &drawn)
+{
+    std::set<int> histPathSet(
+        drawn.historyPath,
+        drawn.historyPath + getHistoryPathSize(drawn));
+
+    std::set<int> resetRuneSet(
+        RUNE_RESET.cells,
+        RUNE_RESET.cells + RUNE_RESET.len);
+
+    return histPathSet == resetRuneSet;
+}
+
+int getRuneSet(const DrawnPath &drawn)
+{
+    int currSize = getHistoryPathSize(drawn);
+
+    if (currSize == 0)
+    {
+        return RESULT_NONE;
+    }
+
+    std::set<int> histPathSet(
+        drawn.historyPath,
+        drawn.historyPath + currSize);
+
+    for (int i = 0; i < RUNES_NUM; i++)
+    {
+        std::set<int> runeSet(
+            RUNES_PATHS[i].cells,
+            RUNES_PATHS[i].cells + RUNES_PATHS[i].len);
+
+        if (histPathSet == runeSet)
+        {
+            return i;
+        }
+    }
+
+    return RESULT_NONE;
+}
+
+int matchSet(const DrawnPath &drawn)
+{
+    return isResetRuneSet(drawn) ? RESULT_RESET : getRuneSet(drawn);
+}
+
+/**
+ * The matcher as it is: the mask kept by refreshHistoryPath().
+ */
+
+int matchMask(const DrawnPath &drawn)
+{
+    if (drawn.historyPathMask == RUNE_RESET_MASK)
+    {
+        return RESULT_RESET;
+    }
+
+    if (drawn.historyPathMask == 0)
+    {
+        return RESULT_NONE;
+    }
+
+    for (int i = 0; i < RUNES_NUM; i++)
+    {
+        if (drawn.historyPathMask == RUNES_MASKS[i])
+        {
+            return i;
+        }
+    }
+
+    return RESULT_NONE;
+}
+
+/**
+ * Walks.
+ */
+
+void clearDrawn(DrawnPath &drawn)
+{
+    for (int i = 0; i < HISTORY_PATH_SIZE; i++)
+    {
+        drawn.historyPath[i] = -1;
+    }
+
+    drawn.historyPathMask = 0;
+}
+
+void appendCell(DrawnPath &drawn, int &pivot, int cell)
+{
+    drawn.historyPath[pivot++] = cell;
+    drawn.historyPathMask |= (uint64_t)1 << cell;
+}
+
+/**
+ * A walk over the proximity sensors (the ends of PATHS), moving to an
+ * adjacent sensor on each step, expanded into the cells of each path.
+ */
+void randomWalk(DrawnPath &drawn, std::mt19937 &rng)
+{
+    std::uniform_int_distribution<int> numSensorsDist(2, HISTORY_SENSOR_SIZE);
+    int numSensors = numSensorsDist(rng);
+    int sensor = PATHS[rng() % PATHS_SIZE][0];
+    int pivot = 0;
+
+    clearDrawn(drawn);
+
+    for (int s = 1; s < numSensors; s++)
+    {
+        int options[PATHS_SIZE];
+        bool isDesc[PATHS_SIZE];
+        int numOptions = 0;
+
+        for (int i = 0; i < PATHS_SIZE; i++)
+        {
+            if (PATHS[i][0] == sensor || PATHS[i][PATHS_ITEM_LEN - 1] == sensor)
+            {
+                isDesc[numOptions] = PATHS[i][0] != sensor;
+                options[numOptions++] = i;
+            }
+        }
+
+        int pick = rng() % numOptions;
+        const byte *path = PATHS[options[pick]];
+
+        for (int j = 0; j < PATHS_ITEM_LEN; j++)
+        {
+            appendCell(drawn, pivot, path[isDesc[pick] ? PATHS_ITEM_LEN - 1 - j : j]);
+        }
+
+        sensor = isDesc[pick] ? path[0] : path[PATHS_ITEM_LEN - 1];
+    }
+}
+
+/**
+ * The cells of a rune in a random order, with some drawn twice, as when
+ * a stroke is retraced.
+ */
+void drawRune(DrawnPath &drawn, const RunePath &rune, std::mt19937 &rng)
+{
+    std::vector<int> cells(rune.cells, rune.cells + rune.len);
+    int pivot = 0;
+
+    for (size_t i = 0; i < rune.len && cells.size() < (size_t)HISTORY_PATH_SIZE; i += 3)
+    {
+        cells.push_back(rune.cells[rng() % rune.len]);
+    }
+
+    std::shuffle(cells.begin(), cells.end(), rng);
+    clearDrawn(drawn);
+
+    for (size_t i = 0; i < cells.size(); i++)
+    {
+        appendCell(drawn, pivot, cells[i]);
+    }
+}
+
+template <typename Matcher>
+double timeMatcher(const std::vector<DrawnPath> &paths, Matcher match, long &checksum)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (int round = 0; round < NUM_ROUNDS; round++)
+    {
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            checksum += match(paths[i]);
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           (NUM_ROUNDS * paths.size());
+}
+
+void setup()
+{
+}
+
+void loop()
+{
+}
+
+int main()
+{
+    std::mt19937 rng(1234);
+    std::vector<DrawnPath> paths;
+    DrawnPath drawn;
+
+    for (int i = 0; i < NUM_WALKS; i++)
+    {
+        randomWalk(drawn, rng);
+        paths.push_back(drawn);
+    }
+
+    for (int r = 0; r <= RUNES_NUM; r++)
+    {
+        for (int i = 0; i < NUM_DRAWN_PER_RUNE; i++)
+        {
+            drawRune(drawn, r < RUNES_NUM ? RUNES_PATHS[r] : RUNE_RESET, rng);
+            paths.push_back(drawn);
+        }
+    }
+
+    int numMismatches = 0;
+    int numRecognised = 0;
+
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        int bySet = matchSet(paths[i]);
+        int byMask = matchMask(paths[i]);
+
+        numMismatches += bySet != byMask;
+        numRecognised += byMask != RESULT_NONE;
+    }
+
+    unsigned long allocationsBefore = numAllocations;
+    matchSet(paths[0]);
+    unsigned long setAllocations = numAllocations - allocationsBefore;
+
+    allocationsBefore = numAllocations;
+    matchMask(paths[0]);
+    unsigned long maskAllocations = numAllocations - allocationsBefore;
+
+    long setChecksum = 0;
+    long maskChecksum = 0;
+    double setNs = timeMatcher(paths, matchSet, setChecksum);
+    double maskNs = timeMatcher(paths, matchMask, maskChecksum);
+
+    printf("%zu paths (%d random walks, %d drawn runes), %d recognised\n",
+           paths.size(), NUM_WALKS, NUM_DRAWN_PER_RUNE * (RUNES_NUM + 1), numRecognised);
+    printf("set:  %8.1f ns/match, %lu allocations/match\n", setNs, setAllocations);
+    printf("mask: %8.1f ns/match, %lu allocations/match\n", maskNs, maskAllocations);
+    printf("mismatches: %d\n", numMismatches);
+
+    return numMismatches == 0 && setChecksum == maskChecksum ? 0 : 1;
+}
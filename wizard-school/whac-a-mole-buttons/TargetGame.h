@@ -0,0 +1,151 @@
+#ifndef TARGET_GAME_H
+#define TARGET_GAME_H
+
+#include <Arduino.h>
+
+/**
+ * Target engine for the whac-a-mole family of reaction games.
+ *
+ * Targets and hits are bitmasks with one bit per button or knock sensor.
+ * A hit outside the targets is an error: (hits & ~targets) != 0.
+ * The round is complete when every target has been hit: hits == targets.
+ * Repeated hits on the same index are absorbed by the OR.
+ *
+ * New targets are drawn with a partial Fisher-Yates shuffle over the
+ * indices that are not ignored, so drawing N targets takes exactly N
+ * random() calls and never retries.
+ */
+
+typedef uint16_t TargetMask;
+
+const uint8_t TARGET_GAME_MAX_SIZE = 16;
+
+class TargetGame
+{
+public:
+    TargetGame(uint8_t size, TargetMask ignored = 0)
+        : size(size > TARGET_GAME_MAX_SIZE ? TARGET_GAME_MAX_SIZE : size),
+          ignored(ignored),
+          targets(0),
+          hits(0)
+    {
+    }
+
+    void clear()
+    {
+        targets = 0;
+        hits = 0;
+    }
+
+    void clearHits()
+    {
+        hits = 0;
+    }
+
+    /**
+     * Replaces the targets with num distinct random indices.
+     * Returns the number of targets that could be drawn.
+     */
+    uint8_t randomize(uint8_t num)
+    {
+        uint8_t pool[TARGET_GAME_MAX_SIZE];
+        uint8_t poolSize = 0;
+
+        for (uint8_t i = 0; i < size; i++)
+        {
+            if (!(ignored & maskOf(i)))
+            {
+                pool[poolSize++] = i;
+            }
+        }
+
+        num = num > poolSize ? poolSize : num;
+        targets = 0;
+        hits = 0;
+
+        for (uint8_t i = 0; i < num; i++)
+        {
+            uint8_t j = random(i, poolSize);
+            uint8_t picked = pool[j];
+
+            pool[j] = pool[i];
+            pool[i] = picked;
+            targets |= maskOf(picked);
+        }
+
+        return num;
+    }
+
+    /**
+     * Registers a hit. Returns false if the index was already hit.
+     */
+    bool hit(uint8_t idx)
+    {
+        if (idx >= size || (hits & maskOf(idx)))
+        {
+            return false;
+        }
+
+        hits |= maskOf(idx);
+
+        return true;
+    }
+
+    bool isTarget(uint8_t idx) const
+    {
+        return targets & maskOf(idx);
+    }
+
+    bool isHit(uint8_t idx) const
+    {
+        return hits & maskOf(idx);
+    }
+
+    bool isError() const
+    {
+        return (hits & ~targets) != 0;
+    }
+
+    bool isMatch() const
+    {
+        return hits == targets;
+    }
+
+    TargetMask getTargets() const
+    {
+        return targets;
+    }
+
+    TargetMask getHits() const
+    {
+        return hits;
+    }
+
+    static TargetMask maskOf(uint8_t idx)
+    {
+        return (TargetMask)1 << idx;
+    }
+
+private:
+    uint8_t size;
+    TargetMask ignored;
+    TargetMask targets;
+    TargetMask hits;
+};
+
+/**
+ * Reads a per-phase config table.
+ * Phases past the end of the table use its last entry.
+ */
+template <typename T, size_t N>
+T phaseValue(const T (&table)[N], int phase)
+{
+    if (phase < 0)
+    {
+        return table[0];
+    }
+
+    return table[(size_t)phase < N ? phase : N - 1];
+}
+
+#endif
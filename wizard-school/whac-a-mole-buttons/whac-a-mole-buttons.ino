@@ -1,6 +1,6 @@
 #include <Automaton.h>
 #include <Adafruit_NeoPixel.h>
-#include <CircularBuffer.h>
+#include "TargetGame.h"
 
 /**
  * Buttons.
@@ -13,8 +13,7 @@ const int BUTTONS_PINS[BUTTONS_NUM] = {
 
 Atm_button buttons[BUTTONS_NUM];
 
-const int BUTTONS_BUF_SIZE = 10;
-CircularBuffer<byte, BUTTONS_BUF_SIZE> buttonBuf;
+TargetGame buttonTargets(BUTTONS_NUM);
 
 const int BUTTONS_BOUNCE_MS = 100;
 
@@ -45,22 +44,16 @@ Adafruit_NeoPixel ledStrip = Adafruit_NeoPixel(LED_NUM, LED_PIN, NEO_RGB + NEO_K
 
 const int FINAL_PHASE = 4;
 
-const int SUCCESS_STREAK_LONG = 6;
-const int SUCCESS_STREAK_MEDIUM = 4;
-const int SUCCESS_STREAK_SHORT = 3;
+constexpr int PHASE_HIT_STREAK[] = {6, 4, 3};
+constexpr unsigned long PHASE_MAX_SPAN_MILLIS[] = {6000, 3000, 1500};
 
-const unsigned long MILLIS_SPAN_LONG = 6000;
-const unsigned long MILLIS_SPAN_MEDIUM = 3000;
-const unsigned long MILLIS_SPAN_SHORT = 1500;
-
-const int TARGETS_SIZE = BUTTONS_NUM;
-
-int targetKnocks[TARGETS_SIZE];
+// Targets are drawn from [min, max)
+constexpr int PHASE_NUM_TARGETS_MIN[] = {1, 2, 3, 4};
+constexpr int PHASE_NUM_TARGETS_MAX[] = {3, 4, 5, 6};
 
 typedef struct programState
 {
     unsigned long startMillis;
-    int *targetKnocks;
     int currPhase;
     int hitStreak;
     bool isFinished;
@@ -68,15 +61,13 @@ typedef struct programState
 
 ProgramState progState = {
     .startMillis = 0,
-    .targetKnocks = targetKnocks,
     .currPhase = 0,
     .hitStreak = 0,
     .isFinished = false};
 
 void cleanState()
 {
-    buttonBuf.clear();
-    emptyTargets();
+    buttonTargets.clear();
     progState.startMillis = 0;
     progState.currPhase = 0;
     progState.hitStreak = 0;
@@ -89,199 +80,30 @@ void cleanState()
 
 int getPhaseHitStreak(int phase)
 {
-    if (phase == 0)
-    {
-        return SUCCESS_STREAK_LONG;
-    }
-    else if (phase == 1)
-    {
-        return SUCCESS_STREAK_MEDIUM;
-    }
-    else
-    {
-        return SUCCESS_STREAK_SHORT;
-    }
+    return phaseValue(PHASE_HIT_STREAK, phase);
 }
 
 unsigned long getPhaseMaxSpanMillis(int phase)
 {
-    if (phase == 0)
-    {
-        return MILLIS_SPAN_LONG;
-    }
-    else if (phase == 1)
-    {
-        return MILLIS_SPAN_MEDIUM;
-    }
-    else
-    {
-        return MILLIS_SPAN_SHORT;
-    }
+    return phaseValue(PHASE_MAX_SPAN_MILLIS, phase);
 }
 
 int getPhaseNumTargets(int phase)
 {
-    phase = phase + 1;
-
-    int maxNum = phase + 2;
-    int minNum = phase;
-
-    maxNum = maxNum > BUTTONS_NUM ? BUTTONS_NUM : maxNum;
-    maxNum = maxNum < 2 ? 2 : maxNum;
-
-    minNum = minNum < 1 ? 1 : minNum;
-    minNum = minNum > (BUTTONS_NUM - 1) ? (BUTTONS_NUM - 1) : minNum;
-
-    if (minNum > maxNum)
-    {
-        minNum = maxNum;
-    }
-
-    return random(minNum, maxNum);
-}
-
-bool isTarget(int idx)
-{
-    for (int i = 0; i < TARGETS_SIZE; i++)
-    {
-        if (progState.targetKnocks[i] == -1)
-        {
-            return false;
-        }
-        else if (progState.targetKnocks[i] == idx)
-        {
-            return true;
-        }
-    }
-
-    return false;
-}
-
-bool addTarget(int idx)
-{
-    if (idx < 0 || idx >= LED_NUM)
-    {
-        Serial.println(F("Target should be in [0, numLeds)"));
-        return false;
-    }
-
-    if (isTarget(idx))
-    {
-        return false;
-    }
-
-    for (int i = 0; i < TARGETS_SIZE; i++)
-    {
-        if (progState.targetKnocks[i] == -1)
-        {
-            Serial.print(F("Adding target: "));
-            Serial.println(idx);
-            progState.targetKnocks[i] = idx;
-            return true;
-        }
-    }
-
-    return false;
-}
-
-void emptyTargets()
-{
-    for (int i = 0; i < TARGETS_SIZE; i++)
-    {
-        progState.targetKnocks[i] = -1;
-    }
-}
-
-int pickRandomTarget()
-{
-    int randPivot = random(0, TARGETS_SIZE * 10) % TARGETS_SIZE;
-    int counter = 0;
-
-    while (isTarget(randPivot) && counter <= TARGETS_SIZE)
-    {
-        randPivot = (randPivot + 1) % TARGETS_SIZE;
-        counter++;
-    }
-
-    return isTarget(randPivot) ? -1 : randPivot;
+    return random(
+        phaseValue(PHASE_NUM_TARGETS_MIN, phase),
+        phaseValue(PHASE_NUM_TARGETS_MAX, phase));
 }
 
 void randomizeTargets(int num)
 {
-    num = (num > (TARGETS_SIZE)) ? TARGETS_SIZE : num;
-
-    emptyTargets();
-
-    int randTarget;
-
-    for (int i = 0; i < num; i++)
-    {
-        randTarget = pickRandomTarget();
-
-        if (randTarget == -1)
-        {
-            Serial.println(F("Warn: no more random targets to pick"));
-            break;
-        }
-
-        addTarget(randTarget);
-    }
-}
-
-bool isButtonBufferError()
-{
-    for (int i = 0; i < buttonBuf.size(); i++)
-    {
-        if (!isTarget(buttonBuf[i]))
-        {
-            return true;
-        }
-    }
-
-    return false;
-}
-
-bool isButtonBufferMatch()
-{
-    int targetSize = 0;
-
-    for (int i = 0; i < TARGETS_SIZE; i++)
+    if (buttonTargets.randomize(num) < num)
     {
-        if (progState.targetKnocks[i] == -1)
-        {
-            break;
-        }
-
-        targetSize++;
-    }
-
-    if (targetSize != buttonBuf.size())
-    {
-        return false;
+        Serial.println(F("Warn: no more random targets to pick"));
     }
 
-    bool bufHasTarget;
-
-    for (int i = 0; i < targetSize; i++)
-    {
-        bufHasTarget = false;
-
-        for (int j = 0; j < buttonBuf.size(); j++)
-        {
-            if (buttonBuf[j] == progState.targetKnocks[i])
-            {
-                bufHasTarget = true;
-                break;
-            }
-        }
-
-        if (!bufHasTarget)
-        {
-            return false;
-        }
-    }
-
-    return true;
+    Serial.print(F("Targets: "));
+    Serial.println(buttonTargets.getTargets(), BIN);
 }
 
 bool isExpired()
@@ -313,7 +135,6 @@ void updateTargets()
     randomizeTargets(numTargets);
     showTargetLeds();
     progState.startMillis = millis();
-    buttonBuf.clear();
 }
 
 void advanceProgress()
@@ -363,7 +184,7 @@ void updateState()
         Serial.println(F("First target update"));
         updateTargets();
     }
-    else if (isButtonBufferError())
+    else if (buttonTargets.isError())
     {
         Serial.println(F("Knock pattern error: restart"));
 
@@ -385,7 +206,7 @@ void updateState()
 
         cleanState();
     }
-    else if (isButtonBufferMatch())
+    else if (buttonTargets.isMatch())
     {
         Serial.println(F("OK: advancing progress"));
         advanceProgress();
@@ -424,9 +245,12 @@ void showTargetLeds()
 {
     ledStrip.clear();
 
-    for (int i = 0; i < TARGETS_SIZE; i++)
+    for (int i = 0; i < BUTTONS_NUM; i++)
     {
-        ledStrip.setPixelColor(progState.targetKnocks[i], randomColor());
+        if (buttonTargets.isTarget(i))
+        {
+            ledStrip.setPixelColor(i, randomColor());
+        }
     }
 
     ledStrip.show();
@@ -546,23 +370,10 @@ void onPress(int idx, int v, int up)
     Serial.print(F("Press:"));
     Serial.println(idx);
 
-    bool isDup = false;
-
-    for (int i = 0; i < buttonBuf.size(); i++)
-    {
-        if (buttonBuf[i] == idx)
-        {
-            isDup = true;
-            break;
-        }
-    }
-
-    if (!isDup)
+    if (buttonTargets.hit(idx))
     {
         Serial.print(F("Pushing:"));
         Serial.println(idx);
-
-        buttonBuf.push(idx);
     }
 }
 
@@ -0,0 +1,402 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <Arduino.h>
+#include <CircularBuffer.h>
+#include "../TargetGame.h"
+
+/**
+ * Host benchmark of TargetGame against the target functions whac-a-mole
+ * had before it: -1 terminated target array, linear-probe picker and a
+ * CircularBuffer of knocks scanned for errors and matches.
+ *
+ * Each round draws 1-5 targets on the 7 knock sensors, with sensor 3
+ * ignored, then hits every target in a random order and checks for an
+ * error and a match after each hit. It also counts how often each sensor
+ * is drawn by both pickers.
+ *
+ * Build and run from this directory with the native simulation core:
+ *
+ *   g++ -O2 -I ../../../native-sim/ArduinoSim/src target_game_bench.cpp \
+ *       ../../../native-sim/ArduinoSim/src/ArduinoSim.cpp -o target_game_bench
+ *   ./target_game_bench
+ *
+ * Exits with 1 if the two disagree on whether a sequence of knocks is an
+ * error or a match, for every set of targets.
+ */
+
+const int KNOCK_NUM = 7;
+const int KNOCK_IGNORED_IDX = 3;
+const int KNOCK_BUF_SIZE = 10;
+
+const int NUM_ROUNDS = 200000;
+
+/**
+ * The target functions as they were (without the serial logging).
+ */
+
+const int TARGETS_SIZE = KNOCK_NUM;
+
+int targetKnocks[TARGETS_SIZE];
+CircularBuffer<byte, KNOCK_BUF_SIZE> knockBuf;
+
+bool isIgnoredKnock(int knockIdx)
+{
+    return knockIdx == KNOCK_IGNORED_IDX;
+}
+
+bool isTarget(int idx)
+{
+    for (int i = 0; i < TARGETS_SIZE; i++)
+    {
+        if (targetKnocks[i] == -1)
+        {
+            return false;
+        }
+        else if (targetKnocks[i] == idx)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool addTarget(int idx)
+{
+    if (idx < 0 || idx >= KNOCK_NUM || isTarget(idx))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < TARGETS_SIZE; i++)
+    {
+        if (targetKnocks[i] == -1)
+        {
+            targetKnocks[i] = idx;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void emptyTargets()
+{
+    for (int i = 0; i < TARGETS_SIZE; i++)
+    {
+        targetKnocks[i] = -1;
+    }
+}
+
+int pickRandomTarget()
+{
+    int pivot = random(0, TARGETS_SIZE * 10) % TARGETS_SIZE;
+    int counter = 0;
+
+    while ((isTarget(pivot) || isIgnoredKnock(pivot)) &&
+           counter <= TARGETS_SIZE)
+    {
+        pivot = (pivot + 1) % TARGETS_SIZE;
+        counter++;
+    }
+
+    return (isTarget(pivot) || isIgnoredKnock(pivot)) ? -1 : pivot;
+}
+
+void randomizeTargets(int num)
+{
+    num = (num > (TARGETS_SIZE)) ? TARGETS_SIZE : num;
+
+    emptyTargets();
+
+    for (int i = 0; i < num; i++)
+    {
+        int randTarget = pickRandomTarget();
+
+        if (randTarget == -1)
+        {
+            break;
+        }
+
+        addTarget(randTarget);
+    }
+}
+
+bool isKnockBufferError()
+{
+    for (int i = 0; i < knockBuf.size(); i++)
+    {
+        if (!isTarget(knockBuf[i]))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool isKnockBufferMatch()
+{
+    int targetSize = 0;
+
+    for (int i = 0; i < TARGETS_SIZE; i++)
+    {
+        if (targetKnocks[i] == -1)
+        {
+            break;
+        }
+
+        targetSize++;
+    }
+
+    if (targetSize != knockBuf.size())
+    {
+        return false;
+    }
+
+    for (int i = 0; i < targetSize; i++)
+    {
+        bool bufHasTarget = false;
+
+        for (int j = 0; j < knockBuf.size(); j++)
+        {
+            if (knockBuf[j] == targetKnocks[i])
+            {
+                bufHasTarget = true;
+                break;
+            }
+        }
+
+        if (!bufHasTarget)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void pushKnock(int idx)
+{
+    for (int i = 0; i < knockBuf.size(); i++)
+    {
+        if (knockBuf[i] == idx)
+        {
+            return;
+        }
+    }
+
+    knockBuf.push(idx);
+}
+
+/**
+ * Rounds.
+ */
+
+typedef struct roundPlan
+{
+    uint8_t numTargets;
+    uint8_t hitOrder[KNOCK_NUM];
+} RoundPlan;
+
+int playOld(const RoundPlan &plan, unsigned long *drawn)
+{
+    int result = 0;
+
+    randomizeTargets(plan.numTargets);
+    knockBuf.clear();
+
+    for (int i = 0; i < TARGETS_SIZE && targetKnocks[i] != -1; i++)
+    {
+        drawn[targetKnocks[i]]++;
+    }
+
+    for (int i = 0; i < KNOCK_NUM; i++)
+    {
+        int idx = plan.hitOrder[i];
+
+        if (!isTarget(idx))
+        {
+            continue;
+        }
+
+        pushKnock(idx);
+        result = result * 3 + isKnockBufferError() * 2 + isKnockBufferMatch();
+    }
+
+    return result;
+}
+
+TargetGame game(KNOCK_NUM, TargetGame::maskOf(KNOCK_IGNORED_IDX));
+
+int playNew(const RoundPlan &plan, unsigned long *drawn)
+{
+    int result = 0;
+
+    game.randomize(plan.numTargets);
+
+    for (int i = 0; i < KNOCK_NUM; i++)
+    {
+        if (game.isTarget(i))
+        {
+            drawn[i]++;
+        }
+    }
+
+    for (int i = 0; i < KNOCK_NUM; i++)
+    {
+        int idx = plan.hitOrder[i];
+
+        if (!game.isTarget(idx))
+        {
+            continue;
+        }
+
+        game.hit(idx);
+        result = result * 3 + game.isError() * 2 + game.isMatch();
+    }
+
+    return result;
+}
+
+/**
+ * Both engines on the same targets: TargetGame draws all the indices it
+ * does not ignore, so ignoring the complement sets its targets.
+ */
+int checkEquivalence(std::mt19937 &rng)
+{
+    const int numSequences = 2000;
+    int numMismatches = 0;
+
+    for (TargetMask targets = 1; targets < TargetGame::maskOf(KNOCK_NUM); targets++)
+    {
+        if (targets & TargetGame::maskOf(KNOCK_IGNORED_IDX))
+        {
+            continue;
+        }
+
+        TargetGame fixed(KNOCK_NUM, ~targets);
+
+        emptyTargets();
+
+        for (int i = 0; i < KNOCK_NUM; i++)
+        {
+            if (targets & TargetGame::maskOf(i))
+            {
+                addTarget(i);
+            }
+        }
+
+        for (int s = 0; s < numSequences; s++)
+        {
+            int numKnocks = 1 + rng() % KNOCK_BUF_SIZE;
+
+            fixed.randomize(KNOCK_NUM);
+            knockBuf.clear();
+
+            for (int k = 0; k < numKnocks; k++)
+            {
+                int idx = rng() % KNOCK_NUM;
+
+                if (isIgnoredKnock(idx))
+                {
+                    continue;
+                }
+
+                pushKnock(idx);
+                fixed.hit(idx);
+
+                numMismatches += isKnockBufferError() != fixed.isError();
+                numMismatches += isKnockBufferMatch() != fixed.isMatch();
+            }
+        }
+    }
+
+    return numMismatches;
+}
+
+template <typename Player>
+double timeRounds(const RoundPlan *plans, Player play, unsigned long *drawn, long &checksum)
+{
+    randomSeed(42);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int r = 0; r < NUM_ROUNDS; r++)
+    {
+        checksum += play(plans[r], drawn);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / NUM_ROUNDS;
+}
+
+void printDistribution(const char *name, const unsigned long *drawn)
+{
+    unsigned long total = 0;
+
+    for (int i = 0; i < KNOCK_NUM; i++)
+    {
+        total += drawn[i];
+    }
+
+    printf("%s drawn:", name);
+
+    for (int i = 0; i < KNOCK_NUM; i++)
+    {
+        printf(" %d=%.3f", i, (double)drawn[i] * (KNOCK_NUM - 1) / total);
+    }
+
+    printf(" (1.000 is uniform)\n");
+}
+
+void setup()
+{
+}
+
+void loop()
+{
+}
+
+int main()
+{
+    static RoundPlan plans[NUM_ROUNDS];
+    std::mt19937 rng(1234);
+
+    for (int r = 0; r < NUM_ROUNDS; r++)
+    {
+        plans[r].numTargets = 1 + rng() % 5;
+
+        for (int i = 0; i < KNOCK_NUM; i++)
+        {
+            plans[r].hitOrder[i] = i;
+        }
+
+        std::shuffle(plans[r].hitOrder, plans[r].hitOrder + KNOCK_NUM, rng);
+    }
+
+    unsigned long drawnOld[KNOCK_NUM] = {0};
+    unsigned long drawnNew[KNOCK_NUM] = {0};
+    long checksumOld = 0;
+    long checksumNew = 0;
+
+    double oldNs = timeRounds(plans, playOld, drawnOld, checksumOld);
+    double newNs = timeRounds(plans, playNew, drawnNew, checksumNew);
+
+    int numMismatches = checkEquivalence(rng);
+
+    printf("%d rounds of 1-5 targets on %d sensors\n", NUM_ROUNDS, KNOCK_NUM);
+    printf("old:         %6.1f ns/round\n", oldNs);
+    printf("TargetGame:  %6.1f ns/round\n", newNs);
+    printDistribution("old", drawnOld);
+    printDistribution("TargetGame", drawnNew);
+    printf("mismatches: %d\n", numMismatches);
+
+    bool isOk = numMismatches == 0 &&
+                checksumOld == checksumNew &&
+                drawnNew[KNOCK_IGNORED_IDX] == 0;
+
+    return isOk ? 0 : 1;
+}
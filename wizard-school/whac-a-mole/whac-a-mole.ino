@@ -1,6 +1,10 @@
 #include <Automaton.h>
 #include <Adafruit_NeoPixel.h>
-#include <CircularBuffer.h>
+#include "DirtyNeoPixel.h"
+#include "TargetGame.h"
+
+// #define LOOP_PROFILER
+#include "LoopProfiler.h"
 
 /**
  * Color gamma correction.
@@ -114,9 +118,6 @@ const int KNOCK_PINS[KNOCK_NUM] = {
 Atm_analog knockAnalogs[KNOCK_NUM];
 Atm_controller knockControllers[KNOCK_NUM];
 
-const int KNOCK_BUF_SIZE = 10;
-CircularBuffer<byte, KNOCK_BUF_SIZE> knockBuf;
-
 const int KNOCK_BOUNCE_MS = 500;
 
 /**
@@ -127,6 +128,10 @@ const int KNOCK_BOUNCE_MS = 500;
 const bool KNOCK_IGNORE = true;
 const int KNOCK_IGNORED_IDX = 3;
 
+TargetGame knockTargets(
+    KNOCK_NUM,
+    KNOCK_IGNORE ? TargetGame::maskOf(KNOCK_IGNORED_IDX) : 0);
+
 /**
  * Colors for the unlock phase.
  */
@@ -167,7 +172,7 @@ const int LED_SUCCESS_ITERS = 6;
 const int LED_SUCCESS_SLEEP_MS = 200;
 const int LED_FADE_MS = 5;
 
-Adafruit_NeoPixel ledStrip = Adafruit_NeoPixel(LED_NUM, LED_PIN, NEO_RGB + NEO_KHZ800);
+DirtyNeoPixel ledStrip(LED_NUM, LED_PIN, NEO_RGB + NEO_KHZ800);
 
 /**
  * Program state.
@@ -175,17 +180,13 @@ Adafruit_NeoPixel ledStrip = Adafruit_NeoPixel(LED_NUM, LED_PIN, NEO_RGB + NEO_K
 
 const int FINAL_PHASE = 4;
 
-const int SUCCESS_STREAK_LONG = 6;
-const int SUCCESS_STREAK_MEDIUM = 4;
-const int SUCCESS_STREAK_SHORT = 3;
-
-const unsigned long MILLIS_SPAN_LONG = 6000;
-const unsigned long MILLIS_SPAN_MEDIUM = 6000;
-const unsigned long MILLIS_SPAN_SHORT = 6000;
+constexpr int PHASE_HIT_STREAK[] = {6, 4, 3};
+constexpr unsigned long PHASE_MAX_SPAN_MILLIS[] = {6000, 6000, 6000};
 
-const int TARGETS_SIZE = KNOCK_NUM;
+// Targets are drawn from [min, max)
+constexpr int PHASE_NUM_TARGETS_MIN[] = {1, 2, 3, 4};
+constexpr int PHASE_NUM_TARGETS_MAX[] = {3, 4, 5, 6};
 
-int targetKnocks[TARGETS_SIZE];
 int currColorIdx[KNOCK_NUM];
 
 typedef struct programState
@@ -193,7 +194,6 @@ typedef struct programState
     bool isKnockUnlocked;
     unsigned long lastLockMillis;
     unsigned long startMillis;
-    int *targetKnocks;
     int currPhase;
     int hitStreak;
     bool isKnockComplete;
@@ -204,7 +204,6 @@ ProgramState progState = {
     .isKnockUnlocked = false,
     .lastLockMillis = 0,
     .startMillis = 0,
-    .targetKnocks = targetKnocks,
     .currPhase = 0,
     .hitStreak = 0,
     .isKnockComplete = false,
@@ -222,8 +221,7 @@ void initState()
 
 void cleanKnockGameState()
 {
-    knockBuf.clear();
-    emptyTargets();
+    knockTargets.clear();
     progState.startMillis = 0;
     progState.currPhase = 0;
     progState.hitStreak = 0;
@@ -236,200 +234,30 @@ void cleanKnockGameState()
 
 int getPhaseHitStreak(int phase)
 {
-    if (phase == 0)
-    {
-        return SUCCESS_STREAK_LONG;
-    }
-    else if (phase == 1)
-    {
-        return SUCCESS_STREAK_MEDIUM;
-    }
-    else
-    {
-        return SUCCESS_STREAK_SHORT;
-    }
+    return phaseValue(PHASE_HIT_STREAK, phase);
 }
 
 unsigned long getPhaseMaxSpanMillis(int phase)
 {
-    if (phase == 0)
-    {
-        return MILLIS_SPAN_LONG;
-    }
-    else if (phase == 1)
-    {
-        return MILLIS_SPAN_MEDIUM;
-    }
-    else
-    {
-        return MILLIS_SPAN_SHORT;
-    }
+    return phaseValue(PHASE_MAX_SPAN_MILLIS, phase);
 }
 
 int getPhaseNumTargets(int phase)
 {
-    phase = phase + 1;
-
-    int maxNum = phase + 2;
-    int minNum = phase;
-
-    maxNum = maxNum > KNOCK_NUM ? KNOCK_NUM : maxNum;
-    maxNum = maxNum < 2 ? 2 : maxNum;
-
-    minNum = minNum < 1 ? 1 : minNum;
-    minNum = minNum > (KNOCK_NUM - 1) ? (KNOCK_NUM - 1) : minNum;
-
-    if (minNum > maxNum)
-    {
-        minNum = maxNum;
-    }
-
-    return random(minNum, maxNum);
-}
-
-bool isTarget(int idx)
-{
-    for (int i = 0; i < TARGETS_SIZE; i++)
-    {
-        if (progState.targetKnocks[i] == -1)
-        {
-            return false;
-        }
-        else if (progState.targetKnocks[i] == idx)
-        {
-            return true;
-        }
-    }
-
-    return false;
-}
-
-bool addTarget(int idx)
-{
-    if (idx < 0 || idx >= LED_NUM)
-    {
-        Serial.println(F("Target should be in [0, numLeds)"));
-        return false;
-    }
-
-    if (isTarget(idx))
-    {
-        return false;
-    }
-
-    for (int i = 0; i < TARGETS_SIZE; i++)
-    {
-        if (progState.targetKnocks[i] == -1)
-        {
-            Serial.print(F("Adding target: "));
-            Serial.println(idx);
-            progState.targetKnocks[i] = idx;
-            return true;
-        }
-    }
-
-    return false;
-}
-
-void emptyTargets()
-{
-    for (int i = 0; i < TARGETS_SIZE; i++)
-    {
-        progState.targetKnocks[i] = -1;
-    }
-}
-
-int pickRandomTarget()
-{
-    int pivot = random(0, TARGETS_SIZE * 10) % TARGETS_SIZE;
-    int counter = 0;
-
-    while ((isTarget(pivot) || isIgnoredKnock(pivot)) &&
-           counter <= TARGETS_SIZE)
-    {
-        pivot = (pivot + 1) % TARGETS_SIZE;
-        counter++;
-    }
-
-    return (isTarget(pivot) || isIgnoredKnock(pivot)) ? -1 : pivot;
+    return random(
+        phaseValue(PHASE_NUM_TARGETS_MIN, phase),
+        phaseValue(PHASE_NUM_TARGETS_MAX, phase));
 }
 
 void randomizeTargets(int num)
 {
-    num = (num > (TARGETS_SIZE)) ? TARGETS_SIZE : num;
-
-    emptyTargets();
-
-    int randTarget;
-
-    for (int i = 0; i < num; i++)
-    {
-        randTarget = pickRandomTarget();
-
-        if (randTarget == -1)
-        {
-            Serial.println(F("Warn: no more random targets to pick"));
-            break;
-        }
-
-        addTarget(randTarget);
-    }
-}
-
-bool isKnockBufferError()
-{
-    for (int i = 0; i < knockBuf.size(); i++)
+    if (knockTargets.randomize(num) < num)
     {
-        if (!isTarget(knockBuf[i]))
-        {
-            return true;
-        }
+        Serial.println(F("Warn: no more random targets to pick"));
     }
 
-    return false;
-}
-
-bool isKnockBufferMatch()
-{
-    int targetSize = 0;
-
-    for (int i = 0; i < TARGETS_SIZE; i++)
-    {
-        if (progState.targetKnocks[i] == -1)
-        {
-            break;
-        }
-
-        targetSize++;
-    }
-
-    if (targetSize != knockBuf.size())
-    {
-        return false;
-    }
-
-    bool bufHasTarget;
-
-    for (int i = 0; i < targetSize; i++)
-    {
-        bufHasTarget = false;
-
-        for (int j = 0; j < knockBuf.size(); j++)
-        {
-            if (knockBuf[j] == progState.targetKnocks[i])
-            {
-                bufHasTarget = true;
-                break;
-            }
-        }
-
-        if (!bufHasTarget)
-        {
-            return false;
-        }
-    }
-
-    return true;
+    Serial.print(F("Targets: "));
+    Serial.println(knockTargets.getTargets(), BIN);
 }
 
 bool isExpired()
@@ -461,7 +289,6 @@ void updateTargets()
     randomizeTargets(numTargets);
     showTargetLeds();
     progState.startMillis = millis();
-    knockBuf.clear();
 }
 
 void advanceProgress()
@@ -539,7 +366,7 @@ void updateState()
         Serial.println(F("First target update"));
         updateTargets();
     }
-    else if (isKnockBufferError())
+    else if (knockTargets.isError())
     {
         Serial.println(F("Knock pattern error: restart"));
 
@@ -562,7 +389,7 @@ void updateState()
 
         cleanKnockGameState();
     }
-    else if (isKnockBufferMatch())
+    else if (knockTargets.isMatch())
     {
         Serial.println(F("OK: advancing progress"));
         advanceProgress();
@@ -589,11 +416,16 @@ void clearLeds()
 
 void showTargetLeds()
 {
+    PROFILE_SECTION(PROFILE_SECTION_LED);
+
     ledStrip.clear();
 
-    for (int i = 0; i < TARGETS_SIZE; i++)
+    for (int i = 0; i < KNOCK_NUM; i++)
     {
-        ledStrip.setPixelColor(progState.targetKnocks[i], colorPurple());
+        if (knockTargets.isTarget(i))
+        {
+            ledStrip.setPixelColor(i, colorPurple());
+        }
     }
 
     ledStrip.show();
@@ -606,6 +438,8 @@ void showErrorLedsBlink()
 
 void showErrorLedsBlink(uint32_t color)
 {
+    PROFILE_SECTION(PROFILE_SECTION_LED);
+
     for (int i = 0; i < LED_ERROR_ITERS; i++)
     {
         for (int j = 0; j < LED_NUM; j++)
@@ -626,6 +460,8 @@ void showErrorLedsBlink(uint32_t color)
 
 void showSuccessLedPattern()
 {
+    PROFILE_SECTION(PROFILE_SECTION_LED);
+
     clearLeds();
 
     for (int i = 0; i < LED_SUCCESS_ITERS; i++)
@@ -660,6 +496,8 @@ void setPixelColorChannel(int idx, int channel, int val)
 
 void fadeLeds()
 {
+    PROFILE_SECTION(PROFILE_SECTION_LED);
+
     clearLeds();
 
     int channel = random(0, 3);
@@ -691,6 +529,8 @@ void fadeLeds()
 
 void refreshUnlockPhaseLeds()
 {
+    PROFILE_SECTION(PROFILE_SECTION_LED);
+
     ledStrip.clear();
 
     for (int i = 0; i < KNOCK_NUM; i++)
@@ -780,23 +620,10 @@ void onKnock(int idx, int v, int up)
     Serial.print(":");
     Serial.println(analogVal);
 
-    bool isDup = false;
-
-    for (int i = 0; i < knockBuf.size(); i++)
-    {
-        if (knockBuf[i] == idx)
-        {
-            isDup = true;
-            break;
-        }
-    }
-
-    if (!isDup)
+    if (knockTargets.hit(idx))
     {
         Serial.print(F("Pushing:"));
         Serial.println(idx);
-
-        knockBuf.push(idx);
     }
 }
 
@@ -833,6 +660,7 @@ void setup()
 
 void loop()
 {
+    PROFILE_LOOP();
     automaton.run();
     updateState();
 }